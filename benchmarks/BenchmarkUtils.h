@@ -0,0 +1,61 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include "../src/core/PhysicsConfig.h"
+
+namespace bench {
+
+/// Grid sizes per axis covered by the size sweeps
+constexpr int kMinGrid = 128;
+constexpr int kMaxGrid = 4096;
+
+/**
+ * @brief Configuration of a free Gaussian wavepacket on an n x n grid
+ *
+ * Plans with FFTW_ESTIMATE and no wisdom store, so setup time stays
+ * bounded on large grids and results do not depend on earlier runs.
+ *
+ * @param n Grid points per axis
+ * @param numThreads Solver threads (0 = OpenMP default)
+ * @param precision "double" or "float"
+ * @return The configuration
+ */
+inline PhysicsConfig makeConfig(int n, int numThreads, const std::string& precision = "double") {
+    PhysicsConfig config;
+    config.nx = n;
+    config.ny = n;
+    config.dt = 0.001;
+    config.omega = 0.0;
+    config.potential.type = "FreeSpace";
+    config.wavepacket = {-2.0, 0.0, 1.0, 1.0, 5.0, 0.0};
+    config.numThreads = numThreads;
+    config.precision = precision;
+    config.fftw.planner = "estimate";
+    config.fftw.wisdomDir.clear();
+    return config;
+}
+
+/**
+ * @brief Report per-point cost and effective memory bandwidth
+ *
+ * Adds an "ns_per_point" counter (time per iteration divided by the work
+ * per iteration) and sets bytes_per_second from the bytes each grid point
+ * moves per unit of work.
+ *
+ * @param state Benchmark state, after the timing loop
+ * @param points Grid points processed per unit of work
+ * @param units Units of work per iteration (e.g. steps)
+ * @param bytesPerPoint Minimum memory traffic per point and unit of work
+ */
+inline void reportThroughput(benchmark::State& state, int64_t points, int64_t units, int64_t bytesPerPoint) {
+    // An inverted rate of work * 1e-9 is nanoseconds per unit of work
+    state.counters["ns_per_point"] = benchmark::Counter(
+        static_cast<double>(points) * static_cast<double>(units) * 1e-9,
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.SetItemsProcessed(state.iterations() * points * units);
+    state.SetBytesProcessed(state.iterations() * points * units * bytesPerPoint);
+}
+
+}  // namespace bench
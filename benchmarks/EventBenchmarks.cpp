@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "../src/core/AsyncEventQueue.h"
+#include "../src/core/EventBus.h"
+#include "../src/core/EventPool.h"
+#include "../src/core/IEventHandler.h"
+
+namespace {
+
+// Counts the events it receives
+class CountingHandler : public IEventHandler {
+public:
+    bool handleEvent(const EventPtr& event) override {
+        benchmark::DoNotOptimize(event.get());
+        ++count;
+        return true;
+    }
+
+    size_t count = 0;
+};
+
+// Synchronous publish of a heap-allocated step event to one subscriber
+void BM_EventBusPublish(benchmark::State& state) {
+    EventBus bus;
+    auto handler = std::make_shared<CountingHandler>();
+    bus.subscribe(EventType::SimulationStepped, handler);
+    double time = 0.0;
+    for (auto _ : state) {
+        bus.publish(makeEvent<SimulationSteppedEvent>(time, 0.001, 1.0));
+        time += 0.001;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Posting pooled step events from the solver side; they coalesce, so the
+// bus sees one per dispatch, which happens every range(0) posts
+void BM_AsyncEventQueuePost(benchmark::State& state) {
+    EventBus bus;
+    auto handler = std::make_shared<CountingHandler>();
+    bus.subscribe(EventType::SimulationStepped, handler);
+    AsyncEventQueue queue;
+    auto pool = std::make_shared<EventPool>();
+    const int64_t postsPerDispatch = state.range(0);
+
+    double time = 0.0;
+    int64_t posted = 0;
+    for (auto _ : state) {
+        queue.post(makePooledEvent<SimulationSteppedEvent>(pool, time, 0.001, 1.0));
+        time += 0.001;
+        if (++posted == postsPerDispatch) {
+            queue.dispatch(bus);
+            posted = 0;
+        }
+    }
+    queue.dispatch(bus);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["heap_allocations"] = static_cast<double>(pool->getHeapAllocationCount());
+}
+
+// Posting events that are not coalesced and go through the ring
+void BM_AsyncEventQueueRing(benchmark::State& state) {
+    EventBus bus;
+    AsyncEventQueue queue;
+    queue.setCoalesced({});
+    auto pool = std::make_shared<EventPool>(2048);
+    int64_t posted = 0;
+    for (auto _ : state) {
+        queue.post(makePooledEvent<WavefunctionUpdatedEvent>(pool));
+        if (++posted == 512) {
+            queue.dispatch(bus);
+            posted = 0;
+        }
+    }
+    queue.dispatch(bus);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Event allocation from the heap and from a pool
+void BM_MakeEvent(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeEvent<SimulationSteppedEvent>(0.0, 0.001, 1.0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MakePooledEvent(benchmark::State& state) {
+    auto pool = std::make_shared<EventPool>();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makePooledEvent<SimulationSteppedEvent>(pool, 0.0, 0.001, 1.0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_EventBusPublish);
+BENCHMARK(BM_AsyncEventQueuePost)->Arg(1)->Arg(16)->Arg(1024);
+BENCHMARK(BM_AsyncEventQueueRing);
+BENCHMARK(BM_MakeEvent);
+BENCHMARK(BM_MakePooledEvent);
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "../src/solver/DensityPyramid.h"
+#include "../src/solver/SimulationEngine.h"
+
+namespace {
+
+// Display size the frame benchmarks sample down to
+constexpr int kDisplaySize = 1024;
+
+// Arguments: grid points per axis
+void gridSizes(benchmark::internal::Benchmark* benchmark) {
+    for (int n = bench::kMinGrid; n <= bench::kMaxGrid; n *= 2) {
+        benchmark->Args({n});
+    }
+    benchmark->ArgNames({"n"})->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+// Fill level 0 from the engine and build the max-pooled pyramid, as the
+// worker does for every published frame
+void BM_PyramidBuild(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    SimulationEngine engine(bench::makeConfig(n, 0));
+    DensityPyramid pyramid;
+    for (auto _ : state) {
+        engine.writeProbabilityDensity(pyramid.resize(n, n));
+        pyramid.build();
+        benchmark::ClobberMemory();
+    }
+    // ψ read, level 0 written, and about a third of level 0 for the coarser levels
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, 16 + 4 + 4);
+}
+
+// Sample the whole grid at display resolution from a built pyramid
+void BM_PyramidSample(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    SimulationEngine engine(bench::makeConfig(n, 0));
+    DensityPyramid pyramid;
+    engine.writeProbabilityDensity(pyramid.resize(n, n));
+    pyramid.build();
+
+    DensityViewport request;
+    request.maxWidth = kDisplaySize;
+    request.maxHeight = kDisplaySize;
+    const DensityViewport view = DensityPyramid::resolve(request, n, n);
+    int width = 0;
+    int height = 0;
+    DensityPyramid::outputSize(view, width, height);
+    std::vector<float> display(static_cast<size_t>(width) * height);
+
+    for (auto _ : state) {
+        pyramid.sample(view, display.data());
+        benchmark::ClobberMemory();
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(width) * height, 1, sizeof(float));
+}
+
+// Interleaved re/im floats for the GPU |ψ|² and phase views
+void BM_WriteWavefunctionField(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    SimulationEngine engine(bench::makeConfig(n, 0));
+    std::vector<float> field(2 * static_cast<size_t>(n) * n);
+    for (auto _ : state) {
+        engine.writeWavefunctionField(field.data());
+        benchmark::ClobberMemory();
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, 16 + 8);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PyramidBuild)->Apply(gridSizes);
+BENCHMARK(BM_PyramidSample)->Apply(gridSizes);
+BENCHMARK(BM_WriteWavefunctionField)->Apply(gridSizes);
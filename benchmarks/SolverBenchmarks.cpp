@@ -0,0 +1,217 @@
+#include <benchmark/benchmark.h>
+#include <complex>
+#include <fftw3.h>
+#include <memory>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "../src/core/Wavefunction.h"
+#include "../src/solver/EnsembleEngine.h"
+#include "../src/solver/SplittingScheme.h"
+#include "../src/solver/SimulationEngine.h"
+
+namespace {
+
+// Arguments: grid points per axis, solver threads (0 = all)
+void gridAndThreads(benchmark::internal::Benchmark* benchmark) {
+    for (int n = bench::kMinGrid; n <= bench::kMaxGrid; n *= 2) {
+        benchmark->Args({n, 1});
+        benchmark->Args({n, 0});
+    }
+    benchmark->ArgNames({"n", "threads"})->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+// Arguments: grid points per axis
+void gridOnly(benchmark::internal::Benchmark* benchmark) {
+    for (int n = bench::kMinGrid; n <= bench::kMaxGrid; n *= 2) {
+        benchmark->Args({n});
+    }
+    benchmark->ArgNames({"n"})->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+template <typename Real>
+const char* precisionName() {
+    return sizeof(Real) == sizeof(double) ? "double" : "float";
+}
+
+// Minimum traffic of one fused step per point: one potential pass and the
+// kinetic multiply (read ψ and a phase, write ψ) plus two FFTs (read and
+// write ψ at least once each)
+template <typename Real>
+constexpr int64_t stepBytesPerPoint() {
+    return static_cast<int64_t>(10 * sizeof(std::complex<Real>));
+}
+
+// One unfused Strang step per iteration, as the interactive path calls it
+template <typename Real>
+void BM_Step(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    for (auto _ : state) {
+        engine.step();
+    }
+    // The unfused step makes one more potential pass than a fused one
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1,
+                            stepBytesPerPoint<Real>() + static_cast<int64_t>(3 * sizeof(std::complex<Real>)));
+}
+
+// Ten fused steps per iteration, as batch runs execute them
+template <typename Real>
+void BM_Advance(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    constexpr int kSteps = 10;
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    for (auto _ : state) {
+        engine.advance(kSteps);
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, kSteps, stepBytesPerPoint<Real>());
+}
+
+// Ten fused steps of each splitting; the cost per step grows with its FFT pairs
+void BM_AdvanceScheme(benchmark::State& state) {
+    static const char* const kSchemes[] = {"strang", "yoshida4", "blanes-moan4"};
+    const int n = static_cast<int>(state.range(0));
+    const SplittingScheme& scheme = SplittingScheme::fromName(kSchemes[state.range(1)]);
+    constexpr int kSteps = 10;
+    PhysicsConfig config = bench::makeConfig(n, 0);
+    config.integration.scheme = scheme.name;
+    SimulationEngine engine(config);
+    for (auto _ : state) {
+        engine.advance(kSteps);
+    }
+    state.SetLabel(scheme.name);
+    state.counters["fft_pairs_per_step"] = static_cast<double>(scheme.b.size());
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, kSteps,
+                            static_cast<int64_t>(scheme.b.size()) * stepBytesPerPoint<double>());
+}
+
+// Ten fused steps of K wavepackets, as one ensemble (mode 0) or as K
+// separate engines (mode 1); points count every member
+void BM_AdvanceEnsemble(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    const int members = static_cast<int>(state.range(1));
+    const bool separate = state.range(2) != 0;
+    constexpr int kSteps = 10;
+    PhysicsConfig config = bench::makeConfig(n, 0);
+    std::vector<Wavepacket> wavepackets(static_cast<size_t>(members), config.wavepacket);
+    for (int k = 0; k < members; ++k) {
+        wavepackets[k].kx = 0.5 * k;
+    }
+
+    if (separate) {
+        std::vector<std::unique_ptr<SimulationEngine>> engines;
+        for (const Wavepacket& wavepacket : wavepackets) {
+            config.wavepacket = wavepacket;
+            engines.push_back(std::make_unique<SimulationEngine>(config));
+        }
+        for (auto _ : state) {
+            for (auto& engine : engines) {
+                engine->advance(kSteps);
+            }
+        }
+    } else {
+        EnsembleEngine ensemble(config, wavepackets);
+        for (auto _ : state) {
+            ensemble.advance(kSteps);
+        }
+    }
+    state.SetLabel(separate ? "separate" : "ensemble");
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n * members, kSteps, stepBytesPerPoint<double>());
+}
+
+// Norm reduction over the grid
+template <typename Real>
+void BM_TotalProbability(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.getTotalProbability());
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, sizeof(std::complex<Real>));
+}
+
+// |ψ|² into a reused buffer and into a fresh vector
+template <typename Real>
+void BM_WriteProbabilityDensity(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    std::vector<float> density(static_cast<size_t>(n) * n);
+    for (auto _ : state) {
+        engine.writeProbabilityDensity(density.data());
+        benchmark::ClobberMemory();
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, sizeof(std::complex<Real>) + sizeof(float));
+}
+
+template <typename Real>
+void BM_GetProbabilityDensity(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.getProbabilityDensity());
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, sizeof(std::complex<Real>) + sizeof(float));
+}
+
+// All observables in one position-space and one k-space pass
+template <typename Real>
+void BM_ComputeObservables(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicSimulationEngine<Real> engine(bench::makeConfig(n, static_cast<int>(state.range(1)), precisionName<Real>()));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.computeObservables());
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, 5 * sizeof(std::complex<Real>));
+}
+
+// Gaussian wavepacket initialization (uses the OpenMP default thread count)
+template <typename Real>
+void BM_InitializeGaussian(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    BasicWavefunction<Real> psi(n, n);
+    for (auto _ : state) {
+        psi.initializeGaussian(-2.0, 0.0, 1.0, 1.0, 5.0, 0.0, 20.0, 20.0);
+        benchmark::ClobberMemory();
+    }
+    bench::reportThroughput(state, static_cast<int64_t>(n) * n, 1, sizeof(std::complex<Real>));
+}
+
+// FFTW plan creation for the solver's in-place 2D transform, without wisdom
+template <unsigned Flags>
+void BM_PlanCreation(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    fftw_complex* data = fftw_alloc_complex(static_cast<size_t>(n) * n);
+    for (auto _ : state) {
+        fftw_plan plan = fftw_plan_dft_2d(n, n, data, data, FFTW_FORWARD, Flags);
+        benchmark::DoNotOptimize(plan);
+        state.PauseTiming();
+        fftw_destroy_plan(plan);
+        fftw_forget_wisdom();
+        state.ResumeTiming();
+    }
+    fftw_free(data);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Step, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_Step, float)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_Advance, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_Advance, float)->Apply(gridAndThreads);
+BENCHMARK(BM_AdvanceScheme)
+    ->ArgsProduct({{256, 1024}, {0, 1, 2}})->ArgNames({"n", "scheme"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AdvanceEnsemble)
+    ->ArgsProduct({{128, 512}, {8}, {0, 1}})->ArgNames({"n", "members", "separate"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_TotalProbability, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_TotalProbability, float)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_WriteProbabilityDensity, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_GetProbabilityDensity, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_ComputeObservables, double)->Apply(gridAndThreads);
+BENCHMARK_TEMPLATE(BM_InitializeGaussian, double)->Apply(gridOnly);
+BENCHMARK_TEMPLATE(BM_InitializeGaussian, float)->Apply(gridOnly);
+BENCHMARK_TEMPLATE(BM_PlanCreation, FFTW_ESTIMATE)->Apply(gridOnly);
+// Measuring planners take minutes on the largest grids
+BENCHMARK_TEMPLATE(BM_PlanCreation, FFTW_MEASURE)
+    ->RangeMultiplier(2)->Range(bench::kMinGrid, 1024)->ArgNames({"n"})
+    ->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(1);
@@ -0,0 +1,310 @@
+#include "BatchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "../solver/Checkpoint.h"
+#include "../solver/Observables.h"
+#include "../solver/SimulationEngine.h"
+#include "../solver/Snapshots.h"
+#include "../core/Trace.h"
+
+namespace {
+
+// Convert the requested run length to a step count
+int resolveStepCount(const PhysicsConfig& config, const BatchOptions& options) {
+    if (options.duration > 0.0) {
+        // Round up, tolerating dt values that do not divide the duration exactly
+        return static_cast<int>(std::ceil(options.duration / config.dt - 1e-9));
+    }
+    return std::max(0, options.steps);
+}
+
+// Samples the observable writer may fall behind by before it drops them
+constexpr size_t kObservableQueueSize = 4096;
+
+// Next multiple of interval after step, or limit if the interval is disabled
+int nextMultiple(int step, int interval, int limit) {
+    if (interval <= 0) {
+        return limit;
+    }
+    return std::min(limit, (step / interval + 1) * interval);
+}
+
+}  // namespace
+
+// Read the resume checkpoint's header, if there is one
+std::optional<CheckpointState> BatchRunner::readResumeHeader(const BatchOptions& options) {
+    if (options.resumeFrom.empty()) {
+        return std::nullopt;
+    }
+    return Checkpoint::read(options.resumeFrom, false);
+}
+
+// Take the grid, time step and potential of the resume checkpoint
+PhysicsConfig BatchRunner::resumeConfig(const PhysicsConfig& config, const std::optional<CheckpointState>& header) {
+    PhysicsConfig resumed = config;
+    if (header) {
+        resumed.nx = header->nx;
+        resumed.ny = header->ny;
+        resumed.lx = header->lx;
+        resumed.ly = header->ly;
+        // Adaptive runs keep the configured dt as the unit of their output steps
+        if (!config.integration.adaptive) {
+            resumed.dt = header->dt;
+        }
+        resumed.potential = header->potential;
+    }
+    return resumed;
+}
+
+// Take the grid, time step and potential of the resume checkpoint
+PhysicsConfig BatchRunner::resumeConfig(const PhysicsConfig& config, const BatchOptions& options) {
+    return resumeConfig(config, readResumeHeader(options));
+}
+
+// Create a runner with a new engine of the configured precision
+BatchRunner::BatchRunner(const PhysicsConfig& config, const BatchOptions& options)
+    : BatchRunner(config, options, readResumeHeader(options)) {}
+
+// Create the engine for the resumed configuration; the header is read only once
+BatchRunner::BatchRunner(const PhysicsConfig& config, const BatchOptions& options,
+                         const std::optional<CheckpointState>& header)
+    : BatchRunner(createSimulationEngine(resumeConfig(config, header)), resumeConfig(config, header), options,
+                  header) {}
+
+// Create a runner around an existing engine
+BatchRunner::BatchRunner(std::shared_ptr<ISimulationEngine> engine, const PhysicsConfig& config,
+                         const BatchOptions& options)
+    : BatchRunner(std::move(engine), config, options, readResumeHeader(options)) {}
+
+// Create a runner around an existing engine with the resume header
+BatchRunner::BatchRunner(std::shared_ptr<ISimulationEngine> engine, const PhysicsConfig& config,
+                         const BatchOptions& options, const std::optional<CheckpointState>& header)
+    : m_config(config),
+      m_options(options),
+      m_engine(std::move(engine)),
+      m_totalSteps(resolveStepCount(config, options))
+{
+    if (!m_engine) {
+        throw std::invalid_argument("BatchRunner requires a simulation engine");
+    }
+
+    if (!m_options.resumeFrom.empty()) {
+        if (!header) {
+            throw std::invalid_argument("BatchRunner requires the header of " + m_options.resumeFrom);
+        }
+        // Engines with their own reader (e.g. one slab per rank) restore directly
+        if (!m_engine->restoreCheckpointFile(m_options.resumeFrom)) {
+            m_engine->restoreCheckpoint(Checkpoint::read(m_options.resumeFrom));
+        }
+        if (!m_config.integration.adaptive) {
+            m_config.dt = header->dt;
+        }
+        m_config.potential = header->potential;
+        m_startStep = static_cast<int>(header->step);
+        m_totalSteps = resolveStepCount(m_config, m_options);
+    }
+}
+
+// Run the simulation to completion
+BatchResult BatchRunner::run() {
+    // With a distributed engine every rank steps, but only one writes files
+    const bool output = m_engine->isOutputRank();
+    const bool quiet = m_options.quiet || !output;
+    if (output) {
+        std::filesystem::create_directories(m_options.outputDir);
+    }
+
+    // Observables are formatted and written on a background thread; a resumed
+    // run keeps the rows of the interrupted one up to the checkpoint
+    const ObservableWriter::Format format = ObservableWriter::parseFormat(m_config.output.observablesFormat);
+    const std::string observablesPath = (std::filesystem::path(m_options.outputDir) /
+                                         (std::string("observables") + ObservableWriter::extension(format))).string();
+    std::unique_ptr<ObservableWriter> observables;
+    if (output) {
+        observables = std::make_unique<ObservableWriter>(observablesPath, format, m_config.output.regions,
+                                                         kObservableQueueSize,
+                                                         m_options.resumeFrom.empty() ? -1 : m_startStep);
+    }
+
+    // Checkpoints are written on a background thread while stepping continues
+    const std::string checkpointPath = (std::filesystem::path(m_options.outputDir) / "checkpoint.h5").string();
+    const int checkpointSteps = Checkpoint::intervalSteps(m_config.output.checkpointInterval, m_config.dt);
+    std::unique_ptr<CheckpointWriter> checkpointWriter;
+    int directCheckpoints = 0;
+    if (checkpointSteps > 0) {
+        checkpointWriter = std::make_unique<CheckpointWriter>(m_config.output.checkpointCompression);
+    }
+
+    // A snapshot stream keeps every snapshot in one file written in the background
+    const bool streamSnapshots = !m_config.output.snapshotStream.empty();
+    SnapshotFormat::Encoding snapshotEncoding = SnapshotFormat::Encoding::Density32;
+    std::unique_ptr<SnapshotWriter> snapshotStream;
+    if (streamSnapshots) {
+        snapshotEncoding = SnapshotFormat::parseEncoding(m_config.output.snapshotStream);
+        if (output) {
+            const std::string name = m_options.resumeFrom.empty()
+                                         ? std::string("snapshots.qms")
+                                         : "snapshots_" + std::to_string(m_startStep) + ".qms";
+            snapshotStream = std::make_unique<SnapshotWriter>(
+                (std::filesystem::path(m_options.outputDir) / name).string(), snapshotEncoding,
+                m_config.nx, m_config.ny, m_config.lx, m_config.ly, m_config.dt);
+        }
+    }
+
+    BatchResult result;
+    result.firstStep = m_startStep;
+
+    // Start from the ground state; a resumed run already has its state
+    if (m_config.imaginaryTime.enabled && m_options.resumeFrom.empty()) {
+        TRACE_SCOPE("Relax initial state", "solver");
+        if (!m_engine->relaxInitialState(m_config.imaginaryTime, result.eigenstates)) {
+            throw std::runtime_error("imaginaryTime is not supported by this engine");
+        }
+        if (!quiet) {
+            for (size_t k = 0; k < result.eigenstates.size(); ++k) {
+                const EigenstateResult& state = result.eigenstates[k];
+                std::cout << "Eigenstate " << k << ": E=" << state.energy << " after " << state.steps
+                          << " imaginary time steps" << (state.converged ? "" : " (not converged)") << std::endl;
+            }
+        }
+    }
+    double stepSeconds = 0.0;
+    // computeObservables() is collective for a distributed engine, so every rank calls it
+    auto writeObservables = [&](int step, bool keep) {
+        ObservableSample sample = m_engine->computeObservables();
+        sample.step = step;
+        sample.wallSeconds = stepSeconds;
+        if (observables && keep) {
+            observables->push(sample);
+        }
+    };
+
+    writeObservables(m_startStep, observables && observables->getLastKeptStep() != m_startStep);
+
+    int step = m_startStep;
+    int adaptiveSteps = 0;
+    const double startTime = m_engine->getCurrentTime();
+    int nextObservable = nextMultiple(step, m_options.observableInterval, m_totalSteps);
+    int nextSnapshot = nextMultiple(step, m_options.snapshotInterval, m_totalSteps);
+    int nextCheckpoint = checkpointSteps > 0 ? nextMultiple(step, checkpointSteps, m_totalSteps)
+                                             : std::numeric_limits<int>::max();
+
+    while (step < m_totalSteps) {
+        // Advance in one fused batch up to the next point that produces output
+        int target = std::min({nextObservable, nextSnapshot, nextCheckpoint});
+
+        auto start = std::chrono::steady_clock::now();
+        if (m_config.integration.adaptive) {
+            // Output stays on the grid of the configured dt; the engine picks
+            // the steps in between. The span is measured from the start so
+            // rounding does not accumulate.
+            const double span = startTime + (target - m_startStep) * m_config.dt - m_engine->getCurrentTime();
+            int taken = 0;
+            if (!m_engine->advanceAdaptive(span, taken)) {
+                throw std::runtime_error("integration.adaptive is not supported by this engine");
+            }
+            adaptiveSteps += taken;
+        } else {
+            m_engine->advance(target - step);
+        }
+        stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        step = target;
+
+        if (step == nextObservable) {
+            writeObservables(step, true);
+            nextObservable = nextMultiple(step, m_options.observableInterval, m_totalSteps);
+        }
+        if (step == nextSnapshot) {
+            if (snapshotStream) {
+                snapshotStream->capture(*m_engine, step);
+            } else if (streamSnapshots) {
+                SnapshotWriter::participate(*m_engine, snapshotEncoding);
+            } else {
+                writeSnapshot(step);
+            }
+            ++result.snapshots;
+            nextSnapshot = nextMultiple(step, m_options.snapshotInterval, m_totalSteps);
+        }
+        if (step == nextCheckpoint) {
+            TRACE_SCOPE("Capture checkpoint", "io");
+            if (m_engine->writeCheckpointFile(checkpointPath, step, m_config.output.checkpointCompression)) {
+                ++directCheckpoints;
+            }
+            else {
+                CheckpointState state = m_engine->captureCheckpoint();
+                state.step = step;
+                checkpointWriter->submit(checkpointPath, std::move(state));
+            }
+            nextCheckpoint = nextMultiple(step, checkpointSteps, m_totalSteps);
+        }
+
+        if (!quiet && m_options.observableInterval > 0) {
+            std::cout << "step " << step << "/" << m_totalSteps
+                      << "  t=" << m_engine->getCurrentTime() << std::endl;
+        }
+    }
+
+    if (observables) {
+        observables->close();
+        result.droppedSamples = static_cast<int>(observables->getDroppedCount());
+    }
+    if (snapshotStream) {
+        snapshotStream->close();
+        result.droppedSnapshots = static_cast<int>(snapshotStream->getDroppedCount());
+        result.snapshots -= result.droppedSnapshots;
+    }
+    if (checkpointWriter) {
+        checkpointWriter->flush();
+        result.checkpoints = checkpointWriter->getWrittenCount();
+    }
+    result.checkpoints += directCheckpoints;
+
+    result.steps = m_config.integration.adaptive ? adaptiveSteps : step - m_startStep;
+    result.simulatedTime = m_engine->getCurrentTime();
+    result.totalProbability = m_engine->getTotalProbability();
+    result.wallSeconds = stepSeconds;
+
+    if (!quiet && result.steps > 0) {
+        const double points = static_cast<double>(m_config.nx) * m_config.ny;
+        std::cout << "Ran " << result.steps << " steps (" << m_config.nx << "x" << m_config.ny << ", "
+                  << m_config.precision << ") in " << stepSeconds << " s: "
+                  << result.steps / stepSeconds << " steps/s, "
+                  << stepSeconds * 1e9 / (points * result.steps) << " ns/point/step" << std::endl;
+    }
+
+    return result;
+}
+
+// Write the current probability density as raw float32
+void BatchRunner::writeSnapshot(int step) {
+    TRACE_SCOPE("Snapshot", "io");
+    const std::string path = (std::filesystem::path(m_options.outputDir) /
+                              ("density_" + std::to_string(step) + ".f32")).string();
+
+    // Every rank takes part in gathering the density; only the output rank writes it
+    const bool output = m_engine->isOutputRank();
+    if (output) {
+        m_snapshotBuffer.resize(static_cast<size_t>(m_config.nx) * static_cast<size_t>(m_config.ny));
+    }
+    m_engine->writeProbabilityDensity(m_snapshotBuffer.data());
+    if (!output) {
+        return;
+    }
+    const std::vector<float>& density = m_snapshotBuffer;
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(density.data()),
+               static_cast<std::streamsize>(density.size() * sizeof(float)));
+    if (!file) {
+        throw std::runtime_error("Cannot write snapshot " + path);
+    }
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../core/PhysicsConfig.h"
+#include "../solver/Checkpoint.h"
+#include "../solver/ISimulationEngine.h"
+
+/**
+ * @struct BatchOptions
+ * @brief Run length and output settings for a headless batch run
+ */
+struct BatchOptions {
+    int steps = 0;               ///< Number of time steps to run (used when duration <= 0)
+    double duration = 0.0;       ///< Simulated time to run; overrides steps when > 0
+    int observableInterval = 0;  ///< Steps between observable rows (0 = first and last step only)
+    int snapshotInterval = 0;    ///< Steps between density snapshots (0 = final snapshot only)
+    std::string outputDir = "output";  ///< Directory for observables.csv, snapshots and checkpoints
+    std::string resumeFrom;      ///< Checkpoint file to continue from (empty = start fresh)
+    bool quiet = false;          ///< Suppress the progress and summary output
+};
+
+/**
+ * @struct BatchResult
+ * @brief Summary of a finished batch run
+ */
+struct BatchResult {
+    int steps = 0;                ///< Steps actually taken (accepted steps of an adaptive run)
+    int firstStep = 0;            ///< Step the run started from (non-zero when resumed)
+    double simulatedTime = 0.0;   ///< Simulation time reached
+    double totalProbability = 0.0;  ///< Final norm of the wavefunction
+    double wallSeconds = 0.0;     ///< Wall-clock time spent stepping (excluding output)
+    int snapshots = 0;            ///< Number of density snapshots written
+    int checkpoints = 0;          ///< Number of checkpoints written
+    int droppedSamples = 0;       ///< Observable samples dropped because the writer fell behind
+    int droppedSnapshots = 0;     ///< Stream frames dropped because the snapshot writer fell behind
+    std::vector<EigenstateResult> eigenstates;  ///< States relaxed before the run (imaginaryTime.enabled)
+};
+
+/**
+ * @class BatchRunner
+ * @brief Runs a simulation without a window, as fast as the engine allows
+ *
+ * The runner drives an ISimulationEngine through ISimulationEngine::advance()
+ * in batches that end exactly at the next observable or snapshot step, so
+ * the fused half steps and the absence of an event bus keep the solver on
+ * its fast path between outputs.
+ *
+ * Output written to BatchOptions::outputDir:
+ * - observables.csv (or .bin with output.observablesFormat = "binary"):
+ *   one ObservableSample per row, see ObservableWriter for the columns
+ * - density_<step>.f32: |ψ|² as raw float32 in storage order (x fastest),
+ *   nx * ny values per file
+ * - snapshots.qms instead, with output.snapshotStream set to an encoding
+ *   name (see SnapshotFormat): every snapshot as one frame of a single
+ *   mmap-able stream, written on a background thread. A resumed run
+ *   starts snapshots_<step>.qms.
+ * - checkpoint.h5: the latest state, every output.checkpointInterval of
+ *   simulation time and at the end of the run (see Checkpoint); written on
+ *   a background thread
+ *
+ * A run resumed from a checkpoint continues at the saved step towards the
+ * same total step count, keeps the observable rows up to that step and
+ * appends the rest.
+ *
+ * With imaginaryTime.enabled, a fresh run first relaxes the initial
+ * wavefunction to the ground state of the configured potential
+ * (ISimulationEngine::relaxInitialState()), so the real-time run starts
+ * from it; a resumed run continues from the checkpoint instead.
+ *
+ * With integration.adaptive set, the run is driven through
+ * ISimulationEngine::advanceAdaptive() instead: step numbers, output
+ * intervals and the run length still count steps of the configured dt,
+ * so output lands at the same simulation times, while the engine chooses
+ * the steps in between.
+ *
+ * A distributed engine is driven the same way on every rank: all ranks
+ * step and compute observables together, engines that write their own
+ * checkpoints (ISimulationEngine::writeCheckpointFile()) do so
+ * collectively, and only the output rank (ISimulationEngine::isOutputRank())
+ * writes observables, snapshots and console output.
+ */
+class BatchRunner {
+public:
+    /**
+     * @brief Create a runner for a configuration
+     * @param config Physics configuration; config.precision selects the engine.
+     *        When resuming, the grid, time step and potential come from the checkpoint.
+     * @param options Run length and output settings
+     * @throws std::runtime_error if the resume checkpoint cannot be read
+     */
+    BatchRunner(const PhysicsConfig& config, const BatchOptions& options);
+
+    /**
+     * @brief Create a runner around an existing engine
+     * @param engine Engine to drive; its current state is the starting point
+     *        unless options.resumeFrom names a checkpoint for its grid
+     * @param config Configuration the engine was created with
+     * @param options Run length and output settings
+     * @throws std::runtime_error if the resume checkpoint cannot be read
+     * @throws std::invalid_argument if the checkpoint grid does not match the engine
+     */
+    BatchRunner(std::shared_ptr<ISimulationEngine> engine, const PhysicsConfig& config,
+                const BatchOptions& options);
+
+    /**
+     * @brief Create a runner around an existing engine with a resume header read before
+     * @param engine Engine to drive
+     * @param config Configuration the engine was created with
+     * @param options Run length and output settings
+     * @param header readResumeHeader(options), so the header is not read again
+     * @throws std::invalid_argument if options.resumeFrom is set but header is empty,
+     *         or if the checkpoint grid does not match the engine
+     */
+    BatchRunner(std::shared_ptr<ISimulationEngine> engine, const PhysicsConfig& config,
+                const BatchOptions& options, const std::optional<CheckpointState>& header);
+
+    /**
+     * @brief Read the header of the resume checkpoint, without the wavefunction
+     * @param options Run options; options.resumeFrom names the checkpoint, if any
+     * @return The header, or nothing when the run starts fresh
+     * @throws std::runtime_error if the resume checkpoint cannot be read
+     */
+    static std::optional<CheckpointState> readResumeHeader(const BatchOptions& options);
+
+    /**
+     * @brief Get the configuration a run will use
+     *
+     * Useful to create the engine for the other constructors, e.g. a
+     * distributed one, with the grid of the resume checkpoint.
+     *
+     * @param config Physics configuration of the run
+     * @param header Header from readResumeHeader()
+     * @return config with the grid, time step and potential of the checkpoint
+     */
+    static PhysicsConfig resumeConfig(const PhysicsConfig& config, const std::optional<CheckpointState>& header);
+
+    /**
+     * @brief Get the configuration a run will use, reading the resume header
+     * @param config Physics configuration of the run
+     * @param options Run options; options.resumeFrom names the checkpoint, if any
+     * @return config with the grid, time step and potential of the checkpoint
+     * @throws std::runtime_error if the resume checkpoint cannot be read
+     */
+    static PhysicsConfig resumeConfig(const PhysicsConfig& config, const BatchOptions& options);
+
+    /**
+     * @brief Run the simulation to completion and write all output
+     * @return Summary of the run
+     * @throws std::runtime_error if the output cannot be written, or if
+     *         integration.adaptive or imaginaryTime.enabled is set for an
+     *         engine without adaptive steps or imaginary-time relaxation
+     * @throws std::invalid_argument if the adaptive settings are inconsistent
+     */
+    BatchResult run();
+
+    /**
+     * @brief Get the number of steps the run will take
+     * @return Steps derived from BatchOptions::steps or BatchOptions::duration
+     */
+    int getTotalSteps() const { return m_totalSteps; }
+
+    /**
+     * @brief Get the step the run starts from
+     * @return Saved step of the resume checkpoint, or 0
+     */
+    int getStartStep() const { return m_startStep; }
+
+    /**
+     * @brief Get the engine driven by this runner
+     * @return The simulation engine
+     */
+    std::shared_ptr<ISimulationEngine> getEngine() const { return m_engine; }
+
+private:
+    /**
+     * @brief Create a runner with a new engine for a resume header read before
+     * @param config Physics configuration of the run
+     * @param options Run length and output settings
+     * @param header readResumeHeader(options)
+     */
+    BatchRunner(const PhysicsConfig& config, const BatchOptions& options,
+                const std::optional<CheckpointState>& header);
+
+    /**
+     * @brief Write |ψ|² of the current state to density_<step>.f32
+     * @param step Step number used in the file name
+     */
+    void writeSnapshot(int step);
+
+
+    PhysicsConfig m_config;     ///< Configuration of the run
+    BatchOptions m_options;     ///< Run length and output settings
+    std::shared_ptr<ISimulationEngine> m_engine;  ///< Engine being driven
+    int m_totalSteps;           ///< Step count at which the run ends
+    int m_startStep = 0;        ///< Step the run starts from
+    std::vector<float> m_snapshotBuffer;  ///< Reused |ψ|² buffer for snapshots
+};
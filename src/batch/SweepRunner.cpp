@@ -0,0 +1,178 @@
+#include "SweepRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "WorkStealingPool.h"
+#include "../solver/Observables.h"
+#include "../solver/SimulationEngine.h"
+#include "../core/DebugUtils.h"
+#include "../core/Trace.h"
+
+namespace {
+
+// Upper bound on queued samples; the writer normally keeps up long before this
+constexpr size_t kMaxObservableQueueSize = 1 << 16;
+
+// Convert the sweep's run length to a step count for one configuration
+int resolveStepCount(const config::SweepSpec& spec, const PhysicsConfig& config) {
+    if (spec.duration > 0.0) {
+        // Round up, tolerating dt values that do not divide the duration exactly
+        return static_cast<int>(std::ceil(spec.duration / config.dt - 1e-9));
+    }
+    return std::max(0, spec.steps);
+}
+
+// Next multiple of interval after step, or limit if the interval is disabled
+int nextMultiple(int step, int interval, int limit) {
+    if (interval <= 0) {
+        return limit;
+    }
+    return std::min(limit, (step / interval + 1) * interval);
+}
+
+// Column name of a swept JSON pointer: "/wavepacket/kx" -> "wavepacket.kx"
+std::string parameterColumn(const std::string& pointer) {
+    std::string name = pointer.substr(pointer.empty() || pointer[0] != '/' ? 0 : 1);
+    std::replace(name.begin(), name.end(), '/', '.');
+    return name;
+}
+
+}  // namespace
+
+// Create a runner for an expanded sweep
+SweepRunner::SweepRunner(config::SweepSpec spec, const SweepOptions& options)
+    : m_spec(std::move(spec)),
+      m_options(options),
+      m_workers(WorkStealingPool(options.workers > 0 ? options.workers : m_spec.workers).getWorkerCount())
+{
+    if (m_spec.steps <= 0 && m_spec.duration <= 0.0) {
+        throw std::invalid_argument("A sweep needs \"steps\" or \"time\"");
+    }
+
+    // Runs on the same precision and grid next to each other, so a worker's
+    // consecutive runs keep its plans
+    std::stable_sort(m_spec.jobs.begin(), m_spec.jobs.end(),
+                     [](const config::SweepJob& a, const config::SweepJob& b) {
+                         return std::tie(a.config.precision, a.config.nx, a.config.ny) <
+                                std::tie(b.config.precision, b.config.nx, b.config.ny);
+                     });
+}
+
+// Get the column names of the label columns
+std::vector<std::string> SweepRunner::labelColumns() const {
+    std::vector<std::string> columns = {"run"};
+    for (const std::string& pointer : m_spec.parameters) {
+        columns.push_back(parameterColumn(pointer));
+    }
+    return columns;
+}
+
+// Run all jobs and write the aggregated observables
+SweepResult SweepRunner::run() {
+    std::filesystem::create_directories(m_options.outputDir);
+
+    // Columns and format come from the base configuration
+    const PhysicsConfig base = m_spec.jobs.empty() ? PhysicsConfig() : m_spec.jobs.front().config;
+    const ObservableWriter::Format format = ObservableWriter::parseFormat(base.output.observablesFormat);
+    const std::string observablesPath = (std::filesystem::path(m_options.outputDir) /
+                                         (std::string("sweep") + ObservableWriter::extension(format))).string();
+
+    // Size the queue for every row of the sweep, so finished runs never wait on the writer
+    size_t rows = 0;
+    for (const config::SweepJob& job : m_spec.jobs) {
+        const int steps = resolveStepCount(m_spec, job.config);
+        rows += 2 + (m_spec.observableInterval > 0 ? steps / m_spec.observableInterval : 0);
+    }
+    ObservableWriter observables(observablesPath, format, base.output.regions,
+                                 std::min(rows, kMaxObservableQueueSize), -1, labelColumns());
+
+    WorkStealingPool pool(m_workers);
+    std::vector<std::shared_ptr<ISimulationEngine>> engines(pool.getWorkerCount());
+    std::vector<std::string> enginePrecisions(engines.size());
+    std::mutex progressMutex;
+    SweepResult result;
+
+    std::vector<WorkStealingPool::Task> tasks;
+    for (const config::SweepJob& job : m_spec.jobs) {
+        tasks.push_back([&, job](int worker) {
+            TRACE_SCOPE("Sweep run", "batch");
+            PhysicsConfig config = job.config;
+            config.numThreads = m_spec.threadsPerRun;
+
+            std::vector<double> labels = {static_cast<double>(job.index)};
+            labels.insert(labels.end(), job.values.begin(), job.values.end());
+
+            try {
+                // Reuse the worker's engine when the precision matches; updateConfig
+                // keeps the plans when the grid does too
+                std::shared_ptr<ISimulationEngine>& engine = engines[worker];
+                if (engine && enginePrecisions[worker] == config.precision) {
+                    engine->updateConfig(config);
+                } else {
+                    engine.reset();
+                    engine = createSimulationEngine(config);
+                    enginePrecisions[worker] = config.precision;
+                }
+
+                const int totalSteps = resolveStepCount(m_spec, config);
+                double stepSeconds = 0.0;
+                auto writeObservables = [&](int step) {
+                    ObservableSample sample = engine->computeObservables();
+                    sample.step = step;
+                    sample.wallSeconds = stepSeconds;
+                    sample.labels = labels;
+                    observables.push(sample);
+                };
+
+                writeObservables(0);
+                int step = 0;
+                while (step < totalSteps) {
+                    const int target = nextMultiple(step, m_spec.observableInterval, totalSteps);
+                    auto start = std::chrono::steady_clock::now();
+                    engine->advance(target - step);
+                    stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    step = target;
+                    writeObservables(step);
+                }
+
+                std::lock_guard<std::mutex> lock(progressMutex);
+                ++result.runs;
+                if (!m_options.quiet) {
+                    std::cout << "run " << job.index << " done (" << result.runs + result.failed << "/"
+                              << m_spec.jobs.size() << ", " << stepSeconds << " s)" << std::endl;
+                }
+            }
+            catch (const std::exception& e) {
+                // A bad configuration fails its run, not the sweep
+                engines[worker].reset();
+                std::lock_guard<std::mutex> lock(progressMutex);
+                ++result.failed;
+                ERROR_LOG("SweepRunner", "Run " + std::to_string(job.index) + " failed: " + e.what());
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pool.run(tasks);
+    engines.clear();
+    observables.close();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.droppedSamples = static_cast<int>(observables.getDroppedCount());
+    result.stolen = pool.getStolenCount();
+    result.runsPerHour = result.wallSeconds > 0.0 ? result.runs * 3600.0 / result.wallSeconds : 0.0;
+
+    if (!m_options.quiet) {
+        std::cout << "Ran " << result.runs << " of " << m_spec.jobs.size() << " runs on "
+                  << pool.getWorkerCount() << " workers in " << result.wallSeconds << " s: "
+                  << result.runsPerHour << " runs/hour" << std::endl;
+    }
+    return result;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "../config/ConfigLoader.h"
+
+/**
+ * @struct SweepOptions
+ * @brief Output and scheduling settings for a parameter sweep
+ */
+struct SweepOptions {
+    std::string outputDir = "output";  ///< Directory for sweep.csv (or sweep.bin)
+    int workers = 0;                   ///< Concurrent runs (0 = the sweep file's value, else one per hardware thread)
+    bool quiet = false;                ///< Suppress the progress and summary output
+};
+
+/**
+ * @struct SweepResult
+ * @brief Summary of a finished sweep
+ */
+struct SweepResult {
+    int runs = 0;               ///< Runs that finished
+    int failed = 0;             ///< Runs that threw, e.g. for an invalid configuration
+    double wallSeconds = 0.0;   ///< Wall-clock time of the whole sweep
+    double runsPerHour = 0.0;   ///< Throughput: finished runs per wall-clock hour
+    int droppedSamples = 0;     ///< Observable samples dropped because the writer fell behind
+    size_t stolen = 0;          ///< Runs taken over by a worker other than the one they were dealt to
+};
+
+/**
+ * @class SweepRunner
+ * @brief Runs every configuration of a parameter sweep on a work-stealing pool
+ *
+ * Each worker owns one engine and runs its jobs one after another, switching
+ * configurations through ISimulationEngine::updateConfig(). Jobs are ordered
+ * by precision and grid before they are dealt out, so consecutive runs on
+ * a worker usually share a grid and reuse the engine's FFTW plans and
+ * buffers; new plans come from FFTW's process-wide wisdom, which the
+ * engines fill and read under FFTWWisdom::plannerMutex(). Each run uses
+ * SweepSpec::threadsPerRun solver threads, so the sweep parallelizes across
+ * runs rather than inside them.
+ *
+ * All runs write to one observables file in outputDir, sweep.csv (or
+ * sweep.bin with output.observablesFormat = "binary" in the base
+ * configuration): the ObservableWriter columns of the base configuration's
+ * regions followed by "run" and one column per swept parameter, named
+ * after its JSON pointer with '/' replaced by '.' (e.g.
+ * "wavepacket.kx"). Rows of concurrent runs interleave; sort by run and
+ * step to separate them.
+ */
+class SweepRunner {
+public:
+    /**
+     * @brief Create a runner for an expanded sweep
+     * @param spec Sweep from config::ConfigLoader::loadSweep()
+     * @param options Output and scheduling settings
+     * @throws std::invalid_argument if the sweep specifies neither steps nor time
+     */
+    SweepRunner(config::SweepSpec spec, const SweepOptions& options);
+
+    /**
+     * @brief Run all jobs and write the aggregated observables
+     * @return Summary of the sweep
+     * @throws std::runtime_error if the output cannot be written
+     */
+    SweepResult run();
+
+    /**
+     * @brief Get the number of concurrent runs
+     * @return Worker count
+     */
+    int getWorkerCount() const { return m_workers; }
+
+    /**
+     * @brief Get the column names of the label columns
+     * @return "run" followed by one name per swept parameter
+     */
+    std::vector<std::string> labelColumns() const;
+
+private:
+    config::SweepSpec m_spec;   ///< Jobs and run length
+    SweepOptions m_options;     ///< Output and scheduling settings
+    int m_workers;              ///< Concurrent runs
+};
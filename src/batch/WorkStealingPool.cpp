@@ -0,0 +1,101 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Task indices owned by one worker
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+};
+
+// Take the next task of a worker's own queue
+bool popFront(TaskQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+// Steal the last task of another worker's queue
+bool popBack(TaskQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+}  // namespace
+
+// Create a pool
+WorkStealingPool::WorkStealingPool(int workers)
+    : m_workers(workers > 0 ? workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))) {}
+
+// Run all tasks and wait for them to finish
+void WorkStealingPool::run(const std::vector<Task>& tasks) {
+    const int workers = static_cast<int>(std::min<size_t>(m_workers, std::max<size_t>(1, tasks.size())));
+
+    // Deal out contiguous chunks, so neighbouring tasks share a worker
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    for (int w = 0; w < workers; ++w) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queues[i * workers / tasks.size()]->tasks.push_back(i);
+    }
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto workerMain = [&](int worker) {
+        while (!failed.load()) {
+            size_t task = 0;
+            bool found = popFront(*queues[worker], task);
+            for (int offset = 1; !found && offset < workers; ++offset) {
+                found = popBack(*queues[(worker + offset) % workers], task);
+                if (found) {
+                    ++m_stolen;
+                }
+            }
+            if (!found) {
+                return;  // Tasks are never added during a run, so every queue is drained
+            }
+
+            try {
+                tasks[task](worker);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; ++w) {
+        threads.emplace_back(workerMain, w);
+    }
+    workerMain(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
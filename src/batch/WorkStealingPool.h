@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief Runs a fixed set of independent tasks on worker threads that steal from each other
+ *
+ * run() deals the tasks out in contiguous chunks, one chunk per worker, so
+ * neighbouring tasks (which the caller may have ordered to share state,
+ * e.g. runs on the same grid) land on the same worker. Each worker takes
+ * tasks from the front of its own chunk; a worker whose chunk is empty
+ * steals from the back of another's, so long tasks do not leave the
+ * remaining workers idle.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Task body
+     * @param worker Index of the worker running the task, 0 to getWorkerCount() - 1
+     */
+    using Task = std::function<void(int worker)>;
+
+    /**
+     * @brief Create a pool
+     * @param workers Number of worker threads (0 = one per hardware thread)
+     */
+    explicit WorkStealingPool(int workers = 0);
+
+    /**
+     * @brief Get the number of worker threads
+     * @return Worker count
+     */
+    int getWorkerCount() const { return m_workers; }
+
+    /**
+     * @brief Run all tasks and wait for them to finish
+     *
+     * If a task throws, the workers stop starting new tasks and the first
+     * exception is rethrown once the running ones have finished.
+     *
+     * @param tasks Tasks to run; each runs exactly once unless a task throws
+     */
+    void run(const std::vector<Task>& tasks);
+
+    /**
+     * @brief Get the number of tasks taken from another worker's chunk
+     * @return Steal count, accumulated over all calls to run()
+     */
+    size_t getStolenCount() const { return m_stolen.load(); }
+
+private:
+    int m_workers;                   ///< Number of worker threads
+    std::atomic<size_t> m_stolen{0};  ///< Tasks run by a worker other than their owner
+};
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "core/PhysicsConfig.h"
+#include "core/DebugUtils.h"
+#include "core/Metrics.h"
+#include "core/Trace.h"
+#include "config/ConfigLoader.h"
+#include "batch/BatchRunner.h"
+#include "batch/SweepRunner.h"
+
+#ifdef QMSIM_WITH_MPI
+#include <mpi.h>
+#include "solver/DistributedSimulationEngine.h"
+
+namespace {
+
+// Initializes MPI for the lifetime of main(); only the main thread calls MPI
+class MpiSession {
+public:
+    MpiSession(int& argc, char**& argv) {
+        int provided = 0;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+        MPI_Comm_rank(MPI_COMM_WORLD, &m_rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &m_size);
+    }
+    ~MpiSession() { MPI_Finalize(); }
+    MpiSession(const MpiSession&) = delete;
+    MpiSession& operator=(const MpiSession&) = delete;
+
+    int rank() const { return m_rank; }
+    int size() const { return m_size; }
+
+    // Stop every rank, since the others would wait forever in a collective call
+    void abort(int code) const {
+        if (m_size > 1) {
+            MPI_Abort(MPI_COMM_WORLD, code);
+        }
+    }
+
+private:
+    int m_rank = 0;
+    int m_size = 1;
+};
+
+}  // namespace
+#endif
+
+// Metrics file of a rank: ranks after the first insert their number before the extension
+std::string rankMetricsPath(const std::string& path, int rank) {
+    if (rank == 0) {
+        return path;
+    }
+    std::filesystem::path rankPath(path);
+    const std::string extension = rankPath.extension().string();
+    rankPath.replace_extension();
+    return rankPath.string() + ".rank" + std::to_string(rank) + extension;
+}
+
+// Write the recorded trace and report it
+void finishTrace(const std::string& tracePath, bool quiet) {
+    const size_t events = Tracer::getInstance().stop();
+    if (!quiet) {
+        std::cout << "Wrote " << events << " trace events to " << tracePath << std::endl;
+    }
+}
+
+// Print usage information
+void printHelp(const char* programName) {
+    std::cout << "Usage: " << programName << " --config FILE (--steps N | --time T) [options]" << std::endl;
+    std::cout << "       " << programName << " --sweep FILE [options]" << std::endl;
+    std::cout << "Runs a simulation without a window and writes observables and snapshots." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --config, -c FILE     Physics configuration JSON" << std::endl;
+    std::cout << "  --steps, -n N         Number of time steps to run" << std::endl;
+    std::cout << "  --time T              Simulated time to run (overrides --steps)" << std::endl;
+    std::cout << "  --output, -o DIR      Output directory (default: output)" << std::endl;
+    std::cout << "  --observe-every N     Steps between observable rows (default: first and last only)" << std::endl;
+    std::cout << "  --snapshot-every N    Steps between density snapshots (default: final only)" << std::endl;
+    std::cout << "  --snapshot-stream ENC Write snapshots to one stream file: complex128, complex64," << std::endl;
+    std::cout << "                        float32, float16 or delta16 (overrides the config)" << std::endl;
+    std::cout << "  --resume FILE         Continue from a checkpoint written by an earlier run" << std::endl;
+    std::cout << "  --sweep FILE          Run every configuration of a parameter sweep into one file" << std::endl;
+    std::cout << "  --workers N           Concurrent sweep runs (default: the sweep file, else all cores)" << std::endl;
+    std::cout << "  --threads, -t N       Number of solver threads (overrides the config or threads per sweep run)" << std::endl;
+    std::cout << "  --float, -f           Run in single precision (overrides the config)" << std::endl;
+#ifdef QMSIM_WITH_MPI
+    std::cout << "  --distributed         Split the grid across MPI ranks (default when started on several ranks)" << std::endl;
+#endif
+    std::cout << "  --quiet, -q           Only report errors" << std::endl;
+    std::cout << "  --debug, -d           Enable debug output" << std::endl;
+    std::cout << "  --trace FILE          Record solver timings as a Chrome trace (chrome://tracing)" << std::endl;
+    std::cout << "  --metrics FILE        Export stage timings, steps and memory use: JSON for *.json," << std::endl;
+    std::cout << "                        else Prometheus text (e.g. *.prom for a textfile collector)" << std::endl;
+    std::cout << "  --metrics-every S     Seconds between metrics file updates (default: 5, 0 = at exit only)" << std::endl;
+    std::cout << "  --help, -h            Show this help message" << std::endl;
+}
+
+int main(int argc, char** argv) {
+#ifdef QMSIM_WITH_MPI
+    MpiSession mpi(argc, argv);
+    bool distributed = mpi.size() > 1;
+#endif
+    std::string configPath;
+    BatchOptions options;
+    int numThreads = -1;
+    bool useFloat = false;
+    bool debugEnabled = false;
+    std::string tracePath;
+    std::string metricsPath;
+    double metricsInterval = 5.0;
+    std::string sweepPath;
+    std::string snapshotStream;
+    int workers = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "--config" || arg == "-c") && hasValue) {
+            configPath = argv[++i];
+        } else if ((arg == "--steps" || arg == "-n") && hasValue) {
+            options.steps = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--time" && hasValue) {
+            options.duration = std::atof(argv[++i]);
+        } else if ((arg == "--output" || arg == "-o") && hasValue) {
+            options.outputDir = argv[++i];
+        } else if (arg == "--observe-every" && hasValue) {
+            options.observableInterval = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--snapshot-every" && hasValue) {
+            options.snapshotInterval = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--snapshot-stream" && hasValue) {
+            snapshotStream = argv[++i];
+        } else if (arg == "--resume" && hasValue) {
+            options.resumeFrom = argv[++i];
+        } else if (arg == "--sweep" && hasValue) {
+            sweepPath = argv[++i];
+        } else if (arg == "--workers" && hasValue) {
+            workers = std::max(0, std::atoi(argv[++i]));
+        } else if ((arg == "--threads" || arg == "-t") && hasValue) {
+            numThreads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--float" || arg == "-f") {
+            useFloat = true;
+#ifdef QMSIM_WITH_MPI
+        } else if (arg == "--distributed") {
+            distributed = true;
+#endif
+        } else if (arg == "--quiet" || arg == "-q") {
+            options.quiet = true;
+        } else if (arg == "--debug" || arg == "-d") {
+            debugEnabled = true;
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--metrics" && hasValue) {
+            metricsPath = argv[++i];
+        } else if (arg == "--metrics-every" && hasValue) {
+            metricsInterval = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--help" || arg == "-h") {
+            printHelp(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (sweepPath.empty() && (configPath.empty() || (options.steps <= 0 && options.duration <= 0.0))) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+#ifdef QMSIM_WITH_MPI
+    if (distributed && !sweepPath.empty()) {
+        if (mpi.rank() == 0) {
+            std::cerr << "Error: --sweep runs its jobs on one process; start it without --distributed" << std::endl;
+        }
+        return 1;
+    }
+#endif
+    if (!sweepPath.empty() && (options.snapshotInterval > 0 || !snapshotStream.empty() || !options.resumeFrom.empty())) {
+        std::cerr << "Error: --snapshot-every, --snapshot-stream and --resume apply to single runs, not --sweep" << std::endl;
+        return 1;
+    }
+
+    DebugUtils::getInstance().setDebugEnabled(debugEnabled);
+
+    // Rewritten in the background while the run goes on, and once more at exit
+    std::unique_ptr<MetricsExporter> metrics;
+    if (!metricsPath.empty()) {
+        int rank = 0;
+#ifdef QMSIM_WITH_MPI
+        rank = mpi.rank();
+#endif
+        metrics = std::make_unique<MetricsExporter>(rankMetricsPath(metricsPath, rank), metricsInterval);
+    }
+
+    if (!sweepPath.empty()) {
+        try {
+            // The command line overrides the sweep file's run length and threads
+            config::SweepSpec spec = config::ConfigLoader::loadSweep(sweepPath);
+            if (options.steps > 0 || options.duration > 0.0) {
+                spec.steps = options.steps;
+                spec.duration = options.duration;
+            }
+            if (options.observableInterval > 0) {
+                spec.observableInterval = options.observableInterval;
+            }
+            if (numThreads >= 0) {
+                spec.threadsPerRun = numThreads;
+            }
+            if (useFloat) {
+                for (config::SweepJob& job : spec.jobs) {
+                    job.config.precision = "float";
+                }
+            }
+
+            SweepOptions sweepOptions;
+            sweepOptions.outputDir = options.outputDir;
+            sweepOptions.workers = workers;
+            sweepOptions.quiet = options.quiet;
+            if (!tracePath.empty()) {
+                Tracer::getInstance().start(tracePath);
+            }
+            SweepResult result = SweepRunner(std::move(spec), sweepOptions).run();
+            if (!tracePath.empty()) {
+                finishTrace(tracePath, options.quiet);
+            }
+            if (metrics) {
+                metrics->stop();
+            }
+            return result.failed > 0 ? 1 : 0;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        PhysicsConfig config = config::ConfigLoader::load(configPath);
+        if (numThreads >= 0) {
+            config.numThreads = numThreads;
+        }
+        if (useFloat) {
+            config.precision = "float";
+        }
+        if (!snapshotStream.empty()) {
+            config.output.snapshotStream = snapshotStream;
+        }
+
+        if (!tracePath.empty()) {
+            Tracer::getInstance().start(tracePath);
+        }
+#ifdef QMSIM_WITH_MPI
+        if (distributed) {
+            // Every rank runs the same batch; BatchRunner writes output on rank 0 only
+            if (mpi.rank() != 0) {
+                options.quiet = true;
+            }
+            const std::optional<CheckpointState> header = BatchRunner::readResumeHeader(options);
+            const PhysicsConfig resumed = BatchRunner::resumeConfig(config, header);
+            BatchRunner runner(std::make_shared<DistributedSimulationEngine>(resumed), resumed, options, header);
+            runner.run();
+        }
+        else
+#endif
+        {
+            BatchRunner runner(config, options);
+            runner.run();
+        }
+        if (!tracePath.empty()) {
+            finishTrace(tracePath, options.quiet);
+        }
+        if (metrics) {
+            metrics->stop();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+#ifdef QMSIM_WITH_MPI
+        mpi.abort(1);
+#endif
+        return 1;
+    }
+
+    return 0;
+}
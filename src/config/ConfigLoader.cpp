@@ -1,21 +1,65 @@
 #include "ConfigLoader.h"
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <stdexcept>
 
 using namespace config;
 
-PhysicsConfig ConfigLoader::load(const std::string& path) {
+namespace {
+
+// Read a potential and, for composite potentials, its components
+PotentialConfig loadPotential(const nlohmann::json& j) {
+    PotentialConfig potential;
+    potential.type = j["type"].get<std::string>();
+    if (j.contains("parameters")) {
+        for (auto& p : j["parameters"]) {
+            potential.parameters.push_back(p.get<double>());
+        }
+    }
+    potential.file = j.value("file", std::string());
+    if (j.contains("components")) {
+        for (auto& component : j["components"]) {
+            potential.components.push_back(loadPotential(component));
+        }
+    }
+    return potential;
+}
+
+// Read a JSON file
+nlohmann::json readJson(const std::string& path) {
     std::ifstream f(path);
     nlohmann::json j;
     f >> j;
+    return j;
+}
+
+// Values of one swept parameter: a list, or {"from", "to", "count"} evenly spaced
+std::vector<nlohmann::json> sweepValues(const std::string& pointer, const nlohmann::json& spec) {
+    if (spec.is_array()) {
+        return std::vector<nlohmann::json>(spec.begin(), spec.end());
+    }
+    const int count = spec.value("count", 0);
+    if (!spec.is_object() || count <= 0) {
+        throw std::invalid_argument("Sweep values of " + pointer + " need a list or from/to/count");
+    }
+    const double from = spec["from"].get<double>();
+    const double to = spec["to"].get<double>();
+    std::vector<nlohmann::json> values;
+    for (int k = 0; k < count; ++k) {
+        values.push_back(count > 1 ? from + (to - from) * k / (count - 1) : from);
+    }
+    return values;
+}
+
+// Read a configuration from parsed JSON
+PhysicsConfig parseConfig(nlohmann::json j) {
     PhysicsConfig cfg;
     cfg.nx = j["grid"]["nx"].get<int>();
     cfg.ny = j["grid"]["ny"].get<int>();
+    cfg.lx = j["grid"].value("lx", cfg.lx);
+    cfg.ly = j["grid"].value("ly", cfg.ly);
     cfg.dt = j["dt"].get<double>();
-    cfg.potential.type = j["potential"]["type"].get<std::string>();
-    for (auto& p : j["potential"]["parameters"]) {
-        cfg.potential.parameters.push_back(p.get<double>());
-    }
+    cfg.potential = loadPotential(j["potential"]);
     auto& w = j["wavepacket"]; 
     cfg.wavepacket.x0 = w["x0"].get<double>();
     cfg.wavepacket.y0 = w["y0"].get<double>();
@@ -27,5 +71,108 @@ PhysicsConfig ConfigLoader::load(const std::string& path) {
     auto& o = j["output"];
     cfg.output.checkpointInterval = o["checkpointInterval"].get<double>();
     cfg.output.exportObservables = o["exportObservables"].get<bool>();
+    cfg.output.checkpointCompression = o.value("checkpointCompression", 0);
+    cfg.output.observablesFormat = o.value("observablesFormat", cfg.output.observablesFormat);
+    cfg.output.snapshotStream = o.value("snapshotStream", cfg.output.snapshotStream);
+    if (o.contains("regions")) {
+        for (auto& r : o["regions"]) {
+            cfg.output.regions.push_back({
+                r["name"].get<std::string>(),
+                r["xMin"].get<double>(), r["xMax"].get<double>(),
+                r["yMin"].get<double>(), r["yMax"].get<double>()
+            });
+        }
+    }
+    if (j.contains("absorber")) {
+        auto& a = j["absorber"];
+        cfg.absorber.width = a.value("width", cfg.absorber.width);
+        cfg.absorber.strength = a.value("strength", cfg.absorber.strength);
+    }
+    if (j.contains("integration")) {
+        auto& in = j["integration"];
+        cfg.integration.scheme = in.value("scheme", cfg.integration.scheme);
+        cfg.integration.adaptive = in.value("adaptive", cfg.integration.adaptive);
+        cfg.integration.tolerance = in.value("tolerance", cfg.integration.tolerance);
+        cfg.integration.minDt = in.value("minDt", cfg.integration.minDt);
+        cfg.integration.maxDt = in.value("maxDt", cfg.integration.maxDt);
+    }
+    if (j.contains("imaginaryTime")) {
+        auto& it = j["imaginaryTime"];
+        cfg.imaginaryTime.enabled = it.value("enabled", true);
+        cfg.imaginaryTime.dt = it.value("dt", cfg.imaginaryTime.dt);
+        cfg.imaginaryTime.minDt = it.value("minDt", cfg.imaginaryTime.minDt);
+        cfg.imaginaryTime.tolerance = it.value("tolerance", cfg.imaginaryTime.tolerance);
+        cfg.imaginaryTime.checkInterval = it.value("checkInterval", cfg.imaginaryTime.checkInterval);
+        cfg.imaginaryTime.maxSteps = it.value("maxSteps", cfg.imaginaryTime.maxSteps);
+        cfg.imaginaryTime.states = it.value("states", cfg.imaginaryTime.states);
+    }
+    cfg.numThreads = j.value("threads", 0);
+    cfg.precision = j.value("precision", std::string("double"));
+    if (j.contains("fftw")) {
+        auto& f = j["fftw"];
+        cfg.fftw.planner = f.value("planner", cfg.fftw.planner);
+        cfg.fftw.wisdomDir = f.value("wisdomDir", cfg.fftw.wisdomDir);
+    }
     return cfg;
+}
+
+}  // namespace
+
+PhysicsConfig ConfigLoader::load(const std::string& path) {
+    return parseConfig(readJson(path));
+}
+
+SweepSpec ConfigLoader::loadSweep(const std::string& path) {
+    nlohmann::json j = readJson(path);
+    if (!j.contains("sweep")) {
+        throw std::invalid_argument("No \"sweep\" block in " + path);
+    }
+    const nlohmann::json sweep = j["sweep"];
+    j.erase("sweep");
+
+    SweepSpec spec;
+    spec.steps = sweep.value("steps", 0);
+    spec.duration = sweep.value("time", 0.0);
+    spec.observableInterval = sweep.value("observeEvery", 0);
+    spec.workers = sweep.value("workers", 0);
+    spec.threadsPerRun = sweep.value("threadsPerRun", 1);
+    const std::string combine = sweep.value("combine", std::string("product"));
+    if (combine != "product" && combine != "zip") {
+        throw std::invalid_argument("Unknown sweep combination: " + combine);
+    }
+    const bool zip = combine == "zip";
+
+    // Parameters in key order, each with its list of values
+    std::vector<std::vector<nlohmann::json>> values;
+    size_t runs = 1;
+    if (sweep.contains("parameters")) {
+        for (auto& [pointer, list] : sweep["parameters"].items()) {
+            spec.parameters.push_back(pointer);
+            values.push_back(sweepValues(pointer, list));
+            const size_t count = values.back().size();
+            if (count == 0 || (zip && values.size() > 1 && count != runs)) {
+                throw std::invalid_argument("Sweep values of " + pointer + " are empty or differ in length");
+            }
+            runs = zip ? count : runs * count;
+        }
+    }
+
+    for (size_t run = 0; run < runs; ++run) {
+        nlohmann::json runConfig = j;
+        SweepJob job;
+        job.index = static_cast<int>(run);
+        job.values.resize(values.size());
+
+        // Mixed-radix digits of the run index, the last parameter fastest
+        size_t rest = run;
+        for (size_t p = values.size(); p-- > 0;) {
+            const size_t k = zip ? run : rest % values[p].size();
+            rest = zip ? rest : rest / values[p].size();
+            runConfig[nlohmann::json::json_pointer(spec.parameters[p])] = values[p][k];
+            job.values[p] = values[p][k].is_number() ? values[p][k].get<double>() : static_cast<double>(k);
+        }
+        job.config = parseConfig(std::move(runConfig));
+        spec.jobs.push_back(std::move(job));
+    }
+    return spec;
 }
\ No newline at end of file
@@ -1,10 +1,37 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "../core/PhysicsConfig.h"
 
 namespace config {
+    // One run of a parameter sweep
+    struct SweepJob {
+        int index = 0;               // Position of the run in the expanded sweep
+        PhysicsConfig config;        // Base configuration with this run's values applied
+        std::vector<double> values;  // Value of each swept parameter (list index for non-numbers)
+    };
+
+    // A base configuration expanded over the values of its "sweep" block
+    struct SweepSpec {
+        std::vector<std::string> parameters;  // JSON pointers of the swept values, e.g. "/wavepacket/kx"
+        std::vector<SweepJob> jobs;           // One entry per run
+        int steps = 0;                        // Steps per run (used when duration <= 0)
+        double duration = 0.0;                // Simulated time per run; overrides steps when > 0
+        int observableInterval = 0;           // Steps between observable rows (0 = first and last only)
+        int workers = 0;                      // Concurrent runs (0 = one per hardware thread)
+        int threadsPerRun = 1;                // Solver threads of each run
+    };
+
     class ConfigLoader {
     public:
         static PhysicsConfig load(const std::string& path);
+
+        // Read a configuration with a "sweep" block and expand it into runs.
+        // "parameters" maps JSON pointers into the configuration to a list
+        // of values or to {"from", "to", "count"}; "combine" is "product"
+        // (every combination, the last parameter in key order varying
+        // fastest) or "zip" (the i-th value of every list). Throws
+        // std::invalid_argument for an inconsistent sweep.
+        static SweepSpec loadSweep(const std::string& path);
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,200 @@
+#include "AsyncEventQueue.h"
+#include <algorithm>
+#include <thread>
+
+// Ring cell; the sequence number tells producers and the consumer whose turn it is
+struct AsyncEventQueue::Cell {
+    std::atomic<size_t> sequence{0};
+    Entry entry;
+};
+
+// Latest undispatched event of a coalesced type
+struct AsyncEventQueue::CoalescedSlot {
+    explicit CoalescedSlot(EventType eventType) : type(eventType) {}
+
+    void lock() {
+        while (busy.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    void unlock() { busy.clear(std::memory_order_release); }
+
+    EventType type;
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+    Entry entry;
+};
+
+// Create a queue
+AsyncEventQueue::AsyncEventQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    m_cells.reset(new Cell[size]);
+    m_mask = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    setCoalesced({EventType::SimulationStepped, EventType::WavefunctionUpdated});
+}
+
+AsyncEventQueue::~AsyncEventQueue() = default;
+
+// Choose the event types that are coalesced
+void AsyncEventQueue::setCoalesced(const std::vector<EventType>& types) {
+    m_slots.clear();
+    for (EventType type : types) {
+        m_slots.push_back(std::make_unique<CoalescedSlot>(type));
+    }
+}
+
+// Find the coalescing slot of an event type
+AsyncEventQueue::CoalescedSlot* AsyncEventQueue::findSlot(EventType type) {
+    for (const auto& slot : m_slots) {
+        if (slot->type == type) {
+            return slot.get();
+        }
+    }
+    return nullptr;
+}
+
+// Claim a ring cell and store an entry
+bool AsyncEventQueue::tryPush(Entry& entry) {
+    size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = m_cells[position & m_mask];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.entry = std::move(entry);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;  // The consumer has not freed this cell yet
+        } else {
+            position = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Queue an event for the next dispatch
+void AsyncEventQueue::post(EventPtr event) {
+    if (!event) {
+        return;
+    }
+    Entry entry(m_nextOrder.fetch_add(1, std::memory_order_relaxed), std::move(event));
+
+    if (CoalescedSlot* slot = findSlot(entry.second->getType())) {
+        slot->lock();
+        const bool replaced = static_cast<bool>(slot->entry.second);
+        std::swap(slot->entry, entry);
+        slot->unlock();
+        if (replaced) {
+            m_coalescedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;  // The replaced event, if any, is released here, outside the lock
+    }
+
+    if (!tryPush(entry)) {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflow.push_back(std::move(entry));
+        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Queue an event for the next dispatch
+bool AsyncEventQueue::handleEvent(const EventPtr& event) {
+    post(event);
+    return true;
+}
+
+// Publish every queued event on a bus
+size_t AsyncEventQueue::dispatch(EventBus& eventBus) {
+    // Coalesced slots first, then the overflow, then the ring up to the
+    // position seen under the overflow lock: everything a producer posted
+    // before an event taken here is then part of the same batch
+    for (const auto& slot : m_slots) {
+        slot->lock();
+        if (slot->entry.second) {
+            m_batch.push_back(std::move(slot->entry));
+            slot->entry.second.reset();
+        }
+        slot->unlock();
+    }
+
+    size_t end = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflowTaken.swap(m_overflow);
+        end = m_enqueuePos.load(std::memory_order_acquire);
+    }
+    for (Entry& entry : m_overflowTaken) {
+        m_batch.push_back(std::move(entry));
+    }
+    m_overflowTaken.clear();
+
+    while (m_dequeuePos != end) {
+        Cell& cell = m_cells[m_dequeuePos & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+            // Claimed but not yet filled; the producer is between two stores
+            std::this_thread::yield();
+            continue;
+        }
+        m_batch.push_back(std::move(cell.entry));
+        cell.entry.second.reset();
+        cell.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+        ++m_dequeuePos;
+    }
+
+    std::sort(m_batch.begin(), m_batch.end(),
+              [](const Entry& a, const Entry& b) { return a.first < b.first; });
+
+    for (const Entry& entry : m_batch) {
+        eventBus.publish(entry.second);
+        record(entry.second);
+    }
+
+    // Dropping the references here returns pooled events to their pool
+    const size_t count = m_batch.size();
+    m_batch.clear();
+    return count;
+}
+
+// Set the number of dispatched events kept in the history
+void AsyncEventQueue::setHistoryCapacity(size_t capacity) {
+    std::vector<EventPtr> kept = getHistory();
+    if (kept.size() > capacity) {
+        kept.erase(kept.begin(), kept.end() - static_cast<std::ptrdiff_t>(capacity));
+    }
+    m_history = std::move(kept);
+    m_historyCapacity = capacity;
+    m_historyNext = m_history.size() % std::max<size_t>(capacity, 1);
+}
+
+// Append a dispatched event to the history
+void AsyncEventQueue::record(const EventPtr& event) {
+    if (m_historyCapacity == 0) {
+        return;
+    }
+    if (m_history.size() < m_historyCapacity) {
+        m_history.push_back(event);
+    } else {
+        m_history[m_historyNext] = event;
+    }
+    m_historyNext = (m_historyNext + 1) % m_historyCapacity;
+}
+
+// Get the dispatched events kept in the history
+std::vector<EventPtr> AsyncEventQueue::getHistory() const {
+    if (m_history.size() < m_historyCapacity || m_historyCapacity == 0) {
+        return m_history;
+    }
+    // Full ring: the oldest event is the next one to be overwritten
+    std::vector<EventPtr> ordered;
+    ordered.reserve(m_history.size());
+    ordered.insert(ordered.end(), m_history.begin() + static_cast<std::ptrdiff_t>(m_historyNext), m_history.end());
+    ordered.insert(ordered.end(), m_history.begin(), m_history.begin() + static_cast<std::ptrdiff_t>(m_historyNext));
+    return ordered;
+}
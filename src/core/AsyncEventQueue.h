@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "EventBus.h"
+#include "Events.h"
+#include "IEventHandler.h"
+
+/**
+ * @class AsyncEventQueue
+ * @brief Asynchronous front end for an EventBus
+ *
+ * Producers on any thread post() events without locks or allocation; the
+ * consumer thread calls dispatch() once per frame, which publishes the
+ * queued events on a bus, so handlers run on the consumer thread and always
+ * after the producer has moved on.
+ *
+ * - Events go into a bounded lock-free ring with one slot claim per post.
+ *   If the ring is full they spill into a mutex-guarded overflow list, so
+ *   nothing is lost.
+ * - Coalesced event types (by default SimulationStepped and
+ *   WavefunctionUpdated) keep only their latest instance in a per-type slot,
+ *   so however many steps run between two dispatches, each such type is
+ *   delivered at most once per dispatch.
+ * - Within one dispatch, events are published in posting order. A coalesced
+ *   event is never delivered before the events posted ahead of it.
+ * - A history of dispatched events is kept only when enabled with
+ *   setHistoryCapacity(); it is off by default.
+ *
+ * Used as an IEventHandler, the queue can also be subscribed to a bus to
+ * defer that bus's events to the consumer thread.
+ */
+class AsyncEventQueue : public IEventHandler {
+public:
+    /**
+     * @brief Create a queue
+     * @param capacity Ring slots, rounded up to a power of two
+     */
+    explicit AsyncEventQueue(size_t capacity = 1024);
+
+    ~AsyncEventQueue() override;
+
+    AsyncEventQueue(const AsyncEventQueue&) = delete;
+    AsyncEventQueue& operator=(const AsyncEventQueue&) = delete;
+
+    /**
+     * @brief Choose the event types that are coalesced
+     *
+     * Must be called before events are posted.
+     *
+     * @param types Types of which only the latest undispatched event is kept
+     */
+    void setCoalesced(const std::vector<EventType>& types);
+
+    /**
+     * @brief Queue an event for the next dispatch (any thread)
+     * @param event Event to queue
+     */
+    void post(EventPtr event);
+
+    /**
+     * @brief Queue an event for the next dispatch (any thread)
+     * @param event Event to queue
+     * @return Always true
+     */
+    bool handleEvent(const EventPtr& event) override;
+
+    /**
+     * @brief Publish every queued event on a bus (consumer thread)
+     * @param eventBus Bus to publish to
+     * @return Number of events published
+     */
+    size_t dispatch(EventBus& eventBus);
+
+    /**
+     * @brief Set the number of dispatched events kept in the history (consumer thread)
+     * @param capacity History size (0 = no history)
+     */
+    void setHistoryCapacity(size_t capacity);
+
+    /**
+     * @brief Get the dispatched events kept in the history (consumer thread)
+     * @return Events, oldest first
+     */
+    std::vector<EventPtr> getHistory() const;
+
+    /**
+     * @brief Get the number of events replaced by a later event of the same type
+     * @return Coalesced event count
+     */
+    size_t getCoalescedCount() const { return m_coalescedCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of events that went to the overflow list
+     * @return Overflow event count
+     */
+    size_t getOverflowCount() const { return m_overflowCount.load(std::memory_order_relaxed); }
+
+private:
+    /// Event with its posting order
+    using Entry = std::pair<uint64_t, EventPtr>;
+
+    struct Cell;
+    struct CoalescedSlot;
+
+    /**
+     * @brief Find the coalescing slot of an event type
+     * @param type Event type
+     * @return The slot, or null if the type is not coalesced
+     */
+    CoalescedSlot* findSlot(EventType type);
+
+    /**
+     * @brief Claim a ring cell and store an entry (producer)
+     * @param entry Entry to store, left intact when the ring is full
+     * @return False if the ring was full
+     */
+    bool tryPush(Entry& entry);
+
+    /**
+     * @brief Append a dispatched event to the history
+     * @param event Dispatched event
+     */
+    void record(const EventPtr& event);
+
+    std::unique_ptr<Cell[]> m_cells;          ///< Ring storage
+    size_t m_mask;                            ///< Ring capacity - 1
+    std::atomic<size_t> m_enqueuePos{0};      ///< Next cell producers claim
+    size_t m_dequeuePos = 0;                  ///< Next cell the consumer reads
+    std::atomic<uint64_t> m_nextOrder{0};     ///< Posting order counter
+
+    std::vector<std::unique_ptr<CoalescedSlot>> m_slots;  ///< Per-type latest events
+
+    std::mutex m_overflowMutex;           ///< Guards m_overflow
+    std::vector<Entry> m_overflow;        ///< Events posted while the ring was full
+    std::vector<Entry> m_overflowTaken;   ///< Overflow swapped out by dispatch()
+
+    std::vector<Entry> m_batch;           ///< Events of the current dispatch, reused
+    std::vector<EventPtr> m_history;      ///< History ring
+    size_t m_historyCapacity = 0;         ///< History size (0 = off)
+    size_t m_historyNext = 0;             ///< Next history position to overwrite
+
+    std::atomic<size_t> m_coalescedCount{0};  ///< Events replaced by later ones
+    std::atomic<size_t> m_overflowCount{0};   ///< Events that missed the ring
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Lowest log level compiled in (0 = trace ... 4 = error, 5 = none)
+ *
+ * Log statements below this level are removed by the compiler, message
+ * formatting included. Set it with -DQMSIM_MIN_LOG_LEVEL=<n>, e.g. 2 to
+ * strip all DEBUG_LOG calls from a production build.
+ */
+#ifndef QMSIM_MIN_LOG_LEVEL
+#define QMSIM_MIN_LOG_LEVEL 1
+#endif
+
+/**
+ * @enum LogLevel
+ * @brief Severity of a log message
+ */
+enum class LogLevel {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warning = 3,
+    Error = 4,
+    Off = 5
+};
+
+/**
+ * @class DebugUtils
+ * @brief Process-wide logger with per-level filtering
+ *
+ * Messages are written with the component name and level, one line at a
+ * time. Use the logging macros rather than calling log() directly: they
+ * check the level before the message expression is evaluated, so a
+ * disabled statement costs one relaxed atomic load, and statements below
+ * QMSIM_MIN_LOG_LEVEL are compiled out entirely.
+ *
+ * The runtime level defaults to Info; setDebugEnabled(true) (the --debug
+ * command line flag) lowers it to Debug.
+ */
+class DebugUtils {
+public:
+    /**
+     * @brief Get the process-wide logger
+     * @return The logger
+     */
+    static DebugUtils& getInstance() {
+        static DebugUtils instance;
+        return instance;
+    }
+
+    DebugUtils(const DebugUtils&) = delete;
+    DebugUtils& operator=(const DebugUtils&) = delete;
+
+    /**
+     * @brief Enable or disable debug messages
+     * @param enabled True for LogLevel::Debug, false for LogLevel::Info
+     */
+    void setDebugEnabled(bool enabled) { setLogLevel(enabled ? LogLevel::Debug : LogLevel::Info); }
+
+    /**
+     * @brief Check whether debug messages are written
+     * @return True if the runtime level is Debug or lower
+     */
+    bool isDebugEnabled() const { return isEnabled(LogLevel::Debug); }
+
+    /**
+     * @brief Set the lowest level that is written
+     * @param level Runtime level (LogLevel::Off silences everything)
+     */
+    void setLogLevel(LogLevel level) { m_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the lowest level that is written
+     * @return Runtime level
+     */
+    LogLevel getLogLevel() const { return static_cast<LogLevel>(m_level.load(std::memory_order_relaxed)); }
+
+    /**
+     * @brief Check whether messages of a level are written
+     * @param level Message level
+     * @return True if the level is at or above the runtime level
+     */
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= m_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Write a message
+     * @param level Message level
+     * @param component Component the message comes from
+     * @param message Message text
+     * @param withTime Prefix the wall-clock time with millisecond resolution
+     */
+    void log(LogLevel level, const char* component, const std::string& message, bool withTime = false) {
+        std::ostream& out = level >= LogLevel::Warning ? std::cerr : std::cout;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (withTime) {
+            const auto now = std::chrono::system_clock::now();
+            const std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+            const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now.time_since_epoch()).count() % 1000;
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &seconds);
+#else
+            localtime_r(&seconds, &local);
+#endif
+            out << std::put_time(&local, "%H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << millis
+                << std::setfill(' ') << ' ';
+        }
+        out << '[' << levelName(level) << "] [" << component << "] " << message << std::endl;
+    }
+
+    /**
+     * @brief Write a debug message if debug output is enabled
+     * @param component Component the message comes from
+     * @param message Message text
+     */
+    void debug(const std::string& component, const std::string& message) {
+        if (isDebugEnabled()) {
+            log(LogLevel::Debug, component.c_str(), message);
+        }
+    }
+
+    /**
+     * @brief Write a time-stamped debug message if debug output is enabled
+     * @param component Component the message comes from
+     * @param message Message text
+     */
+    void debugWithTime(const std::string& component, const std::string& message) {
+        if (isDebugEnabled()) {
+            log(LogLevel::Debug, component.c_str(), message, true);
+        }
+    }
+
+    /**
+     * @brief Get the display name of a level
+     * @param level Message level
+     * @return Upper-case name
+     */
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::Trace: return "TRACE";
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO";
+            case LogLevel::Warning: return "WARNING";
+            case LogLevel::Error: return "ERROR";
+            default: return "OFF";
+        }
+    }
+
+private:
+    DebugUtils() = default;
+
+    std::atomic<int> m_level{static_cast<int>(LogLevel::Info)};  ///< Lowest level written
+    std::mutex m_mutex;  ///< Keeps lines from different threads apart
+};
+
+/**
+ * @brief Write a message at a level; the message is only evaluated if it is written
+ *
+ * The first condition is a compile-time constant, so statements below
+ * QMSIM_MIN_LOG_LEVEL are discarded by the compiler.
+ */
+#define QMSIM_LOG_AT(level, component, message, withTime)                                  \
+    do {                                                                                   \
+        if (static_cast<int>(level) >= QMSIM_MIN_LOG_LEVEL &&                              \
+            DebugUtils::getInstance().isEnabled(level)) {                                  \
+            DebugUtils::getInstance().log(level, component, message, withTime);            \
+        }                                                                                  \
+    } while (0)
+
+#define TRACE_LOG(component, message) QMSIM_LOG_AT(LogLevel::Trace, component, message, false)
+#define DEBUG_LOG(component, message) QMSIM_LOG_AT(LogLevel::Debug, component, message, false)
+#define DEBUG_LOG_TIME(component, message) QMSIM_LOG_AT(LogLevel::Debug, component, message, true)
+#define INFO_LOG(component, message) QMSIM_LOG_AT(LogLevel::Info, component, message, false)
+#define WARNING_LOG(component, message) QMSIM_LOG_AT(LogLevel::Warning, component, message, false)
+#define ERROR_LOG(component, message) QMSIM_LOG_AT(LogLevel::Error, component, message, false)
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include "Events.h"
+
+/**
+ * @class EventPool
+ * @brief Fixed set of recycled memory blocks for high-frequency events
+ *
+ * Events made with makePooledEvent() place the event and its shared_ptr
+ * control block in one pool block, which returns to the pool when the last
+ * reference is dropped, on whichever thread that happens. The free list is
+ * a lock-free stack with a version tag against ABA. When the pool is empty
+ * or an event does not fit a block, the heap is used instead, so pooling
+ * only ever changes where events live.
+ *
+ * Allocators hold a shared reference to the pool, so it outlives every
+ * event made from it.
+ */
+class EventPool {
+public:
+    static constexpr size_t kBlockSize = 192;  ///< Bytes per block (event plus control block)
+
+    /**
+     * @brief Create a pool
+     * @param capacity Number of blocks
+     */
+    explicit EventPool(size_t capacity = 256)
+        : m_capacity(capacity),
+          m_blocks(new Block[capacity]),
+          m_next(new std::atomic<uint32_t>[capacity])
+    {
+        // Link every block into the free list; indices are stored off by one so 0 means empty
+        for (size_t i = 0; i < capacity; ++i) {
+            m_next[i].store(static_cast<uint32_t>(i + 2 <= capacity ? i + 2 : 0), std::memory_order_relaxed);
+        }
+        m_head.store(capacity > 0 ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    EventPool(const EventPool&) = delete;
+    EventPool& operator=(const EventPool&) = delete;
+
+    /**
+     * @brief Take memory for an object
+     * @param bytes Object size
+     * @param alignment Object alignment
+     * @return A pool block if one is free and large enough, otherwise heap memory
+     */
+    void* allocate(size_t bytes, size_t alignment) {
+        if (bytes <= kBlockSize && alignment <= alignof(std::max_align_t)) {
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            for (;;) {
+                const uint32_t index = static_cast<uint32_t>(head);
+                if (index == 0) {
+                    break;  // Empty
+                }
+                const uint32_t next = m_next[index - 1].load(std::memory_order_relaxed);
+                const uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+                if (m_head.compare_exchange_weak(head, replacement, std::memory_order_acquire,
+                                                 std::memory_order_acquire)) {
+                    return m_blocks[index - 1].bytes;
+                }
+            }
+        }
+        m_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(bytes);
+    }
+
+    /**
+     * @brief Return memory taken with allocate()
+     * @param pointer Memory to return
+     * @param bytes Object size passed to allocate()
+     */
+    void deallocate(void* pointer, size_t bytes) {
+        Block* block = static_cast<Block*>(pointer);
+        if (block < m_blocks.get() || block >= m_blocks.get() + m_capacity) {
+            ::operator delete(pointer);
+            return;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(block - m_blocks.get()) + 1;
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t replacement = 0;
+        do {
+            m_next[index - 1].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            replacement = (((head >> 32) + 1) << 32) | index;
+        } while (!m_head.compare_exchange_weak(head, replacement, std::memory_order_release,
+                                               std::memory_order_relaxed));
+        (void)bytes;
+    }
+
+    /**
+     * @brief Get the number of blocks
+     * @return Pool capacity
+     */
+    size_t getCapacity() const { return m_capacity; }
+
+    /**
+     * @brief Get the number of allocations that had to use the heap
+     * @return Heap allocation count (stays 0 while the pool is large enough)
+     */
+    size_t getHeapAllocationCount() const { return m_heapAllocations.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        unsigned char bytes[kBlockSize];
+    };
+
+    size_t m_capacity;                               ///< Number of blocks
+    std::unique_ptr<Block[]> m_blocks;               ///< Block storage
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next; ///< Free-list links (index + 1, 0 = end)
+    std::atomic<uint64_t> m_head{0};                 ///< Version tag (high) and first free index + 1 (low)
+    std::atomic<size_t> m_heapAllocations{0};        ///< Allocations that fell back to the heap
+};
+
+/**
+ * @class EventPoolAllocator
+ * @brief Standard allocator drawing from an EventPool, for std::allocate_shared
+ */
+template <typename T>
+class EventPoolAllocator {
+public:
+    using value_type = T;
+
+    explicit EventPoolAllocator(std::shared_ptr<EventPool> pool) : m_pool(std::move(pool)) {}
+
+    template <typename U>
+    EventPoolAllocator(const EventPoolAllocator<U>& other) : m_pool(other.getPool()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_pool->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* pointer, size_t n) { m_pool->deallocate(pointer, n * sizeof(T)); }
+
+    const std::shared_ptr<EventPool>& getPool() const { return m_pool; }
+
+    template <typename U>
+    bool operator==(const EventPoolAllocator<U>& other) const { return m_pool == other.getPool(); }
+    template <typename U>
+    bool operator!=(const EventPoolAllocator<U>& other) const { return m_pool != other.getPool(); }
+
+private:
+    std::shared_ptr<EventPool> m_pool;
+};
+
+/**
+ * @brief Create an event in pooled memory
+ *
+ * Drop-in for makeEvent() on hot paths; without a pool it is makeEvent().
+ *
+ * @param pool Pool to allocate from (may be null)
+ * @param args Event constructor arguments
+ * @return The new event
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooledEvent(const std::shared_ptr<EventPool>& pool, Args&&... args) {
+    if (!pool) {
+        return makeEvent<T>(std::forward<Args>(args)...);
+    }
+    return std::allocate_shared<T>(EventPoolAllocator<T>(pool), std::forward<Args>(args)...);
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @class GridPool
+ * @brief Recycled, cache-line aligned memory for grid-sized buffers
+ *
+ * Wavefunctions, operator tables, density levels and scratch buffers take
+ * their storage from the shared pool through GridAllocator. Every block is
+ * aligned to kAlignment bytes, which satisfies the SIMD codelets FFTW picks
+ * for fftw_malloc'd arrays and keeps rows of the SIMD kernels on cache-line
+ * boundaries.
+ *
+ * Blocks of at least kMinPooledBytes are kept when they are released and
+ * handed out again to the next request of exactly the same size, so
+ * resizing a run back and forth or rebuilding an engine with the same grid
+ * does not go back to the system allocator. The oldest cached blocks are
+ * freed once the cache grows past its limit.
+ *
+ * Fresh blocks are first-touched in parallel before they are returned: one
+ * byte per page is written by an OpenMP team with a static schedule, so on
+ * NUMA machines each page lands on the node of the thread that owns that
+ * part of the grid in the solver's own static loops. The team size comes
+ * from the innermost FirstTouchScope of the allocating thread, which the
+ * engines open with their solver thread count. Recycled blocks keep the
+ * placement of their first use.
+ */
+class GridPool {
+public:
+    static constexpr size_t kAlignment = 64;                 ///< Alignment of every block in bytes
+    static constexpr size_t kMinPooledBytes = 64 * 1024;     ///< Smaller blocks are neither cached nor touched
+    static constexpr size_t kPageSize = 4096;                ///< Stride of the first-touch writes
+    static constexpr size_t kDefaultCacheLimit = size_t(1) << 30;  ///< Default bytes kept for reuse
+
+    /**
+     * @brief Sets the first-touch team size of the current thread while it lives
+     */
+    class FirstTouchScope {
+    public:
+        /**
+         * @brief Open a scope
+         * @param numThreads Threads that first-touch fresh blocks (0 = OpenMP default)
+         */
+        explicit FirstTouchScope(int numThreads) : m_previous(touchThreads()) { touchThreads() = numThreads; }
+        ~FirstTouchScope() { touchThreads() = m_previous; }
+
+        FirstTouchScope(const FirstTouchScope&) = delete;
+        FirstTouchScope& operator=(const FirstTouchScope&) = delete;
+
+    private:
+        int m_previous;  ///< Team size of the enclosing scope
+    };
+
+    /**
+     * @brief Get the pool shared by the whole process
+     *
+     * The pool is never destroyed, so buffers held by static objects can
+     * still be released during shutdown.
+     *
+     * @return The shared pool
+     */
+    static GridPool& shared() {
+        static GridPool* pool = new GridPool();
+        return *pool;
+    }
+
+    /**
+     * @brief Create a pool
+     * @param cacheLimit Bytes of released blocks to keep for reuse
+     */
+    explicit GridPool(size_t cacheLimit = kDefaultCacheLimit) : m_cacheLimit(cacheLimit) {}
+
+    ~GridPool() { trim(); }
+
+    GridPool(const GridPool&) = delete;
+    GridPool& operator=(const GridPool&) = delete;
+
+    /**
+     * @brief Take an aligned block
+     * @param bytes Block size
+     * @return A cached block of exactly this size, or a fresh first-touched one
+     * @throws std::bad_alloc if the system allocator fails
+     */
+    void* allocate(size_t bytes) {
+        if (bytes >= kMinPooledBytes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Most recently released first, its pages are the likeliest to be cached
+            for (size_t n = m_cached.size(); n-- > 0;) {
+                if (m_cached[n].bytes == bytes) {
+                    void* pointer = m_cached[n].pointer;
+                    m_cached.erase(m_cached.begin() + static_cast<std::ptrdiff_t>(n));
+                    m_cachedBytes -= bytes;
+                    m_reused.fetch_add(1, std::memory_order_relaxed);
+                    m_liveBytes.fetch_add(bytes, std::memory_order_relaxed);
+                    return pointer;
+                }
+            }
+        }
+        void* pointer = ::operator new(bytes, std::align_val_t(kAlignment));
+        m_fresh.fetch_add(1, std::memory_order_relaxed);
+        m_liveBytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (bytes >= kMinPooledBytes) {
+            firstTouch(pointer, bytes, touchThreads());
+        }
+        return pointer;
+    }
+
+    /**
+     * @brief Return a block taken with allocate()
+     * @param pointer Block to return
+     * @param bytes Size passed to allocate()
+     */
+    void deallocate(void* pointer, size_t bytes) {
+        m_liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        if (bytes >= kMinPooledBytes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (bytes <= m_cacheLimit) {
+                m_cached.push_back(Block{bytes, pointer});
+                m_cachedBytes += bytes;
+                evict(m_cacheLimit);
+                return;
+            }
+        }
+        ::operator delete(pointer, std::align_val_t(kAlignment));
+    }
+
+    /**
+     * @brief Free every cached block
+     */
+    void trim() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evict(0);
+    }
+
+    /**
+     * @brief Change how many bytes of released blocks are kept
+     * @param bytes New limit; cached blocks beyond it are freed, oldest first
+     */
+    void setCacheLimit(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cacheLimit = bytes;
+        evict(bytes);
+    }
+
+    /**
+     * @brief Get the bytes currently kept for reuse
+     * @return Total size of the cached blocks
+     */
+    size_t getCachedBytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cachedBytes;
+    }
+
+    /**
+     * @brief Get the number of blocks taken from the system allocator
+     * @return Fresh allocation count
+     */
+    size_t getFreshAllocationCount() const { return m_fresh.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of requests served from the cache
+     * @return Reuse count
+     */
+    size_t getReuseCount() const { return m_reused.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the bytes of the blocks currently handed out
+     * @return Total size of the blocks taken and not yet returned
+     */
+    size_t getLiveBytes() const { return m_liveBytes.load(std::memory_order_relaxed); }
+
+private:
+    struct Block {
+        size_t bytes;   ///< Block size
+        void* pointer;  ///< Block start
+    };
+
+    static int& touchThreads() {
+        thread_local int threads = 0;
+        return threads;
+    }
+
+    // Write one byte per page with a static OpenMP schedule
+    static void firstTouch(void* pointer, size_t bytes, int numThreads) {
+        unsigned char* base = static_cast<unsigned char*>(pointer);
+        const std::ptrdiff_t pages = static_cast<std::ptrdiff_t>((bytes + kPageSize - 1) / kPageSize);
+#ifdef _OPENMP
+        const int team = numThreads > 0 ? numThreads : omp_get_max_threads();
+#else
+        const int team = 1;
+        (void)numThreads;
+#endif
+        #pragma omp parallel for schedule(static) num_threads(team)
+        for (std::ptrdiff_t page = 0; page < pages; ++page) {
+            base[static_cast<size_t>(page) * kPageSize] = 0;
+        }
+        (void)team;
+    }
+
+    // Free the oldest cached blocks until at most limit bytes remain; call with m_mutex held
+    void evict(size_t limit) {
+        size_t freed = 0;
+        while (freed < m_cached.size() && m_cachedBytes > limit) {
+            ::operator delete(m_cached[freed].pointer, std::align_val_t(kAlignment));
+            m_cachedBytes -= m_cached[freed].bytes;
+            ++freed;
+        }
+        m_cached.erase(m_cached.begin(), m_cached.begin() + static_cast<std::ptrdiff_t>(freed));
+    }
+
+    mutable std::mutex m_mutex;       ///< Guards the cache
+    std::vector<Block> m_cached;      ///< Released blocks, oldest first
+    size_t m_cachedBytes = 0;         ///< Total size of m_cached
+    size_t m_cacheLimit;              ///< Largest m_cachedBytes kept
+    std::atomic<size_t> m_fresh{0};   ///< Blocks taken from the system allocator
+    std::atomic<size_t> m_reused{0};  ///< Requests served from the cache
+    std::atomic<size_t> m_liveBytes{0};  ///< Blocks handed out and not returned
+};
+
+/**
+ * @class GridAllocator
+ * @brief Standard allocator drawing from the shared GridPool
+ *
+ * Elements are value-initialized by the container as usual; the pool only
+ * decides where the block comes from and which threads touch it first.
+ */
+template <typename T>
+class GridAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static_assert(alignof(T) <= GridPool::kAlignment, "GridAllocator cannot satisfy the element alignment");
+
+    GridAllocator() = default;
+
+    template <typename U>
+    GridAllocator(const GridAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(GridPool::shared().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* pointer, size_t n) { GridPool::shared().deallocate(pointer, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const GridAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const GridAllocator<U>&) const { return false; }
+};
+
+/// Contiguous grid buffer with pooled, aligned storage
+template <typename T>
+using GridVector = std::vector<T, GridAllocator<T>>;
+
+/**
+ * @brief Resize a grid buffer to exactly count elements
+ *
+ * Unlike std::vector::resize, a size change first returns the old block to
+ * the pool and then takes one of exactly the new size, so blocks keep
+ * matching sizes across resizes and can be recycled. Values are kept when
+ * the size does not change and are value-initialized otherwise.
+ *
+ * @param buffer Buffer to resize
+ * @param count New element count
+ */
+template <typename T>
+void resizeGrid(GridVector<T>& buffer, size_t count) {
+    if (buffer.size() == count) {
+        return;
+    }
+    GridVector<T>().swap(buffer);
+    buffer.resize(count);
+}
@@ -0,0 +1,347 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include "DebugUtils.h"
+#include "GridPool.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Resident set size from /proc, 0 where it is not available
+size_t residentBytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+double seconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+// Write one Prometheus metric family header
+void writeHeader(std::ostream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+}  // namespace
+
+// Get the process-wide registry
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::MetricsRegistry() : m_epoch(std::chrono::steady_clock::now()) {}
+
+// Get a stage's metric label
+const char* MetricsRegistry::stageName(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::Potential: return "potential";
+        case MetricStage::FFTForward: return "fft_forward";
+        case MetricStage::FFTBackward: return "fft_backward";
+        case MetricStage::Kinetic: return "kinetic";
+        case MetricStage::Observables: return "observables";
+        case MetricStage::DensityUpload: return "density_upload";
+        case MetricStage::Render: return "render";
+        case MetricStage::EventDispatch: return "event_dispatch";
+        case MetricStage::Count: break;
+    }
+    return "unknown";
+}
+
+// Get a stage's display name
+const char* MetricsRegistry::stageTitle(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::Potential: return "V pass";
+        case MetricStage::FFTForward: return "FFT forward";
+        case MetricStage::FFTBackward: return "FFT backward";
+        case MetricStage::Kinetic: return "K pass";
+        case MetricStage::Observables: return "Observables";
+        case MetricStage::DensityUpload: return "Density upload";
+        case MetricStage::Render: return "Render";
+        case MetricStage::EventDispatch: return "Event dispatch";
+        case MetricStage::Count: break;
+    }
+    return "Unknown";
+}
+
+// Get the upper bound of a duration bucket
+double MetricsRegistry::bucketBound(size_t bucket) {
+    if (bucket + 1 >= MetricsSnapshot::kBuckets) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::ldexp(1e-6, static_cast<int>(bucket));
+}
+
+// Record one completed pass of a stage
+void MetricsRegistry::recordStage(MetricStage stage, uint64_t nanoseconds, uint64_t bytes) {
+    StageCounters& counters = m_stages[static_cast<size_t>(stage)];
+    size_t bucket = 0;
+    uint64_t bound = 1000;
+    while (bucket + 1 < MetricsSnapshot::kBuckets && nanoseconds > bound) {
+        bound <<= 1;
+        ++bucket;
+    }
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    counters.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    if (bytes > 0) {
+        counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+// Read all counters and the memory footprint
+MetricsSnapshot MetricsRegistry::snapshot() const {
+    MetricsSnapshot snapshot;
+    snapshot.uptimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_epoch).count();
+    snapshot.steps = m_steps.load(std::memory_order_relaxed);
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const StageCounters& counters = m_stages[s];
+        MetricsSnapshot::Stage& stage = snapshot.stages[s];
+        stage.count = counters.count.load(std::memory_order_relaxed);
+        stage.nanoseconds = counters.nanoseconds.load(std::memory_order_relaxed);
+        stage.bytes = counters.bytes.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < MetricsSnapshot::kBuckets; ++b) {
+            stage.buckets[b] = counters.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    snapshot.gridBytes = GridPool::shared().getLiveBytes();
+    snapshot.cachedGridBytes = GridPool::shared().getCachedBytes();
+    snapshot.residentBytes = residentBytes();
+    return snapshot;
+}
+
+// Format a snapshot in the Prometheus text exposition format
+std::string MetricsRegistry::formatPrometheus(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out.precision(9);
+
+    writeHeader(out, "qmsim_stage_seconds", "histogram", "Wall time of the solver and renderer passes by stage");
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const MetricsSnapshot::Stage& stage = snapshot.stages[s];
+        const char* name = stageName(static_cast<MetricStage>(s));
+        // Prometheus buckets are cumulative
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < MetricsSnapshot::kBuckets; ++b) {
+            cumulative += stage.buckets[b];
+            out << "qmsim_stage_seconds_bucket{stage=\"" << name << "\",le=\"";
+            if (b + 1 < MetricsSnapshot::kBuckets) {
+                out << bucketBound(b);
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << '\n';
+        }
+        out << "qmsim_stage_seconds_sum{stage=\"" << name << "\"} " << seconds(stage.nanoseconds) << '\n';
+        out << "qmsim_stage_seconds_count{stage=\"" << name << "\"} " << stage.count << '\n';
+    }
+
+    writeHeader(out, "qmsim_stage_bytes_total", "counter", "Memory traffic of the passes by stage");
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        out << "qmsim_stage_bytes_total{stage=\"" << stageName(static_cast<MetricStage>(s)) << "\"} "
+            << snapshot.stages[s].bytes << '\n';
+    }
+
+    writeHeader(out, "qmsim_steps_total", "counter", "Solver time steps taken");
+    out << "qmsim_steps_total " << snapshot.steps << '\n';
+    writeHeader(out, "qmsim_uptime_seconds", "gauge", "Time since the metrics registry was created");
+    out << "qmsim_uptime_seconds " << snapshot.uptimeSeconds << '\n';
+    writeHeader(out, "qmsim_grid_bytes", "gauge", "Grid buffers in use");
+    out << "qmsim_grid_bytes " << snapshot.gridBytes << '\n';
+    writeHeader(out, "qmsim_grid_cached_bytes", "gauge", "Released grid buffers kept for reuse");
+    out << "qmsim_grid_cached_bytes " << snapshot.cachedGridBytes << '\n';
+    writeHeader(out, "qmsim_resident_bytes", "gauge", "Resident set size of the process");
+    out << "qmsim_resident_bytes " << snapshot.residentBytes << '\n';
+    return out.str();
+}
+
+// Format a snapshot as a JSON object
+std::string MetricsRegistry::formatJson(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out.precision(9);
+    out << "{\"uptimeSeconds\":" << snapshot.uptimeSeconds
+        << ",\"steps\":" << snapshot.steps
+        << ",\"memory\":{\"gridBytes\":" << snapshot.gridBytes
+        << ",\"cachedGridBytes\":" << snapshot.cachedGridBytes
+        << ",\"residentBytes\":" << snapshot.residentBytes << '}';
+
+    // The last bucket is unbounded, so only the finite bounds are listed
+    out << ",\"bucketBoundsSeconds\":[";
+    for (size_t b = 0; b + 1 < MetricsSnapshot::kBuckets; ++b) {
+        out << (b > 0 ? "," : "") << bucketBound(b);
+    }
+    out << "],\"stages\":{";
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const MetricsSnapshot::Stage& stage = snapshot.stages[s];
+        out << (s > 0 ? "," : "") << '"' << stageName(static_cast<MetricStage>(s)) << "\":{"
+            << "\"count\":" << stage.count
+            << ",\"seconds\":" << seconds(stage.nanoseconds)
+            << ",\"bytes\":" << stage.bytes
+            << ",\"buckets\":[";
+        for (size_t b = 0; b < MetricsSnapshot::kBuckets; ++b) {
+            out << (b > 0 ? "," : "") << stage.buckets[b];
+        }
+        out << "]}";
+    }
+    out << "}}\n";
+    return out.str();
+}
+
+// Write the current totals to a file through a temporary one
+void MetricsRegistry::writeFile(const std::string& path) const {
+    const std::filesystem::path target(path);
+    const MetricsSnapshot totals = snapshot();
+    const std::string text = target.extension() == ".json" ? formatJson(totals) : formatPrometheus(totals);
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << text;
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write metrics file " + temporary);
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot move metrics file to " + path + ": " + error.message());
+    }
+}
+
+// Create an empty history
+MetricsHistory::MetricsHistory(size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+// Append a value to a series, overwriting the oldest once full
+void MetricsHistory::push(std::vector<float>& series, double value) const {
+    if (series.size() < m_capacity) {
+        series.push_back(static_cast<float>(value));
+    } else {
+        series[m_offset] = static_cast<float>(value);
+    }
+}
+
+// Add a snapshot and append the interval since the previous one
+void MetricsHistory::sample(const MetricsSnapshot& snapshot) {
+    if (!m_hasSample) {
+        m_previous = snapshot;
+        m_hasSample = true;
+        return;
+    }
+
+    Interval interval;
+    interval.seconds = snapshot.uptimeSeconds - m_previous.uptimeSeconds;
+    const double wall = interval.seconds > 0.0 ? interval.seconds : 0.0;
+    if (wall > 0.0) {
+        interval.stepsPerSecond = static_cast<double>(snapshot.steps - m_previous.steps) / wall;
+    }
+
+    uint64_t trafficBytes = 0;
+    uint64_t trafficNanoseconds = 0;
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const MetricsSnapshot::Stage& now = snapshot.stages[s];
+        const MetricsSnapshot::Stage& before = m_previous.stages[s];
+        const uint64_t calls = now.count - before.count;
+        const uint64_t nanoseconds = now.nanoseconds - before.nanoseconds;
+        const uint64_t bytes = now.bytes - before.bytes;
+        if (calls > 0) {
+            interval.milliseconds[s] = static_cast<double>(nanoseconds) * 1e-6 / static_cast<double>(calls);
+        }
+        if (wall > 0.0) {
+            interval.callsPerSecond[s] = static_cast<double>(calls) / wall;
+        }
+        if (bytes > 0 && nanoseconds > 0) {
+            interval.stageGigabytesPerSecond[s] = static_cast<double>(bytes) / static_cast<double>(nanoseconds);
+            trafficBytes += bytes;
+            trafficNanoseconds += nanoseconds;
+        }
+    }
+    // Bytes per nanosecond are GB/s
+    if (trafficNanoseconds > 0) {
+        interval.gigabytesPerSecond = static_cast<double>(trafficBytes) / static_cast<double>(trafficNanoseconds);
+    }
+
+    const bool full = m_stepsPerSecond.size() == m_capacity;
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        push(m_stageMilliseconds[s], interval.milliseconds[s]);
+    }
+    push(m_stepsPerSecond, interval.stepsPerSecond);
+    push(m_gigabytesPerSecond, interval.gigabytesPerSecond);
+    if (full) {
+        m_offset = (m_offset + 1) % m_capacity;
+    }
+
+    m_latest = interval;
+    m_previous = snapshot;
+}
+
+// Start exporting
+MetricsExporter::MetricsExporter(std::string path, double intervalSeconds)
+    : m_path(std::move(path)), m_interval(intervalSeconds)
+{
+    if (intervalSeconds > 0.0) {
+        m_thread = std::thread(&MetricsExporter::run, this);
+    }
+}
+
+// Stop and write the final totals, logging a failure
+MetricsExporter::~MetricsExporter() {
+    try {
+        stop();
+    }
+    catch (const std::exception& e) {
+        ERROR_LOG("MetricsExporter", e.what());
+    }
+}
+
+// Stop the periodic writes and write the final totals
+void MetricsExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped) {
+            return;
+        }
+        m_stopping = true;
+        m_stopped = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    MetricsRegistry::getInstance().writeFile(m_path);
+    m_writes.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Write every interval until stopped
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wake.wait_for(lock, m_interval, [this] { return m_stopping; })) {
+        lock.unlock();
+        try {
+            MetricsRegistry::getInstance().writeFile(m_path);
+            m_writes.fetch_add(1, std::memory_order_relaxed);
+        }
+        catch (const std::exception& e) {
+            ERROR_LOG("MetricsExporter", e.what());
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Compile stage timers in (1, the default) or out (0)
+ *
+ * An enabled timer reads the clock twice and adds to a few relaxed
+ * atomics, which is negligible next to a pass over the grid, so release
+ * builds keep them and every run can be watched.
+ */
+#ifndef QMSIM_ENABLE_METRICS
+#define QMSIM_ENABLE_METRICS 1
+#endif
+
+/**
+ * @brief Stages of a time step and of a displayed frame timed by the MetricsRegistry
+ */
+enum class MetricStage {
+    Potential,      ///< V pass: a potential stage applied in position space
+    FFTForward,     ///< Forward FFT to k-space
+    FFTBackward,    ///< Backward FFT to position space
+    Kinetic,        ///< K pass: a kinetic stage applied in k-space
+    Observables,    ///< Norm, moments, energy and region probabilities
+    DensityUpload,  ///< Copy of a frame into the display texture
+    Render,         ///< Drawing the uploaded frame
+    EventDispatch,  ///< Re-publishing engine events on the application bus
+    Count
+};
+
+/// Number of timed stages
+constexpr size_t kMetricStageCount = static_cast<size_t>(MetricStage::Count);
+
+/**
+ * @struct MetricsSnapshot
+ * @brief Totals of the registry at one point in time
+ *
+ * All counts are cumulative since the start of the process; rates follow
+ * from the difference of two snapshots (see MetricsHistory).
+ */
+struct MetricsSnapshot {
+    /// Duration buckets: bucket b counts durations up to 2^b microseconds, the last one the rest
+    static constexpr size_t kBuckets = 24;
+
+    struct Stage {
+        uint64_t count = 0;        ///< Completed passes
+        uint64_t nanoseconds = 0;  ///< Wall time spent in them
+        uint64_t bytes = 0;        ///< Memory traffic of the passes (see ScopedStageTimer)
+        std::array<uint64_t, kBuckets> buckets{};  ///< Passes per duration bucket
+    };
+
+    double uptimeSeconds = 0.0;  ///< Time since the registry was created
+    uint64_t steps = 0;          ///< Solver time steps taken
+    size_t gridBytes = 0;        ///< Grid buffers in use (GridPool)
+    size_t cachedGridBytes = 0;  ///< Released grid buffers kept for reuse
+    size_t residentBytes = 0;    ///< Resident set size of the process (0 where unknown)
+    std::array<Stage, kMetricStageCount> stages{};  ///< Totals per MetricStage
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Process-wide performance counters fed by the engines and the renderer
+ *
+ * Engines time their passes with METRICS_SCOPE and count their steps with
+ * addSteps(); the renderer and the simulation worker time the upload,
+ * render and event dispatch stages the same way. Every counter is a
+ * relaxed atomic, so engines on several threads (sweeps, OpenMP callers,
+ * the render thread) record without locks. Stage durations also go into a
+ * log2 histogram, which the Prometheus export publishes as a histogram
+ * metric.
+ */
+class MetricsRegistry {
+public:
+    /**
+     * @brief Get the process-wide registry
+     * @return The registry
+     */
+    static MetricsRegistry& getInstance();
+
+    /**
+     * @brief Get a stage's metric label, e.g. "fft_forward"
+     * @param stage Stage
+     * @return Lower-case identifier used in the exports
+     */
+    static const char* stageName(MetricStage stage);
+
+    /**
+     * @brief Get a stage's display name, e.g. "FFT forward"
+     * @param stage Stage
+     * @return Name shown in the diagnostics panel
+     */
+    static const char* stageTitle(MetricStage stage);
+
+    /**
+     * @brief Get the upper bound of a duration bucket
+     * @param bucket Bucket index below MetricsSnapshot::kBuckets
+     * @return Bound in seconds; infinity for the last bucket
+     */
+    static double bucketBound(size_t bucket);
+
+    /**
+     * @brief Record one completed pass of a stage
+     * @param stage Stage
+     * @param nanoseconds Wall time of the pass
+     * @param bytes Memory traffic of the pass
+     */
+    void recordStage(MetricStage stage, uint64_t nanoseconds, uint64_t bytes = 0);
+
+    /**
+     * @brief Count solver time steps
+     * @param steps Steps taken
+     */
+    void addSteps(uint64_t steps) { m_steps.fetch_add(steps, std::memory_order_relaxed); }
+
+    /**
+     * @brief Read all counters and the memory footprint
+     * @return Current totals
+     */
+    MetricsSnapshot snapshot() const;
+
+    /**
+     * @brief Format a snapshot in the Prometheus text exposition format
+     * @param snapshot Totals to format
+     * @return Metrics named qmsim_*, one sample per line
+     */
+    static std::string formatPrometheus(const MetricsSnapshot& snapshot);
+
+    /**
+     * @brief Format a snapshot as a JSON object
+     * @param snapshot Totals to format
+     * @return JSON text
+     */
+    static std::string formatJson(const MetricsSnapshot& snapshot);
+
+    /**
+     * @brief Write the current totals to a file
+     *
+     * A path ending in .json gets JSON, any other the Prometheus text
+     * format (name it *.prom for the node exporter's textfile collector).
+     * The file is written next to the target and renamed over it, so
+     * readers never see a partial file.
+     *
+     * @param path Output file
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void writeFile(const std::string& path) const;
+
+private:
+    struct StageCounters {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> nanoseconds{0};
+        std::atomic<uint64_t> bytes{0};
+        std::array<std::atomic<uint64_t>, MetricsSnapshot::kBuckets> buckets{};
+    };
+
+    MetricsRegistry();
+
+    std::chrono::steady_clock::time_point m_epoch;      ///< Creation time, the origin of uptimeSeconds
+    std::atomic<uint64_t> m_steps{0};                    ///< Solver steps
+    std::array<StageCounters, kMetricStageCount> m_stages;  ///< Counters per stage
+};
+
+/**
+ * @class ScopedStageTimer
+ * @brief Records the lifetime of a scope as one pass of a stage
+ *
+ * The byte count is the traffic of one sweep over the arrays the pass
+ * streams (e.g. ψ read and written plus its phase table), so bytes over
+ * time is a lower bound of the bandwidth the pass achieved.
+ */
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(MetricStage stage, uint64_t bytes = 0)
+        : m_stage(stage), m_bytes(bytes), m_begin(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedStageTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - m_begin;
+        MetricsRegistry::getInstance().recordStage(
+            m_stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+            m_bytes);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    MetricStage m_stage;
+    uint64_t m_bytes;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+#define QMSIM_METRICS_CONCAT_INNER(a, b) a##b
+#define QMSIM_METRICS_CONCAT(a, b) QMSIM_METRICS_CONCAT_INNER(a, b)
+
+#if QMSIM_ENABLE_METRICS
+/// Time the rest of the enclosing scope as one pass of a MetricStage moving bytes of memory traffic
+#define METRICS_SCOPE(stage, bytes) \
+    ScopedStageTimer QMSIM_METRICS_CONCAT(qmsimMetric_, __LINE__)(stage, static_cast<uint64_t>(bytes))
+/// Count solver time steps
+#define METRICS_STEPS(steps) MetricsRegistry::getInstance().addSteps(static_cast<uint64_t>(steps))
+#else
+// The arguments stay referenced but are not evaluated
+#define METRICS_SCOPE(stage, bytes) static_cast<void>(sizeof(bytes))
+#define METRICS_STEPS(steps) static_cast<void>(sizeof(steps))
+#endif
+
+/**
+ * @class MetricsHistory
+ * @brief Rolling per-interval rates computed from successive snapshots
+ *
+ * Each sample() after the first appends one interval: the mean duration
+ * of each stage's passes, steps per second and the achieved bandwidth.
+ * Series are ring buffers of at most getCapacity() values; once full,
+ * getOffset() is the index of the oldest value, as ImGui's plot widgets
+ * expect.
+ */
+class MetricsHistory {
+public:
+    /**
+     * @struct Interval
+     * @brief Rates between two snapshots
+     */
+    struct Interval {
+        double seconds = 0.0;             ///< Length of the interval
+        double stepsPerSecond = 0.0;      ///< Solver steps per wall-clock second
+        double gigabytesPerSecond = 0.0;  ///< Traffic of all timed passes over the time spent in them
+        std::array<double, kMetricStageCount> milliseconds{};      ///< Mean duration of a pass per stage
+        std::array<double, kMetricStageCount> callsPerSecond{};    ///< Passes per second per stage
+        std::array<double, kMetricStageCount> stageGigabytesPerSecond{};  ///< Bandwidth per stage
+    };
+
+    /**
+     * @brief Create an empty history
+     * @param capacity Intervals kept per series
+     */
+    explicit MetricsHistory(size_t capacity = 120);
+
+    /**
+     * @brief Add a snapshot; from the second one on, the interval since the previous one is appended
+     * @param snapshot Newer totals than the previous sample
+     */
+    void sample(const MetricsSnapshot& snapshot);
+
+    /**
+     * @brief Get the most recent interval
+     * @return Rates of the last interval (zero before the second sample)
+     */
+    const Interval& getLatest() const { return m_latest; }
+
+    /**
+     * @brief Get the last snapshot passed to sample()
+     * @return Snapshot, e.g. for the memory footprint
+     */
+    const MetricsSnapshot& getSnapshot() const { return m_previous; }
+
+    /**
+     * @brief Get the mean pass duration per interval of a stage
+     * @param stage Stage
+     * @return Milliseconds, in ring order (see getOffset())
+     */
+    const std::vector<float>& getStageMilliseconds(MetricStage stage) const {
+        return m_stageMilliseconds[static_cast<size_t>(stage)];
+    }
+
+    /**
+     * @brief Get the steps per second of each interval
+     * @return Rates, in ring order (see getOffset())
+     */
+    const std::vector<float>& getStepsPerSecond() const { return m_stepsPerSecond; }
+
+    /**
+     * @brief Get the achieved bandwidth of each interval
+     * @return GB/s, in ring order (see getOffset())
+     */
+    const std::vector<float>& getGigabytesPerSecond() const { return m_gigabytesPerSecond; }
+
+    /**
+     * @brief Get the index of the oldest value in each series
+     * @return Ring offset; 0 until the series are full
+     */
+    size_t getOffset() const { return m_offset; }
+
+    /**
+     * @brief Get the number of intervals kept per series
+     * @return Capacity
+     */
+    size_t getCapacity() const { return m_capacity; }
+
+private:
+    // Append a value to a series, overwriting the oldest once full
+    void push(std::vector<float>& series, double value) const;
+
+    size_t m_capacity;          ///< Values kept per series
+    size_t m_offset = 0;        ///< Oldest value once the series are full
+    bool m_hasSample = false;   ///< Whether m_previous holds a snapshot
+    MetricsSnapshot m_previous; ///< Last sampled totals
+    Interval m_latest;          ///< Rates of the last interval
+    std::array<std::vector<float>, kMetricStageCount> m_stageMilliseconds;  ///< Mean pass duration per stage
+    std::vector<float> m_stepsPerSecond;      ///< Steps per second
+    std::vector<float> m_gigabytesPerSecond;  ///< Achieved bandwidth
+};
+
+/**
+ * @class MetricsExporter
+ * @brief Rewrites a metrics file periodically on a background thread
+ *
+ * Used by headless runs so a scraper (or anyone with `watch cat`) can
+ * follow them; the file is written once more when the exporter stops.
+ * Errors of the periodic writes are logged, not thrown.
+ */
+class MetricsExporter {
+public:
+    /**
+     * @brief Start exporting
+     * @param path Output file, see MetricsRegistry::writeFile()
+     * @param intervalSeconds Time between writes (<= 0: only when stopped)
+     */
+    MetricsExporter(std::string path, double intervalSeconds);
+
+    /**
+     * @brief Stop and write the final totals, logging a failure
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief Stop the periodic writes and write the final totals
+     * @throws std::runtime_error if the final write fails
+     */
+    void stop();
+
+    /**
+     * @brief Get the number of files written so far
+     * @return Write count, including the final one
+     */
+    size_t getWriteCount() const { return m_writes.load(std::memory_order_relaxed); }
+
+private:
+    // Write every interval until stopped
+    void run();
+
+    std::string m_path;                ///< Output file
+    std::chrono::duration<double> m_interval;  ///< Time between writes
+    std::mutex m_mutex;                ///< Guards m_stopping
+    std::condition_variable m_wake;    ///< Signals stop() to the thread
+    bool m_stopping = false;           ///< Set by stop()
+    bool m_stopped = false;            ///< Final file written
+    std::atomic<size_t> m_writes{0};   ///< Files written
+    std::thread m_thread;              ///< Periodic writer (not started without an interval)
+};
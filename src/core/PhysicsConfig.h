@@ -6,6 +6,14 @@
 struct PotentialConfig {
     std::string type;
     std::vector<double> parameters;
+    std::string file;                         // Data file of "Grid" potentials (HDF5 or PGM image)
+    std::vector<PotentialConfig> components;  // Summed potentials of "Composite" potentials
+
+    // Lets updateConfig() skip re-evaluating an unchanged potential
+    friend bool operator==(const PotentialConfig& a, const PotentialConfig& b) {
+        return a.type == b.type && a.parameters == b.parameters && a.file == b.file && a.components == b.components;
+    }
+    friend bool operator!=(const PotentialConfig& a, const PotentialConfig& b) { return !(a == b); }
 };
 
 struct Wavepacket {
@@ -17,17 +25,77 @@ struct Wavepacket {
     double ky;
 };
 
+// Rectangle whose enclosed probability is recorded as an observable
+struct ObservableRegion {
+    std::string name;
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+};
+
 struct Output {
-    double checkpointInterval;
-    bool exportObservables;
+    double checkpointInterval = 0.0;  // Simulation time between checkpoints (0 = disabled)
+    bool exportObservables = false;
+    int checkpointCompression = 0;    // Deflate level 1-9 for checkpoint files (0 = uncompressed)
+    std::string observablesFormat = "csv";  // Observable time series format: "csv" or "binary"
+    std::string snapshotStream;       // Batch snapshot stream encoding, e.g. "float16" (empty = one density_<step>.f32 per snapshot)
+    std::vector<ObservableRegion> regions;  // Regions for transmission/reflection probabilities
+};
+
+// Complex absorbing layer along the domain edges. Inside the layer the
+// potential gains -i*W with W = strength * (depth / width)^2, so probability
+// that reaches the edges is removed instead of wrapping around.
+struct AbsorbingBoundary {
+    double width = 0.0;      // Layer thickness in domain units (0 = no absorber)
+    double strength = 10.0;  // W at the domain edge
+
+    friend bool operator==(const AbsorbingBoundary& a, const AbsorbingBoundary& b) {
+        return a.width == b.width && a.strength == b.strength;
+    }
+    friend bool operator!=(const AbsorbingBoundary& a, const AbsorbingBoundary& b) { return !(a == b); }
+};
+
+// Time integration settings
+struct Integration {
+    std::string scheme = "strang";  // Splitting: "strang", "yoshida4" or "blanes-moan4"
+    bool adaptive = false;          // Let advanceFor() adjust dt from an embedded Strang error estimate (fourth-order schemes only)
+    double tolerance = 1e-6;        // Target L2 error of ψ per adaptive step
+    double minDt = 1e-6;            // Smallest adaptive step
+    double maxDt = 0.1;             // Largest adaptive step
+};
+
+// Imaginary-time relaxation towards the ground state and low eigenstates
+struct ImaginaryTime {
+    bool enabled = false;      // Relax the initial state before a batch run (set by an imaginaryTime config block)
+    double dt = 0.01;          // Initial imaginary time step
+    double minDt = 0.001;      // Smallest step; dt is halved on convergence until it reaches this
+    double tolerance = 1e-9;   // Converged when the energy estimate changes by less than this between checks
+    int checkInterval = 10;    // Steps between energy checks and renormalizations
+    int maxSteps = 100000;     // Steps per state before giving up
+    int states = 1;            // Eigenstates to find, lowest first
+};
+
+// FFTW planning settings
+struct FFTWConfig {
+    std::string planner = "measure";  // "estimate", "measure", "patient" or "exhaustive"
+    std::string wisdomDir;            // Directory of the persistent wisdom store (empty = disabled)
 };
 
 struct PhysicsConfig {
     int nx;
     int ny;
+    double lx = 20.0;  // Physical domain length in x, centred on the origin
+    double ly = 20.0;  // Physical domain length in y, centred on the origin
     double dt;
     double omega;
     PotentialConfig potential;
     Wavepacket wavepacket;
     Output output;
+    AbsorbingBoundary absorber;
+    Integration integration;
+    ImaginaryTime imaginaryTime;
+    int numThreads = 0;  // Solver threads for OpenMP loops and FFTW plans (0 = OpenMP default)
+    std::string precision = "double";  // Scalar type of the simulation state: "double" or "float"
+    FFTWConfig fftw;
 };
\ No newline at end of file
@@ -0,0 +1,506 @@
+#include "Potential.h"
+#include <hdf5.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Closes an HDF5 identifier when it goes out of scope
+class Handle {
+public:
+    Handle(hid_t id, herr_t (*close)(hid_t), const std::string& what) : m_id(id), m_close(close) {
+        if (m_id < 0) {
+            throw std::runtime_error("HDF5: cannot " + what);
+        }
+    }
+    ~Handle() { m_close(m_id); }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    operator hid_t() const { return m_id; }
+
+private:
+    hid_t m_id;
+    herr_t (*m_close)(hid_t);
+};
+
+// Read the 2D "potential" dataset of an HDF5 file
+std::vector<double> readHDF5(const std::string& path, int& nx, int& ny) {
+    Handle file(H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose, "open " + path);
+    Handle dataset(H5Dopen2(file, "potential", H5P_DEFAULT), H5Dclose, "open potential in " + path);
+    Handle space(H5Dget_space(dataset), H5Sclose, "get dataspace");
+
+    hsize_t dims[2] = {0, 0};
+    if (H5Sget_simple_extent_ndims(space) != 2 || H5Sget_simple_extent_dims(space, dims, nullptr) != 2 ||
+        dims[0] == 0 || dims[1] == 0) {
+        throw std::runtime_error("The potential dataset in " + path + " is not a 2D grid");
+    }
+    ny = static_cast<int>(dims[0]);
+    nx = static_cast<int>(dims[1]);
+
+    std::vector<double> values(static_cast<size_t>(nx) * ny);
+    if (H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()) < 0) {
+        throw std::runtime_error("HDF5: cannot read potential in " + path);
+    }
+    return values;
+}
+
+// Read the next header field of a PGM file, skipping comments
+int readPGMField(std::istream& in, const std::string& path) {
+    in >> std::ws;
+    while (in.peek() == '#') {
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        in >> std::ws;
+    }
+    int value = 0;
+    if (!(in >> value) || value <= 0) {
+        throw std::runtime_error("Invalid PGM header in " + path);
+    }
+    return value;
+}
+
+// Read a binary (P5) or ASCII (P2) greymap, scaled to 0..1, bottom row first
+std::vector<double> readPGM(const std::string& path, int& nx, int& ny) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open potential image " + path);
+    }
+    std::string magic;
+    in >> magic;
+    if (magic != "P5" && magic != "P2") {
+        throw std::runtime_error(path + " is not a PGM image");
+    }
+    nx = readPGMField(in, path);
+    ny = readPGMField(in, path);
+    const int maxValue = readPGMField(in, path);
+    if (maxValue > 65535) {
+        throw std::runtime_error("Invalid PGM maximum value in " + path);
+    }
+    in.get();  // Single whitespace before the raster
+
+    std::vector<double> values(static_cast<size_t>(nx) * ny);
+    const double scale = 1.0 / maxValue;
+    for (int row = ny - 1; row >= 0 && in; --row) {
+        double* out = values.data() + static_cast<size_t>(row) * nx;
+        for (int i = 0; i < nx; ++i) {
+            int level = 0;
+            if (magic == "P2") {
+                in >> level;
+            }
+            else if (maxValue < 256) {
+                level = in.get();
+            }
+            else {
+                const int high = in.get();
+                level = (high << 8) | in.get();
+            }
+            out[i] = level * scale;
+        }
+    }
+    if (!in) {
+        throw std::runtime_error("Truncated PGM image " + path);
+    }
+    return values;
+}
+
+// Get a parameter, or its default when the list is too short
+double parameter(const std::vector<double>& parameters, size_t index, double fallback) {
+    return index < parameters.size() ? parameters[index] : fallback;
+}
+
+// Check whether two grids sample the same points
+bool sameGrid(const GridGeometry& a, const GridGeometry& b) {
+    const double tolerance = 1e-9 * std::max(std::abs(a.dx), std::abs(a.dy));
+    return a.nx == b.nx && a.ny == b.ny && std::abs(a.x0 - b.x0) <= tolerance &&
+           std::abs(a.y0 - b.y0) <= tolerance && std::abs(a.dx - b.dx) <= tolerance &&
+           std::abs(a.dy - b.dy) <= tolerance;
+}
+
+}  // namespace
+
+// Evaluate point by point
+void Potential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = getValue(x[i], y[i]);
+    }
+}
+
+// Evaluate a grid row through the batched interface
+void Potential::sampleRow(const GridGeometry& grid, int row, double* out) const {
+    std::vector<double> x(static_cast<size_t>(grid.nx));
+    const std::vector<double> y(x.size(), grid.y0 + row * grid.dy);
+    for (int i = 0; i < grid.nx; ++i) {
+        x[i] = grid.x0 + i * grid.dx;
+    }
+    evaluate(x.data(), y.data(), out, x.size());
+}
+
+// Create a potential from its type name and parameters
+std::unique_ptr<Potential> Potential::create(const std::string& type, const std::vector<double>& parameters) {
+    if (type == "SquareBarrier") {
+        return std::make_unique<SquareBarrierPotential>(parameter(parameters, 0, 1.0), parameter(parameters, 1, 0.5),
+                                                        parameter(parameters, 2, 0.0), parameter(parameters, 3, 0.0));
+    }
+    if (type == "HarmonicOscillator") {
+        return std::make_unique<HarmonicOscillatorPotential>(parameter(parameters, 0, 1.0));
+    }
+    if (type == "Rectangle") {
+        return std::make_unique<RectanglePotential>(parameter(parameters, 0, 1.0), parameter(parameters, 1, -0.5),
+                                                    parameter(parameters, 2, 0.5), parameter(parameters, 3, -0.5),
+                                                    parameter(parameters, 4, 0.5));
+    }
+    return std::make_unique<FreeSpacePotential>();
+}
+
+// Create a potential from a configuration, including grid and composite ones
+std::unique_ptr<Potential> Potential::create(const PotentialConfig& config, double lx, double ly) {
+    // Grid files cover the whole domain unless their parameters say otherwise
+    if (config.type == "Grid") {
+        const std::vector<double>& p = config.parameters;
+        return GridPotential::load(config.file, parameter(p, 0, 1.0), parameter(p, 1, -lx / 2),
+                                   parameter(p, 2, lx / 2), parameter(p, 3, -ly / 2),
+                                   parameter(p, 4, ly / 2));
+    }
+    if (config.type == "Composite") {
+        auto composite = std::make_unique<CompositePotential>();
+        for (const PotentialConfig& component : config.components) {
+            composite->add(create(component, lx, ly));
+        }
+        return composite;
+    }
+    if (config.type == "Driven") {
+        const std::vector<double>& p = config.parameters;
+        auto base = config.components.size() > 0 ? create(config.components[0], lx, ly) : nullptr;
+        auto coupling = config.components.size() > 1 ? create(config.components[1], lx, ly)
+                                                     : std::make_unique<FreeSpacePotential>();
+        return std::make_unique<DrivenPotential>(
+            std::move(base), std::move(coupling),
+            DrivenPotential::sineDrive(parameter(p, 0, 1.0), parameter(p, 1, 1.0), parameter(p, 2, 0.0),
+                                       parameter(p, 3, 0.0), parameter(p, 4, 0.0), parameter(p, 5, 0.0)));
+    }
+    if (config.type == "Moving") {
+        const std::vector<double>& p = config.parameters;
+        auto shape = config.components.empty() ? std::make_unique<FreeSpacePotential>()
+                                               : create(config.components[0], lx, ly);
+        return std::make_unique<MovingPotential>(
+            std::move(shape), MovingPotential::linearPath(parameter(p, 0, 0.0), parameter(p, 1, 0.0),
+                                                          parameter(p, 2, 0.0), parameter(p, 3, 0.0),
+                                                          parameter(p, 4, 0.0)));
+    }
+    return create(config.type, config.parameters);
+}
+
+// Free space is zero everywhere
+double FreeSpacePotential::getValue(double, double) const {
+    return 0.0;
+}
+
+std::string FreeSpacePotential::getType() const {
+    return "FreeSpace";
+}
+
+void FreeSpacePotential::evaluate(const double*, const double*, double* out, size_t count) const {
+    std::fill(out, out + count, 0.0);
+}
+
+void FreeSpacePotential::sampleRow(const GridGeometry& grid, int, double* out) const {
+    std::fill(out, out + grid.nx, 0.0);
+}
+
+// Constructor
+SquareBarrierPotential::SquareBarrierPotential(double height, double width, double xCenter, double yCenter)
+    : m_height(height), m_width(width < 0.01 ? 0.01 : width), m_xCenter(xCenter), m_yCenter(yCenter) {}
+
+// Height inside the square, zero outside
+double SquareBarrierPotential::getValue(double x, double y) const {
+    const double halfWidth = m_width / 2.0;
+    return (std::abs(x - m_xCenter) <= halfWidth && std::abs(y - m_yCenter) <= halfWidth) ? m_height : 0.0;
+}
+
+std::string SquareBarrierPotential::getType() const {
+    return "SquareBarrier";
+}
+
+// Branch-free select, so the loop vectorizes
+void SquareBarrierPotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    const double halfWidth = m_width / 2.0;
+    for (size_t i = 0; i < count; ++i) {
+        const bool inside = std::abs(x[i] - m_xCenter) <= halfWidth && std::abs(y[i] - m_yCenter) <= halfWidth;
+        out[i] = inside ? m_height : 0.0;
+    }
+}
+
+// Constructor
+HarmonicOscillatorPotential::HarmonicOscillatorPotential(double omega) : m_omega(omega < 0.01 ? 0.01 : omega) {}
+
+// ω²(x² + y²)/2
+double HarmonicOscillatorPotential::getValue(double x, double y) const {
+    return 0.5 * m_omega * m_omega * (x * x + y * y);
+}
+
+std::string HarmonicOscillatorPotential::getType() const {
+    return "HarmonicOscillator";
+}
+
+void HarmonicOscillatorPotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    const double factor = 0.5 * m_omega * m_omega;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = factor * (x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+// Constructor
+RectanglePotential::RectanglePotential(double height, double xMin, double xMax, double yMin, double yMax)
+    : m_height(height), m_xMin(xMin), m_xMax(xMax), m_yMin(yMin), m_yMax(yMax) {}
+
+// Height inside the rectangle (edges included), zero outside
+double RectanglePotential::getValue(double x, double y) const {
+    return (x >= m_xMin && x <= m_xMax && y >= m_yMin && y <= m_yMax) ? m_height : 0.0;
+}
+
+std::string RectanglePotential::getType() const {
+    return "Rectangle";
+}
+
+void RectanglePotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        const bool inside = x[i] >= m_xMin && x[i] <= m_xMax && y[i] >= m_yMin && y[i] <= m_yMax;
+        out[i] = inside ? m_height : 0.0;
+    }
+}
+
+// Constructor
+GridPotential::GridPotential(const GridGeometry& grid, std::vector<double> values)
+    : m_grid(grid), m_values(std::move(values))
+{
+    if (m_grid.nx <= 0 || m_grid.ny <= 0 || m_grid.dx <= 0.0 || m_grid.dy <= 0.0 ||
+        m_values.size() != static_cast<size_t>(m_grid.nx) * m_grid.ny) {
+        throw std::invalid_argument("Grid potential values do not match a " + std::to_string(m_grid.nx) +
+                                    "x" + std::to_string(m_grid.ny) + " grid");
+    }
+}
+
+// Load a potential file covering [xMin, xMax) x [yMin, yMax)
+std::unique_ptr<GridPotential> GridPotential::load(const std::string& path, double scale,
+                                                   double xMin, double xMax, double yMin, double yMax) {
+    if (path.empty()) {
+        throw std::runtime_error("Grid potential has no file");
+    }
+
+    int nx = 0;
+    int ny = 0;
+    const std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::vector<double> values = (extension == "h5" || extension == "hdf5") ? readHDF5(path, nx, ny)
+                                                                             : readPGM(path, nx, ny);
+    for (double& value : values) {
+        value *= scale;
+    }
+
+    // Points sit at cell corners, like the solver's own grid
+    GridGeometry grid;
+    grid.nx = nx;
+    grid.ny = ny;
+    grid.x0 = xMin;
+    grid.y0 = yMin;
+    grid.dx = (xMax - xMin) / nx;
+    grid.dy = (yMax - yMin) / ny;
+    return std::make_unique<GridPotential>(grid, std::move(values));
+}
+
+// Bilinear interpolation, clamped to the grid
+double GridPotential::getValue(double x, double y) const {
+    double value = 0.0;
+    evaluate(&x, &y, &value, 1);
+    return value;
+}
+
+std::string GridPotential::getType() const {
+    return "Grid";
+}
+
+void GridPotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    const int nx = m_grid.nx;
+    const int ny = m_grid.ny;
+    const double* values = m_values.data();
+    for (size_t n = 0; n < count; ++n) {
+        const double u = std::clamp((x[n] - m_grid.x0) / m_grid.dx, 0.0, nx - 1.0);
+        const double v = std::clamp((y[n] - m_grid.y0) / m_grid.dy, 0.0, ny - 1.0);
+        const int i = std::min(static_cast<int>(u), std::max(nx - 2, 0));
+        const int j = std::min(static_cast<int>(v), std::max(ny - 2, 0));
+        const int i1 = std::min(i + 1, nx - 1);
+        const int j1 = std::min(j + 1, ny - 1);
+        const double fx = u - i;
+        const double fy = v - j;
+
+        const double* row0 = values + static_cast<size_t>(j) * nx;
+        const double* row1 = values + static_cast<size_t>(j1) * nx;
+        const double bottom = row0[i] + fx * (row0[i1] - row0[i]);
+        const double top = row1[i] + fx * (row1[i1] - row1[i]);
+        out[n] = bottom + fy * (top - bottom);
+    }
+}
+
+// Copy the stored row when sampling the tabulated grid, interpolate otherwise
+void GridPotential::sampleRow(const GridGeometry& grid, int row, double* out) const {
+    if (sameGrid(grid, m_grid)) {
+        const double* source = m_values.data() + static_cast<size_t>(row) * m_grid.nx;
+        std::copy(source, source + m_grid.nx, out);
+        return;
+    }
+    Potential::sampleRow(grid, row, out);
+}
+
+// Constructor
+CompositePotential::CompositePotential(std::vector<std::unique_ptr<Potential>> components)
+    : m_components(std::move(components)) {}
+
+// Add a summed potential
+void CompositePotential::add(std::unique_ptr<Potential> component) {
+    m_components.push_back(std::move(component));
+}
+
+// Sum of the components
+double CompositePotential::getValue(double x, double y) const {
+    double sum = 0.0;
+    for (const auto& component : m_components) {
+        sum += component->getValue(x, y);
+    }
+    return sum;
+}
+
+std::string CompositePotential::getType() const {
+    return "Composite";
+}
+
+void CompositePotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    std::fill(out, out + count, 0.0);
+    std::vector<double> term(count);
+    for (const auto& component : m_components) {
+        component->evaluate(x, y, term.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] += term[i];
+        }
+    }
+}
+
+// Time-dependent if any component is
+bool CompositePotential::isTimeDependent() const {
+    return std::any_of(m_components.begin(), m_components.end(),
+                       [](const auto& component) { return component->isTimeDependent(); });
+}
+
+void CompositePotential::setTime(double time) {
+    for (const auto& component : m_components) {
+        component->setTime(time);
+    }
+}
+
+// Sum the components' rows, so grid components keep their copy path
+void CompositePotential::sampleRow(const GridGeometry& grid, int row, double* out) const {
+    std::fill(out, out + grid.nx, 0.0);
+    std::vector<double> term(static_cast<size_t>(grid.nx));
+    for (const auto& component : m_components) {
+        component->sampleRow(grid, row, term.data());
+        for (int i = 0; i < grid.nx; ++i) {
+            out[i] += term[i];
+        }
+    }
+}
+
+// Constructor
+DrivenPotential::DrivenPotential(std::unique_ptr<Potential> base, std::unique_ptr<Potential> coupling, Drive drive)
+    : m_base(base ? std::move(base) : std::make_unique<FreeSpacePotential>()),
+      m_coupling(std::move(coupling)),
+      m_drive(std::move(drive)),
+      m_amplitude(m_drive(0.0)) {}
+
+// f(t) = offset + amplitude * sin(omega * t + phase), optionally under a Gaussian pulse
+DrivenPotential::Drive DrivenPotential::sineDrive(double amplitude, double omega, double phase, double offset,
+                                                  double pulseCenter, double pulseWidth) {
+    return [=](double time) {
+        double envelope = 1.0;
+        if (pulseWidth > 0.0) {
+            const double u = (time - pulseCenter) / pulseWidth;
+            envelope = std::exp(-0.5 * u * u);
+        }
+        return offset + amplitude * std::sin(omega * time + phase) * envelope;
+    };
+}
+
+// V0 + f(t) V1
+double DrivenPotential::getValue(double x, double y) const {
+    return m_base->getValue(x, y) + m_amplitude * m_coupling->getValue(x, y);
+}
+
+std::string DrivenPotential::getType() const {
+    return "Driven";
+}
+
+void DrivenPotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    std::vector<double> coupling(count);
+    m_base->evaluate(x, y, out, count);
+    m_coupling->evaluate(x, y, coupling.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] += m_amplitude * coupling[i];
+    }
+}
+
+void DrivenPotential::sampleRow(const GridGeometry& grid, int row, double* out) const {
+    std::vector<double> coupling(static_cast<size_t>(grid.nx));
+    m_base->sampleRow(grid, row, out);
+    m_coupling->sampleRow(grid, row, coupling.data());
+    for (int i = 0; i < grid.nx; ++i) {
+        out[i] += m_amplitude * coupling[i];
+    }
+}
+
+// Evaluate the drive once for all following evaluations
+void DrivenPotential::setTime(double time) {
+    m_base->setTime(time);
+    m_coupling->setTime(time);
+    m_amplitude = m_drive(time);
+}
+
+// Constructor
+MovingPotential::MovingPotential(std::unique_ptr<Potential> shape, Path path)
+    : m_shape(std::move(shape)), m_path(std::move(path))
+{
+    m_path(0.0, m_offsetX, m_offsetY);
+}
+
+// X(t) = vx * t + amplitudeX * sin(omega * t), Y(t) likewise
+MovingPotential::Path MovingPotential::linearPath(double vx, double vy, double amplitudeX, double amplitudeY,
+                                                  double omega) {
+    return [=](double time, double& x, double& y) {
+        const double oscillation = std::sin(omega * time);
+        x = vx * time + amplitudeX * oscillation;
+        y = vy * time + amplitudeY * oscillation;
+    };
+}
+
+// W(x - X, y - Y)
+double MovingPotential::getValue(double x, double y) const {
+    return m_shape->getValue(x - m_offsetX, y - m_offsetY);
+}
+
+std::string MovingPotential::getType() const {
+    return "Moving";
+}
+
+void MovingPotential::evaluate(const double* x, const double* y, double* out, size_t count) const {
+    std::vector<double> shifted(2 * count);
+    for (size_t i = 0; i < count; ++i) {
+        shifted[i] = x[i] - m_offsetX;
+        shifted[count + i] = y[i] - m_offsetY;
+    }
+    m_shape->evaluate(shifted.data(), shifted.data() + count, out, count);
+}
+
+// Move the shape to its offset at the given time
+void MovingPotential::setTime(double time) {
+    m_shape->setTime(time);
+    m_path(time, m_offsetX, m_offsetY);
+}
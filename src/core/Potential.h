@@ -0,0 +1,432 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PhysicsConfig.h"
+
+/**
+ * @struct GridGeometry
+ * @brief Sample positions of a regular grid
+ *
+ * Point (i, j) is at x = x0 + i * dx, y = y0 + j * dy, stored row-major
+ * with rows of constant y.
+ */
+struct GridGeometry {
+    int nx = 0;       ///< Points in x direction
+    int ny = 0;       ///< Points in y direction
+    double x0 = 0.0;  ///< x of the first column
+    double y0 = 0.0;  ///< y of the first row
+    double dx = 1.0;  ///< Spacing in x direction
+    double dy = 1.0;  ///< Spacing in y direction
+};
+
+/**
+ * @class Potential
+ * @brief Potential energy V(x, y) of the simulation
+ *
+ * getValue() evaluates a single point. The solver samples whole grid rows
+ * through sampleRow(), which by default hands the row's coordinates to the
+ * batched evaluate(); concrete potentials override evaluate() with a
+ * loop the compiler can vectorize, so filling a grid costs one virtual
+ * call per row rather than per point. All evaluation methods may be called
+ * from several threads at once.
+ *
+ * Time-dependent potentials evaluate at the time last passed to
+ * setTime(), which must not be called while another thread evaluates.
+ */
+class Potential {
+public:
+    virtual ~Potential() = default;
+
+    /**
+     * @brief Evaluate the potential at one point
+     * @param x x coordinate
+     * @param y y coordinate
+     * @return V(x, y)
+     */
+    virtual double getValue(double x, double y) const = 0;
+
+    /**
+     * @brief Get the factory name of the potential
+     * @return Type name as accepted by create()
+     */
+    virtual std::string getType() const = 0;
+
+    /**
+     * @brief Evaluate the potential at many points
+     *
+     * The default calls getValue() for each point.
+     *
+     * @param x count x coordinates
+     * @param y count y coordinates
+     * @param out Destination for count values
+     * @param count Number of points
+     */
+    virtual void evaluate(const double* x, const double* y, double* out, size_t count) const;
+
+    /**
+     * @brief Evaluate the potential on one row of a grid
+     *
+     * The default builds the row's coordinates and calls evaluate().
+     *
+     * @param grid Grid geometry
+     * @param row Row index, 0 <= row < grid.ny
+     * @param out Destination for grid.nx values
+     */
+    virtual void sampleRow(const GridGeometry& grid, int row, double* out) const;
+
+    /**
+     * @brief Check whether the potential changes with time
+     * @return True if setTime() changes the values
+     */
+    virtual bool isTimeDependent() const { return false; }
+
+    /**
+     * @brief Set the time the potential is evaluated at
+     *
+     * Static potentials ignore it.
+     *
+     * @param time Simulation time
+     */
+    virtual void setTime(double time) { (void)time; }
+
+    /**
+     * @brief Create a potential from its type name and parameters
+     *
+     * Unknown types give free space; missing parameters take defaults.
+     *
+     * @param type "FreeSpace", "SquareBarrier", "HarmonicOscillator" or "Rectangle"
+     * @param parameters Type-specific parameters
+     * @return The potential
+     */
+    static std::unique_ptr<Potential> create(const std::string& type, const std::vector<double>& parameters);
+
+    /**
+     * @brief Create a potential from a configuration
+     *
+     * Also builds "Grid" potentials, loaded from config.file, and
+     * "Composite" potentials, which sum config.components. "Driven"
+     * potentials add components[1] scaled by a sinusoidal drive to
+     * components[0]; "Moving" potentials translate components[0] along a
+     * path (see DrivenPotential::sineDrive and MovingPotential::linearPath
+     * for the parameters).
+     *
+     * @param config Potential configuration
+     * @param lx Domain length in x, the default extent of grid files
+     * @param ly Domain length in y, the default extent of grid files
+     * @return The potential
+     * @throws std::runtime_error if a grid file cannot be loaded
+     */
+    static std::unique_ptr<Potential> create(const PotentialConfig& config, double lx = 20.0, double ly = 20.0);
+};
+
+/**
+ * @class FreeSpacePotential
+ * @brief V = 0 everywhere
+ */
+class FreeSpacePotential : public Potential {
+public:
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+    void sampleRow(const GridGeometry& grid, int row, double* out) const override;
+};
+
+/**
+ * @class SquareBarrierPotential
+ * @brief V = height inside a square, 0 outside
+ */
+class SquareBarrierPotential : public Potential {
+public:
+    /**
+     * @brief Create a square barrier (height > 0) or well (height < 0)
+     * @param height Potential inside the square
+     * @param width Side length (at least 0.01)
+     * @param xCenter x coordinate of the centre
+     * @param yCenter y coordinate of the centre
+     */
+    SquareBarrierPotential(double height, double width, double xCenter, double yCenter);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+
+private:
+    double m_height;   ///< Potential inside the square
+    double m_width;    ///< Side length
+    double m_xCenter;  ///< x coordinate of the centre
+    double m_yCenter;  ///< y coordinate of the centre
+};
+
+/**
+ * @class HarmonicOscillatorPotential
+ * @brief V = ω²(x² + y²)/2 in scaled units (m = 1)
+ */
+class HarmonicOscillatorPotential : public Potential {
+public:
+    /**
+     * @brief Create an isotropic oscillator
+     * @param omega Angular frequency (at least 0.01)
+     */
+    explicit HarmonicOscillatorPotential(double omega);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+
+private:
+    double m_omega;  ///< Angular frequency
+};
+
+/**
+ * @class RectanglePotential
+ * @brief V = height inside an axis-aligned rectangle, 0 outside
+ *
+ * Thin rectangles summed in a CompositePotential build walls with slits.
+ */
+class RectanglePotential : public Potential {
+public:
+    /**
+     * @brief Create a rectangular barrier or well
+     * @param height Potential inside the rectangle
+     * @param xMin Left edge
+     * @param xMax Right edge
+     * @param yMin Bottom edge
+     * @param yMax Top edge
+     */
+    RectanglePotential(double height, double xMin, double xMax, double yMin, double yMax);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+
+private:
+    double m_height;  ///< Potential inside the rectangle
+    double m_xMin;    ///< Left edge
+    double m_xMax;    ///< Right edge
+    double m_yMin;    ///< Bottom edge
+    double m_yMax;    ///< Top edge
+};
+
+/**
+ * @class GridPotential
+ * @brief Potential tabulated on a regular grid
+ *
+ * Values are bilinearly interpolated between grid points and clamped to
+ * the edge values outside the grid. When the solver samples the grid the
+ * potential was tabulated on, sampleRow() copies the stored row, so an
+ * imported potential costs a memory load per point.
+ */
+class GridPotential : public Potential {
+public:
+    /**
+     * @brief Create a potential from tabulated values
+     * @param grid Positions of the values
+     * @param values grid.nx * grid.ny values, row-major
+     * @throws std::invalid_argument if the sizes do not match
+     */
+    GridPotential(const GridGeometry& grid, std::vector<double> values);
+
+    /**
+     * @brief Load a potential from an HDF5 file or a greyscale image
+     *
+     * HDF5 files (.h5, .hdf5) must hold a 2D "potential" dataset of ny x nx
+     * values. Images are binary or ASCII PGM files whose first row is the
+     * top (largest y) and whose grey levels map linearly to 0..scale.
+     * HDF5 values are multiplied by scale.
+     *
+     * @param path File to load
+     * @param scale Factor applied to the loaded values
+     * @param xMin Left edge of the area the file covers
+     * @param xMax Right edge of the area the file covers
+     * @param yMin Bottom edge of the area the file covers
+     * @param yMax Top edge of the area the file covers
+     * @return The potential, with grid points at the cell corners of the area
+     * @throws std::runtime_error if the file cannot be read
+     */
+    static std::unique_ptr<GridPotential> load(const std::string& path, double scale,
+                                               double xMin, double xMax, double yMin, double yMax);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+    void sampleRow(const GridGeometry& grid, int row, double* out) const override;
+
+    /**
+     * @brief Get the positions of the stored values
+     * @return Grid geometry
+     */
+    const GridGeometry& getGrid() const { return m_grid; }
+
+    /**
+     * @brief Get the stored values
+     * @return nx * ny values, row-major
+     */
+    const std::vector<double>& getValues() const { return m_values; }
+
+private:
+    GridGeometry m_grid;          ///< Positions of the values
+    std::vector<double> m_values; ///< Tabulated potential, row-major
+};
+
+/**
+ * @class CompositePotential
+ * @brief Sum of other potentials
+ */
+class CompositePotential : public Potential {
+public:
+    /**
+     * @brief Create the sum of potentials
+     * @param components Summed potentials (none = free space)
+     */
+    explicit CompositePotential(std::vector<std::unique_ptr<Potential>> components = {});
+
+    /**
+     * @brief Add a potential to the sum
+     * @param component The potential
+     */
+    void add(std::unique_ptr<Potential> component);
+
+    /**
+     * @brief Get the number of summed potentials
+     * @return Component count
+     */
+    size_t size() const { return m_components.size(); }
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+    void sampleRow(const GridGeometry& grid, int row, double* out) const override;
+    bool isTimeDependent() const override;
+    void setTime(double time) override;
+
+private:
+    std::vector<std::unique_ptr<Potential>> m_components;  ///< Summed potentials
+};
+
+/**
+ * @class DrivenPotential
+ * @brief Separable time dependence V(x, y, t) = V0(x, y) + f(t) V1(x, y)
+ *
+ * Covers oscillating barriers and dipole-coupled laser pulses. The solver
+ * tabulates V0 and V1 once and updates the phases with one fused pass per
+ * time, without evaluating either potential again.
+ */
+class DrivenPotential : public Potential {
+public:
+    /// Drive amplitude f(t)
+    using Drive = std::function<double(double)>;
+
+    /**
+     * @brief Create a driven potential
+     * @param base Static part V0 (null = free space)
+     * @param coupling Driven part V1
+     * @param drive Drive amplitude f(t)
+     */
+    DrivenPotential(std::unique_ptr<Potential> base, std::unique_ptr<Potential> coupling, Drive drive);
+
+    /**
+     * @brief Sinusoid with an optional Gaussian pulse envelope
+     *
+     * f(t) = offset + amplitude * sin(omega * t + phase) * envelope(t), with
+     * envelope(t) = exp(-(t - pulseCenter)² / (2 pulseWidth²)), or 1 when
+     * pulseWidth <= 0.
+     *
+     * @return The drive
+     */
+    static Drive sineDrive(double amplitude, double omega, double phase = 0.0, double offset = 0.0,
+                           double pulseCenter = 0.0, double pulseWidth = 0.0);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+    void sampleRow(const GridGeometry& grid, int row, double* out) const override;
+    bool isTimeDependent() const override { return true; }
+    void setTime(double time) override;
+
+    /**
+     * @brief Evaluate the drive
+     * @param time Simulation time
+     * @return f(time)
+     */
+    double getDrive(double time) const { return m_drive(time); }
+
+    /**
+     * @brief Get the static part
+     * @return V0
+     */
+    const Potential& getBase() const { return *m_base; }
+
+    /**
+     * @brief Get the driven part
+     * @return V1
+     */
+    const Potential& getCoupling() const { return *m_coupling; }
+
+private:
+    std::unique_ptr<Potential> m_base;      ///< Static part V0
+    std::unique_ptr<Potential> m_coupling;  ///< Driven part V1
+    Drive m_drive;                          ///< Drive amplitude f(t)
+    double m_amplitude = 0.0;               ///< f at the time of the last setTime()
+};
+
+/**
+ * @class MovingPotential
+ * @brief Rigidly translated potential V(x, y, t) = W(x - X(t), y - Y(t))
+ *
+ * Covers moving traps and barriers. The solver tabulates W once and shifts
+ * the table; it re-evaluates nothing when the offset is a whole number of
+ * grid cells and interpolates the table otherwise. The solver domain is
+ * periodic, so W wraps around its edges there.
+ */
+class MovingPotential : public Potential {
+public:
+    /// Offset (X, Y) of the shape at a time
+    using Path = std::function<void(double time, double& x, double& y)>;
+
+    /**
+     * @brief Create a moving potential
+     * @param shape Potential W at offset (0, 0)
+     * @param path Offset of the shape over time
+     */
+    MovingPotential(std::unique_ptr<Potential> shape, Path path);
+
+    /**
+     * @brief Uniform motion plus an oscillation
+     *
+     * X(t) = vx * t + amplitudeX * sin(omega * t), and likewise for Y.
+     *
+     * @return The path
+     */
+    static Path linearPath(double vx, double vy, double amplitudeX = 0.0, double amplitudeY = 0.0,
+                           double omega = 0.0);
+
+    double getValue(double x, double y) const override;
+    std::string getType() const override;
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override;
+    bool isTimeDependent() const override { return true; }
+    void setTime(double time) override;
+
+    /**
+     * @brief Get the offset of the shape
+     * @param time Simulation time
+     * @param x Set to X(time)
+     * @param y Set to Y(time)
+     */
+    void getOffset(double time, double& x, double& y) const { m_path(time, x, y); }
+
+    /**
+     * @brief Get the translated shape
+     * @return W
+     */
+    const Potential& getShape() const { return *m_shape; }
+
+private:
+    std::unique_ptr<Potential> m_shape;  ///< Potential at offset (0, 0)
+    Path m_path;                         ///< Offset over time
+    double m_offsetX = 0.0;              ///< X at the time of the last setTime()
+    double m_offsetY = 0.0;              ///< Y at the time of the last setTime()
+};
@@ -0,0 +1,125 @@
+#include "Trace.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+std::atomic<bool> Tracer::s_active{false};
+
+namespace {
+
+// Write a string as a JSON string literal
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+}  // namespace
+
+// Get the process-wide tracer
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+// Start recording, discarding earlier events
+void Tracer::start(const std::string& path, size_t maxEventsPerThread) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Forget threads that have exited; only this list still references their buffers
+    m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(),
+                                   [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                                       return buffer.use_count() == 1;
+                                   }),
+                    m_buffers.end());
+    for (const auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+
+    m_path = path;
+    m_maxEventsPerThread.store(maxEventsPerThread, std::memory_order_relaxed);
+    m_epochNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count(),
+                    std::memory_order_relaxed);
+    s_active.store(true, std::memory_order_release);
+}
+
+// Stop recording and write the trace file
+size_t Tracer::stop() {
+    s_active.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ofstream out(m_path);
+    if (!out) {
+        throw std::runtime_error("Cannot open trace file: " + m_path);
+    }
+
+    size_t written = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (const auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const Event& event : buffer->events) {
+            out << (written++ == 0 ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"ts\":" << static_cast<double>(event.beginNs) * 1e-3
+                << ",\"dur\":" << static_cast<double>(event.durationNs) * 1e-3
+                << ",\"pid\":1,\"tid\":" << buffer->threadId << '}';
+        }
+    }
+    out << "\n]}\n";
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write trace file: " + m_path);
+    }
+    return written;
+}
+
+// Get the number of events dropped because a thread's buffer was full
+size_t Tracer::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t dropped = 0;
+    for (const auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        dropped += buffer->dropped;
+    }
+    return dropped;
+}
+
+// Get the calling thread's buffer, registering it on first use
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.reserve(4096);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer->threadId = m_nextThreadId++;
+        m_buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Record a complete event on the calling thread
+void Tracer::record(const char* name, const char* category,
+                    std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+    ThreadBuffer& buffer = threadBuffer();
+    const int64_t beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count() -
+                            m_epochNs.load(std::memory_order_relaxed);
+    const int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < m_maxEventsPerThread.load(std::memory_order_relaxed)) {
+        buffer.events.push_back(Event{name, category, beginNs, durationNs});
+    } else {
+        ++buffer.dropped;
+    }
+}
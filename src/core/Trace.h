@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compile tracing scopes in (1, the default) or out (0)
+ *
+ * With tracing compiled in, an inactive scope costs one atomic
+ * load, so release builds keep it and traces can be recorded from
+ * production runs with a command line flag.
+ */
+#ifndef QMSIM_ENABLE_TRACING
+#define QMSIM_ENABLE_TRACING 1
+#endif
+
+/**
+ * @class Tracer
+ * @brief Records timed scopes and writes them in Chrome trace format
+ *
+ * While recording, every TRACE_SCOPE appends one complete ("X") event with
+ * its start and duration to a buffer owned by the calling thread, so
+ * threads do not contend. stop() gathers the buffers and writes a JSON
+ * file that chrome://tracing and Perfetto open directly.
+ *
+ * Scope names and categories must be string literals (or otherwise outlive
+ * the recording); they are stored as pointers, not copied. Each thread
+ * keeps at most getMaxEventsPerThread() events; further ones are counted
+ * as dropped.
+ */
+class Tracer {
+public:
+    /**
+     * @brief Get the process-wide tracer
+     * @return The tracer
+     */
+    static Tracer& getInstance();
+
+    /**
+     * @brief Check whether scopes are being recorded
+     * @return True between start() and stop()
+     */
+    static bool isActive() { return s_active.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Start recording, discarding earlier events
+     * @param path File stop() writes the trace to
+     * @param maxEventsPerThread Event limit per thread
+     */
+    void start(const std::string& path, size_t maxEventsPerThread = 1 << 20);
+
+    /**
+     * @brief Stop recording and write the trace file
+     * @return Number of events written
+     * @throws std::runtime_error if the file cannot be written
+     */
+    size_t stop();
+
+    /**
+     * @brief Get the number of events dropped because a thread's buffer was full
+     * @return Dropped event count of the current or last recording
+     */
+    size_t getDroppedCount() const;
+
+    /**
+     * @brief Get the event limit per thread
+     * @return Maximum events a thread records
+     */
+    size_t getMaxEventsPerThread() const { return m_maxEventsPerThread.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record a complete event on the calling thread
+     * @param name Scope name (string literal)
+     * @param category Scope category (string literal)
+     * @param begin Start time
+     * @param end End time
+     */
+    void record(const char* name, const char* category,
+                std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+private:
+    struct Event {
+        const char* name;
+        const char* category;
+        int64_t beginNs;     ///< Start, relative to the recording start
+        int64_t durationNs;  ///< Duration
+    };
+
+    struct ThreadBuffer {
+        std::mutex mutex;           ///< Owner thread appends, stop() reads
+        std::vector<Event> events;  ///< Events of the current recording
+        uint32_t threadId = 0;      ///< Small id written as "tid"
+        size_t dropped = 0;         ///< Events that did not fit
+    };
+
+    Tracer() = default;
+
+    /**
+     * @brief Get the calling thread's buffer, registering it on first use
+     * @return The buffer
+     */
+    ThreadBuffer& threadBuffer();
+
+    static std::atomic<bool> s_active;  ///< Recording flag read by every scope
+
+    mutable std::mutex m_mutex;                          ///< Guards the members below
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;  ///< Every thread that recorded
+    std::string m_path;                                  ///< Output file
+    uint32_t m_nextThreadId = 1;                         ///< Id of the next registered thread
+    std::atomic<int64_t> m_epochNs{0};                   ///< Recording start (steady clock, ns)
+    std::atomic<size_t> m_maxEventsPerThread{1 << 20};   ///< Event limit per thread
+};
+
+/**
+ * @class ScopedTrace
+ * @brief Records the lifetime of a scope with the Tracer while it is active
+ */
+class ScopedTrace {
+public:
+    ScopedTrace(const char* name, const char* category)
+        : m_name(name), m_category(category), m_active(Tracer::isActive())
+    {
+        if (m_active) {
+            m_begin = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTrace() {
+        if (m_active) {
+            Tracer::getInstance().record(m_name, m_category, m_begin, std::chrono::steady_clock::now());
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_category;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+#define QMSIM_TRACE_CONCAT_INNER(a, b) a##b
+#define QMSIM_TRACE_CONCAT(a, b) QMSIM_TRACE_CONCAT_INNER(a, b)
+
+#if QMSIM_ENABLE_TRACING
+/// Time the rest of the enclosing scope under a name and category (string literals)
+#define TRACE_SCOPE(name, category) ScopedTrace QMSIM_TRACE_CONCAT(qmsimTrace_, __LINE__)(name, category)
+#else
+#define TRACE_SCOPE(name, category) do {} while (0)
+#endif
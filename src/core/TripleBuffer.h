@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Lock-free single-producer/single-consumer handoff of the latest value
+ *
+ * The producer fills writeBuffer() and calls publish(); the consumer calls
+ * update() and then reads readBuffer(). Neither side ever waits: the
+ * producer always has a buffer to write into, the consumer always sees a
+ * complete value, and values the consumer is too slow to pick up are
+ * simply replaced by newer ones.
+ *
+ * Exactly one thread may produce and one thread may consume.
+ *
+ * @tparam T Value type; buffers are reused, so vectors keep their capacity
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * @brief Get the buffer the producer is currently filling
+     * @return Reference to the producer's private buffer
+     */
+    T& writeBuffer() { return m_buffers[m_writeIndex]; }
+
+    /**
+     * @brief Hand the filled write buffer to the consumer
+     *
+     * The previous unread value, if any, becomes the new write buffer.
+     */
+    void publish() {
+        uint8_t previous = m_shared.exchange(static_cast<uint8_t>(m_writeIndex | kFresh), std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+
+    /**
+     * @brief Take the most recently published value, if there is a new one
+     * @return True if readBuffer() now holds a value not seen before
+     */
+    bool update() {
+        if ((m_shared.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        uint8_t previous = m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & kIndexMask;
+        return true;
+    }
+
+    /**
+     * @brief Get the buffer the consumer is currently reading
+     * @return Reference to the latest value taken by update()
+     */
+    const T& readBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;  ///< Buffer index bits of the shared slot
+    static constexpr uint8_t kFresh = 0x4;      ///< Set when the shared slot holds an unread value
+
+    T m_buffers[3];                    ///< Write, shared and read buffers (roles rotate)
+    std::atomic<uint8_t> m_shared{1};  ///< Index of the shared buffer plus the fresh flag
+    uint8_t m_writeIndex = 0;          ///< Producer-owned buffer index
+    uint8_t m_readIndex = 2;           ///< Consumer-owned buffer index
+};
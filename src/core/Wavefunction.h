@@ -3,24 +3,68 @@
 #include <complex>
 #include <vector>
 #include <cmath>
+#include <cstddef>
+#include "GridPool.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /**
- * @class Wavefunction
+ * @class BasicWavefunction
  * @brief Represents a 2D complex-valued quantum wavefunction
  * 
  * This class handles the storage and manipulation of a 2D complex-valued
  * wavefunction used in the quantum simulation. It provides functionality
  * for initializing, accessing, and manipulating the wavefunction data.
+ * 
+ * The storage precision is a template parameter: Wavefunction (double) is
+ * the reference precision, WavefunctionF (float) halves the memory traffic
+ * of every split-step pass. Coordinates and reductions are always computed
+ * in double so that normalization does not drift in single precision.
+ * 
+ * Storage comes from the shared GridPool: it is aligned for FFTW's SIMD
+ * codelets, first-touched in parallel, and recycled when a wavefunction
+ * of the same size is released and another one is created.
+ * 
+ * @tparam Real Floating-point type of the real and imaginary parts
  */
-class Wavefunction {
+template <typename Real>
+class BasicWavefunction {
 public:
+    using value_type = std::complex<Real>;
+    
     /**
      * @brief Construct a new Wavefunction with specified dimensions
      * @param nx Number of grid points in x direction
      * @param ny Number of grid points in y direction
      */
-    Wavefunction(int nx, int ny) 
-        : m_nx(nx), m_ny(ny), m_data(nx * ny, std::complex<double>(0.0, 0.0)) {}
+    BasicWavefunction(int nx, int ny) 
+        : m_nx(nx), m_ny(ny), m_data(nx * ny, value_type(0, 0)) {}
+    
+    /**
+     * @brief Construct a copy of a wavefunction stored in another precision
+     * @param other Wavefunction to convert
+     */
+    template <typename OtherReal>
+    explicit BasicWavefunction(const BasicWavefunction<OtherReal>& other)
+        : m_nx(other.getNx()), m_ny(other.getNy()), m_data(other.begin(), other.end()) {}
+    
+    /**
+     * @brief Change the grid dimensions
+     * 
+     * The storage is kept when nx * ny is unchanged (the values are then
+     * left as they are); otherwise the old block goes back to the pool
+     * before a zeroed one of the new size is taken.
+     * 
+     * @param nx Number of grid points in x direction
+     * @param ny Number of grid points in y direction
+     */
+    void resize(int nx, int ny) {
+        resizeGrid(m_data, static_cast<size_t>(nx) * static_cast<size_t>(ny));
+        m_nx = nx;
+        m_ny = ny;
+    }
     
     /**
      * @brief Get the number of grid points in x direction
@@ -40,7 +84,7 @@ public:
      * @param j Index in y direction
      * @return Reference to complex value at position (i,j)
      */
-    std::complex<double>& operator()(int i, int j) {
+    value_type& operator()(int i, int j) {
         return m_data[j * m_nx + i];  // Correct row-major indexing
     }
     
@@ -50,7 +94,7 @@ public:
      * @param j Index in y direction
      * @return Const reference to complex value at position (i,j)
      */
-    const std::complex<double>& operator()(int i, int j) const {
+    const value_type& operator()(int i, int j) const {
         return m_data[j * m_nx + i];  // Correct row-major indexing
     }
     
@@ -58,13 +102,46 @@ public:
      * @brief Get raw pointer to data for use with FFTW and other libraries
      * @return Pointer to underlying complex data
      */
-    std::complex<double>* data() { return m_data.data(); }
+    value_type* data() { return m_data.data(); }
     
     /**
      * @brief Get const raw pointer to data
      * @return Const pointer to underlying complex data
      */
-    const std::complex<double>* data() const { return m_data.data(); }
+    const value_type* data() const { return m_data.data(); }
+    
+    /**
+     * @brief Get the total number of grid points
+     * @return nx * ny
+     */
+    size_t size() const { return m_data.size(); }
+    
+    /**
+     * @brief Get a pointer to the contiguous row of constant y index j
+     * 
+     * Storage is row-major with x as the fast index, so row(j)[i] is the
+     * same element as (*this)(i, j). Loops should iterate j on the outside
+     * and i on the inside (or run flat over data()) to walk memory in order.
+     * 
+     * @param j Index in y direction
+     * @return Pointer to the first of nx contiguous elements
+     */
+    value_type* row(int j) { return m_data.data() + static_cast<size_t>(j) * m_nx; }
+    
+    /**
+     * @brief Get a const pointer to the contiguous row of constant y index j
+     * @param j Index in y direction
+     * @return Const pointer to the first of nx contiguous elements
+     */
+    const value_type* row(int j) const { return m_data.data() + static_cast<size_t>(j) * m_nx; }
+    
+    /**
+     * @brief Iterators over the flat, contiguous storage
+     */
+    typename GridVector<value_type>::iterator begin() { return m_data.begin(); }
+    typename GridVector<value_type>::iterator end() { return m_data.end(); }
+    typename GridVector<value_type>::const_iterator begin() const { return m_data.begin(); }
+    typename GridVector<value_type>::const_iterator end() const { return m_data.end(); }
     
     /**
      * @brief Initialize a Gaussian wavepacket
@@ -76,60 +153,56 @@ public:
      * @param ky Wavenumber in y direction (momentum)
      * @param lx Total length of domain in x direction
      * @param ly Total length of domain in y direction
+     * @param numThreads OpenMP threads for the pass (0 = OpenMP default)
      */
     void initializeGaussian(double x0, double y0, double sigmaX, double sigmaY, 
-                           double kx, double ky, double lx, double ly) {
-        // Stub implementation - will be properly implemented later
+                           double kx, double ky, double lx, double ly, int numThreads = 0) {
+        const int team = teamSize(numThreads);
         double dx = lx / m_nx;
         double dy = ly / m_ny;
         
-        // Compute physical coordinates and initialize Gaussian
-        for (int i = 0; i < m_nx; ++i) {
-            double x = -lx/2 + i * dx;  // Physical x-coordinate
-            for (int j = 0; j < m_ny; ++j) {
-                double y = -ly/2 + j * dy;  // Physical y-coordinate
+        // Compute physical coordinates and initialize Gaussian, one contiguous row at a time
+        #pragma omp parallel for num_threads(team)
+        for (int j = 0; j < m_ny; ++j) {
+            double y = -ly/2 + j * dy;  // Physical y-coordinate
+            value_type* psiRow = row(j);
+            for (int i = 0; i < m_nx; ++i) {
+                double x = -lx/2 + i * dx;  // Physical x-coordinate
                 
                 // Gaussian envelope
                 double r2 = (x-x0)*(x-x0)/(sigmaX*sigmaX) + (y-y0)*(y-y0)/(sigmaY*sigmaY);
                 double envelope = std::exp(-r2/2);
                 
-                // Phase factor for momentum
-                std::complex<double> phase(0, kx*x + ky*y);
-                
-                // Set wavefunction value
-                (*this)(i, j) = envelope * std::exp(phase);
+                // Set wavefunction value with the momentum phase factor
+                psiRow[i] = value_type(std::polar(envelope, kx*x + ky*y));
             }
         }
+        (void)team;
         
         // Normalize the wavefunction
-        normalize(lx, ly);
+        normalize(lx, ly, numThreads);
     }
     
     /**
      * @brief Normalize the wavefunction to have total probability = 1
      * @param lx Total length of domain in x direction
      * @param ly Total length of domain in y direction
+     * @param numThreads OpenMP threads for the pass (0 = OpenMP default)
      */
-    void normalize(double lx, double ly) {
-        // Stub implementation - will be properly implemented later
-        double dx = lx / m_nx;
-        double dy = ly / m_ny;
-        
+    void normalize(double lx, double ly, int numThreads = 0) {
+        const int team = teamSize(numThreads);
         // Calculate total probability
-        double totalProb = 0.0;
-        for (int i = 0; i < m_nx; ++i) {
-            for (int j = 0; j < m_ny; ++j) {
-                totalProb += std::norm((*this)(i, j)) * dx * dy;
-            }
-        }
+        double totalProb = getTotalProbability(lx, ly, numThreads);
         
         // Normalize
-        double normFactor = 1.0 / std::sqrt(totalProb);
-        for (int i = 0; i < m_nx; ++i) {
-            for (int j = 0; j < m_ny; ++j) {
-                (*this)(i, j) *= normFactor;
-            }
+        const Real normFactor = static_cast<Real>(1.0 / std::sqrt(totalProb));
+        value_type* psi = m_data.data();
+        const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(m_data.size());
+        #pragma omp parallel for num_threads(team)
+        for (std::ptrdiff_t n = 0; n < count; ++n) {
+            psi[n] *= normFactor;
         }
+        (void)team;
     }
     
     /**
@@ -137,39 +210,72 @@ public:
      * @return Vector of float values representing probability density at each grid point
      */
     std::vector<float> getProbabilityDensity() const {
-        // Stub implementation - will be properly implemented later
-        std::vector<float> density(m_nx * m_ny);
-        for (int i = 0; i < m_nx; ++i) {
-            for (int j = 0; j < m_ny; ++j) {
-                density[j * m_nx + i] = static_cast<float>(std::norm((*this)(i, j)));
-            }
-        }
+        std::vector<float> density(m_data.size());
+        writeProbabilityDensity(density.data());
         return density;
     }
     
+    /**
+     * @brief Write the probability density into a caller-provided buffer
+     * @param dst Destination for size() floats in storage order
+     * @param numThreads OpenMP threads for the pass (0 = OpenMP default)
+     */
+    void writeProbabilityDensity(float* dst, int numThreads = 0) const {
+        const int team = teamSize(numThreads);
+        const value_type* psi = m_data.data();
+        const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(m_data.size());
+        #pragma omp parallel for num_threads(team)
+        for (std::ptrdiff_t n = 0; n < count; ++n) {
+            dst[n] = static_cast<float>(std::norm(psi[n]));
+        }
+        (void)team;
+    }
+    
     /**
      * @brief Calculate the total probability of the wavefunction
      * @param lx Total length of domain in x direction
      * @param ly Total length of domain in y direction
+     * @param numThreads OpenMP threads for the reduction (0 = OpenMP default)
      * @return The total probability (should be 1.0 for a normalized wavefunction)
      */
-    double getTotalProbability(double lx, double ly) const {
-        // Stub implementation - will be properly implemented later
+    double getTotalProbability(double lx, double ly, int numThreads = 0) const {
+        const int team = teamSize(numThreads);
         double dx = lx / m_nx;
         double dy = ly / m_ny;
         
+        const value_type* psi = m_data.data();
+        const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(m_data.size());
+        
         double totalProb = 0.0;
-        for (int i = 0; i < m_nx; ++i) {
-            for (int j = 0; j < m_ny; ++j) {
-                totalProb += std::norm((*this)(i, j)) * dx * dy;
-            }
+        #pragma omp parallel for reduction(+:totalProb) num_threads(team)
+        for (std::ptrdiff_t n = 0; n < count; ++n) {
+            const double re = psi[n].real();
+            const double im = psi[n].imag();
+            totalProb += re*re + im*im;
         }
+        (void)team;
         
-        return totalProb;
+        return totalProb * dx * dy;
     }
 
 private:
+    // Team size for the parallel passes above
+    static int teamSize(int numThreads) {
+#ifdef _OPENMP
+        return numThreads > 0 ? numThreads : omp_get_max_threads();
+#else
+        (void)numThreads;
+        return 1;
+#endif
+    }
+
     int m_nx; ///< Number of grid points in x direction
     int m_ny; ///< Number of grid points in y direction
-    std::vector<std::complex<double>> m_data; ///< Storage for wavefunction values
-};
\ No newline at end of file
+    GridVector<value_type> m_data; ///< Storage for wavefunction values
+};
+
+/// Double-precision wavefunction (the reference precision)
+using Wavefunction = BasicWavefunction<double>;
+
+/// Single-precision wavefunction
+using WavefunctionF = BasicWavefunction<float>;
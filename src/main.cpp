@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -13,12 +15,14 @@
 
 #include "core/PhysicsConfig.h"
 #include "core/DebugUtils.h"
+#include "core/Metrics.h"
+#include "core/Trace.h"
 #include "core/ServiceContainer.h"
 #include "core/EventBus.h"
 #include "core/Events.h"
 #include "core/IEventHandler.h"
 #include "solver/ISimulationEngine.h"
-#include "solver/SimulationEngine.h"
+#include "solver/SimulationWorker.h"
 #include "visualization/IVisualizationEngine.h"
 #include "visualization/VisualizationEngine.h"
 #include "ui/UIManager.h"
@@ -30,33 +34,37 @@ const int WINDOW_HEIGHT = 600;
 const char* WINDOW_TITLE = "Quantum Mechanics Simulator";
 const char* GLSL_VERSION = "#version 330";
 
-// Target frame rate and simulation update rate
+// Target frame rate and default simulation batch size
 const double TARGET_FPS = 60.0;
-const double SIMULATION_RATE = 30.0; // Simulation steps per second
 const double FRAME_TIME = 1.0 / TARGET_FPS;
-const double SIMULATION_TIME = 1.0 / SIMULATION_RATE;
+const int STEPS_PER_FRAME = 1;
+const double SIMULATION_RATE = 0.0; // Maximum simulation steps per second (0 = unlimited)
 
 // Application state manager class for coordinating components
 class ApplicationController : public IEventHandler, public std::enable_shared_from_this<ApplicationController> {
 private:
     std::shared_ptr<EventBus> eventBus;
-    std::shared_ptr<ISimulationEngine> simulationEngine;
+    std::shared_ptr<SimulationWorker> simulationEngine;
     std::shared_ptr<IVisualizationEngine> visualizationEngine;
     std::shared_ptr<IUIManager> uiManager;
     
     bool isRunning = true;
     bool needsRender = true;
     bool simulationUpdated = false;
-    std::chrono::time_point<std::chrono::high_resolution_clock> lastSimulationUpdateTime;
     std::chrono::time_point<std::chrono::high_resolution_clock> lastRenderTime;
     std::chrono::time_point<std::chrono::high_resolution_clock> lastFrameTime;
     double fpsCounter = 0.0;
     int frameCount = 0;
     
+    // Displayed part of the grid: zoom factor and centre as fractions of the domain
+    double viewZoom = 1.0;
+    double viewCenterX = 0.5;
+    double viewCenterY = 0.5;
+    
 public:
     ApplicationController(
         std::shared_ptr<EventBus> eventBus,
-        std::shared_ptr<ISimulationEngine> simulationEngine,
+        std::shared_ptr<SimulationWorker> simulationEngine,
         std::shared_ptr<IVisualizationEngine> visualizationEngine,
         std::shared_ptr<IUIManager> uiManager)
         : eventBus(eventBus),
@@ -65,9 +73,8 @@ public:
           uiManager(uiManager) {
         
         // Initialize timing
-        lastSimulationUpdateTime = std::chrono::high_resolution_clock::now();
-        lastRenderTime = lastSimulationUpdateTime;
-        lastFrameTime = lastSimulationUpdateTime;
+        lastRenderTime = std::chrono::high_resolution_clock::now();
+        lastFrameTime = lastRenderTime;
     }
     
     ~ApplicationController() {
@@ -79,6 +86,7 @@ public:
             eventBus->unsubscribe(EventType::SimulationStepCompleted, std::static_pointer_cast<IEventHandler>(shared_from_this()));
             eventBus->unsubscribe(EventType::ApplicationExiting, std::static_pointer_cast<IEventHandler>(shared_from_this()));
             eventBus->unsubscribe(EventType::UIConfigChanged, std::static_pointer_cast<IEventHandler>(shared_from_this()));
+            eventBus->unsubscribe(EventType::ConfigurationUpdated, std::static_pointer_cast<IEventHandler>(shared_from_this()));
         }
     }
     
@@ -93,11 +101,30 @@ public:
             eventBus->subscribe(EventType::SimulationStepCompleted, std::static_pointer_cast<IEventHandler>(shared_from_this()));
             eventBus->subscribe(EventType::ApplicationExiting, std::static_pointer_cast<IEventHandler>(shared_from_this()));
             eventBus->subscribe(EventType::UIConfigChanged, std::static_pointer_cast<IEventHandler>(shared_from_this()));
+            eventBus->subscribe(EventType::ConfigurationUpdated, std::static_pointer_cast<IEventHandler>(shared_from_this()));
         }
         
+        updateViewport();
         return true;
     }
     
+    // Ask the worker for the zoomed region at no more than the display texture size;
+    // zoomed in far enough, the region arrives at full grid resolution
+    void updateViewport() {
+        if (!visualizationEngine) {
+            return;
+        }
+        const DensityFrame& frame = simulationEngine->currentFrame();
+        DensityViewport view;
+        view.width = std::max(1, static_cast<int>(frame.nx / viewZoom));
+        view.height = std::max(1, static_cast<int>(frame.ny / viewZoom));
+        view.x0 = std::clamp(static_cast<int>(viewCenterX * frame.nx) - view.width / 2, 0, frame.nx - view.width);
+        view.y0 = std::clamp(static_cast<int>(viewCenterY * frame.ny) - view.height / 2, 0, frame.ny - view.height);
+        view.maxWidth = visualizationEngine->getWidth();
+        view.maxHeight = visualizationEngine->getHeight();
+        simulationEngine->setViewport(view);
+    }
+    
     void shutdown() {
         DEBUG_LOG("AppController", "Shutting down application controller");
         isRunning = false;
@@ -108,11 +135,11 @@ public:
     }
     
     void processFrame(GLFWwindow* window) {
+        TRACE_SCOPE("Frame", "main");
         auto currentTime = std::chrono::high_resolution_clock::now();
         
         // Calculate delta times
         double frameTimeDelta = std::chrono::duration<double>(currentTime - lastFrameTime).count();
-        double simulationTimeDelta = std::chrono::duration<double>(currentTime - lastSimulationUpdateTime).count();
         double renderTimeDelta = std::chrono::duration<double>(currentTime - lastRenderTime).count();
         
         // Update FPS counter
@@ -138,24 +165,45 @@ public:
             uiManager->processInput();
         }
         
-        // Step simulation if running and it's time for an update
-        if (uiManager && uiManager->getSimulationState() == SimulationState::Running && 
-            simulationTimeDelta >= SIMULATION_TIME) {
-            
-            simulationEngine->step();
-            lastSimulationUpdateTime = currentTime;
+        // The worker steps the simulation on its own thread; the render loop
+        // only tells it whether to run and picks up the newest frame
+        if (uiManager) {
+            simulationEngine->setRunning(uiManager->getSimulationState() == SimulationState::Running);
+        }
+        // Field and phase views take ψ itself and compute |ψ|² on the GPU
+        const bool fieldView = visualizationEngine &&
+            visualizationEngine->getRenderMode() != RenderMode::Density;
+        simulationEngine->setFrameContent(fieldView ? FrameContent::Wavefunction : FrameContent::Density);
+        simulationEngine->dispatchEvents();
+        if (simulationEngine->acquireFrame()) {
             simulationUpdated = true;
+            
+            // Copy the display-sized frame into the mapped pixel buffer;
+            // frames published before a viewport change may not fit yet
+            const DensityFrame& frame = simulationEngine->currentFrame();
+            if (visualizationEngine && frame.width <= visualizationEngine->getWidth() &&
+                frame.height <= visualizationEngine->getHeight()) {
+                // Host frames are read once and written once into the staging buffer
+                METRICS_SCOPE(MetricStage::DensityUpload,
+                              2 * (frame.field.size() + frame.density.size()) * sizeof(float));
+                if (!frame.field.empty()) {
+                    if (float* staging = visualizationEngine->beginFieldUpload(frame.width, frame.height)) {
+                        std::copy(frame.field.begin(), frame.field.end(), staging);
+                        visualizationEngine->endFieldUpload();
+                    }
+                } else if (float* staging = visualizationEngine->beginDensityUpload(frame.width, frame.height)) {
+                    std::copy(frame.density.begin(), frame.density.end(), staging);
+                    visualizationEngine->endDensityUpload();
+                }
+            }
         }
         
         // Render visualization and UI if needed (either simulation updated or frame time passed)
         if ((simulationUpdated || renderTimeDelta >= FRAME_TIME) && visualizationEngine && uiManager) {
-            // Get probability density data for visualization
-            std::vector<float> densityData = simulationEngine->getProbabilityDensity();
-            
-            // Render visualization
+            // Render the latest uploaded frame
             glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
-            visualizationEngine->render(densityData);
+            visualizationEngine->renderCurrent();
             
             // Render UI
             uiManager->render();
@@ -208,6 +256,31 @@ public:
                 needsRender = true;
                 break;
                 
+            case EventType::ConfigurationUpdated: {
+                auto configEvent = std::dynamic_pointer_cast<ConfigurationUpdatedEvent>(event);
+                if (!configEvent) {
+                    return false;
+                }
+                const std::string& param = configEvent->getParameter();
+                if (param != "zoom" && param != "viewX" && param != "viewY") {
+                    return false;
+                }
+                try {
+                    const double value = std::stod(configEvent->getValue());
+                    if (param == "zoom") {
+                        viewZoom = std::max(1.0, value);
+                    } else if (param == "viewX") {
+                        viewCenterX = std::clamp(value, 0.0, 1.0);
+                    } else {
+                        viewCenterY = std::clamp(value, 0.0, 1.0);
+                    }
+                    updateViewport();
+                } catch (const std::exception& e) {
+                    DEBUG_LOG("AppController", "Error parsing " + param + " value: " + configEvent->getValue());
+                }
+                break;
+            }
+                
             case EventType::ApplicationExiting:
                 DEBUG_LOG("AppController", "Received ApplicationExitingEvent");
                 shutdown();
@@ -227,17 +300,49 @@ void printHelp(const char* programName) {
     std::cout << "Usage: " << programName << " [options]" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  --debug, -d     Enable debug output" << std::endl;
+    std::cout << "  --threads, -t N Number of solver threads (0 = OpenMP default)" << std::endl;
+    std::cout << "  --grid N        Grid points per axis (default: 256)" << std::endl;
+    std::cout << "  --float, -f     Run the simulation in single precision" << std::endl;
+    std::cout << "  --planner MODE  FFTW planner: estimate, measure or patient (default: measure)" << std::endl;
+    std::cout << "  --wisdom DIR    FFTW wisdom store directory, empty to disable (default: fftw_wisdom)" << std::endl;
+    std::cout << "  --steps-per-frame N  Solver steps between displayed frames (default: 1)" << std::endl;
+    std::cout << "  --step-rate R   Maximum solver steps per second, 0 = unlimited (default: 0)" << std::endl;
+    std::cout << "  --trace FILE    Record frame, render and solver timings as a Chrome trace" << std::endl;
     std::cout << "  --help, -h      Show this help message" << std::endl;
 }
 
 int main(int argc, char** argv) {
     // Process command line arguments
     bool debugEnabled = false;
+    int numThreads = 0;
+    int gridSize = 256;
+    std::string precision = "double";
+    std::string planner = "measure";
+    std::string wisdomDir = "fftw_wisdom";
+    int stepsPerFrame = STEPS_PER_FRAME;
+    double stepRate = SIMULATION_RATE;
+    std::string tracePath;
     
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--debug" || arg == "-d") {
             debugEnabled = true;
+        } else if ((arg == "--threads" || arg == "-t") && i + 1 < argc) {
+            numThreads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--grid" && i + 1 < argc) {
+            gridSize = std::max(2, std::atoi(argv[++i]));
+        } else if (arg == "--float" || arg == "-f") {
+            precision = "float";
+        } else if (arg == "--planner" && i + 1 < argc) {
+            planner = argv[++i];
+        } else if (arg == "--wisdom" && i + 1 < argc) {
+            wisdomDir = argv[++i];
+        } else if (arg == "--steps-per-frame" && i + 1 < argc) {
+            stepsPerFrame = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--step-rate" && i + 1 < argc) {
+            stepRate = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
         } else if (arg == "--help" || arg == "-h") {
             printHelp(argv[0]);
             return 0;
@@ -246,6 +351,9 @@ int main(int argc, char** argv) {
     
     // Configure debug utilities
     DebugUtils::getInstance().setDebugEnabled(debugEnabled);
+    if (!tracePath.empty()) {
+        Tracer::getInstance().start(tracePath);
+    }
     
     std::cout << "Program starting..." << std::endl;
     DEBUG_LOG("Main", "Quantum simulator application initializing");
@@ -319,9 +427,13 @@ int main(int argc, char** argv) {
         
         // Create and configure physics
         PhysicsConfig config;
-        config.nx = 256;
-        config.ny = 256;
+        config.nx = gridSize;
+        config.ny = gridSize;
         config.dt = 0.01;
+        config.numThreads = numThreads;
+        config.precision = precision;
+        config.fftw.planner = planner;
+        config.fftw.wisdomDir = wisdomDir;
         config.potential.type = "FreeSpace";  // Initialize with default potential
         
         // Set up wavepacket
@@ -336,18 +448,27 @@ int main(int argc, char** argv) {
                       ", ny=" + std::to_string(config.ny) + ", dt=" + std::to_string(config.dt));
         
         // Create components
-        DEBUG_LOG("Simulation", "Creating simulation engine with configured physics");
-        auto simulationEngine = std::make_shared<SimulationEngine>(config, eventBus);
-        serviceContainer.registerInstance<ISimulationEngine, SimulationEngine>(simulationEngine);
-        
+        DEBUG_LOG("Simulation", "Creating " + config.precision + " precision simulation engine with configured physics");
+        auto simulationEngine = std::make_shared<SimulationWorker>(config, eventBus);
+        simulationEngine->setStepsPerFrame(stepsPerFrame);
+        simulationEngine->setTargetStepRate(stepRate);
+        serviceContainer.registerInstance<ISimulationEngine, SimulationWorker>(simulationEngine);
+        
+        // The display texture never needs more texels than the window has pixels;
+        // larger grids are max-pooled down by the worker before they are uploaded
+        int framebufferWidth = WINDOW_WIDTH;
+        int framebufferHeight = WINDOW_HEIGHT;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        const int textureWidth = std::min(config.nx, std::max(1, framebufferWidth));
+        const int textureHeight = std::min(config.ny, std::max(1, framebufferHeight));
         DEBUG_LOG("Visualization", "Creating visualization engine with dimensions " + 
-                 std::to_string(config.nx) + "x" + std::to_string(config.ny));
-        auto visualizationEngine = std::make_shared<VisualizationEngine>(config.nx, config.ny, eventBus);
+                 std::to_string(textureWidth) + "x" + std::to_string(textureHeight));
+        auto visualizationEngine = std::make_shared<VisualizationEngine>(textureWidth, textureHeight, eventBus);
         serviceContainer.registerInstance<IVisualizationEngine, VisualizationEngine>(visualizationEngine);
         
         // Create UI manager
         DEBUG_LOG("UI", "Creating UI manager with event bus");
-        auto uiManager = std::make_shared<UIManager>(eventBus);
+        auto uiManager = std::make_shared<UIManager>(config, eventBus);
         serviceContainer.registerInstance<IUIManager, UIManager>(uiManager);
         
         // Initialize visualization engine
@@ -396,7 +517,7 @@ int main(int argc, char** argv) {
             }
         });
         
-        // Modify the SimulationEngine to publish events after each step
+        // Publish a step completion event for every frame with new steps
         simulationEngine->setStepCompletionCallback([&]() {
             if (eventBus) {
                 eventBus->publish(makeEvent<SimulationStepCompletedEvent>());
@@ -424,6 +545,11 @@ int main(int argc, char** argv) {
         uiManager->shutdown();
         visualizationEngine->shutdown();
         simulationEngine->shutdown();
+        
+        if (!tracePath.empty()) {
+            const size_t events = Tracer::getInstance().stop();
+            std::cout << "Wrote " << events << " trace events to " << tracePath << std::endl;
+        }
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
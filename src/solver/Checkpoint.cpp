@@ -0,0 +1,518 @@
+#include "Checkpoint.h"
+#include <hdf5.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include "../core/DebugUtils.h"
+
+namespace {
+
+constexpr int kFormatVersion = 2;
+
+// Target size of one /psi chunk; whole rows are kept together
+constexpr size_t kChunkBytes = 1 << 20;
+
+// The HDF5 library is not built thread-safe everywhere, so all calls into it
+// from this file are serialized
+std::mutex& hdf5Mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Closes an HDF5 identifier when it goes out of scope
+class Handle {
+public:
+    Handle(hid_t id, herr_t (*close)(hid_t), const std::string& what) : m_id(id), m_close(close) {
+        if (m_id < 0) {
+            throw std::runtime_error("HDF5: cannot " + what);
+        }
+    }
+    ~Handle() { m_close(m_id); }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    operator hid_t() const { return m_id; }
+
+private:
+    hid_t m_id;
+    herr_t (*m_close)(hid_t);
+};
+
+// Turns off HDF5's own error printing; failures are reported as exceptions
+class SilenceErrors {
+public:
+    SilenceErrors() {
+        H5Eget_auto2(H5E_DEFAULT, &m_func, &m_data);
+        H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);
+    }
+    ~SilenceErrors() { H5Eset_auto2(H5E_DEFAULT, m_func, m_data); }
+
+private:
+    H5E_auto2_t m_func = nullptr;
+    void* m_data = nullptr;
+};
+
+void check(herr_t status, const std::string& what) {
+    if (status < 0) {
+        throw std::runtime_error("HDF5: cannot " + what);
+    }
+}
+
+void writeAttribute(hid_t location, const char* name, hid_t type, const void* value) {
+    Handle space(H5Screate(H5S_SCALAR), H5Sclose, "create dataspace");
+    Handle attribute(H5Acreate2(location, name, type, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose,
+                     std::string("create attribute ") + name);
+    check(H5Awrite(attribute, type, value), std::string("write attribute ") + name);
+}
+
+void writeStringAttribute(hid_t location, const char* name, const std::string& value) {
+    Handle type(H5Tcopy(H5T_C_S1), H5Tclose, "create string type");
+    check(H5Tset_size(type, std::max<size_t>(1, value.size())), "set string size");
+    check(H5Tset_strpad(type, H5T_STR_NULLPAD), "set string padding");
+    writeAttribute(location, name, type, value.empty() ? "" : value.data());
+}
+
+void readAttribute(hid_t location, const char* name, hid_t type, void* value) {
+    Handle attribute(H5Aopen(location, name, H5P_DEFAULT), H5Aclose,
+                     std::string("open attribute ") + name);
+    check(H5Aread(attribute, type, value), std::string("read attribute ") + name);
+}
+
+std::string readStringAttribute(hid_t location, const char* name) {
+    Handle attribute(H5Aopen(location, name, H5P_DEFAULT), H5Aclose,
+                     std::string("open attribute ") + name);
+    Handle fileType(H5Aget_type(attribute), H5Tclose, "get attribute type");
+    const size_t size = H5Tget_size(fileType);
+
+    Handle type(H5Tcopy(H5T_C_S1), H5Tclose, "create string type");
+    check(H5Tset_size(type, size), "set string size");
+    check(H5Tset_strpad(type, H5T_STR_NULLPAD), "set string padding");
+
+    std::string value(size, '\0');
+    check(H5Aread(attribute, type, value.data()), std::string("read attribute ") + name);
+    value.resize(value.find('\0') == std::string::npos ? size : value.find('\0'));
+    return value;
+}
+
+// Write a potential's type, file and parameters at a location; the
+// components of Composite, Driven and Moving potentials go into numbered
+// subgroups of potential_components, written the same way
+void writePotential(hid_t location, const PotentialConfig& potential) {
+    writeStringAttribute(location, "potential_type", potential.type);
+    if (!potential.file.empty()) {
+        writeStringAttribute(location, "potential_file", potential.file);
+    }
+
+    {
+        const hsize_t dims[1] = {potential.parameters.size()};
+        Handle space(H5Screate_simple(1, dims, nullptr), H5Sclose, "create dataspace");
+        Handle dataset(H5Dcreate2(location, "potential_parameters", H5T_IEEE_F64LE, space,
+                                  H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+                       H5Dclose, "create potential_parameters");
+        if (!potential.parameters.empty()) {
+            check(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                           potential.parameters.data()),
+                  "write potential_parameters");
+        }
+    }
+
+    if (potential.components.empty()) {
+        return;
+    }
+    Handle components(H5Gcreate2(location, "potential_components", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+                      H5Gclose, "create potential_components");
+    for (size_t c = 0; c < potential.components.size(); ++c) {
+        const std::string name = std::to_string(c);
+        Handle component(H5Gcreate2(components, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+                         H5Gclose, "create potential component " + name);
+        writePotential(component, potential.components[c]);
+    }
+}
+
+// Read a potential written by writePotential()
+PotentialConfig readPotential(hid_t location) {
+    PotentialConfig potential;
+    potential.type = readStringAttribute(location, "potential_type");
+    if (H5Aexists(location, "potential_file") > 0) {
+        potential.file = readStringAttribute(location, "potential_file");
+    }
+
+    {
+        Handle dataset(H5Dopen2(location, "potential_parameters", H5P_DEFAULT), H5Dclose,
+                       "open potential_parameters");
+        Handle space(H5Dget_space(dataset), H5Sclose, "get dataspace");
+        const hssize_t count = H5Sget_simple_extent_npoints(space);
+        potential.parameters.resize(static_cast<size_t>(std::max<hssize_t>(0, count)));
+        if (count > 0) {
+            check(H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                          potential.parameters.data()),
+                  "read potential_parameters");
+        }
+    }
+
+    if (H5Lexists(location, "potential_components", H5P_DEFAULT) <= 0) {
+        return potential;
+    }
+    Handle components(H5Gopen2(location, "potential_components", H5P_DEFAULT), H5Gclose,
+                      "open potential_components");
+    for (size_t c = 0;; ++c) {
+        const std::string name = std::to_string(c);
+        if (H5Lexists(components, name.c_str(), H5P_DEFAULT) <= 0) {
+            break;
+        }
+        Handle component(H5Gopen2(components, name.c_str(), H5P_DEFAULT), H5Gclose,
+                         "open potential component " + name);
+        potential.components.push_back(readPotential(component));
+    }
+    return potential;
+}
+
+// Write the scalar fields and the potential
+void writeHeader(hid_t file, const CheckpointState& state) {
+    const int version = kFormatVersion;
+    writeAttribute(file, "format_version", H5T_NATIVE_INT, &version);
+    writeAttribute(file, "nx", H5T_NATIVE_INT, &state.nx);
+    writeAttribute(file, "ny", H5T_NATIVE_INT, &state.ny);
+    writeAttribute(file, "lx", H5T_NATIVE_DOUBLE, &state.lx);
+    writeAttribute(file, "ly", H5T_NATIVE_DOUBLE, &state.ly);
+    writeAttribute(file, "dt", H5T_NATIVE_DOUBLE, &state.dt);
+    writeAttribute(file, "time", H5T_NATIVE_DOUBLE, &state.time);
+    writeAttribute(file, "step", H5T_NATIVE_INT64, &state.step);
+    writeStringAttribute(file, "precision", state.precision);
+    if (state.absorbed != 0.0) {
+        writeAttribute(file, "absorbed", H5T_NATIVE_DOUBLE, &state.absorbed);
+    }
+    writePotential(file, state.potential);
+}
+
+// Write the state to path, which must not be open elsewhere
+void writeFile(const std::string& path, const CheckpointState& state, int compressionLevel) {
+    Handle file(H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT), H5Fclose,
+                "create " + path);
+    writeHeader(file, state);
+
+    // Wavefunction, chunked by whole rows
+    if (state.nx <= 0 || state.ny <= 0 ||
+        state.psi.size() != static_cast<size_t>(state.nx) * static_cast<size_t>(state.ny)) {
+        throw std::runtime_error("Checkpoint wavefunction does not match its " +
+                                 std::to_string(state.nx) + "x" + std::to_string(state.ny) + " grid");
+    }
+
+    const bool single = state.precision == "float";
+    const hid_t fileType = single ? H5T_IEEE_F32LE : H5T_IEEE_F64LE;
+    const size_t rowBytes = static_cast<size_t>(state.nx) * 2 * (single ? sizeof(float) : sizeof(double));
+
+    const hsize_t dims[3] = {static_cast<hsize_t>(state.ny), static_cast<hsize_t>(state.nx), 2};
+    const hsize_t chunk[3] = {
+        static_cast<hsize_t>(std::clamp<size_t>(kChunkBytes / rowBytes, 1, static_cast<size_t>(state.ny))),
+        static_cast<hsize_t>(state.nx), 2};
+
+    Handle space(H5Screate_simple(3, dims, nullptr), H5Sclose, "create dataspace");
+    Handle properties(H5Pcreate(H5P_DATASET_CREATE), H5Pclose, "create dataset properties");
+    check(H5Pset_chunk(properties, 3, chunk), "set chunk size");
+    if (compressionLevel > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+        check(H5Pset_shuffle(properties), "enable shuffle filter");
+        check(H5Pset_deflate(properties, static_cast<unsigned>(std::min(compressionLevel, 9))),
+              "enable deflate filter");
+    }
+
+    Handle dataset(H5Dcreate2(file, "psi", fileType, space, H5P_DEFAULT, properties, H5P_DEFAULT),
+                   H5Dclose, "create psi");
+    check(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, state.psi.data()),
+          "write psi");
+}
+
+// Read the scalar fields and the potential
+CheckpointState readHeader(hid_t file, const std::string& path) {
+    int version = 0;
+    readAttribute(file, "format_version", H5T_NATIVE_INT, &version);
+    if (version != kFormatVersion) {
+        throw std::runtime_error("Unsupported checkpoint format version " + std::to_string(version) +
+                                 " in " + path);
+    }
+
+    CheckpointState state;
+    readAttribute(file, "nx", H5T_NATIVE_INT, &state.nx);
+    readAttribute(file, "ny", H5T_NATIVE_INT, &state.ny);
+    readAttribute(file, "lx", H5T_NATIVE_DOUBLE, &state.lx);
+    readAttribute(file, "ly", H5T_NATIVE_DOUBLE, &state.ly);
+    readAttribute(file, "dt", H5T_NATIVE_DOUBLE, &state.dt);
+    readAttribute(file, "time", H5T_NATIVE_DOUBLE, &state.time);
+    readAttribute(file, "step", H5T_NATIVE_INT64, &state.step);
+    state.precision = readStringAttribute(file, "precision");
+    if (H5Aexists(file, "absorbed") > 0) {
+        readAttribute(file, "absorbed", H5T_NATIVE_DOUBLE, &state.absorbed);
+    }
+    state.potential = readPotential(file);
+
+    return state;
+}
+
+// Check that /psi is (ny, nx, 2)
+void checkWavefunctionShape(hid_t space, const CheckpointState& state, const std::string& path) {
+    hsize_t dims[3] = {0, 0, 0};
+    if (H5Sget_simple_extent_ndims(space) != 3 ||
+        H5Sget_simple_extent_dims(space, dims, nullptr) != 3 ||
+        dims[0] != static_cast<hsize_t>(state.ny) || dims[1] != static_cast<hsize_t>(state.nx) ||
+        dims[2] != 2) {
+        throw std::runtime_error("Checkpoint wavefunction does not match its grid in " + path);
+    }
+}
+
+}  // namespace
+
+// Write a checkpoint through a temporary file
+void Checkpoint::write(const std::string& path, const CheckpointState& state, int compressionLevel) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::lock_guard<std::mutex> lock(hdf5Mutex());
+        SilenceErrors silence;
+        try {
+            writeFile(temporary, state, compressionLevel);
+        }
+        catch (...) {
+            std::remove(temporary.c_str());
+            throw;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot move checkpoint to " + path + ": " + error.message());
+    }
+    DEBUG_LOG("Checkpoint", "Wrote checkpoint " + path + " at t=" + std::to_string(state.time));
+}
+
+// Read a checkpoint file
+CheckpointState Checkpoint::read(const std::string& path, bool includeWavefunction) {
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Checkpoint not found: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(hdf5Mutex());
+    SilenceErrors silence;
+
+    Handle file(H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose, "open " + path);
+    CheckpointState state = readHeader(file, path);
+
+    if (includeWavefunction) {
+        Handle dataset(H5Dopen2(file, "psi", H5P_DEFAULT), H5Dclose, "open psi");
+        Handle space(H5Dget_space(dataset), H5Sclose, "get dataspace");
+        checkWavefunctionShape(space, state, path);
+
+        state.psi.resize(static_cast<size_t>(state.nx) * static_cast<size_t>(state.ny));
+        check(H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, state.psi.data()),
+              "read psi");
+    }
+
+    return state;
+}
+
+#ifdef QMSIM_WITH_MPI
+// Write a checkpoint collectively through a temporary file
+void Checkpoint::writeParallel(MPI_Comm comm, const std::string& path, const CheckpointState& state,
+                               int firstRow, int rows) {
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    if (state.nx <= 0 || state.ny <= 0 || firstRow < 0 || rows < 0 || firstRow + rows > state.ny ||
+        state.psi.size() != static_cast<size_t>(rows) * static_cast<size_t>(state.nx)) {
+        throw std::runtime_error("Checkpoint slab does not match its " + std::to_string(state.nx) +
+                                 "x" + std::to_string(state.ny) + " grid");
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::lock_guard<std::mutex> lock(hdf5Mutex());
+        SilenceErrors silence;
+
+        Handle access(H5Pcreate(H5P_FILE_ACCESS), H5Pclose, "create file access properties");
+        check(H5Pset_fapl_mpio(access, comm, MPI_INFO_NULL), "set MPI-IO file access");
+        Handle file(H5Fcreate(temporary.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, access), H5Fclose,
+                    "create " + temporary);
+        writeHeader(file, state);
+
+        const hsize_t dims[3] = {static_cast<hsize_t>(state.ny), static_cast<hsize_t>(state.nx), 2};
+        Handle fileSpace(H5Screate_simple(3, dims, nullptr), H5Sclose, "create dataspace");
+        Handle dataset(H5Dcreate2(file, "psi", H5T_IEEE_F64LE, fileSpace, H5P_DEFAULT, H5P_DEFAULT,
+                                  H5P_DEFAULT),
+                       H5Dclose, "create psi");
+
+        const hsize_t start[3] = {static_cast<hsize_t>(firstRow), 0, 0};
+        const hsize_t count[3] = {static_cast<hsize_t>(rows), static_cast<hsize_t>(state.nx), 2};
+        Handle slab(H5Dget_space(dataset), H5Sclose, "get dataspace");
+        Handle memory(H5Screate_simple(3, count, nullptr), H5Sclose, "create memory dataspace");
+        if (rows > 0) {
+            check(H5Sselect_hyperslab(slab, H5S_SELECT_SET, start, nullptr, count, nullptr),
+                  "select psi rows");
+        }
+        else {
+            check(H5Sselect_none(slab), "select no psi rows");
+            check(H5Sselect_none(memory), "select no memory");
+        }
+
+        Handle transfer(H5Pcreate(H5P_DATASET_XFER), H5Pclose, "create transfer properties");
+        check(H5Pset_dxpl_mpio(transfer, H5FD_MPIO_COLLECTIVE), "set collective transfer");
+        check(H5Dwrite(dataset, H5T_NATIVE_DOUBLE, memory, slab, transfer, state.psi.data()),
+              "write psi");
+    }
+
+    // The file is closed on every rank before it is moved
+    MPI_Barrier(comm);
+    int failed = 0;
+    if (rank == 0) {
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            std::remove(temporary.c_str());
+            failed = 1;
+        }
+    }
+    MPI_Bcast(&failed, 1, MPI_INT, 0, comm);
+    if (failed) {
+        throw std::runtime_error("Cannot move checkpoint to " + path);
+    }
+    if (rank == 0) {
+        DEBUG_LOG("Checkpoint", "Wrote parallel checkpoint " + path + " at t=" + std::to_string(state.time));
+    }
+}
+
+// Read one slab of a checkpoint collectively
+CheckpointState Checkpoint::readParallel(MPI_Comm comm, const std::string& path, int firstRow, int rows) {
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Checkpoint not found: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(hdf5Mutex());
+    SilenceErrors silence;
+
+    Handle access(H5Pcreate(H5P_FILE_ACCESS), H5Pclose, "create file access properties");
+    check(H5Pset_fapl_mpio(access, comm, MPI_INFO_NULL), "set MPI-IO file access");
+    Handle file(H5Fopen(path.c_str(), H5F_ACC_RDONLY, access), H5Fclose, "open " + path);
+    CheckpointState state = readHeader(file, path);
+    if (firstRow < 0 || rows < 0 || firstRow + rows > state.ny) {
+        throw std::runtime_error("Checkpoint slab is outside the grid in " + path);
+    }
+
+    Handle dataset(H5Dopen2(file, "psi", H5P_DEFAULT), H5Dclose, "open psi");
+    Handle slab(H5Dget_space(dataset), H5Sclose, "get dataspace");
+    checkWavefunctionShape(slab, state, path);
+
+    const hsize_t start[3] = {static_cast<hsize_t>(firstRow), 0, 0};
+    const hsize_t count[3] = {static_cast<hsize_t>(rows), static_cast<hsize_t>(state.nx), 2};
+    Handle memory(H5Screate_simple(3, count, nullptr), H5Sclose, "create memory dataspace");
+    if (rows > 0) {
+        check(H5Sselect_hyperslab(slab, H5S_SELECT_SET, start, nullptr, count, nullptr),
+              "select psi rows");
+    }
+    else {
+        check(H5Sselect_none(slab), "select no psi rows");
+        check(H5Sselect_none(memory), "select no memory");
+    }
+
+    state.psi.resize(static_cast<size_t>(rows) * static_cast<size_t>(state.nx));
+    Handle transfer(H5Pcreate(H5P_DATASET_XFER), H5Pclose, "create transfer properties");
+    check(H5Pset_dxpl_mpio(transfer, H5FD_MPIO_COLLECTIVE), "set collective transfer");
+    check(H5Dread(dataset, H5T_NATIVE_DOUBLE, memory, slab, transfer, state.psi.data()), "read psi");
+    return state;
+}
+#endif
+
+// Convert a checkpoint interval in simulation time to steps
+int Checkpoint::intervalSteps(double interval, double dt) {
+    if (interval <= 0.0 || dt <= 0.0) {
+        return 0;
+    }
+    return std::max(1, static_cast<int>(std::lround(interval / dt)));
+}
+
+// Start the writer thread
+CheckpointWriter::CheckpointWriter(int compressionLevel)
+    : m_compressionLevel(compressionLevel),
+      m_thread(&CheckpointWriter::threadMain, this) {}
+
+// Finish pending writes and stop the writer thread
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+// Queue a checkpoint, replacing one that has not been started yet
+void CheckpointWriter::submit(const std::string& path, CheckpointState state) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        rethrowError();
+        if (m_pending) {
+            DEBUG_LOG("Checkpoint", "Writer is behind; dropping checkpoint at t=" +
+                      std::to_string(m_pending->time));
+        }
+        m_pending = std::make_unique<CheckpointState>(std::move(state));
+        m_pendingPath = path;
+    }
+    m_condition.notify_all();
+}
+
+// Wait until all queued checkpoints are on disk
+void CheckpointWriter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() { return !m_pending && !m_writing; });
+    rethrowError();
+}
+
+// Get the number of checkpoints written so far
+int CheckpointWriter::getWrittenCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+// Rethrow a stored write error (called with m_mutex held)
+void CheckpointWriter::rethrowError() {
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// Writer thread main loop
+void CheckpointWriter::threadMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this]() { return m_stopRequested || m_pending; });
+        if (!m_pending) {
+            return;  // Stop requested with nothing left to write
+        }
+
+        std::unique_ptr<CheckpointState> state = std::move(m_pending);
+        std::string path = m_pendingPath;
+        m_writing = true;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            Checkpoint::write(path, *state, m_compressionLevel);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_writing = false;
+        if (error) {
+            if (!m_error) {
+                m_error = error;
+            }
+        } else {
+            ++m_written;
+        }
+        m_condition.notify_all();
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/PhysicsConfig.h"
+
+#ifdef QMSIM_WITH_MPI
+#include <mpi.h>
+#endif
+
+/**
+ * @struct CheckpointState
+ * @brief Everything needed to continue a simulation where it stopped
+ */
+struct CheckpointState {
+    int nx = 0;                 ///< Grid points in x direction
+    int ny = 0;                 ///< Grid points in y direction
+    double lx = 0.0;            ///< Physical length of the domain in x direction
+    double ly = 0.0;            ///< Physical length of the domain in y direction
+    double dt = 0.0;            ///< Time step size
+    double time = 0.0;          ///< Simulation time of the state
+    int64_t step = 0;           ///< Steps taken to reach the state (set by the caller)
+    std::string precision = "double";  ///< Precision of the engine that wrote the state
+    PotentialConfig potential;  ///< Potential type, parameters, file and components
+    double absorbed = 0.0;      ///< Probability removed by the absorbing layer before the state
+    std::vector<std::complex<double>> psi;  ///< Wavefunction in storage order (x fastest)
+};
+
+/**
+ * @class Checkpoint
+ * @brief HDF5 checkpoint files of the simulation state
+ *
+ * File layout (format version 2):
+ * - root attributes: format_version, nx, ny, lx, ly, dt, time, step,
+ *   precision, potential_type, potential_file (optional), absorbed (optional)
+ * - /potential_parameters: 1-D float64 dataset
+ * - /potential_components/<i> (optional): one group per component of a
+ *   Composite, Driven or Moving potential, laid out like the root potential
+ * - /psi: (ny, nx, 2) dataset of real and imaginary parts, chunked by rows
+ *   and stored as float32 for single precision states; optionally
+ *   compressed with shuffle + deflate
+ *
+ * Files are written to a temporary name and renamed into place, so a run
+ * killed mid-write leaves the previous checkpoint intact. MPI builds can
+ * also write and read the same layout collectively, one row slab per rank.
+ */
+class Checkpoint {
+public:
+    /**
+     * @brief Write a checkpoint file
+     * @param path Destination file; its directory must exist
+     * @param state State to save
+     * @param compressionLevel Deflate level 1-9, or 0 for no compression
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void write(const std::string& path, const CheckpointState& state, int compressionLevel = 0);
+
+    /**
+     * @brief Read a checkpoint file
+     * @param path Checkpoint file to read
+     * @param includeWavefunction False to read only the scalar fields and potential
+     * @return The saved state
+     * @throws std::runtime_error if the file is missing or malformed
+     */
+    static CheckpointState read(const std::string& path, bool includeWavefunction = true);
+
+#ifdef QMSIM_WITH_MPI
+    /**
+     * @brief Write a checkpoint collectively with parallel HDF5
+     *
+     * Every rank of comm must call this with the same scalar fields; each
+     * writes its own rows of /psi. The dataset is stored unchunked and
+     * uncompressed, which parallel HDF5 requires for independent slabs.
+     *
+     * @param comm Communicator of the ranks sharing the file
+     * @param path Destination file; its directory must exist
+     * @param state State to save, with psi holding only rows [firstRow, firstRow + rows)
+     * @param firstRow First global row owned by this rank
+     * @param rows Number of rows owned by this rank (may be 0)
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void writeParallel(MPI_Comm comm, const std::string& path, const CheckpointState& state,
+                              int firstRow, int rows);
+
+    /**
+     * @brief Read one slab of a checkpoint collectively
+     * @param comm Communicator of the ranks sharing the file
+     * @param path Checkpoint file to read
+     * @param firstRow First global row to read into psi
+     * @param rows Number of rows to read (may be 0)
+     * @return The saved scalar fields, with psi holding rows * nx values
+     * @throws std::runtime_error if the file is missing or malformed
+     */
+    static CheckpointState readParallel(MPI_Comm comm, const std::string& path, int firstRow, int rows);
+#endif
+
+    /**
+     * @brief Convert a checkpoint interval in simulation time to steps
+     * @param interval Interval in simulation time units (<= 0 disables checkpoints)
+     * @param dt Time step size
+     * @return Steps between checkpoints, or 0 if disabled
+     */
+    static int intervalSteps(double interval, double dt);
+};
+
+/**
+ * @class CheckpointWriter
+ * @brief Writes checkpoints on a background thread
+ *
+ * submit() only moves the state into the writer, so the stepping thread is
+ * blocked just for the copy of the wavefunction made when capturing it. If
+ * a new checkpoint arrives while an older one is still waiting, the older
+ * one is dropped; the file on disk is always the newest completed state.
+ */
+class CheckpointWriter {
+public:
+    /**
+     * @brief Start the writer thread
+     * @param compressionLevel Deflate level 1-9, or 0 for no compression
+     */
+    explicit CheckpointWriter(int compressionLevel = 0);
+
+    /**
+     * @brief Finish pending writes and stop the writer thread
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Queue a checkpoint for writing
+     * @param path Destination file
+     * @param state State to save
+     * @throws std::runtime_error if an earlier write failed
+     */
+    void submit(const std::string& path, CheckpointState state);
+
+    /**
+     * @brief Wait until all queued checkpoints are on disk
+     * @throws std::runtime_error if a write failed
+     */
+    void flush();
+
+    /**
+     * @brief Get the number of checkpoints written so far
+     * @return Completed writes
+     */
+    int getWrittenCount() const;
+
+private:
+    /**
+     * @brief Writer thread main loop
+     */
+    void threadMain();
+
+    /**
+     * @brief Rethrow a stored write error, clearing it
+     */
+    void rethrowError();
+
+    int m_compressionLevel;  ///< Deflate level for written files
+
+    mutable std::mutex m_mutex;               ///< Guards all members below
+    std::condition_variable m_condition;      ///< Signals new work and completed writes
+    std::unique_ptr<CheckpointState> m_pending;  ///< Newest queued state, if any
+    std::string m_pendingPath;                ///< Destination of the queued state
+    bool m_writing = false;                   ///< A write is in progress
+    bool m_stopRequested = false;             ///< Writer thread should exit
+    int m_written = 0;                        ///< Completed writes
+    std::exception_ptr m_error;               ///< First write failure not yet reported
+
+    std::thread m_thread;  ///< The writer thread
+};
@@ -0,0 +1,606 @@
+#include "ComplexKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QMSIM_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define QMSIM_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace kernels {
+
+namespace {
+
+// Kernels for one element precision
+template <typename T>
+struct KernelSet {
+    void (*multiply)(T*, const T*, size_t);
+    void (*multiplySquared)(T*, const T*, size_t);
+    void (*scale)(T*, T, size_t);
+    void (*normToFloat)(const T*, float*, size_t);
+    double (*sumNorm)(const T*, size_t);
+};
+
+// Function table for one instruction set
+struct KernelTable {
+    KernelSet<double> f64;
+    KernelSet<float> f32;
+};
+
+// Scalar implementations, written on the real/imaginary parts so that the
+// compiler can vectorize them without -fcx-limited-range
+
+template <typename T>
+void multiplyScalar(T* psi, const T* table, size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        T ar = psi[2 * n], ai = psi[2 * n + 1];
+        T br = table[2 * n], bi = table[2 * n + 1];
+        psi[2 * n] = ar * br - ai * bi;
+        psi[2 * n + 1] = ar * bi + ai * br;
+    }
+}
+
+template <typename T>
+void multiplySquaredScalar(T* psi, const T* table, size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        T br = table[2 * n], bi = table[2 * n + 1];
+        T sr = br * br - bi * bi, si = 2 * br * bi;
+        T ar = psi[2 * n], ai = psi[2 * n + 1];
+        psi[2 * n] = ar * sr - ai * si;
+        psi[2 * n + 1] = ar * si + ai * sr;
+    }
+}
+
+template <typename T>
+void scaleScalar(T* psi, T factor, size_t count) {
+    for (size_t n = 0; n < 2 * count; ++n) {
+        psi[n] *= factor;
+    }
+}
+
+template <typename T>
+void normToFloatScalar(const T* psi, float* out, size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        out[n] = static_cast<float>(psi[2 * n] * psi[2 * n] + psi[2 * n + 1] * psi[2 * n + 1]);
+    }
+}
+
+// Sums are accumulated in double for both precisions
+template <typename T>
+double sumNormScalar(const T* psi, size_t count) {
+    double sum = 0.0;
+    for (size_t n = 0; n < 2 * count; ++n) {
+        double v = psi[n];
+        sum += v * v;
+    }
+    return sum;
+}
+
+template <typename T>
+constexpr KernelSet<T> scalarSet() {
+    return { multiplyScalar<T>, multiplySquaredScalar<T>, scaleScalar<T>, normToFloatScalar<T>, sumNormScalar<T> };
+}
+
+const KernelTable s_scalarTable = { scalarSet<double>(), scalarSet<float>() };
+
+#ifdef QMSIM_KERNELS_X86
+
+// AVX2: one __m256d holds two interleaved complex values [r0 i0 r1 i1]
+
+__attribute__((target("avx2,fma")))
+inline __m256d complexMul256(__m256d a, __m256d b) {
+    __m256d br = _mm256_movedup_pd(b);         // [br0 br0 br1 br1]
+    __m256d bi = _mm256_permute_pd(b, 0xF);    // [bi0 bi0 bi1 bi1]
+    __m256d aSwap = _mm256_permute_pd(a, 0x5); // [ai0 ar0 ai1 ar1]
+    // Even lanes: ar*br - ai*bi, odd lanes: ai*br + ar*bi
+    return _mm256_fmaddsub_pd(a, br, _mm256_mul_pd(aSwap, bi));
+}
+
+__attribute__((target("avx2,fma")))
+void multiplyAVX2(double* psi, const double* table, size_t count) {
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        __m256d a = _mm256_loadu_pd(psi + 2 * n);
+        __m256d b = _mm256_loadu_pd(table + 2 * n);
+        _mm256_storeu_pd(psi + 2 * n, complexMul256(a, b));
+    }
+    multiplyScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void multiplySquaredAVX2(double* psi, const double* table, size_t count) {
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        __m256d a = _mm256_loadu_pd(psi + 2 * n);
+        __m256d b = _mm256_loadu_pd(table + 2 * n);
+        _mm256_storeu_pd(psi + 2 * n, complexMul256(a, complexMul256(b, b)));
+    }
+    multiplySquaredScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void scaleAVX2(double* psi, double factor, size_t count) {
+    __m256d f = _mm256_set1_pd(factor);
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        _mm256_storeu_pd(psi + 2 * n, _mm256_mul_pd(_mm256_loadu_pd(psi + 2 * n), f));
+    }
+    scaleScalar(psi + 2 * n, factor, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void normToFloatAVX2(const double* psi, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256d a = _mm256_loadu_pd(psi + 2 * n);
+        __m256d b = _mm256_loadu_pd(psi + 2 * n + 4);
+        // hadd gives [|a0|² |b0|² |a1|² |b1|²]; reorder to [a0 a1 b0 b1]
+        __m256d sums = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        sums = _mm256_permute4x64_pd(sums, 0xD8);
+        _mm_storeu_ps(out + n, _mm256_cvtpd_ps(sums));
+    }
+    normToFloatScalar(psi + 2 * n, out + n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+double sumNormAVX2(const double* psi, size_t count) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256d a = _mm256_loadu_pd(psi + 2 * n);
+        __m256d b = _mm256_loadu_pd(psi + 2 * n + 4);
+        acc0 = _mm256_fmadd_pd(a, a, acc0);
+        acc1 = _mm256_fmadd_pd(b, b, acc1);
+    }
+    __m256d acc = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return sum + sumNormScalar(psi + 2 * n, count - n);
+}
+
+// AVX2 single precision: one __m256 holds four interleaved complex values
+
+__attribute__((target("avx2,fma")))
+inline __m256 complexMul256(__m256 a, __m256 b) {
+    __m256 br = _mm256_moveldup_ps(b);         // [br0 br0 br1 br1 ...]
+    __m256 bi = _mm256_movehdup_ps(b);         // [bi0 bi0 bi1 bi1 ...]
+    __m256 aSwap = _mm256_permute_ps(a, 0xB1); // [ai0 ar0 ai1 ar1 ...]
+    return _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(aSwap, bi));
+}
+
+__attribute__((target("avx2,fma")))
+void multiplyAVX2(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256 a = _mm256_loadu_ps(psi + 2 * n);
+        __m256 b = _mm256_loadu_ps(table + 2 * n);
+        _mm256_storeu_ps(psi + 2 * n, complexMul256(a, b));
+    }
+    multiplyScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void multiplySquaredAVX2(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256 a = _mm256_loadu_ps(psi + 2 * n);
+        __m256 b = _mm256_loadu_ps(table + 2 * n);
+        _mm256_storeu_ps(psi + 2 * n, complexMul256(a, complexMul256(b, b)));
+    }
+    multiplySquaredScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void scaleAVX2(float* psi, float factor, size_t count) {
+    __m256 f = _mm256_set1_ps(factor);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        _mm256_storeu_ps(psi + 2 * n, _mm256_mul_ps(_mm256_loadu_ps(psi + 2 * n), f));
+    }
+    scaleScalar(psi + 2 * n, factor, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+void normToFloatAVX2(const float* psi, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 a = _mm256_loadu_ps(psi + 2 * n);
+        __m256 b = _mm256_loadu_ps(psi + 2 * n + 8);
+        // hadd gives [a0 a1 b0 b1 | a2 a3 b2 b3]; reorder the 64-bit pairs
+        __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+        sums = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), 0xD8));
+        _mm256_storeu_ps(out + n, sums);
+    }
+    normToFloatScalar(psi + 2 * n, out + n, count - n);
+}
+
+__attribute__((target("avx2,fma")))
+double sumNormAVX2(const float* psi, size_t count) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m256 a = _mm256_loadu_ps(psi + 2 * n);
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(a));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1));
+        acc0 = _mm256_fmadd_pd(lo, lo, acc0);
+        acc1 = _mm256_fmadd_pd(hi, hi, acc1);
+    }
+    __m256d acc = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return sum + sumNormScalar(psi + 2 * n, count - n);
+}
+
+const KernelTable s_avx2Table = {
+    { multiplyAVX2, multiplySquaredAVX2, scaleAVX2, normToFloatAVX2, sumNormAVX2 },
+    { multiplyAVX2, multiplySquaredAVX2, scaleAVX2, normToFloatAVX2, sumNormAVX2 }
+};
+
+// AVX-512: one __m512d holds four interleaved complex values
+
+__attribute__((target("avx512f")))
+inline __m512d complexMul512(__m512d a, __m512d b) {
+    __m512d br = _mm512_movedup_pd(b);
+    __m512d bi = _mm512_permute_pd(b, 0xFF);
+    __m512d aSwap = _mm512_permute_pd(a, 0x55);
+    return _mm512_fmaddsub_pd(a, br, _mm512_mul_pd(aSwap, bi));
+}
+
+__attribute__((target("avx512f")))
+void multiplyAVX512(double* psi, const double* table, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m512d a = _mm512_loadu_pd(psi + 2 * n);
+        __m512d b = _mm512_loadu_pd(table + 2 * n);
+        _mm512_storeu_pd(psi + 2 * n, complexMul512(a, b));
+    }
+    multiplyScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx512f")))
+void multiplySquaredAVX512(double* psi, const double* table, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m512d a = _mm512_loadu_pd(psi + 2 * n);
+        __m512d b = _mm512_loadu_pd(table + 2 * n);
+        _mm512_storeu_pd(psi + 2 * n, complexMul512(a, complexMul512(b, b)));
+    }
+    multiplySquaredScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx512f")))
+void scaleAVX512(double* psi, double factor, size_t count) {
+    __m512d f = _mm512_set1_pd(factor);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        _mm512_storeu_pd(psi + 2 * n, _mm512_mul_pd(_mm512_loadu_pd(psi + 2 * n), f));
+    }
+    scaleScalar(psi + 2 * n, factor, count - n);
+}
+
+__attribute__((target("avx512f")))
+double sumNormAVX512(const double* psi, size_t count) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m512d a = _mm512_loadu_pd(psi + 2 * n);
+        acc = _mm512_fmadd_pd(a, a, acc);
+    }
+    return _mm512_reduce_add_pd(acc) + sumNormScalar(psi + 2 * n, count - n);
+}
+
+// AVX-512 single precision: one __m512 holds eight interleaved complex values
+
+__attribute__((target("avx512f")))
+inline __m512 complexMul512(__m512 a, __m512 b) {
+    __m512 br = _mm512_moveldup_ps(b);
+    __m512 bi = _mm512_movehdup_ps(b);
+    __m512 aSwap = _mm512_permute_ps(a, 0xB1);
+    return _mm512_fmaddsub_ps(a, br, _mm512_mul_ps(aSwap, bi));
+}
+
+__attribute__((target("avx512f")))
+void multiplyAVX512(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m512 a = _mm512_loadu_ps(psi + 2 * n);
+        __m512 b = _mm512_loadu_ps(table + 2 * n);
+        _mm512_storeu_ps(psi + 2 * n, complexMul512(a, b));
+    }
+    multiplyScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx512f")))
+void multiplySquaredAVX512(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m512 a = _mm512_loadu_ps(psi + 2 * n);
+        __m512 b = _mm512_loadu_ps(table + 2 * n);
+        _mm512_storeu_ps(psi + 2 * n, complexMul512(a, complexMul512(b, b)));
+    }
+    multiplySquaredScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+__attribute__((target("avx512f")))
+void scaleAVX512(float* psi, float factor, size_t count) {
+    __m512 f = _mm512_set1_ps(factor);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        _mm512_storeu_ps(psi + 2 * n, _mm512_mul_ps(_mm512_loadu_ps(psi + 2 * n), f));
+    }
+    scaleScalar(psi + 2 * n, factor, count - n);
+}
+
+__attribute__((target("avx512f")))
+double sumNormAVX512(const float* psi, size_t count) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m512 a = _mm512_loadu_ps(psi + 2 * n);
+        __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(a));
+        __m512d hi = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1)));
+        acc0 = _mm512_fmadd_pd(lo, lo, acc0);
+        acc1 = _mm512_fmadd_pd(hi, hi, acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) + sumNormScalar(psi + 2 * n, count - n);
+}
+
+// The float conversion is bound by the narrow stores, so AVX-512 reuses AVX2
+const KernelTable s_avx512Table = {
+    { multiplyAVX512, multiplySquaredAVX512, scaleAVX512, normToFloatAVX2, sumNormAVX512 },
+    { multiplyAVX512, multiplySquaredAVX512, scaleAVX512, normToFloatAVX2, sumNormAVX512 }
+};
+
+#endif  // QMSIM_KERNELS_X86
+
+#ifdef QMSIM_KERNELS_NEON
+
+// NEON: one float64x2_t holds a single complex value [r i]
+
+inline float64x2_t complexMulNeon(float64x2_t a, float64x2_t b) {
+    static const double signs[2] = { -1.0, 1.0 };
+    float64x2_t br = vdupq_laneq_f64(b, 0);
+    float64x2_t bi = vdupq_laneq_f64(b, 1);
+    float64x2_t aSwap = vextq_f64(a, a, 1);  // [ai ar]
+    float64x2_t cross = vmulq_f64(vmulq_f64(aSwap, bi), vld1q_f64(signs));
+    return vfmaq_f64(cross, a, br);          // [ar*br - ai*bi, ai*br + ar*bi]
+}
+
+void multiplyNeon(double* psi, const double* table, size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        vst1q_f64(psi + 2 * n, complexMulNeon(vld1q_f64(psi + 2 * n), vld1q_f64(table + 2 * n)));
+    }
+}
+
+void multiplySquaredNeon(double* psi, const double* table, size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+        float64x2_t b = vld1q_f64(table + 2 * n);
+        vst1q_f64(psi + 2 * n, complexMulNeon(vld1q_f64(psi + 2 * n), complexMulNeon(b, b)));
+    }
+}
+
+void scaleNeon(double* psi, double factor, size_t count) {
+    float64x2_t f = vdupq_n_f64(factor);
+    for (size_t n = 0; n < count; ++n) {
+        vst1q_f64(psi + 2 * n, vmulq_f64(vld1q_f64(psi + 2 * n), f));
+    }
+}
+
+void normToFloatNeon(const double* psi, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        float64x2_t a = vld1q_f64(psi + 2 * n);
+        float64x2_t b = vld1q_f64(psi + 2 * n + 2);
+        float64x2_t sums = vpaddq_f64(vmulq_f64(a, a), vmulq_f64(b, b));
+        vst1_f32(out + n, vcvt_f32_f64(sums));
+    }
+    normToFloatScalar(psi + 2 * n, out + n, count - n);
+}
+
+double sumNormNeon(const double* psi, size_t count) {
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (size_t n = 0; n < count; ++n) {
+        float64x2_t a = vld1q_f64(psi + 2 * n);
+        acc = vfmaq_f64(acc, a, a);
+    }
+    return vaddvq_f64(acc);
+}
+
+// NEON single precision: one float32x4_t holds two complex values
+
+inline float32x4_t complexMulNeon(float32x4_t a, float32x4_t b) {
+    static const float signs[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+    float32x4_t br = vtrn1q_f32(b, b);       // [br0 br0 br1 br1]
+    float32x4_t bi = vtrn2q_f32(b, b);       // [bi0 bi0 bi1 bi1]
+    float32x4_t aSwap = vrev64q_f32(a);      // [ai0 ar0 ai1 ar1]
+    float32x4_t cross = vmulq_f32(vmulq_f32(aSwap, bi), vld1q_f32(signs));
+    return vfmaq_f32(cross, a, br);
+}
+
+void multiplyNeon(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        vst1q_f32(psi + 2 * n, complexMulNeon(vld1q_f32(psi + 2 * n), vld1q_f32(table + 2 * n)));
+    }
+    multiplyScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+void multiplySquaredNeon(float* psi, const float* table, size_t count) {
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        float32x4_t b = vld1q_f32(table + 2 * n);
+        vst1q_f32(psi + 2 * n, complexMulNeon(vld1q_f32(psi + 2 * n), complexMulNeon(b, b)));
+    }
+    multiplySquaredScalar(psi + 2 * n, table + 2 * n, count - n);
+}
+
+void scaleNeon(float* psi, float factor, size_t count) {
+    float32x4_t f = vdupq_n_f32(factor);
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        vst1q_f32(psi + 2 * n, vmulq_f32(vld1q_f32(psi + 2 * n), f));
+    }
+    scaleScalar(psi + 2 * n, factor, count - n);
+}
+
+void normToFloatNeon(const float* psi, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        float32x4_t a = vld1q_f32(psi + 2 * n);
+        float32x4_t b = vld1q_f32(psi + 2 * n + 4);
+        vst1q_f32(out + n, vpaddq_f32(vmulq_f32(a, a), vmulq_f32(b, b)));
+    }
+    normToFloatScalar(psi + 2 * n, out + n, count - n);
+}
+
+double sumNormNeon(const float* psi, size_t count) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t n = 0;
+    for (; n + 2 <= count; n += 2) {
+        float32x4_t a = vld1q_f32(psi + 2 * n);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(a));
+        float64x2_t hi = vcvt_high_f64_f32(a);
+        acc0 = vfmaq_f64(acc0, lo, lo);
+        acc1 = vfmaq_f64(acc1, hi, hi);
+    }
+    return vaddvq_f64(vaddq_f64(acc0, acc1)) + sumNormScalar(psi + 2 * n, count - n);
+}
+
+const KernelTable s_neonTable = {
+    { multiplyNeon, multiplySquaredNeon, scaleNeon, normToFloatNeon, sumNormNeon },
+    { multiplyNeon, multiplySquaredNeon, scaleNeon, normToFloatNeon, sumNormNeon }
+};
+
+#endif  // QMSIM_KERNELS_NEON
+
+const KernelTable* tableFor(Isa isa) {
+    switch (isa) {
+#ifdef QMSIM_KERNELS_X86
+        case Isa::AVX2:   return &s_avx2Table;
+        case Isa::AVX512: return &s_avx512Table;
+#endif
+#ifdef QMSIM_KERNELS_NEON
+        case Isa::NEON:   return &s_neonTable;
+#endif
+        case Isa::Scalar: return &s_scalarTable;
+        default:          return nullptr;
+    }
+}
+
+Isa detectBestIsa() {
+    if (isSupported(Isa::AVX512)) return Isa::AVX512;
+    if (isSupported(Isa::AVX2)) return Isa::AVX2;
+    if (isSupported(Isa::NEON)) return Isa::NEON;
+    return Isa::Scalar;
+}
+
+// Active selection, initialized on first use
+struct Dispatch {
+    Isa isa;
+    const KernelTable* table;
+};
+
+Dispatch& dispatch() {
+    static Dispatch s_dispatch = [] {
+        Isa isa = detectBestIsa();
+        return Dispatch{ isa, tableFor(isa) };
+    }();
+    return s_dispatch;
+}
+
+inline double* raw(std::complex<double>* p) { return reinterpret_cast<double*>(p); }
+inline const double* raw(const std::complex<double>* p) { return reinterpret_cast<const double*>(p); }
+inline float* raw(std::complex<float>* p) { return reinterpret_cast<float*>(p); }
+inline const float* raw(const std::complex<float>* p) { return reinterpret_cast<const float*>(p); }
+
+}  // namespace
+
+bool isSupported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef QMSIM_KERNELS_X86
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f") && isSupported(Isa::AVX2);
+#endif
+#ifdef QMSIM_KERNELS_NEON
+        case Isa::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+Isa activeIsa() {
+    return dispatch().isa;
+}
+
+bool setIsa(Isa isa) {
+    if (!isSupported(isa)) {
+        return false;
+    }
+    dispatch() = Dispatch{ isa, tableFor(isa) };
+    return true;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "Scalar";
+        case Isa::AVX2:   return "AVX2";
+        case Isa::AVX512: return "AVX-512";
+        case Isa::NEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+void multiply(std::complex<double>* psi, const std::complex<double>* table, size_t count) {
+    dispatch().table->f64.multiply(raw(psi), raw(table), count);
+}
+
+void multiplySquared(std::complex<double>* psi, const std::complex<double>* table, size_t count) {
+    dispatch().table->f64.multiplySquared(raw(psi), raw(table), count);
+}
+
+void scale(std::complex<double>* psi, double factor, size_t count) {
+    dispatch().table->f64.scale(raw(psi), factor, count);
+}
+
+void normToFloat(const std::complex<double>* psi, float* out, size_t count) {
+    dispatch().table->f64.normToFloat(raw(psi), out, count);
+}
+
+double sumNorm(const std::complex<double>* psi, size_t count) {
+    return dispatch().table->f64.sumNorm(raw(psi), count);
+}
+
+void multiply(std::complex<float>* psi, const std::complex<float>* table, size_t count) {
+    dispatch().table->f32.multiply(raw(psi), raw(table), count);
+}
+
+void multiplySquared(std::complex<float>* psi, const std::complex<float>* table, size_t count) {
+    dispatch().table->f32.multiplySquared(raw(psi), raw(table), count);
+}
+
+void scale(std::complex<float>* psi, float factor, size_t count) {
+    dispatch().table->f32.scale(raw(psi), factor, count);
+}
+
+void normToFloat(const std::complex<float>* psi, float* out, size_t count) {
+    dispatch().table->f32.normToFloat(raw(psi), out, count);
+}
+
+double sumNorm(const std::complex<float>* psi, size_t count) {
+    return dispatch().table->f32.sumNorm(raw(psi), count);
+}
+
+}  // namespace kernels
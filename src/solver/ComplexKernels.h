@@ -0,0 +1,119 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+
+/**
+ * @namespace kernels
+ * @brief Vectorized pointwise kernels for the split-step operators
+ *
+ * These kernels work directly on interleaved std::complex<double> or
+ * std::complex<float> buffers (such as Wavefunction::data() and the engine's
+ * phase tables). They use
+ * explicit real/imaginary arithmetic instead of std::complex operator*,
+ * whose NaN/Inf recovery path prevents auto-vectorization, and dispatch at
+ * runtime to AVX2, AVX-512 or NEON implementations when available.
+ *
+ * The kernels are single-threaded; callers split large buffers into
+ * blocks and run the blocks in parallel.
+ */
+namespace kernels {
+
+/**
+ * @enum Isa
+ * @brief Instruction set used by the kernel implementations
+ */
+enum class Isa {
+    Scalar,
+    AVX2,
+    AVX512,
+    NEON
+};
+
+/**
+ * @brief Get the instruction set currently used by the kernels
+ * @return The active instruction set (the best supported one by default)
+ */
+Isa activeIsa();
+
+/**
+ * @brief Check whether an instruction set is supported on this machine
+ * @param isa The instruction set to check
+ * @return True if kernels for isa were compiled in and the CPU supports them
+ */
+bool isSupported(Isa isa);
+
+/**
+ * @brief Select the instruction set used by the kernels
+ *
+ * Mainly useful for testing and benchmarking individual code paths.
+ *
+ * @param isa The instruction set to use
+ * @return True if isa is supported and now active, false otherwise
+ */
+bool setIsa(Isa isa);
+
+/**
+ * @brief Get a human-readable name for an instruction set
+ * @param isa The instruction set
+ * @return Name such as "AVX2"
+ */
+const char* isaName(Isa isa);
+
+/**
+ * @brief Multiply a buffer in place by a table: psi[n] *= table[n]
+ * @param psi Complex buffer to modify
+ * @param table Complex factors, one per element
+ * @param count Number of complex elements
+ */
+void multiply(std::complex<double>* psi, const std::complex<double>* table, size_t count);
+
+/**
+ * @brief Multiply a buffer in place by a squared table: psi[n] *= table[n]^2
+ *
+ * Used to apply a full exp(-i*V*dt) step from the cached half-step table.
+ *
+ * @param psi Complex buffer to modify
+ * @param table Complex factors, one per element
+ * @param count Number of complex elements
+ */
+void multiplySquared(std::complex<double>* psi, const std::complex<double>* table, size_t count);
+
+/**
+ * @brief Scale a buffer in place by a real factor: psi[n] *= factor
+ * @param psi Complex buffer to modify
+ * @param factor Real scale factor
+ * @param count Number of complex elements
+ */
+void scale(std::complex<double>* psi, double factor, size_t count);
+
+/**
+ * @brief Write |psi|^2 of each element as float: out[n] = |psi[n]|^2
+ * @param psi Complex input buffer
+ * @param out Output buffer with room for count floats
+ * @param count Number of complex elements
+ */
+void normToFloat(const std::complex<double>* psi, float* out, size_t count);
+
+/**
+ * @brief Sum |psi|^2 over a buffer
+ * @param psi Complex input buffer
+ * @param count Number of complex elements
+ * @return Sum of the squared magnitudes
+ */
+double sumNorm(const std::complex<double>* psi, size_t count);
+
+/**
+ * @name Single-precision overloads
+ * Same operations on std::complex<float> buffers, with twice as many values
+ * per vector register. sumNorm still accumulates in double.
+ */
+///@{
+void multiply(std::complex<float>* psi, const std::complex<float>* table, size_t count);
+void multiplySquared(std::complex<float>* psi, const std::complex<float>* table, size_t count);
+void scale(std::complex<float>* psi, float factor, size_t count);
+void normToFloat(const std::complex<float>* psi, float* out, size_t count);
+double sumNorm(const std::complex<float>* psi, size_t count);
+///@}
+
+}  // namespace kernels
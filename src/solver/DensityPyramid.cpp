@@ -0,0 +1,156 @@
+#include "DensityPyramid.h"
+#include "SolverDetail.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// First level-0 point covered by output sample i of n over a region [origin, origin + size)
+inline int spanBegin(int origin, int size, int i, int n) {
+    return origin + static_cast<int>(static_cast<int64_t>(i) * size / n);
+}
+
+}  // namespace
+
+// Create an empty pyramid
+DensityPyramid::DensityPyramid(int numThreads)
+    : m_numThreads(solver_detail::resolveThreadCount(numThreads))
+{
+}
+
+// Resolve a viewport against a grid
+DensityViewport DensityPyramid::resolve(const DensityViewport& view, int nx, int ny) {
+    DensityViewport resolved;
+    resolved.x0 = std::clamp(view.x0, 0, nx - 1);
+    resolved.y0 = std::clamp(view.y0, 0, ny - 1);
+    resolved.width = view.width > 0 ? std::min(view.width, nx - resolved.x0) : nx - resolved.x0;
+    resolved.height = view.height > 0 ? std::min(view.height, ny - resolved.y0) : ny - resolved.y0;
+    resolved.maxWidth = view.maxWidth > 0 ? view.maxWidth : resolved.width;
+    resolved.maxHeight = view.maxHeight > 0 ? view.maxHeight : resolved.height;
+    return resolved;
+}
+
+// Get the size of the data sample() produces for a viewport
+void DensityPyramid::outputSize(const DensityViewport& view, int& width, int& height) {
+    width = std::min(view.width, view.maxWidth);
+    height = std::min(view.height, view.maxHeight);
+}
+
+// Check whether a viewport is the whole grid at full resolution
+bool DensityPyramid::isFullResolution(const DensityViewport& view, int nx, int ny) {
+    return view.x0 == 0 && view.y0 == 0 && view.width == nx && view.height == ny &&
+           view.maxWidth >= nx && view.maxHeight >= ny;
+}
+
+// Point-sample a complex field over a viewport
+void DensityPyramid::sampleField(const float* field, int nx, int ny, const DensityViewport& view,
+                                 float* dst, int numThreads) {
+    (void)ny;
+    int width = 0;
+    int height = 0;
+    outputSize(view, width, height);
+    const int threads = solver_detail::resolveThreadCount(numThreads);
+
+    #pragma omp parallel for num_threads(threads)
+    for (int v = 0; v < height; ++v) {
+        // Centre of the rows covered by output row v
+        const int j = (spanBegin(view.y0, view.height, v, height) +
+                       spanBegin(view.y0, view.height, v + 1, height) - 1) / 2;
+        const float* row = field + 2 * static_cast<size_t>(j) * nx;
+        float* out = dst + 2 * static_cast<size_t>(v) * width;
+        for (int u = 0; u < width; ++u) {
+            const int i = (spanBegin(view.x0, view.width, u, width) +
+                           spanBegin(view.x0, view.width, u + 1, width) - 1) / 2;
+            out[2 * u] = row[2 * i];
+            out[2 * u + 1] = row[2 * i + 1];
+        }
+    }
+}
+
+// Size level 0 for a grid and return its storage
+float* DensityPyramid::resize(int nx, int ny) {
+    if (m_levels.empty() || m_levels[0].width != nx || m_levels[0].height != ny) {
+        // The old levels go back to the pool before the new ones are taken
+        GridPool::FirstTouchScope firstTouch(m_numThreads);
+        m_levels.clear();
+        int width = nx;
+        int height = ny;
+        for (;;) {
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.data.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+            m_levels.push_back(std::move(level));
+            if (width == 1 && height == 1) {
+                break;
+            }
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+    return m_levels[0].data.data();
+}
+
+// Build the coarser levels from level 0
+void DensityPyramid::build() {
+    for (size_t l = 1; l < m_levels.size(); ++l) {
+        const Level& fine = m_levels[l - 1];
+        Level& coarse = m_levels[l];
+        const float* src = fine.data.data();
+        float* dst = coarse.data.data();
+        const int fineWidth = fine.width;
+        const int fineHeight = fine.height;
+        const int width = coarse.width;
+        const int height = coarse.height;
+
+        // Each coarse point is the maximum of its 2x2 block; odd edges repeat the last row/column
+        #pragma omp parallel for num_threads(m_numThreads) if (static_cast<int64_t>(width) * height > 4096)
+        for (int j = 0; j < height; ++j) {
+            const float* row0 = src + static_cast<size_t>(2 * j) * fineWidth;
+            const float* row1 = src + static_cast<size_t>(std::min(2 * j + 1, fineHeight - 1)) * fineWidth;
+            float* out = dst + static_cast<size_t>(j) * width;
+            for (int i = 0; i < width; ++i) {
+                const int i0 = 2 * i;
+                const int i1 = std::min(2 * i + 1, fineWidth - 1);
+                out[i] = std::max(std::max(row0[i0], row0[i1]), std::max(row1[i0], row1[i1]));
+            }
+        }
+    }
+}
+
+// Max-pool a viewport to display resolution
+void DensityPyramid::sample(const DensityViewport& view, float* dst) const {
+    int width = 0;
+    int height = 0;
+    outputSize(view, width, height);
+
+    // Coarsest level that still has at least one point per output sample
+    int level = 0;
+    while (level + 1 < getLevelCount() &&
+           (view.width >> (level + 1)) >= width && (view.height >> (level + 1)) >= height) {
+        ++level;
+    }
+    const Level& source = m_levels[level];
+    const float* src = source.data.data();
+    const int shift = level;
+
+    #pragma omp parallel for num_threads(m_numThreads) if (static_cast<int64_t>(width) * height > 4096)
+    for (int v = 0; v < height; ++v) {
+        // Level cells covering the level-0 rows of output row v
+        const int jBegin = spanBegin(view.y0, view.height, v, height) >> shift;
+        const int jEnd = (spanBegin(view.y0, view.height, v + 1, height) - 1) >> shift;
+        float* out = dst + static_cast<size_t>(v) * width;
+        for (int u = 0; u < width; ++u) {
+            const int iBegin = spanBegin(view.x0, view.width, u, width) >> shift;
+            const int iEnd = (spanBegin(view.x0, view.width, u + 1, width) - 1) >> shift;
+            float value = 0.0f;
+            for (int j = jBegin; j <= jEnd; ++j) {
+                const float* row = src + static_cast<size_t>(j) * source.width;
+                for (int i = iBegin; i <= iEnd; ++i) {
+                    value = std::max(value, row[i]);
+                }
+            }
+            out[u] = value;
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include "../core/GridPool.h"
+
+/**
+ * @struct DensityViewport
+ * @brief Region of the grid to display and the largest resolution to display it at
+ *
+ * Zero sizes mean "the rest of the grid" for the region and "unlimited" for
+ * the output, so a default viewport is the whole grid at full resolution.
+ */
+struct DensityViewport {
+    int x0 = 0;         ///< First grid column of the region
+    int y0 = 0;         ///< First grid row of the region
+    int width = 0;      ///< Region width in grid points (0 = to the end of the grid)
+    int height = 0;     ///< Region height in grid points (0 = to the end of the grid)
+    int maxWidth = 0;   ///< Largest output width in samples (0 = unlimited)
+    int maxHeight = 0;  ///< Largest output height in samples (0 = unlimited)
+};
+
+/**
+ * @class DensityPyramid
+ * @brief Multi-resolution, max-pooled copy of a probability density
+ *
+ * Level 0 is the full-resolution density; every further level halves both
+ * axes (rounding up) by taking the maximum of 2x2 blocks, down to 1x1.
+ * Max pooling keeps narrow peaks visible at any zoom, where averaging or
+ * decimation would wash them out.
+ *
+ * sample() reads a viewport at display resolution from the coarsest level
+ * that still has enough points, so its cost depends on the output size
+ * rather than on the grid size. Viewports small enough to fit the output
+ * are returned at full resolution.
+ */
+class DensityPyramid {
+public:
+    /**
+     * @brief Create an empty pyramid
+     * @param numThreads Threads used to build and sample (0 = OpenMP default)
+     */
+    explicit DensityPyramid(int numThreads = 0);
+
+    /**
+     * @brief Resolve a viewport against a grid
+     *
+     * Fills in zero sizes and clamps the region to the grid.
+     *
+     * @param view Requested viewport
+     * @param nx Grid points in x direction
+     * @param ny Grid points in y direction
+     * @return Viewport with a non-empty region inside the grid and positive output limits
+     */
+    static DensityViewport resolve(const DensityViewport& view, int nx, int ny);
+
+    /**
+     * @brief Get the size of the data sample() produces for a viewport
+     * @param view Resolved viewport
+     * @param width Set to the output width (region width, capped at maxWidth)
+     * @param height Set to the output height (region height, capped at maxHeight)
+     */
+    static void outputSize(const DensityViewport& view, int& width, int& height);
+
+    /**
+     * @brief Check whether a viewport is the whole grid at full resolution
+     * @param view Resolved viewport
+     * @param nx Grid points in x direction
+     * @param ny Grid points in y direction
+     * @return True if sampling would just copy level 0
+     */
+    static bool isFullResolution(const DensityViewport& view, int nx, int ny);
+
+    /**
+     * @brief Point-sample a complex field (re, im pairs) over a viewport
+     *
+     * Phases cannot be pooled, so each output sample takes the grid point
+     * at the centre of the cells it covers.
+     *
+     * @param field Full-resolution field, 2 * nx * ny floats
+     * @param nx Grid points in x direction
+     * @param ny Grid points in y direction
+     * @param view Resolved viewport
+     * @param dst Destination for 2 * width * height floats, see outputSize()
+     * @param numThreads Threads to use (0 = OpenMP default)
+     */
+    static void sampleField(const float* field, int nx, int ny, const DensityViewport& view,
+                            float* dst, int numThreads = 0);
+
+    /**
+     * @brief Size level 0 for a grid and return its storage
+     *
+     * The caller fills the returned nx * ny floats with |ψ|² and then calls
+     * build(). Storage is reused while the grid size stays the same.
+     *
+     * @param nx Grid points in x direction
+     * @param ny Grid points in y direction
+     * @return Level 0 storage in row-major order (x fastest)
+     */
+    float* resize(int nx, int ny);
+
+    /**
+     * @brief Build the coarser levels from level 0
+     */
+    void build();
+
+    /**
+     * @brief Max-pool a viewport to display resolution
+     * @param view Resolved viewport
+     * @param dst Destination for width * height floats, see outputSize()
+     */
+    void sample(const DensityViewport& view, float* dst) const;
+
+    /**
+     * @brief Get the number of levels (0 before the first resize())
+     * @return Level count
+     */
+    int getLevelCount() const { return static_cast<int>(m_levels.size()); }
+
+    /**
+     * @brief Get the width of a level
+     * @param level Level index
+     * @return Points in x direction
+     */
+    int getLevelWidth(int level) const { return m_levels[level].width; }
+
+    /**
+     * @brief Get the height of a level
+     * @param level Level index
+     * @return Points in y direction
+     */
+    int getLevelHeight(int level) const { return m_levels[level].height; }
+
+    /**
+     * @brief Get the data of a level
+     * @param level Level index
+     * @return Row-major values (x fastest)
+     */
+    const float* getLevel(int level) const { return m_levels[level].data.data(); }
+
+private:
+    struct Level {
+        int width = 0;
+        int height = 0;
+        GridVector<float> data;
+    };
+
+    int m_numThreads;             ///< Threads used to build and sample
+    std::vector<Level> m_levels;  ///< Level 0 is full resolution
+};
@@ -0,0 +1,739 @@
+#include "DistributedSimulationEngine.h"
+#include "ComplexKernels.h"
+#include "FFTWWisdom.h"
+#include "SolverDetail.h"
+#include <fftw3-mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include "../core/DebugUtils.h"
+#include "../core/Metrics.h"
+#include "../core/Trace.h"
+
+using solver_detail::findStage;
+using solver_detail::forEachBlock;
+using solver_detail::kKernelBlock;
+
+// Create the engine on every rank
+DistributedSimulationEngine::DistributedSimulationEngine(const PhysicsConfig& config, MPI_Comm comm)
+    : m_nx(config.nx),
+      m_ny(config.ny),
+      m_lx(config.lx),
+      m_ly(config.ly),
+      m_dt(config.dt),
+      m_numThreads(solver_detail::resolveThreadCount(config.numThreads)),
+      m_plannerFlags(FFTWWisdom::plannerFlags(config.fftw.planner)),
+      m_wavepacket(config.wavepacket),
+      m_potentialConfig(config.potential),
+      m_absorber(config.absorber),
+      m_scheme(&SplittingScheme::fromName(config.integration.scheme)),
+      m_regions(config.output.regions)
+{
+    if (config.precision != "double") {
+        throw std::invalid_argument("The distributed engine supports only double precision");
+    }
+    if (!(m_lx > 0.0) || !(m_ly > 0.0)) {
+        throw std::invalid_argument("Domain lengths must be positive");
+    }
+    MPI_Comm_dup(comm, &m_comm);
+    MPI_Comm_rank(m_comm, &m_rank);
+    MPI_Comm_size(m_comm, &m_rankCount);
+    m_potential = Potential::create(config.potential, m_lx, m_ly);
+
+    // Plan first, since measuring planners overwrite the slab
+    initializeFFTWPlans();
+    rebuildTables();
+    initializeWavefunction();
+}
+
+// Destroy the FFTW plans and the duplicated communicator
+DistributedSimulationEngine::~DistributedSimulationEngine() {
+    cleanupFFTWPlans();
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized) {
+        MPI_Comm_free(&m_comm);
+    }
+}
+
+// Compute the slab layout and create the distributed plans
+void DistributedSimulationEngine::initializeFFTWPlans() {
+    TRACE_SCOPE("FFTW planning", "solver");
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+
+    // FFTW's thread support must be initialized before its MPI support
+    solver_detail::preparePlannerThreads<double>(m_numThreads);
+    static const bool mpiReady = (fftw_mpi_init(), true);
+    (void)mpiReady;
+
+    // Storage is row-major with x fastest, so y is FFTW's slow (first) dimension
+    const std::ptrdiff_t allocation = fftw_mpi_local_size_2d_transposed(
+        m_ny, m_nx, m_comm, &m_localRows, &m_firstRow, &m_localColumns, &m_firstColumn);
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    resizeGrid(m_psi, static_cast<size_t>(std::max<std::ptrdiff_t>(allocation, 1)));
+    std::fill(m_psi.begin(), m_psi.end(), Complex(0, 0));
+
+    fftw_complex* data = reinterpret_cast<fftw_complex*>(m_psi.data());
+    m_forwardPlan = fftw_mpi_plan_dft_2d(m_ny, m_nx, data, data, m_comm, FFTW_FORWARD,
+                                         m_plannerFlags | FFTW_MPI_TRANSPOSED_OUT);
+    m_backwardPlan = fftw_mpi_plan_dft_2d(m_ny, m_nx, data, data, m_comm, FFTW_BACKWARD,
+                                          m_plannerFlags | FFTW_MPI_TRANSPOSED_IN);
+
+    // The observables transform a copy of ψ; planning it here keeps it on
+    // this engine's thread count and out of the first timed sample
+    resizeGrid(m_observableScratch, m_psi.size());
+    fftw_complex* scratch = reinterpret_cast<fftw_complex*>(m_observableScratch.data());
+    m_observablePlan = fftw_mpi_plan_dft_2d(m_ny, m_nx, scratch, scratch, m_comm, FFTW_FORWARD,
+                                            m_plannerFlags | FFTW_MPI_TRANSPOSED_OUT);
+    if (!m_forwardPlan || !m_backwardPlan || !m_observablePlan) {
+        ERROR_LOG("DistributedSimulationEngine", "Failed to create FFTW-MPI plans");
+        throw std::runtime_error("Failed to create FFTW-MPI plans");
+    }
+
+    // Every rank learns the row slab of every other for the gathers
+    const int rows[2] = {static_cast<int>(m_localRows), static_cast<int>(m_firstRow)};
+    std::vector<int> layout(2 * static_cast<size_t>(m_rankCount));
+    MPI_Allgather(rows, 2, MPI_INT, layout.data(), 2, MPI_INT, m_comm);
+    m_rowCounts.resize(static_cast<size_t>(m_rankCount));
+    m_rowStarts.resize(static_cast<size_t>(m_rankCount));
+    for (int r = 0; r < m_rankCount; ++r) {
+        m_rowCounts[r] = layout[2 * r];
+        m_rowStarts[r] = layout[2 * r + 1];
+    }
+    DEBUG_LOG("DistributedSimulationEngine", "Rank " + std::to_string(m_rank) + " owns rows " +
+              std::to_string(m_firstRow) + "-" + std::to_string(m_firstRow + m_localRows) + " of " +
+              std::to_string(m_ny));
+}
+
+// Destroy the FFT plans
+void DistributedSimulationEngine::cleanupFFTWPlans() {
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+    for (fftw_plan* plan : {&m_forwardPlan, &m_backwardPlan, &m_observablePlan}) {
+        if (*plan) {
+            fftw_destroy_plan(*plan);
+            *plan = nullptr;
+        }
+    }
+    m_observableScratch.clear();
+    m_observableScratch.shrink_to_fit();
+}
+
+// Fill the local rows with the Gaussian wavepacket
+void DistributedSimulationEngine::initializeWavefunction() {
+    const Wavepacket& w = m_wavepacket;
+    const double dx = m_lx / m_nx;
+    const double dy = m_ly / m_ny;
+    const int rows = static_cast<int>(m_localRows);
+
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int r = 0; r < rows; ++r) {
+        const double y = -m_ly/2 + (m_firstRow + r) * dy;
+        Complex* row = m_psi.data() + static_cast<size_t>(r) * m_nx;
+        for (int i = 0; i < m_nx; ++i) {
+            const double x = -m_lx/2 + i * dx;
+            const double r2 = (x - w.x0) * (x - w.x0) / (w.sigmaX * w.sigmaX) +
+                              (y - w.y0) * (y - w.y0) / (w.sigmaY * w.sigmaY);
+            row[i] = std::polar(std::exp(-r2 / 2), w.kx * x + w.ky * y);
+        }
+    }
+
+    // Normalize with the norm of the whole grid
+    const double norm = getTotalProbability();
+    const double factor = norm > 0.0 ? 1.0 / std::sqrt(norm) : 1.0;
+    const std::ptrdiff_t size = m_localRows * m_nx;
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (std::ptrdiff_t n = 0; n < size; ++n) {
+        m_psi[n] *= factor;
+    }
+
+    m_currentTime = 0.0;
+    m_initialNorm = getTotalProbability();
+}
+
+// Tabulate the operator tables of the local slabs
+void DistributedSimulationEngine::rebuildTables(bool resamplePotential) {
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    const size_t localSize = static_cast<size_t>(m_localRows) * m_nx;
+    solver_detail::buildAbsorberMask(m_absorber, m_nx, m_ny, m_lx, m_ly, m_dt, m_numThreads, m_absorberMask,
+                                     static_cast<int>(m_firstRow), static_cast<int>(m_localRows));
+
+    // Wave numbers in FFT order [0, 1, ..., N/2, -N/2+1, ..., -1]
+    auto waveNumbers = [](int n, double length) {
+        std::vector<double> k(static_cast<size_t>(n));
+        for (int i = 0; i < n; ++i) {
+            k[i] = 2.0 * M_PI * (i <= n / 2 ? i : i - n) / length;
+        }
+        return k;
+    };
+    m_kx = waveNumbers(m_nx, m_lx);
+    m_ky = waveNumbers(m_ny, m_ly);
+
+    // exp(-i*b*K*dt) with the 1/(nx*ny) of the FFT round trip folded in, in
+    // the transposed k-space layout: column i of the slab holds all ky
+    const double normFactor = 1.0 / (static_cast<double>(m_nx) * m_ny);
+    const int columns = static_cast<int>(m_localColumns);
+    m_kineticStages.clear();
+    solver_detail::buildStageTables(m_kineticStages, m_scheme->b, [&](double weight) {
+        GridVector<Complex> phase(static_cast<size_t>(m_localColumns) * m_ny);
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (int c = 0; c < columns; ++c) {
+            const double kx = m_kx[m_firstColumn + c];
+            Complex* column = phase.data() + static_cast<size_t>(c) * m_ny;
+            for (int j = 0; j < m_ny; ++j) {
+                const double k = (kx * kx + m_ky[j] * m_ky[j]) / 2.0;
+                column[j] = std::polar(normFactor, -weight * m_dt * k);
+            }
+        }
+        return phase;
+    });
+
+    // A static potential gets one table per stage weight, including the
+    // merged last-and-first stage of consecutive steps
+    if (resamplePotential || m_potentialValues.size() != localSize) {
+        m_potentialValues.assign(localSize, 0.0);
+        m_potentialTime = std::numeric_limits<double>::quiet_NaN();
+    }
+    m_potentialStages.clear();
+    samplePotential(m_currentTime);
+    if (m_potential->isTimeDependent()) {
+        return;
+    }
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const double* values = m_potentialValues.data();
+    const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(localSize);
+    solver_detail::buildStageTables(m_potentialStages, solver_detail::potentialStageWeights(*m_scheme),
+                                    [&](double weight) {
+        GridVector<Complex> phase(localSize);
+        Complex* table = phase.data();
+
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < count; ++n) {
+            const double damping = mask ? std::pow(mask[n], 2.0 * weight) : 1.0;
+            table[n] = std::polar(damping, -weight * m_dt * values[n]);
+        }
+        return phase;
+    });
+}
+
+// Sample the potential on the local rows
+void DistributedSimulationEngine::samplePotential(double time) {
+    if (time == m_potentialTime || (!m_potential->isTimeDependent() && !std::isnan(m_potentialTime))) {
+        return;
+    }
+    TRACE_SCOPE("V(t)", "solver");
+    m_potential->setTime(time);
+
+    GridGeometry grid;
+    grid.nx = m_nx;
+    grid.ny = m_ny;
+    grid.x0 = -m_lx/2;
+    grid.y0 = -m_ly/2;
+    grid.dx = m_lx / m_nx;
+    grid.dy = m_ly / m_ny;
+    const int rows = static_cast<int>(m_localRows);
+
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int r = 0; r < rows; ++r) {
+        m_potential->sampleRow(grid, static_cast<int>(m_firstRow) + r,
+                               m_potentialValues.data() + static_cast<size_t>(r) * m_nx);
+    }
+    m_potentialTime = time;
+}
+
+// Apply one potential stage to the local rows
+void DistributedSimulationEngine::applyPotentialStage(double weight, double time) {
+    TRACE_SCOPE("V stage", "solver");
+    Complex* psi = m_psi.data();
+    const std::ptrdiff_t size = m_localRows * m_nx;
+    METRICS_SCOPE(MetricStage::Potential, 3 * static_cast<size_t>(size) * sizeof(Complex));
+    if (const Complex* phase = findStage(m_potentialStages, weight)) {
+        forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+            kernels::multiply(psi + begin, phase + begin, count);
+        });
+        return;
+    }
+
+    // Time-dependent potentials go from the values of V(t), applied in the
+    // same pass that forms the phase
+    samplePotential(time);
+    const double* values = m_potentialValues.data();
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const double scale = -weight * m_dt;
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        for (size_t n = static_cast<size_t>(begin); n < static_cast<size_t>(begin) + count; ++n) {
+            const double damping = mask ? std::pow(mask[n], 2.0 * weight) : 1.0;
+            psi[n] *= std::polar(damping, scale * values[n]);
+        }
+    });
+}
+
+// Apply one kinetic stage through the distributed FFT pair
+void DistributedSimulationEngine::applyKineticStage(double weight) {
+    const Complex* phase = findStage(m_kineticStages, weight);
+    if (!phase) {
+        throw std::logic_error("No kinetic table for the integrator weight");
+    }
+    TRACE_SCOPE("K", "solver");
+    const size_t bytes = static_cast<size_t>(m_localRows * m_nx) * sizeof(Complex);
+    {
+        TRACE_SCOPE("FFT forward", "fft");
+        METRICS_SCOPE(MetricStage::FFTForward, 2 * bytes);
+        fftw_execute(m_forwardPlan);
+    }
+
+    // k-space is transposed: localColumns x ny values
+    Complex* psi = m_psi.data();
+    {
+        METRICS_SCOPE(MetricStage::Kinetic, 3 * static_cast<size_t>(m_localColumns * m_ny) * sizeof(Complex));
+        forEachBlock(m_localColumns * m_ny, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+            kernels::multiply(psi + begin, phase + begin, count);
+        });
+    }
+
+    TRACE_SCOPE("FFT backward", "fft");
+    METRICS_SCOPE(MetricStage::FFTBackward, 2 * bytes);
+    fftw_execute(m_backwardPlan);
+}
+
+// Advance by one step
+void DistributedSimulationEngine::step() {
+    advance(1);
+}
+
+// Advance with fused potential stages
+void DistributedSimulationEngine::advance(int nSteps) {
+    TRACE_SCOPE("Distributed advance", "solver");
+    if (nSteps <= 0) {
+        return;
+    }
+    const SplittingScheme& scheme = *m_scheme;
+    const size_t stages = scheme.b.size();
+
+    applyPotentialStage(scheme.a.front(), m_currentTime);
+    for (int s = 0; s < nSteps; ++s) {
+        for (size_t j = 0; j < stages; ++j) {
+            applyKineticStage(scheme.b[j]);
+            if (j + 1 < stages) {
+                applyPotentialStage(scheme.a[j + 1], m_currentTime + scheme.stageTime(j + 1) * m_dt);
+            }
+        }
+        const double last = scheme.a.back() + (s + 1 < nSteps ? scheme.a.front() : 0.0);
+        applyPotentialStage(last, m_currentTime + m_dt);
+        m_currentTime += m_dt;
+    }
+    METRICS_STEPS(nSteps);
+
+    if (m_stepCompletionCallback) {
+        m_stepCompletionCallback();
+    }
+}
+
+// Restart from the configured wavepacket
+void DistributedSimulationEngine::reset() {
+    DEBUG_LOG("DistributedSimulationEngine", "Resetting simulation");
+    initializeWavefunction();
+    samplePotential(m_currentTime);
+}
+
+// Update the configuration
+void DistributedSimulationEngine::updateConfig(const PhysicsConfig& config, bool keepState) {
+    const unsigned plannerFlags = FFTWWisdom::plannerFlags(config.fftw.planner);
+    const SplittingScheme& scheme = SplittingScheme::fromName(config.integration.scheme);
+    if (!(config.lx > 0.0) || !(config.ly > 0.0)) {
+        throw std::invalid_argument("Domain lengths must be positive");
+    }
+    const bool gridChanged = config.nx != m_nx || config.ny != m_ny;
+    const bool domainChanged = config.lx != m_lx || config.ly != m_ly;
+    if (keepState && domainChanged) {
+        throw std::invalid_argument("The wavefunction can only be carried over to a domain of the same size");
+    }
+    std::unique_ptr<Potential> potential;
+    if (domainChanged || config.potential != m_potentialConfig) {
+        potential = Potential::create(config.potential, config.lx, config.ly);
+    }
+    const bool potentialReplaced = potential != nullptr;
+    const bool tablesChanged = gridChanged || potentialReplaced || config.dt != m_dt ||
+                               config.absorber != m_absorber || &scheme != m_scheme;
+    const int numThreads = solver_detail::resolveThreadCount(config.numThreads);
+
+    // The slab layout and plans only depend on the grid and planner settings
+    const bool keepPlans = m_forwardPlan && m_backwardPlan && !gridChanged &&
+                           numThreads == m_numThreads && plannerFlags == m_plannerFlags;
+
+    // Planning overwrites the slab, so a state that carries over is copied
+    // out first: the local rows on the same grid, the whole ψ on rank 0 otherwise
+    const int previousNx = m_nx;
+    const int previousNy = m_ny;
+    GridVector<Complex> carried;
+    double absorbed = 0.0;
+    if (keepState && !keepPlans) {
+        absorbed = m_initialNorm - getTotalProbability();
+        if (gridChanged) {
+            const Wavefunction& psi = getWavefunction();
+            if (m_rank == 0) {
+                carried.assign(psi.begin(), psi.end());
+            }
+        } else {
+            carried.assign(m_psi.begin(), m_psi.begin() + m_localRows * m_nx);
+        }
+    }
+    if (!keepPlans) {
+        cleanupFFTWPlans();
+    }
+
+    m_nx = config.nx;
+    m_ny = config.ny;
+    m_lx = config.lx;
+    m_ly = config.ly;
+    m_dt = config.dt;
+    m_numThreads = numThreads;
+    m_plannerFlags = plannerFlags;
+    m_wavepacket = config.wavepacket;
+    m_absorber = config.absorber;
+    m_scheme = &scheme;
+    m_regions = config.output.regions;
+    m_potentialConfig = config.potential;
+    if (potential) {
+        m_potential = std::move(potential);
+    }
+
+    if (!keepPlans) {
+        initializeFFTWPlans();
+    }
+    if (!keepState) {
+        m_currentTime = 0.0;
+    }
+    if (tablesChanged) {
+        rebuildTables(gridChanged || potentialReplaced);
+    } else {
+        samplePotential(m_currentTime);
+    }
+    if (!keepState) {
+        initializeWavefunction();
+        return;
+    }
+    if (keepPlans) {
+        return;
+    }
+    if (gridChanged) {
+        GridVector<Complex> resampled;
+        if (m_rank == 0) {
+            resampled.resize(static_cast<size_t>(m_nx) * m_ny);
+            solver_detail::resampleSpectral(carried.data(), previousNx, previousNy, resampled.data(),
+                                            m_nx, m_ny, m_numThreads);
+        }
+        scatterRows(resampled.data(), m_psi.data(), MPI_DOUBLE, 2);
+    } else {
+        std::copy(carried.begin(), carried.end(), m_psi.begin());
+    }
+    m_initialNorm = getTotalProbability() + absorbed;
+}
+
+// Set a new potential
+void DistributedSimulationEngine::setPotential(std::unique_ptr<Potential> potential) {
+    DEBUG_LOG("DistributedSimulationEngine", "Setting new potential of type: " + potential->getType());
+    m_potentialConfig = PotentialConfig();
+    m_potentialConfig.type = potential->getType();
+    m_potential = std::move(potential);
+    rebuildTables();
+}
+
+// Sum values over all ranks
+void DistributedSimulationEngine::allreduceSum(double* values, int count) const {
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, m_comm);
+}
+
+// Gather the local rows on rank 0
+void DistributedSimulationEngine::gatherRows(const void* local, void* global, MPI_Datatype type,
+                                             int components) const {
+    std::vector<int> counts(static_cast<size_t>(m_rankCount));
+    std::vector<int> displacements(static_cast<size_t>(m_rankCount));
+    const int perRow = m_nx * components;
+    for (int r = 0; r < m_rankCount; ++r) {
+        counts[r] = m_rowCounts[r] * perRow;
+        displacements[r] = m_rowStarts[r] * perRow;
+    }
+    MPI_Gatherv(local, counts[m_rank], type, global, counts.data(), displacements.data(), type, 0, m_comm);
+}
+
+// Gather the wavefunction on rank 0
+const Wavefunction& DistributedSimulationEngine::getWavefunction() const {
+    if (m_rank == 0 && (m_gathered.getNx() != m_nx || m_gathered.getNy() != m_ny)) {
+        m_gathered = Wavefunction(m_nx, m_ny);
+    }
+    gatherRows(m_psi.data(), m_rank == 0 ? m_gathered.data() : nullptr, MPI_DOUBLE, 2);
+    return m_gathered;
+}
+
+// Distribute rows from rank 0
+void DistributedSimulationEngine::scatterRows(const void* global, void* local, MPI_Datatype type,
+                                              int components) const {
+    std::vector<int> counts(static_cast<size_t>(m_rankCount));
+    std::vector<int> displacements(static_cast<size_t>(m_rankCount));
+    const int perRow = m_nx * components;
+    for (int r = 0; r < m_rankCount; ++r) {
+        counts[r] = m_rowCounts[r] * perRow;
+        displacements[r] = m_rowStarts[r] * perRow;
+    }
+    MPI_Scatterv(global, counts.data(), displacements.data(), type, local, counts[m_rank], type, 0, m_comm);
+}
+
+// Get the total probability of all ranks
+double DistributedSimulationEngine::getTotalProbability() const {
+    const Complex* psi = m_psi.data();
+    const std::ptrdiff_t size = m_localRows * m_nx;
+    const std::ptrdiff_t blocks = (size + kKernelBlock - 1) / kKernelBlock;
+
+    double total = 0.0;
+    #pragma omp parallel for reduction(+:total) num_threads(m_numThreads)
+    for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+        const std::ptrdiff_t begin = b * kKernelBlock;
+        total += kernels::sumNorm(psi + begin, static_cast<size_t>(std::min(kKernelBlock, size - begin)));
+    }
+    allreduceSum(&total, 1);
+    return total * (m_lx / m_nx) * (m_ly / m_ny);
+}
+
+// Compute all observables with one reduction over the ranks
+ObservableSample DistributedSimulationEngine::computeObservables() const {
+    TRACE_SCOPE("Observables", "solver");
+    const double dx = m_lx / m_nx;
+    const double dy = m_ly / m_ny;
+    const size_t regionCount = m_regions.size();
+    const int rows = static_cast<int>(m_localRows);
+    const int columns = static_cast<int>(m_localColumns);
+
+    // ψ and V read, the scratch copy written, transformed and read back
+    METRICS_SCOPE(MetricStage::Observables, static_cast<size_t>(rows) * m_nx * (5 * sizeof(Complex) + sizeof(double)));
+
+    // Index ranges covered by each region, [i0, i1) x [j0, j1) in global indices
+    struct Range { int i0, i1, j0, j1; };
+    std::vector<Range> ranges(regionCount);
+    for (size_t r = 0; r < regionCount; ++r) {
+        const ObservableRegion& region = m_regions[r];
+        ranges[r].i0 = std::clamp(static_cast<int>(std::ceil((region.xMin + m_lx/2) / dx)), 0, m_nx);
+        ranges[r].i1 = std::clamp(static_cast<int>(std::floor((region.xMax + m_lx/2) / dx)) + 1, 0, m_nx);
+        ranges[r].j0 = std::clamp(static_cast<int>(std::ceil((region.yMin + m_ly/2) / dy)), 0, m_ny);
+        ranges[r].j1 = std::clamp(static_cast<int>(std::floor((region.yMax + m_ly/2) / dy)) + 1, 0, m_ny);
+    }
+
+    // Position space: per row Σ|ψ|², Σx|ψ|², ΣV|ψ|² and the region sums, copying ψ on the way
+    const size_t rowFields = 3 + regionCount;
+    std::vector<double> rowSums(static_cast<size_t>(rows) * rowFields, 0.0);
+    const Complex* psi = m_psi.data();
+    Complex* scratch = m_observableScratch.data();
+    const double* potential = m_potentialValues.data();
+
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int r = 0; r < rows; ++r) {
+        const int j = static_cast<int>(m_firstRow) + r;
+        const size_t offset = static_cast<size_t>(r) * m_nx;
+        double norm = 0.0, sumX = 0.0, sumV = 0.0;
+        for (int i = 0; i < m_nx; ++i) {
+            const Complex value = psi[offset + i];
+            scratch[offset + i] = value;
+            const double density = std::norm(value);
+            norm += density;
+            sumX += (-m_lx/2 + i * dx) * density;
+            sumV += potential[offset + i] * density;
+        }
+
+        double* row = rowSums.data() + static_cast<size_t>(r) * rowFields;
+        row[0] = norm;
+        row[1] = sumX;
+        row[2] = sumV;
+        for (size_t g = 0; g < regionCount; ++g) {
+            if (j < ranges[g].j0 || j >= ranges[g].j1) {
+                continue;
+            }
+            double inside = 0.0;
+            for (int i = ranges[g].i0; i < ranges[g].i1; ++i) {
+                inside += std::norm(psi[offset + i]);
+            }
+            row[3 + g] = inside;
+        }
+    }
+
+    // Momentum space, transposed: per kx column Σ|ψ̃|², Σky|ψ̃|² and Σ(k²/2)|ψ̃|²
+    fftw_execute(m_observablePlan);
+
+    std::vector<double> columnSums(static_cast<size_t>(columns) * 3, 0.0);
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int c = 0; c < columns; ++c) {
+        const size_t offset = static_cast<size_t>(c) * m_ny;
+        const double kx2 = m_kx[m_firstColumn + c] * m_kx[m_firstColumn + c];
+        double norm = 0.0, sumKy = 0.0, sumK = 0.0;
+        for (int j = 0; j < m_ny; ++j) {
+            const double density = std::norm(scratch[offset + j]);
+            norm += density;
+            sumKy += m_ky[j] * density;
+            sumK += (kx2 + m_ky[j] * m_ky[j]) / 2.0 * density;
+        }
+        columnSums[static_cast<size_t>(c) * 3 + 0] = norm;
+        columnSums[static_cast<size_t>(c) * 3 + 1] = sumKy;
+        columnSums[static_cast<size_t>(c) * 3 + 2] = sumK;
+    }
+
+    // Combine the local partials in a fixed order, then over the ranks:
+    // norm, Σx, Σy, ΣV, |ψ̃|², Σkx, Σky, ΣK, then the regions
+    std::vector<double> totals(8 + regionCount, 0.0);
+    for (int r = 0; r < rows; ++r) {
+        const double* row = rowSums.data() + static_cast<size_t>(r) * rowFields;
+        totals[0] += row[0];
+        totals[1] += row[1];
+        totals[2] += (-m_ly/2 + (m_firstRow + r) * dy) * row[0];
+        totals[3] += row[2];
+        for (size_t g = 0; g < regionCount; ++g) {
+            totals[8 + g] += row[3 + g];
+        }
+    }
+    for (int c = 0; c < columns; ++c) {
+        const double* column = columnSums.data() + static_cast<size_t>(c) * 3;
+        totals[4] += column[0];
+        totals[5] += m_kx[m_firstColumn + c] * column[0];
+        totals[6] += column[1];
+        totals[7] += column[2];
+    }
+    allreduceSum(totals.data(), static_cast<int>(totals.size()));
+
+    ObservableSample sample;
+    sample.time = m_currentTime;
+    sample.totalProbability = totals[0] * dx * dy;
+    sample.absorbedProbability = m_initialNorm - sample.totalProbability;
+    if (totals[0] > 0.0) {
+        sample.x = totals[1] / totals[0];
+        sample.y = totals[2] / totals[0];
+        sample.potentialEnergy = totals[3] / totals[0];
+    }
+    if (totals[4] > 0.0) {
+        sample.px = totals[5] / totals[4];
+        sample.py = totals[6] / totals[4];
+        sample.kineticEnergy = totals[7] / totals[4];
+    }
+    sample.energy = sample.kineticEnergy + sample.potentialEnergy;
+    sample.regions.resize(regionCount);
+    for (size_t g = 0; g < regionCount; ++g) {
+        sample.regions[g] = totals[8 + g] * dx * dy;
+    }
+    return sample;
+}
+
+// Gather the probability density on rank 0
+std::vector<float> DistributedSimulationEngine::getProbabilityDensity() const {
+    std::vector<float> density(m_rank == 0 ? static_cast<size_t>(m_nx) * m_ny : 0);
+    writeProbabilityDensity(density.data());
+    return density;
+}
+
+// Gather the probability density into a buffer on rank 0
+void DistributedSimulationEngine::writeProbabilityDensity(float* dst) const {
+    std::vector<float> local(static_cast<size_t>(m_localRows) * m_nx);
+    const Complex* psi = m_psi.data();
+    float* out = local.data();
+    forEachBlock(static_cast<std::ptrdiff_t>(local.size()), m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        kernels::normToFloat(psi + begin, out + begin, count);
+    });
+    gatherRows(local.data(), m_rank == 0 ? dst : nullptr, MPI_FLOAT, 1);
+}
+
+// Gather single precision real/imaginary pairs on rank 0
+void DistributedSimulationEngine::writeWavefunctionField(float* dst) const {
+    std::vector<float> local(2 * static_cast<size_t>(m_localRows) * m_nx);
+    const double* psi = reinterpret_cast<const double*>(m_psi.data());
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(local.size());
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (std::ptrdiff_t n = 0; n < size; ++n) {
+        local[n] = static_cast<float>(psi[n]);
+    }
+    gatherRows(local.data(), m_rank == 0 ? dst : nullptr, MPI_FLOAT, 2);
+}
+
+// Set step completion callback
+void DistributedSimulationEngine::setStepCompletionCallback(StepCompletionCallback callback) {
+    m_stepCompletionCallback = std::move(callback);
+}
+
+// Gather the state on rank 0
+CheckpointState DistributedSimulationEngine::captureCheckpoint() const {
+    CheckpointState state;
+    state.nx = m_nx;
+    state.ny = m_ny;
+    state.lx = m_lx;
+    state.ly = m_ly;
+    state.dt = m_dt;
+    state.time = m_currentTime;
+    state.precision = "double";
+    state.potential = m_potentialConfig;
+    state.absorbed = m_initialNorm - getTotalProbability();
+    if (m_rank == 0) {
+        state.psi.resize(static_cast<size_t>(m_nx) * m_ny);
+    }
+    gatherRows(m_psi.data(), m_rank == 0 ? state.psi.data() : nullptr, MPI_DOUBLE, 2);
+    return state;
+}
+
+// Adopt the scalar fields of a checkpoint and this rank's rows
+void DistributedSimulationEngine::restoreLocal(const CheckpointState& state, const Complex* rows) {
+    if (state.nx != m_nx || state.ny != m_ny) {
+        throw std::invalid_argument("Checkpoint grid " + std::to_string(state.nx) + "x" +
+                                    std::to_string(state.ny) + " does not match the engine grid " +
+                                    std::to_string(m_nx) + "x" + std::to_string(m_ny));
+    }
+    if (std::abs(state.lx - m_lx) > 1e-12 || std::abs(state.ly - m_ly) > 1e-12) {
+        throw std::invalid_argument("Checkpoint domain does not match the engine domain");
+    }
+    DEBUG_LOG("DistributedSimulationEngine", "Restoring checkpoint at t=" + std::to_string(state.time));
+
+    m_dt = state.dt;
+    m_potentialConfig = state.potential;
+    m_potential = Potential::create(state.potential, m_lx, m_ly);
+    m_currentTime = state.time;
+    rebuildTables();
+
+    std::copy(rows, rows + m_localRows * m_nx, m_psi.begin());
+    m_initialNorm = getTotalProbability() + state.absorbed;
+}
+
+// Continue from a full saved state
+void DistributedSimulationEngine::restoreCheckpoint(const CheckpointState& state) {
+    if (state.psi.size() != static_cast<size_t>(state.nx) * static_cast<size_t>(state.ny)) {
+        throw std::invalid_argument("Checkpoint wavefunction does not match its grid");
+    }
+    const size_t offset = static_cast<size_t>(std::max<std::ptrdiff_t>(0, m_firstRow)) * state.nx;
+    restoreLocal(state, state.psi.data() + std::min(offset, state.psi.size()));
+}
+
+// Write a checkpoint collectively
+bool DistributedSimulationEngine::writeCheckpointFile(const std::string& path, int64_t step, int compressionLevel) {
+    (void)compressionLevel;
+    TRACE_SCOPE("Parallel checkpoint", "io");
+    CheckpointState state;
+    state.nx = m_nx;
+    state.ny = m_ny;
+    state.lx = m_lx;
+    state.ly = m_ly;
+    state.dt = m_dt;
+    state.time = m_currentTime;
+    state.step = step;
+    state.precision = "double";
+    state.potential = m_potentialConfig;
+    state.absorbed = m_initialNorm - getTotalProbability();
+    state.psi.assign(m_psi.begin(), m_psi.begin() + m_localRows * m_nx);
+    Checkpoint::writeParallel(m_comm, path, state, static_cast<int>(m_firstRow), static_cast<int>(m_localRows));
+    return true;
+}
+
+// Continue from a checkpoint file, each rank reading its own rows
+bool DistributedSimulationEngine::restoreCheckpointFile(const std::string& path) {
+    CheckpointState state = Checkpoint::readParallel(m_comm, path, static_cast<int>(m_firstRow),
+                                                     static_cast<int>(m_localRows));
+    restoreLocal(state, state.psi.data());
+    return true;
+}
+
+// Release the FFTW plans
+void DistributedSimulationEngine::shutdown() {
+    DEBUG_LOG("DistributedSimulationEngine", "Shutting down DistributedSimulationEngine");
+    cleanupFFTWPlans();
+}
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <mpi.h>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ISimulationEngine.h"
+#include "Checkpoint.h"
+#include "Observables.h"
+#include "SplittingScheme.h"
+#include "../core/PhysicsConfig.h"
+#include "../core/Potential.h"
+#include "../core/Wavefunction.h"
+#include "../core/GridPool.h"
+
+// Forward declaration for the FFTW plan type
+struct fftw_plan_s;
+typedef struct fftw_plan_s* fftw_plan;
+
+/**
+ * @class DistributedSimulationEngine
+ * @brief Split-step Fourier solver whose grid is split into row slabs across MPI ranks
+ *
+ * Every rank of the communicator holds a contiguous slab of rows of ψ, of
+ * the potential tables and of the absorbing layer, as laid out by
+ * fftw_mpi_local_size_2d_transposed(). The FFTs are FFTW-MPI plans: the
+ * forward transform leaves k-space transposed (each rank owns a slab of
+ * kx columns, ky fastest) and the backward transform reads it back in
+ * that layout, which saves the two global transposes a natural-order
+ * k-space would cost per step. The kinetic tables are built in the
+ * transposed layout, so the pointwise multiplies never leave the rank.
+ *
+ * The steps match BasicSimulationEngine<double> with the same
+ * configuration (same splitting, fused potential stages and absorbing
+ * layer). Time-dependent potentials are resampled on the local rows at
+ * each stage time. Norms and observables are reduced with
+ * MPI_Allreduce, so every rank sees the same values.
+ *
+ * All methods are collective: every rank must call them in the same
+ * order. The methods returning the full state (getWavefunction(),
+ * getProbabilityDensity(), writeProbabilityDensity(),
+ * writeWavefunctionField(), captureCheckpoint()) gather it on rank 0;
+ * other ranks get empty results and their destination pointers are not
+ * touched. Checkpoint files are written and read collectively with
+ * parallel HDF5 (see Checkpoint::writeParallel()).
+ *
+ * Only double precision is supported, and FFT plans are not stored in
+ * the wisdom directory since their layout depends on the rank count.
+ */
+class DistributedSimulationEngine : public ISimulationEngine {
+public:
+    using Complex = std::complex<double>;
+
+    /**
+     * @brief Create the engine on every rank of a communicator
+     * @param config The physics configuration; config.precision must be "double"
+     * @param comm Communicator of the ranks sharing the grid
+     * @throws std::invalid_argument if the precision, domain or integrator is invalid
+     * @throws std::runtime_error if the FFTW-MPI plans cannot be created
+     */
+    explicit DistributedSimulationEngine(const PhysicsConfig& config, MPI_Comm comm = MPI_COMM_WORLD);
+
+    /**
+     * @brief Destroy the FFTW plans
+     */
+    ~DistributedSimulationEngine() override;
+
+    DistributedSimulationEngine(const DistributedSimulationEngine&) = delete;
+    DistributedSimulationEngine& operator=(const DistributedSimulationEngine&) = delete;
+
+    /**
+     * @brief Advance the simulation by one time step
+     */
+    void step() override;
+
+    /**
+     * @brief Advance several steps with fused potential stages
+     * @param nSteps Number of time steps to advance
+     */
+    void advance(int nSteps) override;
+
+    /**
+     * @brief Restart from the configured wavepacket at t = 0
+     */
+    void reset() override;
+
+    /**
+     * @brief Update the configuration, re-planning if the grid or planner changed
+     *
+     * config.precision is ignored, as for BasicSimulationEngine. Collective;
+     * with keepState on a new grid ψ is gathered and resampled on rank 0 and
+     * the new slabs are scattered from there.
+     *
+     * @param config The new physics configuration
+     * @param keepState True to carry ψ and the time over
+     * @throws std::invalid_argument if keepState is set and the domain size changes
+     */
+    void updateConfig(const PhysicsConfig& config, bool keepState = false) override;
+
+    /**
+     * @brief Set a new potential
+     *
+     * Every rank must pass an equivalent potential.
+     *
+     * @param potential Unique pointer to the new potential
+     */
+    void setPotential(std::unique_ptr<Potential> potential) override;
+
+    /**
+     * @brief Gather the wavefunction on rank 0
+     * @return The full wavefunction on rank 0, an empty one on other ranks
+     */
+    const Wavefunction& getWavefunction() const override;
+
+    /**
+     * @brief Get the current simulation time
+     * @return Current simulation time
+     */
+    double getCurrentTime() const override { return m_currentTime; }
+
+    /**
+     * @brief Get the total probability, reduced over all ranks
+     * @return Total probability (should be close to 1.0)
+     */
+    double getTotalProbability() const override;
+
+    /**
+     * @brief Compute all observables, reduced over all ranks
+     *
+     * Uses the same position-space and k-space sums as
+     * BasicSimulationEngine::computeObservables(), with one extra
+     * distributed FFT of a scratch copy of ψ.
+     *
+     * @return The sample on every rank; step and wallSeconds are left for the caller
+     */
+    ObservableSample computeObservables() const override;
+
+    /**
+     * @brief Set the regions whose probabilities computeObservables() reports
+     * @param regions Rectangles in domain coordinates
+     */
+    void setObservableRegions(const std::vector<ObservableRegion>& regions) { m_regions = regions; }
+
+    /**
+     * @brief Gather the probability density on rank 0
+     * @return nx * ny densities on rank 0, an empty vector on other ranks
+     */
+    std::vector<float> getProbabilityDensity() const override;
+
+    /**
+     * @brief Gather the probability density into a buffer on rank 0
+     * @param dst Destination for nx * ny floats on rank 0; ignored on other ranks
+     */
+    void writeProbabilityDensity(float* dst) const override;
+
+    /**
+     * @brief Gather the wavefunction as single precision pairs on rank 0
+     * @param dst Destination for 2 * nx * ny floats on rank 0; ignored on other ranks
+     */
+    void writeWavefunctionField(float* dst) const override;
+
+    /**
+     * @brief Set a callback to be invoked after each step or batch of steps
+     * @param callback The function to call
+     */
+    void setStepCompletionCallback(StepCompletionCallback callback) override;
+
+    /**
+     * @brief Gather the state needed to resume later on rank 0
+     * @return The full state on rank 0; other ranks get the scalar fields with an empty psi
+     */
+    CheckpointState captureCheckpoint() const override;
+
+    /**
+     * @brief Continue from a saved state
+     *
+     * Every rank must pass the full state; each copies its own rows.
+     *
+     * @param state State captured by captureCheckpoint() or read with Checkpoint::read()
+     * @throws std::invalid_argument if the grid or domain does not match
+     */
+    void restoreCheckpoint(const CheckpointState& state) override;
+
+    /**
+     * @brief Write a checkpoint collectively, each rank writing its own rows
+     * @param path Destination file
+     * @param step Step count stored in the file
+     * @param compressionLevel Ignored; parallel checkpoints are uncompressed
+     * @return Always true
+     */
+    bool writeCheckpointFile(const std::string& path, int64_t step, int compressionLevel) override;
+
+    /**
+     * @brief Continue from a checkpoint file, each rank reading its own rows
+     * @param path Checkpoint file
+     * @return Always true
+     * @throws std::invalid_argument if the grid or domain does not match
+     */
+    bool restoreCheckpointFile(const std::string& path) override;
+
+    /**
+     * @brief Check whether this is rank 0
+     * @return True on the rank that writes output files
+     */
+    bool isOutputRank() const override { return m_rank == 0; }
+
+    /**
+     * @brief Release the FFTW plans
+     */
+    void shutdown() override;
+
+    /**
+     * @brief Get this process's rank in the engine's communicator
+     * @return Rank, 0 to getRankCount() - 1
+     */
+    int getRank() const { return m_rank; }
+
+    /**
+     * @brief Get the number of ranks sharing the grid
+     * @return Communicator size
+     */
+    int getRankCount() const { return m_rankCount; }
+
+    /**
+     * @brief Get the first row (y index) owned by this rank
+     * @return Global row index
+     */
+    int getFirstRow() const { return static_cast<int>(m_firstRow); }
+
+    /**
+     * @brief Get the number of rows owned by this rank
+     * @return Row count (may be 0 when there are more ranks than rows)
+     */
+    int getLocalRows() const { return static_cast<int>(m_localRows); }
+
+    /**
+     * @brief Get the local slab of ψ
+     * @return getLocalRows() * nx values in storage order (x fastest)
+     */
+    const Complex* getLocalData() const { return m_psi.data(); }
+
+private:
+    /**
+     * @brief Compute the slab layout and create the distributed FFT plans
+     */
+    void initializeFFTWPlans();
+
+    /**
+     * @brief Destroy the FFT plans
+     */
+    void cleanupFFTWPlans();
+
+    /**
+     * @brief Fill the local rows with the configured Gaussian wavepacket, normalized globally
+     */
+    void initializeWavefunction();
+
+    /**
+     * @brief Rebuild the kinetic, potential and absorber tables for the local slabs
+     * @param resamplePotential False to keep the sampled V, e.g. when only dt changed
+     */
+    void rebuildTables(bool resamplePotential = true);
+
+    /**
+     * @brief Sample the potential on the local rows
+     *
+     * Static potentials are sampled once, time-dependent ones once per time.
+     *
+     * @param time Simulation time to sample at
+     */
+    void samplePotential(double time);
+
+    /**
+     * @brief Apply exp(-i*a*V*dt) to the local rows
+     * @param weight Stage weight a in units of dt
+     * @param time Simulation time the stage acts at
+     */
+    void applyPotentialStage(double weight, double time);
+
+    /**
+     * @brief Apply exp(-i*b*K*dt) through the distributed FFT pair
+     * @param weight Stage weight b in units of dt
+     */
+    void applyKineticStage(double weight);
+
+    /**
+     * @brief Adopt the scalar fields of a checkpoint and the local rows of ψ
+     * @param state Saved state; its psi is not read
+     * @param rows getLocalRows() * nx values of this rank's slab
+     * @throws std::invalid_argument if the grid or domain does not match
+     */
+    void restoreLocal(const CheckpointState& state, const Complex* rows);
+
+    /**
+     * @brief Gather the local rows of a per-point array on rank 0
+     * @param local getLocalRows() * nx * components values of this rank
+     * @param global Destination for nx * ny * components values on rank 0
+     * @param type MPI type of one value
+     * @param components Values per grid point
+     */
+    void gatherRows(const void* local, void* global, MPI_Datatype type, int components) const;
+
+    /**
+     * @brief Distribute the rows of a per-point array from rank 0, the inverse of gatherRows()
+     * @param global nx * ny * components values on rank 0 (ignored elsewhere)
+     * @param local Destination for getLocalRows() * nx * components values of this rank
+     * @param type MPI type of one value
+     * @param components Values per grid point
+     */
+    void scatterRows(const void* global, void* local, MPI_Datatype type, int components) const;
+
+    /**
+     * @brief Sum values over all ranks in place
+     * @param values Values to reduce
+     * @param count Number of values
+     */
+    void allreduceSum(double* values, int count) const;
+
+    /**
+     * @brief Operator table for one stage weight of the splitting
+     */
+    struct StageTable {
+        double weight;               ///< Stage weight in units of dt
+        GridVector<Complex> phase;   ///< exp(-i*weight*X*dt) at each local point
+    };
+
+    MPI_Comm m_comm;           ///< Communicator of the ranks sharing the grid (duplicated)
+    int m_rank = 0;            ///< This process's rank in m_comm
+    int m_rankCount = 1;       ///< Number of ranks in m_comm
+
+    // Physics and simulation parameters
+    int m_nx;                  ///< Number of grid points in x direction
+    int m_ny;                  ///< Number of grid points in y direction
+    double m_lx;               ///< Physical length of domain in x direction
+    double m_ly;               ///< Physical length of domain in y direction
+    double m_dt;               ///< Time step size
+    double m_currentTime = 0.0;  ///< Current simulation time
+    int m_numThreads;          ///< Threads used by OpenMP loops and FFTW plans
+    unsigned m_plannerFlags;   ///< FFTW planner rigor flag
+    std::unique_ptr<Potential> m_potential;     ///< The potential energy function
+    Wavepacket m_wavepacket;                    ///< Wavepacket parameters
+    PotentialConfig m_potentialConfig;          ///< Type and parameters of m_potential, for checkpoints
+    AbsorbingBoundary m_absorber;               ///< Absorbing layer along the domain edges
+    const SplittingScheme* m_scheme = nullptr;  ///< Coefficients of the configured integrator
+    double m_initialNorm = 1.0;                 ///< Norm before any absorption
+    std::vector<ObservableRegion> m_regions;    ///< Regions reported by computeObservables()
+
+    // Slab layout from fftw_mpi_local_size_2d_transposed()
+    std::ptrdiff_t m_firstRow = 0;      ///< First y row owned in position space
+    std::ptrdiff_t m_localRows = 0;     ///< y rows owned in position space
+    std::ptrdiff_t m_firstColumn = 0;   ///< First x column owned in (transposed) k-space
+    std::ptrdiff_t m_localColumns = 0;  ///< x columns owned in k-space
+    std::vector<int> m_rowCounts;       ///< Rows owned by each rank, for gathers
+    std::vector<int> m_rowStarts;       ///< First row of each rank, for gathers
+
+    GridVector<Complex> m_psi;   ///< Local slab of ψ, FFTW's local allocation size
+    fftw_plan m_forwardPlan = nullptr;   ///< Forward FFT, transposed output
+    fftw_plan m_backwardPlan = nullptr;  ///< Backward FFT, transposed input
+    fftw_plan m_observablePlan = nullptr;              ///< Forward FFT of m_observableScratch
+    mutable GridVector<Complex> m_observableScratch;   ///< Copy of ψ transformed for k-space observables
+
+    // Local operator tables
+    std::vector<double> m_kx;              ///< Wave numbers in x direction (all columns)
+    std::vector<double> m_ky;              ///< Wave numbers in y direction (all rows)
+    GridVector<double> m_potentialValues;  ///< V on the local rows
+    GridVector<double> m_absorberMask;     ///< exp(-W*dt/2) on the local rows (empty = none)
+    std::vector<StageTable> m_potentialStages;  ///< Static V tables per stage weight
+    std::vector<StageTable> m_kineticStages;    ///< K tables per stage weight (with 1/(nx*ny)), transposed
+    double m_potentialTime = std::numeric_limits<double>::quiet_NaN();  ///< Time m_potentialValues holds (NaN = none)
+
+    StepCompletionCallback m_stepCompletionCallback;  ///< Callback for step completion notification
+
+    mutable Wavefunction m_gathered{0, 0};  ///< Full state gathered by getWavefunction() on rank 0
+};
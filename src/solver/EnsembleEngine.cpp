@@ -0,0 +1,336 @@
+#include "EnsembleEngine.h"
+#include "ComplexKernels.h"
+#include "FFTWWisdom.h"
+#include "SolverDetail.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include "../core/DebugUtils.h"
+#include "../core/Metrics.h"
+#include "../core/Trace.h"
+
+using solver_detail::FFTW;
+using solver_detail::findStage;
+using solver_detail::forEachBlock;
+
+// Create an ensemble
+template <typename Real>
+BasicEnsembleEngine<Real>::BasicEnsembleEngine(const PhysicsConfig& config, const std::vector<Wavepacket>& wavepackets)
+    : m_nx(config.nx),
+      m_ny(config.ny),
+      m_lx(config.lx),
+      m_ly(config.ly),
+      m_dt(config.dt),
+      m_numThreads(solver_detail::resolveThreadCount(config.numThreads)),
+      m_plannerFlags(FFTWWisdom::plannerFlags(config.fftw.planner)),
+      m_wisdomDir(config.fftw.wisdomDir),
+      m_absorber(config.absorber),
+      m_scheme(&SplittingScheme::fromName(config.integration.scheme)),
+      m_wavepackets(wavepackets),
+      m_potential(Potential::create(config.potential, config.lx, config.ly))
+{
+    if (m_wavepackets.empty()) {
+        throw std::invalid_argument("An ensemble needs at least one wavepacket");
+    }
+    if (!(m_lx > 0.0) || !(m_ly > 0.0)) {
+        throw std::invalid_argument("Domain lengths must be positive");
+    }
+    // Fresh grid buffers are first-touched by the solver's own thread team
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    resizeGrid(m_members, m_wavepackets.size() * static_cast<size_t>(m_nx) * m_ny);
+    
+    // Plan first, since measuring planners overwrite the buffer
+    initializeFFTWPlans();
+    rebuildTables();
+    initializeMembers();
+}
+
+// Destroy the FFTW plans
+template <typename Real>
+BasicEnsembleEngine<Real>::~BasicEnsembleEngine() {
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+    if (m_forwardPlan) {
+        FFTW<Real>::destroy(m_forwardPlan);
+    }
+    if (m_backwardPlan) {
+        FFTW<Real>::destroy(m_backwardPlan);
+    }
+}
+
+// Put each member in its initial wavepacket
+template <typename Real>
+void BasicEnsembleEngine<Real>::initializeMembers() {
+    const size_t size = static_cast<size_t>(m_nx) * m_ny;
+    WavefunctionType member(m_nx, m_ny);
+    for (size_t k = 0; k < m_wavepackets.size(); ++k) {
+        const Wavepacket& w = m_wavepackets[k];
+        member.initializeGaussian(w.x0, w.y0, w.sigmaX, w.sigmaY, w.kx, w.ky, m_lx, m_ly, m_numThreads);
+        std::copy(member.data(), member.data() + size, m_members.data() + k * size);
+    }
+    m_currentTime = 0.0;
+}
+
+// Create the batched plans
+template <typename Real>
+void BasicEnsembleEngine<Real>::initializeFFTWPlans() {
+    TRACE_SCOPE("FFTW planning", "solver");
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+    const int planThreads = solver_detail::preparePlannerThreads<Real>(m_numThreads);
+    const int members = static_cast<int>(m_wavepackets.size());
+    
+    FFTWWisdom::Key wisdomKey{ m_nx, m_ny, FFTW<Real>::precision, planThreads, m_plannerFlags };
+    wisdomKey.howmany = members;
+    const bool haveWisdom = FFTWWisdom::load(m_wisdomDir, wisdomKey);
+    
+    // Storage is row-major with x fastest, so y is FFTW's slow (first) dimension
+    m_forwardPlan = FFTW<Real>::planMany2d(m_ny, m_nx, members, m_members.data(), FFTW_FORWARD, m_plannerFlags);
+    m_backwardPlan = FFTW<Real>::planMany2d(m_ny, m_nx, members, m_members.data(), FFTW_BACKWARD, m_plannerFlags);
+    if (!m_forwardPlan || !m_backwardPlan) {
+        ERROR_LOG("EnsembleEngine", "Failed to create batched FFTW plans");
+        throw std::runtime_error("Failed to create batched FFTW plans");
+    }
+    if (!haveWisdom) {
+        FFTWWisdom::save(m_wisdomDir, wisdomKey);
+    }
+}
+
+// Tabulate the operator tables shared by all members
+template <typename Real>
+void BasicEnsembleEngine<Real>::rebuildTables() {
+    const size_t size = static_cast<size_t>(m_nx) * m_ny;
+    solver_detail::buildAbsorberMask(m_absorber, m_nx, m_ny, m_lx, m_ly, m_dt, m_numThreads, m_absorberMask);
+    
+    // Wave numbers in FFT order [0, 1, ..., N/2, -N/2+1, ..., -1]
+    auto waveNumbers = [](int n, double length) {
+        std::vector<double> k(static_cast<size_t>(n));
+        for (int i = 0; i < n; ++i) {
+            k[i] = 2.0 * M_PI * (i <= n / 2 ? i : i - n) / length;
+        }
+        return k;
+    };
+    const std::vector<double> kx = waveNumbers(m_nx, m_lx);
+    const std::vector<double> ky = waveNumbers(m_ny, m_ly);
+    
+    // exp(-i*b*K*dt) with the 1/(nx*ny) of the FFT round trip folded in
+    const double normFactor = 1.0 / static_cast<double>(size);
+    m_kineticStages.clear();
+    solver_detail::buildStageTables(m_kineticStages, m_scheme->b, [&](double weight) {
+        GridVector<Complex> phase(size);
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (int j = 0; j < m_ny; ++j) {
+            Complex* row = phase.data() + static_cast<size_t>(j) * m_nx;
+            for (int i = 0; i < m_nx; ++i) {
+                const double k = (kx[i] * kx[i] + ky[j] * ky[j]) / 2.0;
+                row[i] = Complex(std::polar(normFactor, -weight * m_dt * k));
+            }
+        }
+        return phase;
+    });
+    
+    // A static potential gets one table per stage weight, including the
+    // merged last-and-first stage of consecutive steps
+    resizeGrid(m_potentialValues, size);
+    m_potentialTime = std::numeric_limits<double>::quiet_NaN();
+    m_potentialStages.clear();
+    samplePotential(0.0);
+    if (m_potential->isTimeDependent()) {
+        // One block of phases per solver thread for applyPotentialStage()
+        resizeGrid(m_phaseScratch, static_cast<size_t>(m_numThreads) * solver_detail::kKernelBlock);
+        return;
+    }
+    GridVector<Complex>().swap(m_phaseScratch);
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const Real* values = m_potentialValues.data();
+    const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(size);
+    solver_detail::buildStageTables(m_potentialStages, solver_detail::potentialStageWeights(*m_scheme),
+                                    [&](double weight) {
+        GridVector<Complex> phase(size);
+        Complex* table = phase.data();
+        
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < count; ++n) {
+            const double damping = mask ? std::pow(mask[n], 2.0 * weight) : 1.0;
+            table[n] = Complex(std::polar(damping, -weight * m_dt * values[n]));
+        }
+        return phase;
+    });
+}
+
+// Sample the potential on the grid
+template <typename Real>
+void BasicEnsembleEngine<Real>::samplePotential(double time) {
+    // Static potentials are sampled once, time-dependent ones once per stage time
+    if (time == m_potentialTime || (!m_potential->isTimeDependent() && !std::isnan(m_potentialTime))) {
+        return;
+    }
+    TRACE_SCOPE("V(t)", "solver");
+    m_potential->setTime(time);
+    
+    GridGeometry grid;
+    grid.nx = m_nx;
+    grid.ny = m_ny;
+    grid.x0 = -m_lx/2;
+    grid.y0 = -m_ly/2;
+    grid.dx = m_lx / m_nx;
+    grid.dy = m_ly / m_ny;
+    
+    solver_detail::sampleRows(*m_potential, grid, m_numThreads, [&](int j, const double* row) {
+        Real* values = m_potentialValues.data() + static_cast<size_t>(j) * m_nx;
+        for (int i = 0; i < m_nx; ++i) {
+            values[i] = static_cast<Real>(row[i]);
+        }
+    });
+    m_potentialTime = time;
+}
+
+// Multiply a table into every member while each block of it is in cache
+template <typename Real>
+void BasicEnsembleEngine<Real>::multiplyMembers(const Complex* phase) {
+    Complex* psi = m_members.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_nx) * m_ny;
+    const size_t members = m_wavepackets.size();
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        for (size_t k = 0; k < members; ++k) {
+            kernels::multiply(psi + k * size + begin, phase + begin, count);
+        }
+    });
+}
+
+// Apply one potential stage to every member
+template <typename Real>
+void BasicEnsembleEngine<Real>::applyPotentialStage(double weight, double time) {
+    TRACE_SCOPE("V stage", "solver");
+    // Every member read and written, the shared phases read once
+    METRICS_SCOPE(MetricStage::Potential,
+                  (2 * m_wavepackets.size() + 1) * static_cast<size_t>(m_nx) * m_ny * sizeof(Complex));
+    if (const Complex* phase = findStage(m_potentialStages, weight)) {
+        multiplyMembers(phase);
+        return;
+    }
+    
+    // Time-dependent potentials: each block's phases are computed once and
+    // applied to all members, so the sincos cost is shared as well
+    samplePotential(time);
+    Complex* psi = m_members.data();
+    const Real* values = m_potentialValues.data();
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_nx) * m_ny;
+    const size_t members = m_wavepackets.size();
+    const double scale = -weight * m_dt;
+    Complex* scratch = m_phaseScratch.data();
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        Complex* phase = scratch + static_cast<size_t>(solver_detail::threadIndex()) * solver_detail::kKernelBlock;
+        for (size_t n = 0; n < count; ++n) {
+            const size_t index = static_cast<size_t>(begin) + n;
+            const double damping = mask ? std::pow(mask[index], 2.0 * weight) : 1.0;
+            phase[n] = Complex(std::polar(damping, scale * values[index]));
+        }
+        for (size_t k = 0; k < members; ++k) {
+            kernels::multiply(psi + k * size + begin, phase, count);
+        }
+    });
+}
+
+// Apply one kinetic stage to every member
+template <typename Real>
+void BasicEnsembleEngine<Real>::applyKineticStage(double weight) {
+    const Complex* phase = findStage(m_kineticStages, weight);
+    if (!phase) {
+        throw std::logic_error("No kinetic table for the integrator weight");
+    }
+    TRACE_SCOPE("K", "solver");
+    const size_t points = static_cast<size_t>(m_nx) * m_ny;
+    const size_t bytes = m_members.size() * sizeof(Complex);
+    {
+        TRACE_SCOPE("FFT forward", "fft");
+        METRICS_SCOPE(MetricStage::FFTForward, 2 * bytes);
+        FFTW<Real>::execute(m_forwardPlan);
+    }
+    {
+        METRICS_SCOPE(MetricStage::Kinetic, 2 * bytes + points * sizeof(Complex));
+        multiplyMembers(phase);
+    }
+    TRACE_SCOPE("FFT backward", "fft");
+    METRICS_SCOPE(MetricStage::FFTBackward, 2 * bytes);
+    FFTW<Real>::execute(m_backwardPlan);
+}
+
+// Advance every member by one step
+template <typename Real>
+void BasicEnsembleEngine<Real>::step() {
+    advance(1);
+}
+
+// Advance every member with fused potential stages
+template <typename Real>
+void BasicEnsembleEngine<Real>::advance(int nSteps) {
+    TRACE_SCOPE("Ensemble advance", "solver");
+    if (nSteps <= 0) {
+        return;
+    }
+    const SplittingScheme& scheme = *m_scheme;
+    const size_t stages = scheme.b.size();
+    
+    applyPotentialStage(scheme.a.front(), m_currentTime);
+    for (int s = 0; s < nSteps; ++s) {
+        for (size_t j = 0; j < stages; ++j) {
+            applyKineticStage(scheme.b[j]);
+            if (j + 1 < stages) {
+                applyPotentialStage(scheme.a[j + 1], m_currentTime + scheme.stageTime(j + 1) * m_dt);
+            }
+        }
+        const double last = scheme.a.back() + (s + 1 < nSteps ? scheme.a.front() : 0.0);
+        applyPotentialStage(last, m_currentTime + m_dt);
+        m_currentTime += m_dt;
+    }
+    // Each member takes the steps
+    METRICS_STEPS(static_cast<size_t>(nSteps) * m_wavepackets.size());
+}
+
+// Restart every member
+template <typename Real>
+void BasicEnsembleEngine<Real>::reset() {
+    initializeMembers();
+}
+
+// Copy one member
+template <typename Real>
+typename BasicEnsembleEngine<Real>::WavefunctionType BasicEnsembleEngine<Real>::getMember(size_t member) const {
+    const size_t size = static_cast<size_t>(m_nx) * m_ny;
+    WavefunctionType copy(m_nx, m_ny);
+    const Complex* source = m_members.data() + member * size;
+    std::copy(source, source + size, copy.data());
+    return copy;
+}
+
+// Norm of one member
+template <typename Real>
+double BasicEnsembleEngine<Real>::getTotalProbability(size_t member) const {
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_nx) * m_ny;
+    const Complex* psi = m_members.data() + member * static_cast<size_t>(size);
+    const std::ptrdiff_t blocks = (size + solver_detail::kKernelBlock - 1) / solver_detail::kKernelBlock;
+    
+    double total = 0.0;
+    #pragma omp parallel for reduction(+:total) num_threads(m_numThreads)
+    for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+        const std::ptrdiff_t begin = b * solver_detail::kKernelBlock;
+        total += kernels::sumNorm(psi + begin, static_cast<size_t>(std::min(solver_detail::kKernelBlock, size - begin)));
+    }
+    return total * (m_lx / m_nx) * (m_ly / m_ny);
+}
+
+// |ψ|² of one member as float
+template <typename Real>
+void BasicEnsembleEngine<Real>::writeProbabilityDensity(size_t member, float* dst) const {
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_nx) * m_ny;
+    const Complex* psi = m_members.data() + member * static_cast<size_t>(size);
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        kernels::normToFloat(psi + begin, dst + begin, count);
+    });
+}
+
+template class BasicEnsembleEngine<double>;
+template class BasicEnsembleEngine<float>;
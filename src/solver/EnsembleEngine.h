@@ -0,0 +1,196 @@
+#pragma once
+
+#include <complex>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SimulationEngine.h"
+#include "SplittingScheme.h"
+#include "../core/PhysicsConfig.h"
+#include "../core/Potential.h"
+#include "../core/Wavefunction.h"
+#include "../core/GridPool.h"
+
+/**
+ * @class BasicEnsembleEngine
+ * @brief Evolves several wavefunctions that share a grid, time step and potential
+ *
+ * A sweep over initial wavepackets repeats the same operator tables and FFT
+ * plans for every run. The ensemble stores its K members back to back in
+ * one buffer (member k starts at data() + k * nx * ny), transforms all of
+ * them with one batched FFTW plan (fftw_plan_many_dft) and applies every
+ * potential and kinetic phase table block by block: each block of a table
+ * is read once and multiplied into all K members while it is in cache, so
+ * the table traffic of a step is paid once instead of K times.
+ *
+ * Each member evolves exactly as a BasicSimulationEngine with the same
+ * configuration and that member's wavepacket would (same splitting scheme,
+ * absorbing layer and fused half steps). Time-dependent potentials are
+ * sampled once per stage time for the whole ensemble.
+ *
+ * @tparam Real Floating-point type of the members (double or float)
+ */
+template <typename Real>
+class BasicEnsembleEngine {
+public:
+    using Complex = std::complex<Real>;
+    using WavefunctionType = BasicWavefunction<Real>;
+
+    /**
+     * @brief Create an ensemble
+     * @param config Shared configuration; config.wavepacket is ignored
+     * @param wavepackets Initial wavepacket of each member
+     * @throws std::invalid_argument if wavepackets is empty, the domain is
+     *         not positive or the integrator is unknown
+     * @throws std::runtime_error if the FFTW plans cannot be created
+     */
+    BasicEnsembleEngine(const PhysicsConfig& config, const std::vector<Wavepacket>& wavepackets);
+
+    /**
+     * @brief Destroy the FFTW plans
+     */
+    ~BasicEnsembleEngine();
+
+    BasicEnsembleEngine(const BasicEnsembleEngine&) = delete;
+    BasicEnsembleEngine& operator=(const BasicEnsembleEngine&) = delete;
+
+    /**
+     * @brief Advance every member by one time step
+     */
+    void step();
+
+    /**
+     * @brief Advance every member by several time steps with fused potential stages
+     * @param nSteps Number of steps
+     */
+    void advance(int nSteps);
+
+    /**
+     * @brief Restart every member from its initial wavepacket at t = 0
+     */
+    void reset();
+
+    /**
+     * @brief Get the number of members
+     * @return K
+     */
+    size_t getMemberCount() const { return m_wavepackets.size(); }
+
+    /**
+     * @brief Get the simulation time shared by all members
+     * @return Current time
+     */
+    double getCurrentTime() const { return m_currentTime; }
+
+    /**
+     * @brief Copy one member's wavefunction
+     * @param member Member index
+     * @return Copy of the member's state
+     */
+    WavefunctionType getMember(size_t member) const;
+
+    /**
+     * @brief Get one member's norm ∫|ψ|²
+     * @param member Member index
+     * @return Total probability of the member
+     */
+    double getTotalProbability(size_t member) const;
+
+    /**
+     * @brief Write one member's |ψ|² as float in storage order
+     * @param member Member index
+     * @param dst Buffer with room for nx * ny floats
+     */
+    void writeProbabilityDensity(size_t member, float* dst) const;
+
+    /**
+     * @brief Get the ensemble buffer
+     * @return First value of member 0; member k starts nx * ny values later per k
+     */
+    const Complex* data() const { return m_members.data(); }
+
+private:
+    /**
+     * @struct StageTable
+     * @brief Phase table of one integrator stage weight
+     */
+    struct StageTable {
+        double weight;               ///< Stage weight in units of dt
+        GridVector<Complex> phase;   ///< Tabulated factors
+    };
+
+    /**
+     * @brief Put each member in its initial wavepacket and reset the time
+     */
+    void initializeMembers();
+
+    /**
+     * @brief Create the batched forward and backward plans
+     */
+    void initializeFFTWPlans();
+
+    /**
+     * @brief Tabulate the kinetic tables and, for a static potential, the potential tables
+     */
+    void rebuildTables();
+
+    /**
+     * @brief Sample the potential at a time into m_potentialValues
+     * @param time Simulation time (ignored for static potentials)
+     */
+    void samplePotential(double time);
+
+    /**
+     * @brief Apply exp(-i*a*V*dt) to every member
+     * @param weight Stage weight a
+     * @param time Simulation time of the stage
+     */
+    void applyPotentialStage(double weight, double time);
+
+    /**
+     * @brief Apply exp(-i*b*K*dt) to every member through one batched FFT pair
+     * @param weight Stage weight b
+     */
+    void applyKineticStage(double weight);
+
+    /**
+     * @brief Multiply a table into every member, block by block
+     * @param phase Table of nx * ny factors
+     */
+    void multiplyMembers(const Complex* phase);
+
+    int m_nx;                ///< Grid points in x
+    int m_ny;                ///< Grid points in y
+    double m_lx;             ///< Domain length in x
+    double m_ly;             ///< Domain length in y
+    double m_dt;             ///< Time step
+    double m_currentTime = 0.0;  ///< Shared simulation time
+    int m_numThreads;        ///< Solver threads
+    unsigned m_plannerFlags; ///< FFTW planner rigor
+    std::string m_wisdomDir; ///< FFTW wisdom store
+    AbsorbingBoundary m_absorber;        ///< Absorbing layer settings
+    const SplittingScheme* m_scheme;     ///< Operator splitting
+    std::vector<Wavepacket> m_wavepackets;  ///< Initial state of each member
+    std::unique_ptr<Potential> m_potential; ///< Shared potential
+
+    GridVector<Complex> m_members;           ///< K wavefunctions, back to back
+    GridVector<double> m_absorberMask;       ///< exp(-W*dt/2), empty without absorber
+    GridVector<Real> m_potentialValues;      ///< V at m_potentialTime
+    double m_potentialTime = std::numeric_limits<double>::quiet_NaN();  ///< Time of m_potentialValues
+    std::vector<StageTable> m_potentialStages;  ///< exp(-i*a*V*dt) per weight (static potentials only)
+    std::vector<StageTable> m_kineticStages;    ///< exp(-i*b*K*dt)/(nx*ny) per weight
+    GridVector<Complex> m_phaseScratch;         ///< One block of V(t) phases per thread (time-dependent potentials only)
+
+    typename FFTWPlanType<Real>::type m_forwardPlan = nullptr;   ///< Batched forward FFT
+    typename FFTWPlanType<Real>::type m_backwardPlan = nullptr;  ///< Batched backward FFT
+};
+
+extern template class BasicEnsembleEngine<double>;
+extern template class BasicEnsembleEngine<float>;
+
+/// Double-precision ensemble engine
+using EnsembleEngine = BasicEnsembleEngine<double>;
+
+/// Single-precision ensemble engine
+using EnsembleEngineF = BasicEnsembleEngine<float>;
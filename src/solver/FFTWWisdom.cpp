@@ -0,0 +1,90 @@
+#include "FFTWWisdom.h"
+#include <fftw3.h>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include "../core/DebugUtils.h"
+
+// Convert a planner name to its FFTW flag
+unsigned FFTWWisdom::plannerFlags(const std::string& name) {
+    if (name == "estimate") return FFTW_ESTIMATE;
+    if (name == "measure") return FFTW_MEASURE;
+    if (name == "patient") return FFTW_PATIENT;
+    if (name == "exhaustive") return FFTW_EXHAUSTIVE;
+    throw std::invalid_argument("Unknown FFTW planner: " + name);
+}
+
+// Get the planner name for an FFTW flag
+const char* FFTWWisdom::plannerName(unsigned flags) {
+    if (flags & FFTW_ESTIMATE) return "estimate";
+    if (flags & FFTW_EXHAUSTIVE) return "exhaustive";
+    if (flags & FFTW_PATIENT) return "patient";
+    return "measure";
+}
+
+// Lock serializing FFTW planning across threads
+std::mutex& FFTWWisdom::plannerMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Only measuring planners produce wisdom
+bool FFTWWisdom::usesWisdom(unsigned flags) {
+    return (flags & FFTW_ESTIMATE) == 0;
+}
+
+// Build the file name for a plan key
+std::string FFTWWisdom::fileName(const Key& key) {
+    return std::string("fftw-") + (key.precision == Precision::Float ? "float" : "double") +
+           "-" + std::to_string(key.nx) + "x" + std::to_string(key.ny) +
+           "-t" + std::to_string(key.numThreads) +
+           "-" + plannerName(key.flags) +
+           (key.howmany > 1 ? "-k" + std::to_string(key.howmany) : std::string()) + ".wisdom";
+}
+
+// Import saved wisdom for a key
+bool FFTWWisdom::load(const std::string& directory, const Key& key) {
+    if (directory.empty() || !usesWisdom(key.flags)) {
+        return false;
+    }
+
+    std::filesystem::path path = std::filesystem::path(directory) / fileName(key);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return false;
+    }
+
+    int imported = key.precision == Precision::Float
+        ? fftwf_import_wisdom_from_filename(path.string().c_str())
+        : fftw_import_wisdom_from_filename(path.string().c_str());
+
+    DEBUG_LOG("FFTWWisdom", (imported ? "Loaded wisdom from " : "Failed to read wisdom from ") + path.string());
+    return imported != 0;
+}
+
+// Export the current wisdom for a key
+bool FFTWWisdom::save(const std::string& directory, const Key& key) {
+    if (directory.empty() || !usesWisdom(key.flags)) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        WARNING_LOG("FFTWWisdom", "Cannot create FFTW wisdom directory " + directory + ": " + ec.message());
+        return false;
+    }
+
+    std::filesystem::path path = std::filesystem::path(directory) / fileName(key);
+    int exported = key.precision == Precision::Float
+        ? fftwf_export_wisdom_to_filename(path.string().c_str())
+        : fftw_export_wisdom_to_filename(path.string().c_str());
+
+    if (!exported) {
+        WARNING_LOG("FFTWWisdom", "Cannot write FFTW wisdom to " + path.string());
+        return false;
+    }
+
+    DEBUG_LOG("FFTWWisdom", "Saved wisdom to " + path.string());
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+/**
+ * @class FFTWWisdom
+ * @brief Persistent store of FFTW planner wisdom
+ *
+ * Planning with FFTW_MEASURE or FFTW_PATIENT times candidate algorithms and
+ * can take seconds on large grids. The results ("wisdom") are saved to one
+ * file per plan key in a directory, so that later engines with the same
+ * grid size, precision, thread count and planner flag plan almost instantly.
+ *
+ * FFTW's wisdom is process-wide, so loading a file also speeds up planning
+ * of any other transform it happens to cover.
+ */
+class FFTWWisdom {
+public:
+    /**
+     * @enum Precision
+     * @brief FFTW interface the wisdom belongs to (fftw_ or fftwf_)
+     */
+    enum class Precision {
+        Double,
+        Float
+    };
+
+    /**
+     * @struct Key
+     * @brief Identifies one set of plans in the store
+     */
+    struct Key {
+        int nx;               ///< Grid points in x direction
+        int ny;               ///< Grid points in y direction
+        Precision precision;  ///< FFTW interface used for the plans
+        int numThreads;       ///< Threads the plans were created for
+        unsigned flags;       ///< FFTW planner rigor flag
+        int howmany = 1;      ///< Transforms per plan (ensemble members of a batched plan)
+    };
+
+    /**
+     * @brief Convert a planner name to its FFTW flag
+     * @param name One of "estimate", "measure", "patient" or "exhaustive"
+     * @return The matching FFTW_* planner flag
+     * @throws std::invalid_argument if name is not recognized
+     */
+    static unsigned plannerFlags(const std::string& name);
+
+    /**
+     * @brief Get the planner name for an FFTW flag
+     * @param flags FFTW planner rigor flag
+     * @return Name such as "measure"
+     */
+    static const char* plannerName(unsigned flags);
+
+    /**
+     * @brief Check whether plans with these flags are worth caching
+     *
+     * FFTW_ESTIMATE plans are built from heuristics without timing, so
+     * there is nothing to save for them.
+     *
+     * @param flags FFTW planner rigor flag
+     * @return True if the planner measures and therefore produces wisdom
+     */
+    static bool usesWisdom(unsigned flags);
+
+    /**
+     * @brief Get the file name used for a key inside the store directory
+     * @param key The plan key
+     * @return File name such as "fftw-double-256x256-t4-measure.wisdom", with
+     *         "-k<howmany>" before the extension for batched plans
+     */
+    static std::string fileName(const Key& key);
+
+    /**
+     * @brief Import the wisdom saved for a key, if any
+     * @param directory Store directory (empty = store disabled)
+     * @param key The plan key
+     * @return True if wisdom for key was found and imported
+     */
+    static bool load(const std::string& directory, const Key& key);
+
+    /**
+     * @brief Export the current wisdom of the key's precision to the store
+     *
+     * Creates the directory if needed. Failures are reported on stderr but
+     * are not fatal, since wisdom only affects planning time.
+     *
+     * @param directory Store directory (empty = store disabled)
+     * @param key The plan key
+     * @return True if the wisdom was written
+     */
+    static bool save(const std::string& directory, const Key& key);
+
+    /**
+     * @brief Get the lock that serializes FFTW planning across threads
+     *
+     * Only plan execution is thread-safe in FFTW; creating and destroying
+     * plans and importing or exporting wisdom must hold this lock when
+     * several engines run at once. Plans created under it also reuse the
+     * wisdom accumulated by earlier plans of the same size in the process.
+     *
+     * @return The process-wide planner mutex
+     */
+    static std::mutex& plannerMutex();
+};
@@ -1,13 +1,33 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <complex>
+#include <string>
 #include <vector>
+#include <functional>
 #include "../core/PhysicsConfig.h"
 
 // Forward declarations
-class Wavefunction;
+template <typename Real> class BasicWavefunction;
+using Wavefunction = BasicWavefunction<double>;
 class Potential;
+struct CheckpointState;
+struct ObservableSample;
+
+/**
+ * @struct EigenstateResult
+ * @brief Outcome of relaxing one eigenstate in imaginary time
+ */
+struct EigenstateResult {
+    double energy = 0.0;     ///< ⟨H⟩ of the relaxed state
+    int steps = 0;           ///< Imaginary time steps taken
+    double dt = 0.0;         ///< Imaginary time step at the end
+    bool converged = false;  ///< False if maxSteps ran out first
+};
+
+// Define callback type for step completion
+using StepCompletionCallback = std::function<void()>;
 
 /**
  * @interface ISimulationEngine
@@ -30,6 +50,50 @@ public:
      */
     virtual void step() = 0;
     
+    /**
+     * @brief Advance the simulation by several time steps in one batch
+     * 
+     * Equivalent to calling step() nSteps times, but implementations may fuse
+     * work between consecutive steps and publish events only at the end of
+     * the batch (or at their configured observable interval).
+     * 
+     * @param nSteps Number of time steps to advance
+     */
+    virtual void advance(int nSteps) = 0;
+    
+    /**
+     * @brief Advance by a span of simulation time with adaptive steps, if the engine supports them
+     * 
+     * Engines that implement integration.adaptive choose dt themselves and
+     * land exactly on the end of the span. The default returns false, and
+     * the caller takes fixed steps with advance() instead.
+     * 
+     * @param duration Simulation time to advance by
+     * @param steps Set to the number of accepted steps
+     * @return True if the engine advanced, false if it only takes fixed steps
+     * @throws std::invalid_argument if the adaptive settings are inconsistent
+     */
+    virtual bool advanceAdaptive(double duration, int& steps) {
+        (void)duration; (void)steps;
+        return false;
+    }
+    
+    /**
+     * @brief Relax the wavefunction to the ground state in imaginary time, if the engine supports it
+     * 
+     * Used before a real-time run that should start from the ground state
+     * of the configured potential. The default returns false.
+     * 
+     * @param options Step sizes, tolerance and number of states
+     * @param results Set to one result per state, lowest energy first
+     * @return True if the wavefunction now holds the ground state
+     * @throws std::invalid_argument if a step size, interval or count is not positive
+     */
+    virtual bool relaxInitialState(const ImaginaryTime& options, std::vector<EigenstateResult>& results) {
+        (void)options; (void)results;
+        return false;
+    }
+    
     /**
      * @brief Reset the simulation with the current parameters
      */
@@ -37,9 +101,21 @@ public:
     
     /**
      * @brief Update the simulation configuration
+     * 
+     * Implementations redo only the work the changed settings need: a new
+     * dt rebuilds the operator tables, a new potential is sampled again,
+     * and FFT plans are only recreated for a new grid or planner setting.
+     * 
+     * By default the wavepacket is initialized again and the time restarts
+     * at 0. With keepState the current ψ and time carry over instead; on a
+     * new grid ψ is resampled by zero-padding or truncating its Fourier
+     * coefficients, so the domain size must stay the same.
+     * 
      * @param config The new physics configuration
+     * @param keepState True to continue from the current state
+     * @throws std::invalid_argument if keepState is set and the domain size changes
      */
-    virtual void updateConfig(const PhysicsConfig& config) = 0;
+    virtual void updateConfig(const PhysicsConfig& config, bool keepState = false) = 0;
     
     /**
      * @brief Set a new potential for the simulation
@@ -64,6 +140,12 @@ public:
      * @return Total probability (should be close to 1.0)
      */
     virtual double getTotalProbability() const = 0;
+    
+    /**
+     * @brief Compute all observables of the current state in one sample
+     * @return Norm, expectation values, energy and region probabilities; the step is left at 0
+     */
+    virtual ObservableSample computeObservables() const = 0;
 
     /**
      * @brief Get the probability density for visualization
@@ -71,6 +153,92 @@ public:
      */
     virtual std::vector<float> getProbabilityDensity() const = 0;
     
+    /**
+     * @brief Write the probability density into a caller-provided buffer
+     * 
+     * Unlike getProbabilityDensity() this does not allocate, so it can fill
+     * a reused or mapped upload buffer every frame.
+     * 
+     * @param dst Destination for nx * ny floats in storage order (x fastest)
+     */
+    virtual void writeProbabilityDensity(float* dst) const = 0;
+    
+    /**
+     * @brief Write the wavefunction as single precision real/imaginary pairs
+     * 
+     * Lets a display compute |ψ|² and the phase on the GPU instead of the CPU.
+     * 
+     * @param dst Destination for 2 * nx * ny floats (re, im per point, x fastest)
+     */
+    virtual void writeWavefunctionField(float* dst) const = 0;
+    
+    /**
+     * @brief Set a callback to be invoked when a simulation step completes
+     * @param callback The function to call after each step (or batch of steps)
+     */
+    virtual void setStepCompletionCallback(StepCompletionCallback callback) = 0;
+    
+    /**
+     * @brief Copy the state needed to resume the simulation later
+     * @return Grid, time, potential and wavefunction; the step count is left at 0
+     */
+    virtual CheckpointState captureCheckpoint() const = 0;
+    
+    /**
+     * @brief Continue from a saved state
+     * 
+     * The engine adopts the checkpoint's time, time step, potential and
+     * wavefunction. The grid must already match; create the engine from
+     * the checkpoint's grid to resume elsewhere.
+     * 
+     * @param state State captured by captureCheckpoint()
+     * @throws std::invalid_argument if the grid does not match
+     */
+    virtual void restoreCheckpoint(const CheckpointState& state) = 0;
+    
+    /**
+     * @brief Write a checkpoint file directly, if the engine has its own writer
+     * 
+     * Engines whose state does not fit captureCheckpoint() (such as the
+     * distributed engine, whose ranks each hold a slab) write the file
+     * themselves. The default returns false, and the caller captures the
+     * state and writes it with Checkpoint or CheckpointWriter instead.
+     * 
+     * @param path Destination file
+     * @param step Step count stored in the file
+     * @param compressionLevel Deflate level 1-9, or 0 for no compression
+     * @return True if the file was written, false if the caller should write it
+     */
+    virtual bool writeCheckpointFile(const std::string& path, int64_t step, int compressionLevel) {
+        (void)path; (void)step; (void)compressionLevel;
+        return false;
+    }
+    
+    /**
+     * @brief Continue from a checkpoint file, if the engine has its own reader
+     * 
+     * Counterpart of writeCheckpointFile(); the default returns false, and
+     * the caller reads the file and passes it to restoreCheckpoint().
+     * 
+     * @param path Checkpoint file
+     * @return True if the state was restored, false if the caller should restore it
+     * @throws std::invalid_argument if the grid does not match
+     */
+    virtual bool restoreCheckpointFile(const std::string& path) {
+        (void)path;
+        return false;
+    }
+    
+    /**
+     * @brief Check whether this process should write output files
+     * 
+     * Every rank of a distributed engine takes part in the collective
+     * calls, but only rank 0 writes observables and snapshots.
+     * 
+     * @return True unless this is a non-root rank of a distributed engine
+     */
+    virtual bool isOutputRank() const { return true; }
+    
     /**
      * @brief Shutdown the simulation engine and release resources
      * 
@@ -0,0 +1,283 @@
+#include "Observables.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include "../core/DebugUtils.h"
+
+namespace {
+
+const char kBinaryMagic[8] = {'Q', 'M', 'O', 'B', 'S', '0', '0', '1'};
+
+// Column values of a sample in file order
+std::vector<double> sampleValues(const ObservableSample& sample) {
+    std::vector<double> values = {
+        static_cast<double>(sample.step), sample.time, sample.totalProbability,
+        sample.x, sample.y, sample.px, sample.py,
+        sample.kineticEnergy, sample.potentialEnergy, sample.energy, sample.wallSeconds,
+        sample.absorbedProbability
+    };
+    values.insert(values.end(), sample.regions.begin(), sample.regions.end());
+    values.insert(values.end(), sample.labels.begin(), sample.labels.end());
+    return values;
+}
+
+std::string csvHeader(const std::vector<std::string>& columns) {
+    std::string header;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        header += (i ? "," : "") + columns[i];
+    }
+    return header;
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+// Parse a format name
+ObservableWriter::Format ObservableWriter::parseFormat(const std::string& name) {
+    if (name == "csv") return Format::Csv;
+    if (name == "binary") return Format::Binary;
+    throw std::invalid_argument("Unknown observables format: " + name);
+}
+
+// Get the usual file extension of a format
+const char* ObservableWriter::extension(Format format) {
+    return format == Format::Binary ? ".bin" : ".csv";
+}
+
+// Get the column names written for a set of regions
+std::vector<std::string> ObservableWriter::columnNames(const std::vector<ObservableRegion>& regions,
+                                                       const std::vector<std::string>& labelColumns) {
+    std::vector<std::string> columns = {
+        "step", "time", "total_probability", "x_mean", "y_mean", "px_mean", "py_mean",
+        "kinetic_energy", "potential_energy", "energy", "wall_seconds",
+        "absorbed_probability"
+    };
+    for (const ObservableRegion& region : regions) {
+        columns.push_back("region_" + region.name);
+    }
+    columns.insert(columns.end(), labelColumns.begin(), labelColumns.end());
+    return columns;
+}
+
+// Open the output file and start the writer thread
+ObservableWriter::ObservableWriter(const std::string& path, Format format,
+                                   const std::vector<ObservableRegion>& regions,
+                                   size_t capacity, int64_t keepUpToStep,
+                                   const std::vector<std::string>& labelColumns)
+    : m_path(path),
+      m_format(format),
+      m_columns(columnNames(regions, labelColumns)),
+      m_queue(std::max<size_t>(1, capacity))
+{
+    const bool append = keepUpToStep >= 0 && keepExisting(keepUpToStep);
+    const auto mode = std::ios::binary | (append ? std::ios::app : std::ios::trunc);
+    m_file.open(m_path, std::ios::out | mode);
+    if (!m_file) {
+        throw std::runtime_error("Cannot write " + m_path);
+    }
+    if (!append) {
+        writeHeader();
+    }
+    if (m_format == Format::Csv) {
+        m_file << std::setprecision(12);
+    }
+
+    m_thread = std::thread(&ObservableWriter::threadMain, this);
+}
+
+// Write the remaining samples and stop the writer thread
+ObservableWriter::~ObservableWriter() {
+    try {
+        close();
+    }
+    catch (const std::exception& e) {
+        DEBUG_LOG("Observables", std::string("Error while closing observables: ") + e.what());
+    }
+}
+
+// Keep the samples of an existing file up to a step
+bool ObservableWriter::keepExisting(int64_t keepUpToStep) {
+    std::ifstream in(m_path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    if (m_format == Format::Csv) {
+        std::string header;
+        if (!std::getline(in, header) || header != csvHeader(m_columns)) {
+            return false;
+        }
+
+        std::vector<std::string> kept;
+        for (std::string line; std::getline(in, line);) {
+            std::istringstream fields(line);
+            int64_t step = 0;
+            if (fields >> step && step <= keepUpToStep) {
+                kept.push_back(line);
+                m_lastKeptStep = step;
+            }
+        }
+        in.close();
+
+        std::ofstream out(m_path, std::ios::trunc);
+        out << header << '\n';
+        for (const std::string& line : kept) {
+            out << line << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    // Binary: check the header, then cut after the last record to keep
+    char magic[sizeof(kBinaryMagic)];
+    uint32_t columnCount = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kBinaryMagic, sizeof(magic)) != 0 ||
+        !readValue(in, columnCount) || columnCount != m_columns.size()) {
+        return false;
+    }
+    for (const std::string& column : m_columns) {
+        uint32_t length = 0;
+        std::string name;
+        if (!readValue(in, length) || length != column.size()) {
+            return false;
+        }
+        name.resize(length);
+        if (!in.read(name.data(), length) || name != column) {
+            return false;
+        }
+    }
+
+    const std::streamoff headerSize = in.tellg();
+    const std::streamoff recordSize = static_cast<std::streamoff>(columnCount * sizeof(double));
+    std::streamoff keptSize = headerSize;
+    std::vector<double> record(columnCount);
+    while (in.read(reinterpret_cast<char*>(record.data()), recordSize)) {
+        const int64_t step = static_cast<int64_t>(record[0]);
+        if (step > keepUpToStep) {
+            break;
+        }
+        keptSize += recordSize;
+        m_lastKeptStep = step;
+    }
+    in.close();
+
+    std::error_code error;
+    std::filesystem::resize_file(m_path, static_cast<std::uintmax_t>(keptSize), error);
+    return !error;
+}
+
+// Write the file header
+void ObservableWriter::writeHeader() {
+    if (m_format == Format::Csv) {
+        m_file << csvHeader(m_columns) << '\n';
+        return;
+    }
+
+    m_file.write(kBinaryMagic, sizeof(kBinaryMagic));
+    writeValue(m_file, static_cast<uint32_t>(m_columns.size()));
+    for (const std::string& column : m_columns) {
+        writeValue(m_file, static_cast<uint32_t>(column.size()));
+        m_file.write(column.data(), static_cast<std::streamsize>(column.size()));
+    }
+}
+
+// Write one sample
+void ObservableWriter::writeSample(const ObservableSample& sample) {
+    std::vector<double> values = sampleValues(sample);
+    values.resize(m_columns.size(), 0.0);  // Guard against a mismatched region or label count
+
+    if (m_format == Format::Binary) {
+        m_file.write(reinterpret_cast<const char*>(values.data()),
+                     static_cast<std::streamsize>(values.size() * sizeof(double)));
+        return;
+    }
+
+    m_file << sample.step;
+    for (size_t i = 1; i < values.size(); ++i) {
+        m_file << ',' << values[i];
+    }
+    m_file << '\n';
+}
+
+// Queue a sample for writing
+bool ObservableWriter::push(const ObservableSample& sample) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopRequested || m_count == m_queue.size()) {
+            ++m_dropped;
+            return false;
+        }
+        m_queue[(m_head + m_count) % m_queue.size()] = sample;
+        ++m_count;
+    }
+    m_condition.notify_one();
+    return true;
+}
+
+// Write the remaining samples, close the file and stop the thread
+void ObservableWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+        m_file.close();
+        if (m_dropped > 0) {
+            DEBUG_LOG("Observables", "Dropped " + std::to_string(m_dropped) + " samples for " + m_path);
+        }
+    }
+
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// Get the number of samples dropped because the queue was full
+size_t ObservableWriter::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+// Writer thread main loop
+void ObservableWriter::threadMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this]() { return m_stopRequested || m_count > 0; });
+        if (m_count == 0) {
+            break;  // Stop requested and the queue is drained
+        }
+
+        ObservableSample sample = std::move(m_queue[m_head]);
+        m_head = (m_head + 1) % m_queue.size();
+        --m_count;
+        const bool drained = m_count == 0;
+        lock.unlock();
+
+        writeSample(sample);
+        if (drained) {
+            m_file.flush();  // Keep the file current while the solver runs
+        }
+
+        lock.lock();
+    }
+
+    if (!m_file && !m_error) {
+        m_error = std::make_exception_ptr(std::runtime_error("Failed while writing " + m_path));
+    }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/PhysicsConfig.h"
+
+/**
+ * @struct ObservableSample
+ * @brief Observables of the wavefunction at one point in time
+ *
+ * Expectation values are normalized by the current norm, so they stay
+ * meaningful when probability leaves the domain.
+ */
+struct ObservableSample {
+    int64_t step = 0;               ///< Step number (set by the caller)
+    double time = 0.0;              ///< Simulation time
+    double totalProbability = 0.0;  ///< ∫|ψ|² over the domain
+    double absorbedProbability = 0.0;  ///< Probability removed by the absorbing layer so far
+    double x = 0.0;                 ///< ⟨x⟩
+    double y = 0.0;                 ///< ⟨y⟩
+    double px = 0.0;                ///< ⟨p_x⟩
+    double py = 0.0;                ///< ⟨p_y⟩
+    double kineticEnergy = 0.0;     ///< ⟨p²/2⟩
+    double potentialEnergy = 0.0;   ///< ⟨V⟩
+    double energy = 0.0;            ///< ⟨H⟩ = kinetic + potential
+    double wallSeconds = 0.0;       ///< Wall-clock solver time at the sample (set by the caller)
+    std::vector<double> regions;    ///< Probability inside each configured region, in order
+    std::vector<double> labels;     ///< Values of the writer's label columns (set by the caller)
+};
+
+/**
+ * @class ObservableWriter
+ * @brief Streams observable samples to a file from a background thread
+ *
+ * push() copies the sample into a bounded queue and returns immediately;
+ * formatting and file I/O happen on the writer thread. When the queue is
+ * full the sample is dropped and counted rather than blocking the caller.
+ *
+ * Formats:
+ * - CSV: header line with the column names, then one row per sample
+ * - Binary (little-endian): the magic "QMOBS001", a uint32 column count,
+ *   each column name as a uint32 length plus bytes, then one record of
+ *   column-count float64 values per sample
+ *
+ * Columns: step, time, total_probability, x_mean, y_mean, px_mean, py_mean,
+ * kinetic_energy, potential_energy, energy, wall_seconds,
+ * absorbed_probability, then one
+ * region_<name> column per region, then the label columns (e.g. the run
+ * number and swept parameters of a sweep).
+ */
+class ObservableWriter {
+public:
+    /**
+     * @enum Format
+     * @brief Output file format
+     */
+    enum class Format {
+        Csv,
+        Binary
+    };
+
+    /**
+     * @brief Parse a format name
+     * @param name "csv" or "binary"
+     * @return The matching format
+     * @throws std::invalid_argument if name is not recognized
+     */
+    static Format parseFormat(const std::string& name);
+
+    /**
+     * @brief Get the usual file extension of a format
+     * @param format Output format
+     * @return ".csv" or ".bin"
+     */
+    static const char* extension(Format format);
+
+    /**
+     * @brief Get the column names written for a set of regions
+     * @param regions Regions whose probabilities are recorded
+     * @param labelColumns Names of the trailing label columns
+     * @return Column names in file order
+     */
+    static std::vector<std::string> columnNames(const std::vector<ObservableRegion>& regions,
+                                                const std::vector<std::string>& labelColumns = {});
+
+    /**
+     * @brief Open the output file and start the writer thread
+     *
+     * With keepUpToStep >= 0 an existing file with the same columns is
+     * kept up to and including that step and appended to, so a resumed run
+     * continues the series of the interrupted one.
+     *
+     * @param path Output file
+     * @param format Output format
+     * @param regions Regions whose probabilities the samples carry
+     * @param capacity Maximum number of queued samples
+     * @param keepUpToStep Last step to keep from an existing file (-1 = truncate)
+     * @param labelColumns Names of the label columns; samples carry one label value per name
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    ObservableWriter(const std::string& path, Format format, const std::vector<ObservableRegion>& regions,
+                     size_t capacity = 1024, int64_t keepUpToStep = -1,
+                     const std::vector<std::string>& labelColumns = {});
+
+    /**
+     * @brief Write the remaining samples and stop the writer thread
+     */
+    ~ObservableWriter();
+
+    ObservableWriter(const ObservableWriter&) = delete;
+    ObservableWriter& operator=(const ObservableWriter&) = delete;
+
+    /**
+     * @brief Queue a sample for writing
+     * @param sample Sample to write; must carry one value per region and label column
+     * @return False if the queue was full and the sample was dropped
+     */
+    bool push(const ObservableSample& sample);
+
+    /**
+     * @brief Write the remaining samples, close the file and stop the thread
+     * @throws std::runtime_error if writing failed
+     */
+    void close();
+
+    /**
+     * @brief Get the last step kept from an existing file
+     * @return Step of the last kept sample, or -1 if none was kept
+     */
+    int64_t getLastKeptStep() const { return m_lastKeptStep; }
+
+    /**
+     * @brief Get the number of samples dropped because the queue was full
+     * @return Dropped sample count
+     */
+    size_t getDroppedCount() const;
+
+private:
+    /**
+     * @brief Keep the samples of an existing file up to a step
+     * @param keepUpToStep Last step to keep
+     * @return True if the file was kept and should be appended to
+     */
+    bool keepExisting(int64_t keepUpToStep);
+
+    /**
+     * @brief Write the file header
+     */
+    void writeHeader();
+
+    /**
+     * @brief Write one sample
+     * @param sample Sample to write
+     */
+    void writeSample(const ObservableSample& sample);
+
+    /**
+     * @brief Writer thread main loop
+     */
+    void threadMain();
+
+    std::string m_path;                  ///< Output file
+    Format m_format;                     ///< Output format
+    std::vector<std::string> m_columns;  ///< Column names
+    std::ofstream m_file;                ///< Output stream (writer thread only)
+    int64_t m_lastKeptStep = -1;         ///< Last step kept from an existing file
+
+    mutable std::mutex m_mutex;              ///< Guards the queue and flags
+    std::condition_variable m_condition;     ///< Signals queued samples and stop
+    std::vector<ObservableSample> m_queue;   ///< Ring buffer of pending samples
+    size_t m_head = 0;                       ///< Index of the oldest pending sample
+    size_t m_count = 0;                      ///< Number of pending samples
+    size_t m_dropped = 0;                    ///< Samples dropped because the queue was full
+    bool m_stopRequested = false;            ///< Writer thread should drain and exit
+    std::exception_ptr m_error;              ///< Write failure, reported by close()
+
+    std::thread m_thread;  ///< The writer thread
+};
@@ -1,253 +1,965 @@
 #include "SimulationEngine.h"
+#include "ComplexKernels.h"
+#include "FFTWWisdom.h"
+#include "SolverDetail.h"
 #include <fftw3.h>
+#include <algorithm>
 #include <cmath>
-#include <iostream>
+#include <iterator>
+#include <random>
 #include <stdexcept>
+#include <type_traits>
 #include "../core/Events.h"
 #include "../core/DebugUtils.h"
+#include "../core/Metrics.h"
+#include "../core/Trace.h"
+
+using solver_detail::FFTW;
+using solver_detail::findStage;
+using solver_detail::forEachBlock;
+using solver_detail::kKernelBlock;
+using solver_detail::resolveThreadCount;
 
 // Constructor
-SimulationEngine::SimulationEngine(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus)
+template <typename Real>
+BasicSimulationEngine<Real>::BasicSimulationEngine(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus,
+                                                   std::shared_ptr<AsyncEventQueue> eventQueue)
     : m_nx(config.nx), 
       m_ny(config.ny),
-      m_lx(20.0),  // Default domain size (can be made configurable later)
-      m_ly(20.0),
+      m_lx(config.lx),
+      m_ly(config.ly),
       m_dt(config.dt),
       m_currentTime(0.0),
-      m_wavefunction(config.nx, config.ny),
+      m_numThreads(resolveThreadCount(config.numThreads)),
+      m_plannerFlags(FFTWWisdom::plannerFlags(config.fftw.planner)),
+      m_wisdomDir(config.fftw.wisdomDir),
+      m_wavefunction(0, 0),
       m_wavepacket(config.wavepacket),  // Store the wavepacket configuration
+      m_potentialConfig(config.potential),
+      m_absorber(config.absorber),
+      m_integration(config.integration),
+      m_regions(config.output.regions),
       m_kx(config.nx),
       m_ky(config.ny),
-      m_eventBus(eventBus)
+      m_eventBus(eventBus),
+      m_eventQueue(eventQueue),
+      m_eventPool(eventQueue ? std::make_shared<EventPool>() : nullptr)
 {
+    if (!(m_lx > 0.0) || !(m_ly > 0.0)) {
+        throw std::invalid_argument("Domain lengths must be positive");
+    }
+    m_scheme = &SplittingScheme::fromName(m_integration.scheme);
+    
     // Calculate grid spacing
     m_dx = m_lx / m_nx;
     m_dy = m_ly / m_ny;
+    
+    // Fresh grid buffers are first-touched by the solver's own thread team
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    m_wavefunction.resize(m_nx, m_ny);
 
     // Set up the potential using the factory method
-    m_potential = Potential::create(config.potential.type, config.potential.parameters);
+    m_potential = Potential::create(config.potential, m_lx, m_ly);
 
+    // Set up FFTW plans first, since measuring planners overwrite the arrays
+    initializeFFTWPlans();
+    
     // Initialize wavefunction with a Gaussian wavepacket
     initializeWavefunction();
     
-    // Set up FFTW plans
-    initializeFFTWPlans();
-    
     // Precompute k-space grid
-    // For FFT, the k-grid is arranged as [0, 1, 2, ..., N/2-1, -N/2, -N/2+1, ..., -1]
-    for (int i = 0; i < m_nx; ++i) {
-        if (i <= m_nx / 2) {
-            m_kx[i] = 2.0 * M_PI * i / m_lx;
-        } else {
-            m_kx[i] = 2.0 * M_PI * (i - m_nx) / m_lx;
-        }
-    }
+    initializeKSpaceGrid();
     
-    for (int j = 0; j < m_ny; ++j) {
-        if (j <= m_ny / 2) {
-            m_ky[j] = 2.0 * M_PI * j / m_ly;
-        } else {
-            m_ky[j] = 2.0 * M_PI * (j - m_ny) / m_ly;
-        }
-    }
+    // Precompute the operator phase tables used by every step
+    rebuildPhaseTables();
     
     // Publish application started event
-    if (m_eventBus) {
-        m_eventBus->publish(makeEvent<SimulationStartedEvent>());
+    if (hasEventSink()) {
+        publishEvent(makeEvent<SimulationStartedEvent>());
         DEBUG_LOG("SimulationEngine", "Published SimulationStarted event");
     }
 }
 
 // Destructor
-SimulationEngine::~SimulationEngine() {
+template <typename Real>
+BasicSimulationEngine<Real>::~BasicSimulationEngine() {
     cleanupFFTWPlans();
 }
 
 // Initialize wavefunction based on current configuration
-void SimulationEngine::initializeWavefunction() {
+template <typename Real>
+void BasicSimulationEngine<Real>::initializeWavefunction() {
     DEBUG_LOG("SimulationEngine", "Initializing wavefunction with potential type: " + 
               (m_potential ? m_potential->getType() : "NULL"));
     
-    // Debug output
-    std::cout << "Initializing wavefunction. Potential type: " << (m_potential ? m_potential->getType() : "NULL") << std::endl;
-    
     // Use stored wavepacket parameters
-    std::string wavepacketParams = "x0=" + std::to_string(m_wavepacket.x0) + 
-                                  ", y0=" + std::to_string(m_wavepacket.y0) + 
-                                  ", sigmaX=" + std::to_string(m_wavepacket.sigmaX) + 
-                                  ", sigmaY=" + std::to_string(m_wavepacket.sigmaY) + 
-                                  ", kx=" + std::to_string(m_wavepacket.kx) + 
-                                  ", ky=" + std::to_string(m_wavepacket.ky);
-    DEBUG_LOG("SimulationEngine", "Using wavepacket parameters: " + wavepacketParams);
-    
-    std::cout << "Using wavepacket parameters: x0=" << m_wavepacket.x0 
-              << ", y0=" << m_wavepacket.y0 
-              << ", sigmaX=" << m_wavepacket.sigmaX 
-              << ", sigmaY=" << m_wavepacket.sigmaY
-              << ", kx=" << m_wavepacket.kx
-              << ", ky=" << m_wavepacket.ky << std::endl;
+    DEBUG_LOG("SimulationEngine", "Using wavepacket parameters: x0=" + std::to_string(m_wavepacket.x0) + 
+              ", y0=" + std::to_string(m_wavepacket.y0) + 
+              ", sigmaX=" + std::to_string(m_wavepacket.sigmaX) + 
+              ", sigmaY=" + std::to_string(m_wavepacket.sigmaY) + 
+              ", kx=" + std::to_string(m_wavepacket.kx) + 
+              ", ky=" + std::to_string(m_wavepacket.ky));
     
     m_wavefunction.initializeGaussian(
         m_wavepacket.x0, m_wavepacket.y0,         // Center position
         m_wavepacket.sigmaX, m_wavepacket.sigmaY, // Width in x and y directions
         m_wavepacket.kx, m_wavepacket.ky,         // Momentum in x and y directions
-        m_lx, m_ly                                // Domain size
+        m_lx, m_ly,                               // Domain size
+        m_numThreads
     );
     
     m_currentTime = 0.0;
+    m_initialNorm = getTotalProbability();
+    preparePotential(m_currentTime);
 }
 
 // Initialize FFTW plans
-void SimulationEngine::initializeFFTWPlans() {
+template <typename Real>
+void BasicSimulationEngine<Real>::initializeFFTWPlans() {
     // Debug output and safety checks
+    TRACE_SCOPE("FFTW planning", "solver");
     DEBUG_LOG("SimulationEngine", "Initializing FFTW plans with grid size: " + std::to_string(m_nx) + " x " + std::to_string(m_ny));
-    std::cout << "Initializing FFTW plans with grid size: " << m_nx << " x " << m_ny << std::endl;
     
     if (m_wavefunction.data() == nullptr) {
-        DEBUG_LOG("SimulationEngine", "ERROR: Wavefunction data is null!");
-        std::cerr << "ERROR: Wavefunction data is null!" << std::endl;
+        ERROR_LOG("SimulationEngine", "Wavefunction data is null!");
         throw std::runtime_error("Null wavefunction data in initializeFFTWPlans");
     }
     
-    std::cout << "Wavefunction data address: " << m_wavefunction.data() << std::endl;
+    // FFTW's planner and wisdom are shared by every engine in the process
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+    
+    const int planThreads = solver_detail::preparePlannerThreads<Real>(m_numThreads);
+    
+    // Reuse measurements from earlier runs with the same grid and settings
+    const FFTWWisdom::Key wisdomKey{ m_nx, m_ny, FFTW<Real>::precision, planThreads, m_plannerFlags };
+    const bool haveWisdom = FFTWWisdom::load(m_wisdomDir, wisdomKey);
     
     try {
         // Create plans for forward and backward FFTs
         DEBUG_LOG("SimulationEngine", "Creating forward FFTW plan");
-        std::cout << "Creating forward FFTW plan..." << std::endl;
-        m_forwardPlan = fftw_plan_dft_2d(
-            m_nx, m_ny,
-            reinterpret_cast<fftw_complex*>(m_wavefunction.data()),
-            reinterpret_cast<fftw_complex*>(m_wavefunction.data()),
-            FFTW_FORWARD, FFTW_MEASURE
-        );
+        // Storage is row-major with x fastest, so y is FFTW's slow (first) dimension
+        m_forwardPlan = FFTW<Real>::planDft2d(m_ny, m_nx, m_wavefunction.data(), FFTW_FORWARD, m_plannerFlags);
         
         DEBUG_LOG("SimulationEngine", "Creating backward FFTW plan");
-        std::cout << "Creating backward FFTW plan..." << std::endl;
-        m_backwardPlan = fftw_plan_dft_2d(
-            m_nx, m_ny,
-            reinterpret_cast<fftw_complex*>(m_wavefunction.data()),
-            reinterpret_cast<fftw_complex*>(m_wavefunction.data()),
-            FFTW_BACKWARD, FFTW_MEASURE
-        );
+        m_backwardPlan = FFTW<Real>::planDft2d(m_ny, m_nx, m_wavefunction.data(), FFTW_BACKWARD, m_plannerFlags);
+        
+        // The observables transform a copy of ψ; planning it here keeps it on
+        // this engine's thread count and out of the first timed sample
+        DEBUG_LOG("SimulationEngine", "Creating observable FFTW plan");
+        resizeGrid(m_observableScratch, m_wavefunction.size());
+        m_observablePlan = FFTW<Real>::planDft2d(m_ny, m_nx, m_observableScratch.data(), FFTW_FORWARD, m_plannerFlags);
         
-        if (!m_forwardPlan || !m_backwardPlan) {
-            DEBUG_LOG("SimulationEngine", "Failed to create FFTW plans!");
-            std::cerr << "Failed to create FFTW plans!" << std::endl;
+        if (!m_forwardPlan || !m_backwardPlan || !m_observablePlan) {
+            ERROR_LOG("SimulationEngine", "Failed to create FFTW plans!");
             throw std::runtime_error("Failed to create FFTW plans");
         }
         
         DEBUG_LOG("SimulationEngine", "FFTW plans created successfully");
-        std::cout << "FFTW plans created successfully." << std::endl;
+        
+        if (!haveWisdom) {
+            FFTWWisdom::save(m_wisdomDir, wisdomKey);
+        }
     }
     catch (const std::exception& e) {
-        std::cerr << "Exception during FFTW plan creation: " << e.what() << std::endl;
+        ERROR_LOG("SimulationEngine", std::string("Exception during FFTW plan creation: ") + e.what());
         throw;
     }
 }
 
 // Clean up FFTW plans
-void SimulationEngine::cleanupFFTWPlans() {
+template <typename Real>
+void BasicSimulationEngine<Real>::cleanupFFTWPlans() {
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
     if (m_forwardPlan) {
-        fftw_destroy_plan(m_forwardPlan);
+        FFTW<Real>::destroy(m_forwardPlan);
         m_forwardPlan = nullptr;
     }
     
     if (m_backwardPlan) {
-        fftw_destroy_plan(m_backwardPlan);
+        FFTW<Real>::destroy(m_backwardPlan);
         m_backwardPlan = nullptr;
     }
+    
+    if (m_observablePlan) {
+        FFTW<Real>::destroy(m_observablePlan);
+        m_observablePlan = nullptr;
+    }
+    m_observableScratch.clear();
+    m_observableScratch.shrink_to_fit();
 }
 
-// Apply the potential energy operator in position space
-void SimulationEngine::applyPotentialOperator() {
-    // Apply the potential operator exp(-i*V*dt/2)
+// Compute the k-space grid values
+template <typename Real>
+void BasicSimulationEngine<Real>::initializeKSpaceGrid() {
+    // For FFT, the k-grid is arranged as [0, 1, 2, ..., N/2-1, -N/2, -N/2+1, ..., -1]
     for (int i = 0; i < m_nx; ++i) {
-        for (int j = 0; j < m_ny; ++j) {
-            // Calculate position in physical space
-            double x = -m_lx/2 + i * m_dx;
-            double y = -m_ly/2 + j * m_dy;
-            
-            // Get potential value at this position
-            double v = m_potential->getValue(x, y);
-            
-            // Calculate phase factor
-            std::complex<double> phase(0.0, -m_dt * v / 2.0);
-            
-            // Apply phase factor to wavefunction
-            m_wavefunction(i, j) *= std::exp(phase);
+        if (i <= m_nx / 2) {
+            m_kx[i] = 2.0 * M_PI * i / m_lx;
+        } else {
+            m_kx[i] = 2.0 * M_PI * (i - m_nx) / m_lx;
+        }
+    }
+    
+    for (int j = 0; j < m_ny; ++j) {
+        if (j <= m_ny / 2) {
+            m_ky[j] = 2.0 * M_PI * j / m_ly;
+        } else {
+            m_ky[j] = 2.0 * M_PI * (j - m_ny) / m_ly;
         }
     }
 }
 
-// Apply the kinetic energy operator in k-space
-void SimulationEngine::applyKineticOperator() {
-    // Transform to k-space
-    fftw_execute(m_forwardPlan);
+// Rebuild all cached operator tables
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildPhaseTables() {
+    rebuildPotentialPhaseTable();
+    rebuildKineticPhaseTable();
+}
+
+// Rebuild the cached potential phase table exp(-i*V*dt/2)
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildPotentialPhaseTable() {
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    const size_t size = static_cast<size_t>(m_nx) * m_ny;
+    resizeGrid(m_potentialPhase, size);
+    resizeGrid(m_potentialValues, size);
+    m_couplingValues.clear();
+    m_shapePhase.clear();
+    m_shapeValues.clear();
+    m_potentialTime = std::numeric_limits<double>::quiet_NaN();
+    rebuildAbsorberMask();
+    
+    // Free space if no potential is set. Static parts are tabulated here
+    // once; only the time-dependent part is updated per step
+    if (!m_potential) {
+        m_potentialMode = PotentialMode::Static;
+        tabulatePotential(FreeSpacePotential(), m_potentialPhase.data(), m_potentialValues.data());
+    }
+    else if (!m_potential->isTimeDependent()) {
+        m_potentialMode = PotentialMode::Static;
+        tabulatePotential(*m_potential, m_potentialPhase.data(), m_potentialValues.data());
+    }
+    else if (const DrivenPotential* driven = solver_detail::tabulatedDrive(*m_potential)) {
+        m_potentialMode = PotentialMode::Driven;
+        tabulatePotential(driven->getBase(), m_potentialPhase.data(), m_potentialValues.data());
+        resizeGrid(m_couplingValues, size);
+        tabulatePotential(driven->getCoupling(), nullptr, m_couplingValues.data(), false);
+    }
+    else if (const MovingPotential* moving = solver_detail::tabulatedShape(*m_potential)) {
+        m_potentialMode = PotentialMode::Moving;
+        resizeGrid(m_shapePhase, size);
+        resizeGrid(m_shapeValues, size);
+        // The absorber stays at the edges, so it is applied after shifting
+        tabulatePotential(moving->getShape(), m_shapePhase.data(), m_shapeValues.data(), false);
+    }
+    else {
+        m_potentialMode = PotentialMode::Sampled;
+    }
+    
+    preparePotential(m_currentTime);
+    rebuildPotentialStageTables();
+}
+
+// Tabulate exp(-i*a*V*dt) for the potential stage weights of the integrator
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildPotentialStageTables() {
+    m_potentialStages.clear();
+    
+    // Time-dependent potentials are applied from their values at each stage
+    if (m_scheme->isStrang() || m_potentialMode != PotentialMode::Static) {
+        return;
+    }
+    
+    // 1/2 and 1 are served by the Strang tables
+    std::vector<double> weights = solver_detail::potentialStageWeights(*m_scheme);
+    weights.erase(std::remove_if(weights.begin(), weights.end(),
+                                 [](double weight) { return weight == 0.5 || weight == 1.0; }),
+                  weights.end());
+    const Real* values = m_potentialValues.data();
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_potentialValues.size());
+    solver_detail::buildStageTables(m_potentialStages, weights, [&](double weight) {
+        GridVector<Complex> phase(static_cast<size_t>(size));
+        Complex* table = phase.data();
+        
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < size; ++n) {
+            const double damping = mask ? std::pow(mask[n], 2.0 * weight) : 1.0;
+            table[n] = Complex(std::polar(damping, -weight * m_dt * values[n]));
+        }
+        return phase;
+    });
+}
+
+// Rebuild the damping exp(-W*dt/2) of the absorbing layer
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildAbsorberMask() {
+    solver_detail::buildAbsorberMask(m_absorber, m_nx, m_ny, m_lx, m_ly, m_dt, m_numThreads, m_absorberMask);
+}
+
+// Recompute the half-step phases from the tabulated potential values
+template <typename Real>
+void BasicSimulationEngine<Real>::rephasePotentialTables() {
+    rebuildAbsorberMask();
+
+    // Static and driven potentials keep V (or its static part) in the values
+    // table; moving ones keep the unshifted shape, without the absorber
+    const bool moving = m_potentialMode == PotentialMode::Moving;
+    if (m_potentialMode != PotentialMode::Sampled) {
+        const Real* values = moving ? m_shapeValues.data() : m_potentialValues.data();
+        Complex* phase = moving ? m_shapePhase.data() : m_potentialPhase.data();
+        const double* mask = moving || m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+        const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_potentialValues.size());
+
+        #pragma omp parallel for num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < size; ++n) {
+            phase[n] = Complex(std::polar(mask ? mask[n] : 1.0, -m_dt * static_cast<double>(values[n]) / 2.0));
+        }
+    }
+
+    // Time-dependent tables are brought up to date at the current time again
+    m_potentialTime = std::numeric_limits<double>::quiet_NaN();
+    preparePotential(m_currentTime);
+    rebuildPotentialStageTables();
+}
+
+// Sample a potential on the grid with its half-step phases
+template <typename Real>
+void BasicSimulationEngine<Real>::tabulatePotential(const Potential& potential, Complex* phase, Real* values,
+                                                    bool absorb) const {
+    GridGeometry grid;
+    grid.nx = m_nx;
+    grid.ny = m_ny;
+    grid.x0 = -m_lx/2;
+    grid.y0 = -m_ly/2;
+    grid.dx = m_dx;
+    grid.dy = m_dy;
+    
+    // One virtual call per row; the potential fills the row in a batch
+    solver_detail::sampleRows(potential, grid, m_numThreads, [&](int j, const double* row) {
+        Real* valueRow = values + static_cast<size_t>(j) * m_nx;
+        for (int i = 0; i < m_nx; ++i) {
+            valueRow[i] = static_cast<Real>(row[i]);
+        }
+        if (phase) {
+            Complex* phaseRow = phase + static_cast<size_t>(j) * m_nx;
+            const double* mask = absorb && !m_absorberMask.empty()
+                                     ? m_absorberMask.data() + static_cast<size_t>(j) * m_nx : nullptr;
+            for (int i = 0; i < m_nx; ++i) {
+                phaseRow[i] = Complex(std::polar(mask ? mask[i] : 1.0, -m_dt * row[i] / 2.0));
+            }
+        }
+    });
+}
+
+// Update the time-dependent part of the potential tables
+template <typename Real>
+void BasicSimulationEngine<Real>::preparePotential(double time) {
+    // Consecutive half steps at the same time share one update
+    if (m_potentialMode == PotentialMode::Static || time == m_potentialTime) {
+        return;
+    }
+    TRACE_SCOPE("V(t)", "solver");
+    
+    switch (m_potentialMode) {
+        case PotentialMode::Driven:
+            m_driveAmplitude = static_cast<const DrivenPotential&>(*m_potential).getDrive(time);
+            break;
+        case PotentialMode::Moving: {
+            double offsetX = 0.0;
+            double offsetY = 0.0;
+            static_cast<const MovingPotential&>(*m_potential).getOffset(time, offsetX, offsetY);
+            shiftPotential(offsetX / m_dx, offsetY / m_dy);
+            break;
+        }
+        case PotentialMode::Sampled:
+            m_potential->setTime(time);
+            tabulatePotential(*m_potential, m_potentialPhase.data(), m_potentialValues.data());
+            break;
+        case PotentialMode::Static:
+            break;
+    }
+    m_potentialTime = time;
+}
+
+// Copy the shape tables shifted by (shiftX, shiftY) cells, wrapping around the periodic domain
+template <typename Real>
+void BasicSimulationEngine<Real>::shiftPotential(double shiftX, double shiftY) {
+    // Whole-cell offsets move the tables without computing anything
+    constexpr double kWholeCell = 1e-6;
+    const double cellsX = std::floor(shiftX + kWholeCell);
+    const double cellsY = std::floor(shiftY + kWholeCell);
+    const double fx = std::max(shiftX - cellsX, 0.0);
+    const double fy = std::max(shiftY - cellsY, 0.0);
+    const bool whole = fx < kWholeCell && fy < kWholeCell;
+    
+    // Source column and row of destination index 0, in [0, n)
+    const int nx = m_nx;
+    const int ny = m_ny;
+    const int column0 = static_cast<int>(((-static_cast<long long>(cellsX)) % nx + nx) % nx);
+    const int row0 = static_cast<int>(((-static_cast<long long>(cellsY)) % ny + ny) % ny);
+    
+    const Complex* shapePhase = m_shapePhase.data();
+    const Real* shapeValues = m_shapeValues.data();
+    const double* absorberMask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    Complex* phase = m_potentialPhase.data();
+    Real* values = m_potentialValues.data();
+    
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int j = 0; j < ny; ++j) {
+        const size_t source = static_cast<size_t>((row0 + j) % ny) * nx;
+        const size_t destination = static_cast<size_t>(j) * nx;
+        const double* mask = absorberMask ? absorberMask + destination : nullptr;
+        
+        if (whole) {
+            const size_t head = static_cast<size_t>(nx - column0);
+            std::copy(shapePhase + source + column0, shapePhase + source + nx, phase + destination);
+            std::copy(shapePhase + source, shapePhase + source + column0, phase + destination + head);
+            std::copy(shapeValues + source + column0, shapeValues + source + nx, values + destination);
+            std::copy(shapeValues + source, shapeValues + source + column0, values + destination + head);
+            if (mask) {
+                for (int i = 0; i < nx; ++i) {
+                    phase[destination + i] *= static_cast<Real>(mask[i]);
+                }
+            }
+            continue;
+        }
+        
+        // Fractional offsets interpolate W between the neighbouring cells
+        // rather than evaluating the potential again
+        const size_t below = static_cast<size_t>((row0 + j - 1 + ny) % ny) * nx;
+        for (int i = 0; i < nx; ++i) {
+            const int i1 = (column0 + i) % nx;
+            const int i0 = (i1 - 1 + nx) % nx;
+            const double upper = (1.0 - fx) * shapeValues[source + i1] + fx * shapeValues[source + i0];
+            const double lower = (1.0 - fx) * shapeValues[below + i1] + fx * shapeValues[below + i0];
+            const double v = (1.0 - fy) * upper + fy * lower;
+            values[destination + i] = static_cast<Real>(v);
+            phase[destination + i] = Complex(std::polar(mask ? mask[i] : 1.0, -m_dt * v / 2.0));
+        }
+    }
+}
+
+// Rebuild the cached kinetic phase table exp(-i*K*dt)/(nx*ny)
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildKineticPhaseTable() {
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    resizeGrid(m_kineticPhase, static_cast<size_t>(m_nx) * m_ny);
+    
+    // FFTW does not normalize, so the 1/(nx*ny) factor is folded in here
+    double normFactor = 1.0 / (static_cast<double>(m_nx) * m_ny);
     
-    // Apply the kinetic operator exp(-i*K*dt) in k-space
     // K = (kx^2 + ky^2)/2 in scaled units (ħ=1, m=1)
-    for (int i = 0; i < m_nx; ++i) {
-        for (int j = 0; j < m_ny; ++j) {
-            // Get k-values at this point
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int j = 0; j < m_ny; ++j) {
+        double ky2 = m_ky[j] * m_ky[j];
+        Complex* phaseRow = m_kineticPhase.data() + static_cast<size_t>(j) * m_nx;
+        for (int i = 0; i < m_nx; ++i) {
             double kx2 = m_kx[i] * m_kx[i];
-            double ky2 = m_ky[j] * m_ky[j];
-            
-            // Calculate kinetic energy
             double k = (kx2 + ky2) / 2.0;
             
-            // Calculate phase factor
-            std::complex<double> phase(0.0, -m_dt * k);
-            
-            // Apply phase factor to wavefunction in k-space
-            m_wavefunction(i, j) *= std::exp(phase);
+            phaseRow[i] = Complex(std::polar(normFactor, -m_dt * k));
         }
     }
     
-    // Transform back to position space
-    fftw_execute(m_backwardPlan);
-    
-    // Normalize the result (FFTW does not normalize)
-    double norm_factor = 1.0 / (m_nx * m_ny);
-    for (int i = 0; i < m_nx; ++i) {
+    // One table per further kinetic weight of the integrator
+    std::vector<double> weights;
+    std::copy_if(m_scheme->b.begin(), m_scheme->b.end(), std::back_inserter(weights),
+                 [](double weight) { return weight != 1.0; });
+    m_kineticStages.clear();
+    solver_detail::buildStageTables(m_kineticStages, weights, [&](double weight) {
+        GridVector<Complex> phase(m_kineticPhase.size());
+        #pragma omp parallel for num_threads(m_numThreads)
         for (int j = 0; j < m_ny; ++j) {
-            m_wavefunction(i, j) *= norm_factor;
+            double ky2 = m_ky[j] * m_ky[j];
+            Complex* phaseRow = phase.data() + static_cast<size_t>(j) * m_nx;
+            for (int i = 0; i < m_nx; ++i) {
+                double k = (m_kx[i] * m_kx[i] + ky2) / 2.0;
+                phaseRow[i] = Complex(std::polar(normFactor, -weight * m_dt * k));
+            }
+        }
+        return phase;
+    });
+}
+
+// Apply the potential energy operator in position space
+template <typename Real>
+void BasicSimulationEngine<Real>::applyPotentialOperator(double time) {
+    preparePotential(time);
+    TRACE_SCOPE("V/2", "solver");
+    METRICS_SCOPE(MetricStage::Potential, 3 * m_wavefunction.size() * sizeof(Complex));
+    
+    if (m_potentialMode == PotentialMode::Driven) {
+        applyDrivenPotentialOperator(false);
+        return;
+    }
+    
+    // Apply the cached potential operator exp(-i*V*dt/2)
+    Complex* psi = m_wavefunction.data();
+    const Complex* phase = m_potentialPhase.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_potentialPhase.size());
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        kernels::multiply(psi + begin, phase + begin, count);
+    });
+}
+
+// Apply a full potential step exp(-i*V*dt) in position space
+template <typename Real>
+void BasicSimulationEngine<Real>::applyFullPotentialOperator(double time) {
+    preparePotential(time);
+    TRACE_SCOPE("V", "solver");
+    METRICS_SCOPE(MetricStage::Potential, 3 * m_wavefunction.size() * sizeof(Complex));
+    
+    if (m_potentialMode == PotentialMode::Driven) {
+        applyDrivenPotentialOperator(true);
+        return;
+    }
+    
+    // Squaring the cached half phase costs less than streaming a second table
+    Complex* psi = m_wavefunction.data();
+    const Complex* phase = m_potentialPhase.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_potentialPhase.size());
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        kernels::multiplySquared(psi + begin, phase + begin, count);
+    });
+}
+
+// Apply exp(-i*V0*tau) * exp(-i*f*V1*tau) in one pass over ψ
+template <typename Real>
+void BasicSimulationEngine<Real>::applyDrivenPotentialOperator(bool squared) {
+    Complex* psi = m_wavefunction.data();
+    const Complex* phase = m_potentialPhase.data();
+    const Real* coupling = m_couplingValues.data();
+    const Real angle = static_cast<Real>(-m_driveAmplitude * m_dt * (squared ? 1.0 : 0.5));
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_potentialPhase.size());
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        for (size_t n = static_cast<size_t>(begin); n < static_cast<size_t>(begin) + count; ++n) {
+            const Complex base = squared ? phase[n] * phase[n] : phase[n];
+            psi[n] *= base * std::polar(Real(1), angle * coupling[n]);
+        }
+    });
+}
+
+// Apply exp(-i*a*V*dt) for one stage weight of the integrator
+template <typename Real>
+void BasicSimulationEngine<Real>::applyPotentialStage(double weight, double time) {
+    // The Strang weights keep their specialised passes
+    if (weight == 0.5) {
+        applyPotentialOperator(time);
+        return;
+    }
+    if (weight == 1.0) {
+        applyFullPotentialOperator(time);
+        return;
+    }
+    
+    TRACE_SCOPE("V stage", "solver");
+    METRICS_SCOPE(MetricStage::Potential, 3 * m_wavefunction.size() * sizeof(Complex));
+    Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_wavefunction.size());
+    
+    if (m_potentialMode == PotentialMode::Static) {
+        if (const Complex* phase = findStage(m_potentialStages, weight)) {
+            forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+                kernels::multiply(psi + begin, phase + begin, count);
+            });
+            return;
+        }
+    }
+    
+    // Time-dependent potentials go from the values at the stage time, which
+    // costs one sincos per point like re-tabulating would
+    preparePotential(time);
+    const Real* values = m_potentialValues.data();
+    const Real* coupling = m_couplingValues.empty() ? nullptr : m_couplingValues.data();
+    const double* mask = m_absorberMask.empty() ? nullptr : m_absorberMask.data();
+    const double drive = m_driveAmplitude;
+    const double scale = -weight * m_dt;
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        for (size_t n = static_cast<size_t>(begin); n < static_cast<size_t>(begin) + count; ++n) {
+            const double v = values[n] + (coupling ? drive * coupling[n] : 0.0);
+            const double damping = mask ? std::pow(mask[n], 2.0 * weight) : 1.0;
+            psi[n] *= Complex(std::polar(damping, scale * v));
         }
+    });
+}
+
+// Apply exp(-i*b*K*dt) for one stage weight of the integrator
+template <typename Real>
+void BasicSimulationEngine<Real>::applyKineticStage(double weight) {
+    const Complex* phase = weight == 1.0 ? m_kineticPhase.data() : findStage(m_kineticStages, weight);
+    if (!phase) {
+        throw std::logic_error("No kinetic table for the integrator weight");
     }
+    applyKineticOperator(phase);
+}
+
+// Apply the kinetic energy operator in k-space
+template <typename Real>
+void BasicSimulationEngine<Real>::applyKineticOperator(const Complex* phase) {
+    TRACE_SCOPE("K", "solver");
+    const size_t bytes = m_wavefunction.size() * sizeof(Complex);
+    
+    // Transform to k-space
+    {
+        TRACE_SCOPE("FFT forward", "fft");
+        METRICS_SCOPE(MetricStage::FFTForward, 2 * bytes);
+        FFTW<Real>::execute(m_forwardPlan);
+    }
+    
+    // Apply the cached kinetic operator exp(-i*K*dt), which also carries
+    // the 1/(nx*ny) normalization of the FFT round trip
+    Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_kineticPhase.size());
+    
+    {
+        TRACE_SCOPE("exp(-iK dt)", "solver");
+        METRICS_SCOPE(MetricStage::Kinetic, 3 * bytes);
+        forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+            kernels::multiply(psi + begin, phase + begin, count);
+        });
+    }
+    
+    // Transform back to position space
+    TRACE_SCOPE("FFT backward", "fft");
+    METRICS_SCOPE(MetricStage::FFTBackward, 2 * bytes);
+    FFTW<Real>::execute(m_backwardPlan);
 }
 
 // Perform one SSFM step
-void SimulationEngine::step() {
-    DEBUG_LOG("SimulationEngine", "Performing simulation step");
+template <typename Real>
+void BasicSimulationEngine<Real>::step() {
+    TRACE_SCOPE("Step", "solver");
+    TRACE_LOG("SimulationEngine", "Performing simulation step");
     
     // SSFM algorithm for second-order symmetric splitting:
     // 1. Apply half step of potential: exp(-iVdt/2)
     // 2. Apply full step of kinetic: exp(-iKdt)
     // 3. Apply half step of potential: exp(-iVdt/2)
+    // Higher-order integrators alternate more V and K stages the same way
+    applyFusedSteps(*m_scheme, 1, m_dt);
+    METRICS_STEPS(1);
     
-    // Half step potential
-    applyPotentialOperator();
+    publishStepCompleted();
+}
+
+// Advance several SSFM steps with fused potential half steps
+template <typename Real>
+void BasicSimulationEngine<Real>::advance(int nSteps) {
+    TRACE_SCOPE("Advance", "solver");
+    TRACE_LOG("SimulationEngine", "Advancing simulation by " + std::to_string(nSteps) + " steps");
     
-    // Full step kinetic
-    applyKineticOperator();
+    // Between samples the sequence V/2 K V/2 V/2 K V/2 ... is evaluated as
+    // V/2 K V K V ... K V/2, so each sample interval costs one extra
+    // half-step pass instead of one per step
+    int interval = m_observableInterval > 0 ? m_observableInterval : nSteps;
+    int completed = 0;
     
-    // Half step potential
-    applyPotentialOperator();
+    while (completed < nSteps) {
+        int batch = std::min(interval, nSteps - completed);
+        applyFusedSteps(*m_scheme, batch, m_dt);
+        METRICS_STEPS(batch);
+        completed += batch;
+        
+        publishStepCompleted();
+    }
+}
+
+// Run fused steps with the current operator tables
+template <typename Real>
+void BasicSimulationEngine<Real>::applyFusedSteps(const SplittingScheme& scheme, int steps, double timeStep) {
+    const size_t stages = scheme.b.size();
     
-    // Update simulation time
-    m_currentTime += m_dt;
+    applyPotentialStage(scheme.a.front(), m_currentTime);
+    for (int s = 0; s < steps; ++s) {
+        for (size_t j = 0; j < stages; ++j) {
+            applyKineticStage(scheme.b[j]);
+            if (j + 1 < stages) {
+                applyPotentialStage(scheme.a[j + 1], m_currentTime + scheme.stageTime(j + 1) * timeStep);
+            }
+        }
+        
+        // A time-dependent V is taken at the step boundary both merged
+        // stages act at
+        const double last = scheme.a.back() + (s + 1 < steps ? scheme.a.front() : 0.0);
+        applyPotentialStage(last, m_currentTime + timeStep);
+        
+        m_currentTime += timeStep;
+    }
+}
+
+// Advance by a span of simulation time, adapting dt if enabled
+template <typename Real>
+int BasicSimulationEngine<Real>::advanceFor(double duration) {
+    TRACE_SCOPE("AdvanceFor", "solver");
+    if (!m_integration.adaptive) {
+        const int steps = static_cast<int>(std::lround(duration / m_dt));
+        advance(steps);
+        return steps;
+    }
+    if (!(m_integration.tolerance > 0.0) || !(m_integration.minDt > 0.0) ||
+        m_integration.maxDt < m_integration.minDt) {
+        throw std::invalid_argument("Adaptive stepping needs a positive tolerance and 0 < minDt <= maxDt");
+    }
+    // A Strang estimate of a Strang step is the step itself, so the error
+    // would always be zero
+    if (m_scheme->order <= SplittingScheme::strang().order) {
+        throw std::invalid_argument("Adaptive stepping needs a higher-order integration.scheme than strang");
+    }
+    
+    const double end = m_currentTime + duration;
+    const size_t size = m_wavefunction.size();
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    resizeGrid(m_stepStart, size);
+    resizeGrid(m_stepEstimate, size);
+    Complex* psi = m_wavefunction.data();
+    
+    // The Strang estimate is one order lower, so its difference from the
+    // high-order step scales as dt^3
+    const double exponent = 1.0 / (SplittingScheme::strang().order + 1);
+    double proposed = std::clamp(m_dt, m_integration.minDt, m_integration.maxDt);
+    int remainingSteps = 0;
+    int accepted = 0;
+    
+    while (m_currentTime < end) {
+        // Spread the remaining time evenly over steps no longer than the
+        // proposed one, so dt and its tables change only with the proposal
+        if (remainingSteps == 0) {
+            remainingSteps = std::max(1, static_cast<int>(std::ceil((end - m_currentTime) / proposed - 1e-9)));
+            setTimeStep((end - m_currentTime) / remainingSteps);
+        }
+        
+        // Embedded pair: Strang into m_stepEstimate, then the configured
+        // scheme from the same state into ψ
+        const double start = m_currentTime;
+        std::copy(psi, psi + size, m_stepStart.data());
+        applyFusedSteps(SplittingScheme::strang(), 1, m_dt);
+        std::copy(psi, psi + size, m_stepEstimate.data());
+        std::copy(m_stepStart.data(), m_stepStart.data() + size, psi);
+        m_currentTime = start;
+        applyFusedSteps(*m_scheme, 1, m_dt);
+        
+        double sum = 0.0;
+        const Complex* estimate = m_stepEstimate.data();
+        #pragma omp parallel for reduction(+:sum) num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < static_cast<std::ptrdiff_t>(size); ++n) {
+            sum += std::norm(std::complex<double>(psi[n]) - std::complex<double>(estimate[n]));
+        }
+        const double error = std::sqrt(sum * m_dx * m_dy);
+        const double factor = error > 0.0 ? 0.9 * std::pow(m_integration.tolerance / error, exponent) : 2.0;
+        
+        // Spreading the remaining time can leave dt a rounding above minDt,
+        // which must still count as the floor or the step repeats forever
+        const bool atMinimum = m_dt <= m_integration.minDt * (1.0 + 1e-9);
+        if (error <= m_integration.tolerance || atMinimum) {
+            ++accepted;
+            METRICS_STEPS(1);
+            --remainingSteps;
+            if (remainingSteps == 0) {
+                m_currentTime = end;
+            }
+            
+            // Grow only by a clear margin, since a new dt rebuilds the tables
+            if (factor >= 1.5 && m_dt < m_integration.maxDt) {
+                proposed = std::min(m_integration.maxDt, m_dt * std::min(factor, 2.0));
+                remainingSteps = 0;
+            }
+        } else {
+            std::copy(m_stepStart.data(), m_stepStart.data() + size, psi);
+            m_currentTime = start;
+            proposed = std::max(m_integration.minDt, m_dt * std::max(factor, 0.2));
+            remainingSteps = 0;
+        }
+    }
+    
+    publishStepCompleted();
+    return accepted;
+}
+
+// Let callers holding the interface (the batch runner) start from the ground state
+template <typename Real>
+bool BasicSimulationEngine<Real>::relaxInitialState(const ImaginaryTime& options,
+                                                    std::vector<EigenstateResult>& results) {
+    results = relaxEigenstates(options);
+    return true;
+}
+
+// Let callers holding the interface (the batch runner) use adaptive steps
+template <typename Real>
+bool BasicSimulationEngine<Real>::advanceAdaptive(double duration, int& steps) {
+    steps = advanceFor(duration);
+    return true;
+}
+
+// Change dt and rebuild the operator tables that depend on it
+template <typename Real>
+void BasicSimulationEngine<Real>::setTimeStep(double dt) {
+    if (std::abs(dt - m_dt) <= 1e-12 * m_dt) {
+        return;
+    }
+    m_dt = dt;
+    rephasePotentialTables();
+    rebuildKineticPhaseTable();
+}
+
+// Relax towards the lowest eigenstates in imaginary time
+template <typename Real>
+std::vector<EigenstateResult> BasicSimulationEngine<Real>::relaxEigenstates(const ImaginaryTime& options) {
+    TRACE_SCOPE("Imaginary time", "solver");
+    if (!(options.dt > 0.0) || !(options.minDt > 0.0) || options.checkInterval <= 0 ||
+        options.maxSteps <= 0 || options.states <= 0) {
+        throw std::invalid_argument("Imaginary time steps, intervals and state count must be positive");
+    }
+    const double minDt = std::min(options.minDt, options.dt);
+    
+    // V is frozen at the current time; the mode change keeps the V passes on
+    // the plain tables, and rebuildPhaseTables() picks the mode again at the end
+    preparePotential(m_currentTime);
+    m_potentialMode = PotentialMode::Static;
+    
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    const WavefunctionType guess = m_wavefunction;
+    const size_t size = m_wavefunction.size();
+    m_eigenstates.clear();
+    std::vector<EigenstateResult> results;
+    
+    for (int state = 0; state < options.states; ++state) {
+        Complex* psi = m_wavefunction.data();
+        std::copy(guess.data(), guess.data() + size, psi);
+        
+        // The configured wavepacket may be orthogonal to an excited state,
+        // so those start from a perturbed copy that overlaps every symmetry
+        if (state > 0) {
+            std::mt19937 generator(static_cast<unsigned>(state));
+            std::uniform_real_distribution<double> noise(-0.5, 0.5);
+            for (size_t n = 0; n < size; ++n) {
+                psi[n] *= Complex(static_cast<Real>(1.0 + noise(generator)), static_cast<Real>(noise(generator)));
+            }
+        }
+        projectOutEigenstates(m_eigenstates.size());
+        m_wavefunction.normalize(m_lx, m_ly, m_numThreads);
+        
+        EigenstateResult result;
+        result.dt = options.dt;
+        rebuildImaginaryTimeTables(result.dt);
+        double previous = std::numeric_limits<double>::quiet_NaN();
+        
+        while (result.steps < options.maxSteps) {
+            const int batch = std::min(options.checkInterval, options.maxSteps - result.steps);
+            applyFusedSteps(SplittingScheme::strang(), batch, 0.0);
+            result.steps += batch;
+            
+            // The norm decays as exp(-2E*τ) once ψ is dominated by one state
+            const double norm = getTotalProbability();
+            if (!(norm > 0.0) || !std::isfinite(norm)) {
+                break;
+            }
+            const double energy = -std::log(norm) / (2.0 * batch * result.dt);
+            projectOutEigenstates(m_eigenstates.size());
+            m_wavefunction.normalize(m_lx, m_ly, m_numThreads);
+            
+            if (std::abs(energy - previous) < options.tolerance) {
+                if (result.dt <= minDt) {
+                    result.converged = true;
+                    break;
+                }
+                // The splitting error is O(dτ²), so refine and settle again
+                result.dt = std::max(result.dt / 2.0, minDt);
+                rebuildImaginaryTimeTables(result.dt);
+                previous = std::numeric_limits<double>::quiet_NaN();
+                continue;
+            }
+            previous = energy;
+        }
+        
+        result.energy = computeObservables().energy;
+        DEBUG_LOG("SimulationEngine", "Eigenstate " + std::to_string(state) + ": E = " +
+                  std::to_string(result.energy) + " after " + std::to_string(result.steps) + " steps" +
+                  (result.converged ? "" : " (not converged)"));
+        results.push_back(result);
+        m_eigenstates.push_back(m_wavefunction);
+    }
+    
+    // Leave the ground state in ψ and switch back to real time
+    std::copy(m_eigenstates.front().data(), m_eigenstates.front().data() + size, m_wavefunction.data());
+    rebuildPhaseTables();
+    m_initialNorm = getTotalProbability();
+    
+    if (hasEventSink()) {
+        publishEvent(makePooledEvent<WavefunctionUpdatedEvent>(m_eventPool));
+    }
+    return results;
+}
+
+// Fill the operator tables with the real imaginary-time factors
+template <typename Real>
+void BasicSimulationEngine<Real>::rebuildImaginaryTimeTables(double dtau) {
+    const double normFactor = 1.0 / (static_cast<double>(m_nx) * m_ny);
+    const Real* coupling = m_couplingValues.empty() ? nullptr : m_couplingValues.data();
+    
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int j = 0; j < m_ny; ++j) {
+        const size_t offset = static_cast<size_t>(j) * m_nx;
+        const double ky2 = m_ky[j] * m_ky[j];
+        for (int i = 0; i < m_nx; ++i) {
+            const size_t n = offset + i;
+            double v = m_potentialValues[n];
+            if (coupling) {
+                v += m_driveAmplitude * coupling[n];
+            }
+            m_potentialPhase[n] = Complex(static_cast<Real>(std::exp(-dtau * v / 2.0)), Real(0));
+            m_kineticPhase[n] = Complex(static_cast<Real>(normFactor * std::exp(-dtau * (m_kx[i] * m_kx[i] + ky2) / 2.0)),
+                                        Real(0));
+        }
+    }
+}
+
+// Gram-Schmidt projection against the lower eigenstates
+template <typename Real>
+void BasicSimulationEngine<Real>::projectOutEigenstates(size_t count) {
+    Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_wavefunction.size());
     
+    for (size_t k = 0; k < count; ++k) {
+        const Complex* phi = m_eigenstates[k].data();
+        
+        // ⟨φ|ψ⟩ accumulated in double for both precisions
+        double re = 0.0;
+        double im = 0.0;
+        #pragma omp parallel for reduction(+:re, im) num_threads(m_numThreads)
+        for (std::ptrdiff_t n = 0; n < size; ++n) {
+            const std::complex<double> term = std::conj(std::complex<double>(phi[n])) * std::complex<double>(psi[n]);
+            re += term.real();
+            im += term.imag();
+        }
+        const Complex overlap(static_cast<Real>(re * m_dx * m_dy), static_cast<Real>(im * m_dx * m_dy));
+        
+        forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t blockSize) {
+            for (size_t n = static_cast<size_t>(begin); n < static_cast<size_t>(begin) + blockSize; ++n) {
+                psi[n] -= overlap * phi[n];
+            }
+        });
+    }
+}
+
+// Publish step events and notify the step completion callback
+template <typename Real>
+void BasicSimulationEngine<Real>::publishStepCompleted() {
     // Publish simulation stepped event
-    if (m_eventBus) {
+    if (hasEventSink()) {
         double totalProbability = getTotalProbability();
-        DEBUG_LOG("SimulationEngine", "Step completed. Time: " + std::to_string(m_currentTime) + 
+        TRACE_LOG("SimulationEngine", "Step completed. Time: " + std::to_string(m_currentTime) + 
                   ", Total probability: " + std::to_string(totalProbability));
         
-        m_eventBus->publish(makeEvent<SimulationSteppedEvent>(m_currentTime, m_dt, totalProbability));
+        publishEvent(makePooledEvent<SimulationSteppedEvent>(m_eventPool, m_currentTime, m_dt, totalProbability));
         
         // Also publish a wavefunction updated event
-        m_eventBus->publish(makeEvent<WavefunctionUpdatedEvent>());
-        DEBUG_LOG("SimulationEngine", "Published WavefunctionUpdated event");
+        publishEvent(makePooledEvent<WavefunctionUpdatedEvent>(m_eventPool));
+        TRACE_LOG("SimulationEngine", "Published WavefunctionUpdated event");
     }
     
     // Call the step completion callback if registered
@@ -257,19 +969,20 @@ void SimulationEngine::step() {
 }
 
 // Reset the simulation
-void SimulationEngine::reset() {
+template <typename Real>
+void BasicSimulationEngine<Real>::reset() {
     DEBUG_LOG("SimulationEngine", "Resetting simulation");
     
     // Re-initialize the wavefunction
     initializeWavefunction();
     
     // Publish simulation reset event
-    if (m_eventBus) {
-        m_eventBus->publish(makeEvent<SimulationResetEvent>());
+    if (hasEventSink()) {
+        publishEvent(makeEvent<SimulationResetEvent>());
         DEBUG_LOG("SimulationEngine", "Published SimulationReset event");
         
         // Also publish a wavefunction reset event
-        m_eventBus->publish(makeEvent<WavefunctionResetEvent>(
+        publishEvent(makeEvent<WavefunctionResetEvent>(
             m_wavepacket.x0, m_wavepacket.y0,
             m_wavepacket.sigmaX, m_wavepacket.sigmaY,
             m_wavepacket.kx, m_wavepacket.ky
@@ -279,71 +992,135 @@ void SimulationEngine::reset() {
 }
 
 // Update simulation configuration
-void SimulationEngine::updateConfig(const PhysicsConfig& config) {
+template <typename Real>
+void BasicSimulationEngine<Real>::updateConfig(const PhysicsConfig& config, bool keepState) {
     DEBUG_LOG("SimulationEngine", "Updating configuration: nx=" + std::to_string(config.nx) + 
               ", ny=" + std::to_string(config.ny) + ", dt=" + std::to_string(config.dt));
     
+    // Validate the planner, integrator and domain before touching the current plans
+    const unsigned plannerFlags = FFTWWisdom::plannerFlags(config.fftw.planner);
+    const SplittingScheme& scheme = SplittingScheme::fromName(config.integration.scheme);
+    if (!(config.lx > 0.0) || !(config.ly > 0.0)) {
+        throw std::invalid_argument("Domain lengths must be positive");
+    }
+    const bool gridChanged = config.nx != m_nx || config.ny != m_ny;
+    const bool domainChanged = config.lx != m_lx || config.ly != m_ly;
+    if (keepState && domainChanged) {
+        throw std::invalid_argument("The wavefunction can only be carried over to a domain of the same size");
+    }
+    
+    // A new potential is created before anything changes, so a bad one leaves the engine intact
+    std::unique_ptr<Potential> potential;
+    if (!m_potential || domainChanged || config.potential != m_potentialConfig) {
+        potential = Potential::create(config.potential, config.lx, config.ly);
+    }
+    const bool potentialReplaced = potential != nullptr;
+    const bool dtChanged = config.dt != m_dt;
+    const bool absorberChanged = config.absorber != m_absorber;
+    const bool schemeChanged = &scheme != m_scheme;
+    
+    // Plans stay valid while the grid, the ψ buffer and the planner settings
+    // do, so runs that only change physics parameters skip planning
+    const bool keepPlans = m_forwardPlan && m_backwardPlan && !gridChanged &&
+                           resolveThreadCount(config.numThreads) == m_numThreads && plannerFlags == m_plannerFlags;
+    
+    // Measuring planners overwrite ψ, so a state that carries over is copied out first
+    const int previousNx = m_nx;
+    const int previousNy = m_ny;
+    GridVector<Complex> carried;
+    double absorbed = 0.0;
+    if (keepState && !keepPlans) {
+        carried.assign(m_wavefunction.begin(), m_wavefunction.end());
+        absorbed = getAbsorbedProbability();
+    }
+    
     // Clean up old plans
-    cleanupFFTWPlans();
+    if (!keepPlans) {
+        cleanupFFTWPlans();
+    }
     
     // Update the configuration
     m_nx = config.nx;
     m_ny = config.ny;
+    m_lx = config.lx;
+    m_ly = config.ly;
     m_dt = config.dt;
+    m_numThreads = resolveThreadCount(config.numThreads);
+    m_plannerFlags = plannerFlags;
+    m_wisdomDir = config.fftw.wisdomDir;
     m_wavepacket = config.wavepacket;  // Update wavepacket parameters
+    m_absorber = config.absorber;
+    m_integration = config.integration;
+    m_scheme = &scheme;
+    m_potentialConfig = config.potential;
+    m_regions = config.output.regions;
+    if (potential) {
+        m_potential = std::move(potential);
+    }
     
     // Calculate grid spacing
     m_dx = m_lx / m_nx;
     m_dy = m_ly / m_ny;
     
-    // Create a new wavefunction with the updated size
-    m_wavefunction = Wavefunction(m_nx, m_ny);
-    
-    // Create a new potential
-    m_potential = Potential::create(config.potential.type, config.potential.parameters);
-    
-    // Resize k-space arrays
-    m_kx.resize(m_nx);
-    m_ky.resize(m_ny);
+    // Resize the wavefunction in place; its old block goes back to the
+    // pool first, so switching between grid sizes recycles the buffers
+    GridPool::FirstTouchScope firstTouch(m_numThreads);
+    if (gridChanged) {
+        m_wavefunction.resize(m_nx, m_ny);
+        m_kx.resize(m_nx);
+        m_ky.resize(m_ny);
+    }
     
     // Initialize the FFTW plans
-    initializeFFTWPlans();
-    
-    // Recompute k-space grid
-    for (int i = 0; i < m_nx; ++i) {
-        if (i <= m_nx / 2) {
-            m_kx[i] = 2.0 * M_PI * i / m_lx;
-        } else {
-            m_kx[i] = 2.0 * M_PI * (i - m_nx) / m_lx;
-        }
+    if (!keepPlans) {
+        initializeFFTWPlans();
+    }
+    if (gridChanged || domainChanged) {
+        initializeKSpaceGrid();
     }
     
-    for (int j = 0; j < m_ny; ++j) {
-        if (j <= m_ny / 2) {
-            m_ky[j] = 2.0 * M_PI * j / m_ly;
+    // Rebuild only the operator tables whose inputs changed: V is sampled
+    // again for a new potential or grid, a new dt only rephases the samples
+    if (gridChanged || potentialReplaced) {
+        rebuildPotentialPhaseTable();
+    } else if (dtChanged || absorberChanged) {
+        rephasePotentialTables();
+    } else if (schemeChanged) {
+        rebuildPotentialStageTables();
+    }
+    if (gridChanged || domainChanged || dtChanged || schemeChanged) {
+        rebuildKineticPhaseTable();
+    }
+
+    if (!keepState) {
+        initializeWavefunction();
+    } else if (!carried.empty()) {
+        // Same grid: put ψ back after planning; new grid: interpolate it spectrally
+        if (gridChanged) {
+            solver_detail::resampleSpectral(carried.data(), previousNx, previousNy, m_wavefunction.data(),
+                                            m_nx, m_ny, m_numThreads);
         } else {
-            m_ky[j] = 2.0 * M_PI * (j - m_ny) / m_ly;
+            std::copy(carried.begin(), carried.end(), m_wavefunction.begin());
         }
+        m_initialNorm = getTotalProbability() + absorbed;
     }
-    
-    // Initialize the wavefunction
-    initializeWavefunction();
-    
+
     // Publish configuration updated event
-    if (m_eventBus) {
-        m_eventBus->publish(makeEvent<ConfigurationUpdatedEvent>("dt", std::to_string(m_dt)));
-        m_eventBus->publish(makeEvent<ConfigurationUpdatedEvent>("nx", std::to_string(m_nx)));
-        m_eventBus->publish(makeEvent<ConfigurationUpdatedEvent>("ny", std::to_string(m_ny)));
+    if (hasEventSink()) {
+        publishEvent(makeEvent<ConfigurationUpdatedEvent>("dt", std::to_string(m_dt)));
+        publishEvent(makeEvent<ConfigurationUpdatedEvent>("nx", std::to_string(m_nx)));
+        publishEvent(makeEvent<ConfigurationUpdatedEvent>("ny", std::to_string(m_ny)));
         DEBUG_LOG("SimulationEngine", "Published ConfigurationUpdated events");
     }
 }
 
 // Set a new potential
-void SimulationEngine::setPotential(std::unique_ptr<Potential> potential) {
+template <typename Real>
+void BasicSimulationEngine<Real>::setPotential(std::unique_ptr<Potential> potential) {
     DEBUG_LOG("SimulationEngine", "Setting new potential of type: " + potential->getType());
     
     // Get the potential type and parameters before moving it
-    PotentialChangedEvent::PotentialType type;
+    PotentialChangedEvent::PotentialType type = PotentialChangedEvent::PotentialType::FreeSpace;
     std::vector<double> parameters;
     
     // Map the potential type to the event's potential type
@@ -355,53 +1132,315 @@ void SimulationEngine::setPotential(std::unique_ptr<Potential> potential) {
         type = PotentialChangedEvent::PotentialType::HarmonicOscillator;
     }
     
-    // Move the potential
+    // Move the potential; its parameters are not visible through the interface
+    m_potentialConfig = PotentialConfig();
+    m_potentialConfig.type = potential->getType();
     m_potential = std::move(potential);
     
+    // The cached potential phases depend on V, so rebuild them
+    rebuildPotentialPhaseTable();
+    
     // Publish potential changed event
-    if (m_eventBus) {
-        m_eventBus->publish(makeEvent<PotentialChangedEvent>(type, parameters));
+    if (hasEventSink()) {
+        publishEvent(makeEvent<PotentialChangedEvent>(type, parameters));
         DEBUG_LOG("SimulationEngine", "Published PotentialChanged event");
     }
 }
 
+// Copy the state needed to resume later
+template <typename Real>
+CheckpointState BasicSimulationEngine<Real>::captureCheckpoint() const {
+    CheckpointState state;
+    state.nx = m_nx;
+    state.ny = m_ny;
+    state.lx = m_lx;
+    state.ly = m_ly;
+    state.dt = m_dt;
+    state.time = m_currentTime;
+    state.precision = std::is_same<Real, float>::value ? "float" : "double";
+    state.potential = m_potentialConfig;
+    state.absorbed = getAbsorbedProbability();
+    state.psi.assign(m_wavefunction.begin(), m_wavefunction.end());
+    return state;
+}
+
+// Continue from a saved state
+template <typename Real>
+void BasicSimulationEngine<Real>::restoreCheckpoint(const CheckpointState& state) {
+    if (state.nx != m_nx || state.ny != m_ny ||
+        state.psi.size() != static_cast<size_t>(m_nx) * static_cast<size_t>(m_ny)) {
+        throw std::invalid_argument("Checkpoint grid " + std::to_string(state.nx) + "x" +
+                                    std::to_string(state.ny) + " does not match the engine grid " +
+                                    std::to_string(m_nx) + "x" + std::to_string(m_ny));
+    }
+    if (std::abs(state.lx - m_lx) > 1e-12 || std::abs(state.ly - m_ly) > 1e-12) {
+        throw std::invalid_argument("Checkpoint domain does not match the engine domain");
+    }
+    
+    DEBUG_LOG("SimulationEngine", "Restoring checkpoint at t=" + std::to_string(state.time));
+    
+    // Both phase tables depend on dt and the potential table on V
+    m_dt = state.dt;
+    m_potentialConfig = state.potential;
+    m_potential = Potential::create(state.potential, m_lx, m_ly);
+    rebuildPhaseTables();
+    
+    Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(state.psi.size());
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (std::ptrdiff_t i = 0; i < size; ++i) {
+        psi[i] = Complex(static_cast<Real>(state.psi[i].real()), static_cast<Real>(state.psi[i].imag()));
+    }
+    m_currentTime = state.time;
+    m_initialNorm = getTotalProbability() + state.absorbed;
+    preparePotential(m_currentTime);
+    
+    if (hasEventSink()) {
+        publishEvent(makeEvent<WavefunctionUpdatedEvent>());
+        DEBUG_LOG("SimulationEngine", "Published WavefunctionUpdated event");
+    }
+}
+
+// Get the wavefunction, converted to double precision if necessary
+template <typename Real>
+const Wavefunction& BasicSimulationEngine<Real>::getWavefunction() const {
+    if constexpr (std::is_same<Real, double>::value) {
+        return m_wavefunction;
+    } else {
+        m_doubleView = Wavefunction(m_wavefunction);
+        return m_doubleView;
+    }
+}
+
 // Get the total probability
-double SimulationEngine::getTotalProbability() const {
-    return m_wavefunction.getTotalProbability(m_lx, m_ly);
+template <typename Real>
+double BasicSimulationEngine<Real>::getTotalProbability() const {
+    const Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_wavefunction.size());
+    
+    const std::ptrdiff_t blocks = (size + kKernelBlock - 1) / kKernelBlock;
+    
+    double totalProb = 0.0;
+    #pragma omp parallel for reduction(+:totalProb) num_threads(m_numThreads)
+    for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+        std::ptrdiff_t begin = b * kKernelBlock;
+        totalProb += kernels::sumNorm(psi + begin, static_cast<size_t>(std::min(kKernelBlock, size - begin)));
+    }
+    
+    return totalProb * m_dx * m_dy;
 }
 
-// Get probability density for visualization
-std::vector<float> SimulationEngine::getProbabilityDensity() const {
-    std::vector<float> densityData(m_nx * m_ny);
+// Compute all observables in one position-space and one k-space pass
+template <typename Real>
+ObservableSample BasicSimulationEngine<Real>::computeObservables() const {
+    TRACE_SCOPE("Observables", "solver");
+    const size_t size = m_wavefunction.size();
+    const size_t regionCount = m_regions.size();
     
-    // Calculate probability density |ψ|² at each grid point
-    for (int i = 0; i < m_nx; ++i) {
-        for (int j = 0; j < m_ny; ++j) {
-            const std::complex<double>& psi = m_wavefunction(i, j);
-            double probability = std::norm(psi); // |ψ|² = ψ*ψ
-            densityData[j * m_nx + i] = static_cast<float>(probability);
+    // ψ and V read, the scratch copy written, transformed and read back
+    METRICS_SCOPE(MetricStage::Observables, size * (5 * sizeof(Complex) + sizeof(Real)));
+    
+    // Index ranges covered by each region, [i0, i1) x [j0, j1)
+    struct Range { int i0, i1, j0, j1; };
+    std::vector<Range> ranges(regionCount);
+    for (size_t r = 0; r < regionCount; ++r) {
+        const ObservableRegion& region = m_regions[r];
+        ranges[r].i0 = std::clamp(static_cast<int>(std::ceil((region.xMin + m_lx/2) / m_dx)), 0, m_nx);
+        ranges[r].i1 = std::clamp(static_cast<int>(std::floor((region.xMax + m_lx/2) / m_dx)) + 1, 0, m_nx);
+        ranges[r].j0 = std::clamp(static_cast<int>(std::ceil((region.yMin + m_ly/2) / m_dy)), 0, m_ny);
+        ranges[r].j1 = std::clamp(static_cast<int>(std::floor((region.yMax + m_ly/2) / m_dy)) + 1, 0, m_ny);
+    }
+    
+    // Position space: per row Σ|ψ|², Σx|ψ|², ΣV|ψ|² and the region sums, copying ψ on the way
+    const size_t rowFields = 3 + regionCount;
+    std::vector<double> rows(static_cast<size_t>(m_ny) * rowFields, 0.0);
+    const Complex* psi = m_wavefunction.data();
+    Complex* scratch = m_observableScratch.data();
+    const Real* potential = m_potentialValues.data();
+    
+    // A driven potential holds V0 and V1 separately: V = V0 + f*V1
+    const Real* coupling = m_couplingValues.empty() ? nullptr : m_couplingValues.data();
+    const double drive = m_driveAmplitude;
+    
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int j = 0; j < m_ny; ++j) {
+        const size_t offset = static_cast<size_t>(j) * m_nx;
+        double norm = 0.0, sumX = 0.0, sumV = 0.0;
+        for (int i = 0; i < m_nx; ++i) {
+            const Complex value = psi[offset + i];
+            scratch[offset + i] = value;
+            const double density = std::norm(value);
+            norm += density;
+            sumX += (-m_lx/2 + i * m_dx) * density;
+            double v = static_cast<double>(potential[offset + i]);
+            if (coupling) {
+                v += drive * static_cast<double>(coupling[offset + i]);
+            }
+            sumV += v * density;
+        }
+        
+        double* row = rows.data() + static_cast<size_t>(j) * rowFields;
+        row[0] = norm;
+        row[1] = sumX;
+        row[2] = sumV;
+        
+        // The row is still in cache, so region sums are a cheap second look
+        for (size_t r = 0; r < regionCount; ++r) {
+            if (j < ranges[r].j0 || j >= ranges[r].j1) {
+                continue;
+            }
+            double inside = 0.0;
+            for (int i = ranges[r].i0; i < ranges[r].i1; ++i) {
+                inside += std::norm(psi[offset + i]);
+            }
+            row[3 + r] = inside;
+        }
+    }
+    
+    // Momentum space: per row Σ|ψ̃|², Σkx|ψ̃|² and Σ(k²/2)|ψ̃|²
+    FFTW<Real>::execute(m_observablePlan);
+    
+    std::vector<double> kRows(static_cast<size_t>(m_ny) * 3, 0.0);
+    
+    #pragma omp parallel for num_threads(m_numThreads)
+    for (int j = 0; j < m_ny; ++j) {
+        const size_t offset = static_cast<size_t>(j) * m_nx;
+        const double ky2 = m_ky[j] * m_ky[j];
+        double norm = 0.0, sumKx = 0.0, sumK = 0.0;
+        for (int i = 0; i < m_nx; ++i) {
+            const double density = std::norm(scratch[offset + i]);
+            norm += density;
+            sumKx += m_kx[i] * density;
+            sumK += (m_kx[i] * m_kx[i] + ky2) / 2.0 * density;
+        }
+        kRows[static_cast<size_t>(j) * 3 + 0] = norm;
+        kRows[static_cast<size_t>(j) * 3 + 1] = sumKx;
+        kRows[static_cast<size_t>(j) * 3 + 2] = sumK;
+    }
+    
+    // Combine the row partials in a fixed order
+    double norm = 0.0, sumX = 0.0, sumY = 0.0, sumV = 0.0;
+    std::vector<double> regionSums(regionCount, 0.0);
+    double kNorm = 0.0, sumKx = 0.0, sumKy = 0.0, sumK = 0.0;
+    for (int j = 0; j < m_ny; ++j) {
+        const double* row = rows.data() + static_cast<size_t>(j) * rowFields;
+        norm += row[0];
+        sumX += row[1];
+        sumY += (-m_ly/2 + j * m_dy) * row[0];
+        sumV += row[2];
+        for (size_t r = 0; r < regionCount; ++r) {
+            regionSums[r] += row[3 + r];
         }
+        
+        const double* kRow = kRows.data() + static_cast<size_t>(j) * 3;
+        kNorm += kRow[0];
+        sumKx += kRow[1];
+        sumKy += m_ky[j] * kRow[0];
+        sumK += kRow[2];
     }
     
+    ObservableSample sample;
+    sample.time = m_currentTime;
+    sample.totalProbability = norm * m_dx * m_dy;
+    sample.absorbedProbability = m_initialNorm - sample.totalProbability;
+    if (norm > 0.0) {
+        sample.x = sumX / norm;
+        sample.y = sumY / norm;
+        sample.potentialEnergy = sumV / norm;
+    }
+    if (kNorm > 0.0) {
+        sample.px = sumKx / kNorm;
+        sample.py = sumKy / kNorm;
+        sample.kineticEnergy = sumK / kNorm;
+    }
+    sample.energy = sample.kineticEnergy + sample.potentialEnergy;
+    sample.regions.resize(regionCount);
+    for (size_t r = 0; r < regionCount; ++r) {
+        sample.regions[r] = regionSums[r] * m_dx * m_dy;
+    }
+    return sample;
+}
+
+// Get probability density for visualization
+template <typename Real>
+std::vector<float> BasicSimulationEngine<Real>::getProbabilityDensity() const {
+    std::vector<float> densityData(m_wavefunction.size());
+    writeProbabilityDensity(densityData.data());
     return densityData;
 }
 
+// Write the probability density into a caller-provided buffer
+template <typename Real>
+void BasicSimulationEngine<Real>::writeProbabilityDensity(float* density) const {
+    // Calculate probability density |ψ|² at each grid point, in storage order
+    const Complex* psi = m_wavefunction.data();
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_wavefunction.size());
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        kernels::normToFloat(psi + begin, density + begin, count); // |ψ|² = ψ*ψ
+    });
+}
+
+// Write the wavefunction as single precision real/imaginary pairs
+template <typename Real>
+void BasicSimulationEngine<Real>::writeWavefunctionField(float* field) const {
+    // std::complex is layout-compatible with Real[2]
+    const Real* psi = reinterpret_cast<const Real*>(m_wavefunction.data());
+    const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(m_wavefunction.size());
+    
+    forEachBlock(size, m_numThreads, [=](std::ptrdiff_t begin, size_t count) {
+        const Real* src = psi + 2 * begin;
+        float* dst = field + 2 * begin;
+        for (size_t n = 0; n < 2 * count; ++n) {
+            dst[n] = static_cast<float>(src[n]);
+        }
+    });
+}
+
 // Set step completion callback
-void SimulationEngine::setStepCompletionCallback(StepCompletionCallback callback) {
+template <typename Real>
+void BasicSimulationEngine<Real>::setStepCompletionCallback(StepCompletionCallback callback) {
     DEBUG_LOG("SimulationEngine", "Setting step completion callback");
     m_stepCompletionCallback = std::move(callback);
 }
 
 // Shutdown resources
-void SimulationEngine::shutdown() {
+template <typename Real>
+void BasicSimulationEngine<Real>::shutdown() {
     DEBUG_LOG("SimulationEngine", "Shutting down SimulationEngine");
     
     // Clean up FFTW plans
     cleanupFFTWPlans();
     
     // Publish shutdown event if event bus is available
-    if (m_eventBus) {
-        m_eventBus->publish(makeEvent<SimulationEngineShutdownEvent>());
+    if (hasEventSink()) {
+        publishEvent(makeEvent<SimulationEngineShutdownEvent>());
         DEBUG_LOG("SimulationEngine", "Published SimulationEngineShutdown event");
     }
-}
\ No newline at end of file
+}
+
+// Post an event to the event queue, or publish it on the event bus
+template <typename Real>
+void BasicSimulationEngine<Real>::publishEvent(EventPtr event) {
+    if (m_eventQueue) {
+        m_eventQueue->post(std::move(event));
+    } else if (m_eventBus) {
+        m_eventBus->publish(event);
+    }
+}
+
+template class BasicSimulationEngine<double>;
+template class BasicSimulationEngine<float>;
+
+// Create an engine of the configured precision
+std::shared_ptr<ISimulationEngine> createSimulationEngine(const PhysicsConfig& config,
+                                                          std::shared_ptr<EventBus> eventBus,
+                                                          std::shared_ptr<AsyncEventQueue> eventQueue) {
+    if (config.precision == "double") {
+        return std::make_shared<SimulationEngine>(config, eventBus, eventQueue);
+    }
+    if (config.precision == "float") {
+        return std::make_shared<SimulationEngineF>(config, eventBus, eventQueue);
+    }
+    throw std::invalid_argument("Unknown simulation precision: " + config.precision);
+}
@@ -2,48 +2,173 @@
 
 #include <memory>
 #include <complex>
+#include <limits>
 #include <vector>
-#include <functional>
+#include <string>
 #include "ISimulationEngine.h"
+#include "Checkpoint.h"
+#include "Observables.h"
+#include "SplittingScheme.h"
 #include "../core/PhysicsConfig.h"
 #include "../core/Wavefunction.h"
+#include "../core/GridPool.h"
 #include "../core/Potential.h"
 #include "../core/EventBus.h"
+#include "../core/AsyncEventQueue.h"
+#include "../core/EventPool.h"
 
-// Forward declaration for FFTW plan
+// Forward declarations for the FFTW plan types
 struct fftw_plan_s;
 typedef struct fftw_plan_s* fftw_plan;
+struct fftwf_plan_s;
+typedef struct fftwf_plan_s* fftwf_plan;
 
-// Define callback type for step completion
-using StepCompletionCallback = std::function<void()> ;
+/**
+ * @brief Maps a scalar type to the FFTW plan handle of the matching precision
+ */
+template <typename Real> struct FFTWPlanType;
+template <> struct FFTWPlanType<double> { using type = fftw_plan; };
+template <> struct FFTWPlanType<float> { using type = fftwf_plan; };
 
 /**
- * @class SimulationEngine
+ * @class BasicSimulationEngine
  * @brief Core simulation engine implementing the Split-Step Fourier Method
  * 
  * This class implements the Split-Step Fourier Method (SSFM) for solving the
  * 2D Time-Dependent Schrödinger Equation. It manages the wavefunction evolution,
  * applies kinetic and potential energy operators, and handles the FFT transforms.
+ * 
+ * The wavefunction, phase tables and FFTs use the scalar type Real: double
+ * (SimulationEngine, FFTW) or float (SimulationEngineF, FFTW's fftwf
+ * interface). Grid coordinates and phases are computed in double and only
+ * the stored values are rounded, so single precision gives about 1e-6
+ * accuracy at half the memory traffic. The template is explicitly
+ * instantiated for both types in SimulationEngine.cpp.
+ * 
+ * @tparam Real Floating-point type of the simulation state (double or float)
  */
-class SimulationEngine : public ISimulationEngine {
+template <typename Real>
+class BasicSimulationEngine : public ISimulationEngine {
 public:
+    using Complex = std::complex<Real>;
+    using WavefunctionType = BasicWavefunction<Real>;
+    
     /**
      * @brief Constructor for the simulation engine
      * @param config The physics configuration parameters
      * @param eventBus The event bus for publishing simulation events
+     * @param eventQueue Queue to post events to instead of publishing them on eventBus
      */
-    SimulationEngine(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus = nullptr);
+    BasicSimulationEngine(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus = nullptr,
+                          std::shared_ptr<AsyncEventQueue> eventQueue = nullptr);
     
     /**
      * @brief Destructor to clean up FFTW plans and resources
      */
-    ~SimulationEngine() override;
+    ~BasicSimulationEngine() override;
     
     /**
      * @brief Advance the simulation by one time step
      */
     void step() override;
     
+    /**
+     * @brief Advance the simulation by several time steps in one batch
+     * 
+     * Consecutive Strang steps V/2-K-V/2 are fused so that the trailing V/2
+     * of one step and the leading V/2 of the next become a single full-V
+     * multiply. Observables and events are produced only at the end of the
+     * batch, or every observable interval steps if one is set.
+     * 
+     * @param nSteps Number of time steps to advance
+     */
+    void advance(int nSteps) override;
+    
+    /**
+     * @brief Advance by a span of simulation time
+     * 
+     * With integration.adaptive set, each step is taken with the configured
+     * fourth-order splitting and with a Strang step from the same state;
+     * their L2 difference estimates the Strang error, a step is rejected and
+     * retried when it exceeds integration.tolerance, and the next dt follows
+     * (tolerance/error)^(1/3) within [minDt, maxDt]. The more accurate
+     * result is kept, so the actual error is usually far below the
+     * tolerance. dt only grows by a clear margin and the remaining time is
+     * split into equal steps, since every change of dt rebuilds the
+     * operator tables. Without adaptive stepping this is advance() with the
+     * nearest whole number of steps.
+     * 
+     * @param duration Simulation time to advance by
+     * @return Number of steps taken (accepted steps when adaptive)
+     * @throws std::invalid_argument if the adaptive settings are inconsistent
+     *         or the scheme is only second order
+     */
+    int advanceFor(double duration);
+    
+    /**
+     * @brief Advance by a span of simulation time through advanceFor()
+     * @param duration Simulation time to advance by
+     * @param steps Set to the number of steps taken
+     * @return True
+     * @throws std::invalid_argument if the adaptive settings are inconsistent
+     */
+    bool advanceAdaptive(double duration, int& steps) override;
+    
+    /**
+     * @brief Get the current time step
+     * @return dt, which advanceFor() adjusts when adaptive stepping is on
+     */
+    double getTimeStep() const { return m_dt; }
+    
+    /**
+     * @brief Relax the wavefunction towards the lowest eigenstates in imaginary time
+     * 
+     * Propagates with the real operators exp(-V*dτ/2) and exp(-K*dτ) through
+     * the same FFT plans, operator tables and fused step loop as advance(),
+     * renormalizing every check interval. The energy is estimated from the
+     * norm decay, E ≈ -ln(N)/(2τ), so convergence checks cost no extra FFT.
+     * Each time the estimate settles, dτ is halved until it reaches
+     * options.minDt. Excited states start from the current wavefunction with
+     * a fixed perturbation and are kept orthogonal to the states below them
+     * by Gram-Schmidt projection.
+     * 
+     * The potential is frozen at the current time and the absorbing layer is
+     * ignored. On return the wavefunction holds the ground state, the
+     * real-time tables are restored and the simulation time is unchanged.
+     * 
+     * @param options Step sizes, tolerance and number of states
+     * @return One result per state, lowest energy first
+     * @throws std::invalid_argument if a step size, interval or count is not positive
+     */
+    std::vector<EigenstateResult> relaxEigenstates(const ImaginaryTime& options);
+    
+    /**
+     * @brief Get the states found by the last relaxEigenstates() call
+     * @return Normalized eigenstates, lowest energy first
+     */
+    const std::vector<WavefunctionType>& getEigenstates() const { return m_eigenstates; }
+    
+    /**
+     * @brief Replace the wavefunction by the ground state through relaxEigenstates()
+     * @param options Step sizes, tolerance and number of states
+     * @param results Set to one result per state, lowest energy first
+     * @return True
+     * @throws std::invalid_argument if a step size, interval or count is not positive
+     */
+    bool relaxInitialState(const ImaginaryTime& options, std::vector<EigenstateResult>& results) override;
+    
+    /**
+     * @brief Set how often advance() samples observables and publishes events
+     * @param steps Number of steps between samples (0 = only at the end of each batch)
+     */
+    void setObservableInterval(int steps) { m_observableInterval = steps; }
+    
+    /**
+     * @brief Get the observable sampling interval used by advance()
+     * @return Number of steps between samples (0 = only at the end of each batch)
+     */
+    int getObservableInterval() const { return m_observableInterval; }
+    
     /**
      * @brief Reset the simulation with the current parameters
      */
@@ -51,9 +176,16 @@ public:
     
     /**
      * @brief Update the simulation configuration
+     * 
+     * The precision is fixed per engine, so config.precision is ignored
+     * here; use createSimulationEngine() to switch precision. See
+     * ISimulationEngine::updateConfig() for what is rebuilt.
+     * 
      * @param config The new physics configuration
+     * @param keepState True to carry ψ and the time over
+     * @throws std::invalid_argument if keepState is set and the domain size changes
      */
-    void updateConfig(const PhysicsConfig& config) override;
+    void updateConfig(const PhysicsConfig& config, bool keepState = false) override;
     
     /**
      * @brief Set a new potential for the simulation
@@ -62,10 +194,20 @@ public:
     void setPotential(std::unique_ptr<Potential> potential) override;
     
     /**
-     * @brief Get the current wavefunction
+     * @brief Get the current wavefunction in double precision
+     * 
+     * Returns the state itself for the double engine; the float engine
+     * returns a converted copy that is refreshed on every call.
+     * 
      * @return Const reference to the wavefunction
      */
-    const Wavefunction& getWavefunction() const override { return m_wavefunction; }
+    const Wavefunction& getWavefunction() const override;
+    
+    /**
+     * @brief Get the current wavefunction in the engine's own precision
+     * @return Const reference to the wavefunction, without conversion
+     */
+    const WavefunctionType& getNativeWavefunction() const { return m_wavefunction; }
     
     /**
      * @brief Get the current simulation time
@@ -78,13 +220,60 @@ public:
      * @return Total probability (should be close to 1.0)
      */
     double getTotalProbability() const override;
+    
+    /**
+     * @brief Get the probability removed by the absorbing layer
+     * @return Initial norm minus the current norm
+     */
+    double getAbsorbedProbability() const { return m_initialNorm - getTotalProbability(); }
+    
+    /**
+     * @brief Compute all observables of the current state in one sample
+     * 
+     * One position-space pass accumulates the norm, ⟨x⟩, ⟨y⟩, ⟨V⟩ and the
+     * region probabilities while copying ψ to a scratch buffer. One FFT of
+     * that copy and one k-space pass then give ⟨p⟩ and the kinetic energy.
+     * Per-row partial sums are combined in a fixed order, so results do not
+     * depend on the thread count.
+     * 
+     * @return The sample; step and wallSeconds are left for the caller
+     */
+    ObservableSample computeObservables() const override;
+    
+    /**
+     * @brief Set the regions whose probabilities computeObservables() reports
+     * @param regions Rectangles in domain coordinates
+     */
+    void setObservableRegions(const std::vector<ObservableRegion>& regions) { m_regions = regions; }
+    
+    /**
+     * @brief Get the number of threads used by the solver
+     * @return Thread count for OpenMP loops and FFTW plans
+     */
+    int getNumThreads() const { return m_numThreads; }
 
     /**
      * @brief Get the probability density for visualization
+     * 
+     * In single precision |ψ|² is formed directly in float, so the result
+     * goes to the renderer without a double-to-float conversion.
+     * 
      * @return Vector of probability densities at each grid point
      */
     std::vector<float> getProbabilityDensity() const override;
 
+    /**
+     * @brief Write the probability density into a caller-provided buffer
+     * @param dst Destination for nx * ny floats in storage order
+     */
+    void writeProbabilityDensity(float* dst) const override;
+
+    /**
+     * @brief Write the wavefunction as single precision real/imaginary pairs
+     * @param dst Destination for 2 * nx * ny floats
+     */
+    void writeWavefunctionField(float* dst) const override;
+
     /**
      * @brief Shutdown the simulation engine and release resources
      */
@@ -94,7 +283,24 @@ public:
      * @brief Set a callback to be invoked when a simulation step completes
      * @param callback The function to call after each step
      */
-    void setStepCompletionCallback(StepCompletionCallback callback);
+    void setStepCompletionCallback(StepCompletionCallback callback) override;
+
+    /**
+     * @brief Copy the state needed to resume the simulation later
+     * 
+     * The potential is recorded by type and parameters as last set through
+     * the configuration; after setPotential() only the type is known.
+     * 
+     * @return Grid, time, potential and wavefunction (converted to double)
+     */
+    CheckpointState captureCheckpoint() const override;
+
+    /**
+     * @brief Continue from a saved state
+     * @param state State captured by captureCheckpoint(), in either precision
+     * @throws std::invalid_argument if the grid or domain does not match
+     */
+    void restoreCheckpoint(const CheckpointState& state) override;
 
 private:
     /**
@@ -104,6 +310,11 @@ private:
     
     /**
      * @brief Initialize the FFTW plans for forward and backward FFTs
+     * 
+     * Measuring planners overwrite the wavefunction while timing, so the
+     * wavefunction must be (re)initialized after planning. Wisdom for the
+     * grid is loaded from the store first and saved if planning had to
+     * measure from scratch.
      */
     void initializeFFTWPlans();
     
@@ -112,15 +323,169 @@ private:
      */
     void cleanupFFTWPlans();
 
+    /**
+     * @brief Compute the k-space grid values for the current domain
+     */
+    void initializeKSpaceGrid();
+
+    /**
+     * @brief Rebuild both cached operator phase tables
+     */
+    void rebuildPhaseTables();
+
+    /**
+     * @brief Rebuild the cached potential phase table exp(-i*V*dt/2)
+     *
+     * Also picks how time-dependent potentials are updated and tabulates
+     * their static parts (see PotentialMode).
+     */
+    void rebuildPotentialPhaseTable();
+
+    /**
+     * @brief Recompute the potential phases for a new dt or absorber
+     *
+     * Uses the tabulated values instead of sampling the potential again.
+     */
+    void rephasePotentialTables();
+
+    /**
+     * @brief Tabulate a potential and its half-step phases on the grid
+     * @param potential Potential to sample
+     * @param phase Destination for exp(-i*V*dt/2), nx * ny values (null = values only)
+     * @param values Destination for V, nx * ny values
+     * @param absorb True to fold the absorbing layer's damping into the phases
+     */
+    void tabulatePotential(const Potential& potential, Complex* phase, Real* values, bool absorb = true) const;
+
+    /**
+     * @brief Tabulate exp(-W*dt/2) of the absorbing layer, or clear it when there is none
+     */
+    void rebuildAbsorberMask();
+
+    /**
+     * @brief Fill the operator tables with exp(-V*dτ/2) and exp(-K*dτ)/(nx*ny)
+     * @param dtau Imaginary time step
+     */
+    void rebuildImaginaryTimeTables(double dtau);
+
+    /**
+     * @brief Remove the components along the first count eigenstates from ψ
+     * @param count Number of entries of m_eigenstates to project out
+     */
+    void projectOutEigenstates(size_t count);
+
+    /**
+     * @brief Run steps of a splitting with the current tables
+     *
+     * The last potential stage of each step and the first of the next are
+     * merged, so Strang steps run as V/2 K V K ... K V/2. Callers count
+     * the steps they keep towards the metrics.
+     *
+     * @param scheme Splitting to apply
+     * @param steps Number of steps
+     * @param timeStep Simulation time added per step (0 in imaginary time)
+     */
+    void applyFusedSteps(const SplittingScheme& scheme, int steps, double timeStep);
+
+    /**
+     * @brief Change dt and rebuild the operator tables if it differs
+     * @param dt New time step
+     */
+    void setTimeStep(double dt);
+
+    /**
+     * @brief Bring the potential tables up to date for a time
+     *
+     * Does nothing for static potentials or when the tables already hold
+     * that time.
+     *
+     * @param time Simulation time the next potential operator acts at
+     */
+    void preparePotential(double time);
+
+    /**
+     * @brief Shift the tabulated shape of a moving potential into the tables
+     * @param shiftX Offset in grid cells in x direction
+     * @param shiftY Offset in grid cells in y direction
+     */
+    void shiftPotential(double shiftX, double shiftY);
+
+    /**
+     * @brief Rebuild the cached kinetic phase table exp(-i*K*dt)/(nx*ny)
+     *
+     * The FFT normalization factor is folded into the table so that no
+     * separate normalization pass is required after the backward transform.
+     */
+    void rebuildKineticPhaseTable();
+
+    /**
+     * @brief Tabulate exp(-i*a*V*dt) for the integrator's potential weights
+     *
+     * Only static potentials are tabulated; the weights 1/2 and 1 use
+     * m_potentialPhase.
+     */
+    void rebuildPotentialStageTables();
+
     /**
      * @brief Apply the kinetic energy operator in k-space
+     * @param phase Kinetic table to multiply with, nx * ny values
+     */
+    void applyKineticOperator(const Complex* phase);
+
+    /**
+     * @brief Apply exp(-i*b*K*dt) for one kinetic weight of the integrator
+     * @param weight Stage weight b in units of dt
      */
-    void applyKineticOperator();
+    void applyKineticStage(double weight);
+
+    /**
+     * @brief Apply exp(-i*a*V*dt) for one potential weight of the integrator
+     * @param weight Stage weight a in units of dt
+     * @param time Simulation time the stage acts at
+     */
+    void applyPotentialStage(double weight, double time);
     
     /**
      * @brief Apply the potential energy operator in position space
+     * @param time Simulation time of the half step
+     */
+    void applyPotentialOperator(double time);
+    
+    /**
+     * @brief Apply a full potential step exp(-i*V*dt) in position space
+     * 
+     * Used to merge the trailing and leading half steps of consecutive
+     * Strang steps; the full phase is formed from the cached half table.
+     * 
+     * @param time Simulation time between the two merged half steps
+     */
+    void applyFullPotentialOperator(double time);
+
+    /**
+     * @brief Multiply ψ by exp(-i*(V0 + f*V1)*tau) for a driven potential
+     * 
+     * Fuses the cached V0 phases with the drive term in one pass.
+     * 
+     * @param squared True for a full step (squares the V0 half phase)
+     */
+    void applyDrivenPotentialOperator(bool squared);
+    
+    /**
+     * @brief Publish step events and invoke the step completion callback
+     */
+    void publishStepCompleted();
+    
+    /**
+     * @brief Check whether published events have anywhere to go
+     * @return True if an event bus or event queue is set
+     */
+    bool hasEventSink() const { return m_eventBus || m_eventQueue; }
+    
+    /**
+     * @brief Post an event to the event queue, or publish it on the event bus
+     * @param event Event to deliver
      */
-    void applyPotentialOperator();
+    void publishEvent(EventPtr event);
     
     // Physics and simulation parameters
     int m_nx;                  ///< Number of grid points in x direction
@@ -131,23 +496,97 @@ private:
     double m_dy;               ///< Grid spacing in y direction
     double m_dt;               ///< Time step size
     double m_currentTime;      ///< Current simulation time
+    int m_numThreads;          ///< Threads used by OpenMP loops and FFTW plans
+    unsigned m_plannerFlags;   ///< FFTW planner rigor flag
+    std::string m_wisdomDir;   ///< FFTW wisdom store directory (empty = disabled)
     
     // Core simulation objects
-    Wavefunction m_wavefunction;                 ///< The quantum wavefunction
+    WavefunctionType m_wavefunction;             ///< The quantum wavefunction
     std::unique_ptr<Potential> m_potential;      ///< The potential energy function
     Wavepacket m_wavepacket;                     ///< Wavepacket parameters
+    PotentialConfig m_potentialConfig;           ///< Type and parameters of m_potential, for checkpoints
+    AbsorbingBoundary m_absorber;                ///< Absorbing layer along the domain edges
+    Integration m_integration;                   ///< Splitting scheme and adaptive step settings
+    const SplittingScheme* m_scheme = nullptr;   ///< Coefficients of m_integration.scheme
+    double m_initialNorm = 1.0;                  ///< Norm before any absorption, for the absorbed probability
+    std::vector<ObservableRegion> m_regions;     ///< Regions reported by computeObservables()
+    std::vector<WavefunctionType> m_eigenstates; ///< States found by relaxEigenstates()
     
     // FFTW variables
-    fftw_plan m_forwardPlan;   ///< FFTW plan for forward FFT
-    fftw_plan m_backwardPlan;  ///< FFTW plan for backward FFT
+    using Plan = typename FFTWPlanType<Real>::type;
+    Plan m_forwardPlan;        ///< FFTW plan for forward FFT
+    Plan m_backwardPlan;       ///< FFTW plan for backward FFT
+    Plan m_observablePlan = nullptr;  ///< In-place forward plan on m_observableScratch
+    mutable GridVector<Complex> m_observableScratch;   ///< Copy of ψ transformed for k-space observables
     
     // k-space grid values (precomputed)
     std::vector<double> m_kx;  ///< Wave numbers in x direction
     std::vector<double> m_ky;  ///< Wave numbers in y direction
 
+    // Cached operator tables, laid out like the wavefunction storage
+    GridVector<Complex> m_potentialPhase;   ///< exp(-i*V*dt/2) at each grid point (V0 for driven potentials)
+    GridVector<Real> m_potentialValues;     ///< V at each grid point, for ⟨V⟩ (V0 for driven potentials)
+    GridVector<Complex> m_kineticPhase;     ///< exp(-i*K*dt)/(nx*ny) at each k-point
+    /**
+     * @brief Operator table for one stage weight of a higher-order splitting
+     */
+    struct StageTable {
+        double weight;               ///< Stage weight in units of dt
+        GridVector<Complex> phase;   ///< exp(-i*weight*X*dt) at each point
+    };
+    
+    std::vector<StageTable> m_potentialStages;  ///< Static V tables of the weights other than 1/2 and 1
+    std::vector<StageTable> m_kineticStages;    ///< K tables of the weights other than 1 (with 1/(nx*ny))
+    GridVector<Complex> m_stepStart;        ///< ψ at the start of an adaptive step
+    GridVector<Complex> m_stepEstimate;     ///< Strang result of an adaptive step
+    GridVector<double> m_absorberMask;      ///< exp(-W*dt/2) of the absorbing layer (empty = none), folded into m_potentialPhase
+
+    /**
+     * @brief How the potential tables follow the simulation time
+     */
+    enum class PotentialMode {
+        Static,   ///< Tabulated once
+        Driven,   ///< V0 and V1 tabulated once; the drive is applied in the V pass
+        Moving,   ///< Shape tabulated once and shifted into the tables
+        Sampled   ///< Re-tabulated at every new time
+    };
+    PotentialMode m_potentialMode = PotentialMode::Static;  ///< Update strategy of m_potential
+    double m_potentialTime = std::numeric_limits<double>::quiet_NaN();  ///< Time the potential tables hold (NaN = none)
+    double m_driveAmplitude = 0.0;           ///< f(m_potentialTime) of a driven potential
+    GridVector<Real> m_couplingValues;       ///< V1 of a driven potential
+    GridVector<Complex> m_shapePhase;        ///< exp(-i*W*dt/2) of a moving potential at offset 0
+    GridVector<Real> m_shapeValues;          ///< W of a moving potential at offset 0
+
     // Event system
     std::shared_ptr<EventBus> m_eventBus;  ///< Event bus for publishing events
+    std::shared_ptr<AsyncEventQueue> m_eventQueue;  ///< Queue events are posted to instead, if set
+    std::shared_ptr<EventPool> m_eventPool;  ///< Recycled memory for the per-batch step events
 
     // Step completion callback
     StepCompletionCallback m_stepCompletionCallback;  ///< Callback for step completion notification
-};
\ No newline at end of file
+    
+    int m_observableInterval = 0;  ///< Steps between samples in advance() (0 = end of batch)
+    
+    mutable Wavefunction m_doubleView{0, 0};  ///< Converted state returned by getWavefunction() in float mode
+};
+
+extern template class BasicSimulationEngine<double>;
+extern template class BasicSimulationEngine<float>;
+
+/// Double-precision simulation engine
+using SimulationEngine = BasicSimulationEngine<double>;
+
+/// Single-precision simulation engine
+using SimulationEngineF = BasicSimulationEngine<float>;
+
+/**
+ * @brief Create a simulation engine of the precision selected in the configuration
+ * @param config The physics configuration; config.precision is "double" or "float"
+ * @param eventBus The event bus for publishing simulation events
+ * @param eventQueue Queue to post events to instead of publishing them on eventBus
+ * @return The new engine
+ * @throws std::invalid_argument if config.precision is not recognized
+ */
+std::shared_ptr<ISimulationEngine> createSimulationEngine(const PhysicsConfig& config,
+                                                          std::shared_ptr<EventBus> eventBus = nullptr,
+                                                          std::shared_ptr<AsyncEventQueue> eventQueue = nullptr);
\ No newline at end of file
@@ -0,0 +1,435 @@
+#include "SimulationWorker.h"
+#include "SimulationEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include "../core/Events.h"
+#include "../core/DebugUtils.h"
+#include "../core/Metrics.h"
+#include "../core/Trace.h"
+
+// Create the engine and start the worker thread
+SimulationWorker::SimulationWorker(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus)
+    : m_eventBus(eventBus),
+      m_nx(config.nx),
+      m_ny(config.ny),
+      m_pyramid(config.numThreads)
+{
+    // The engine only gets a queue if someone listens, since events cost time per batch
+    if (m_eventBus) {
+        m_eventQueue = std::make_shared<AsyncEventQueue>();
+    }
+
+    m_engine = createSimulationEngine(config, nullptr, m_eventQueue);
+    m_engine->setStepCompletionCallback([this]() {
+        m_completedBatches.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // Give the consumer the initial state before anything runs
+    publishFrame();
+
+    m_thread = std::thread(&SimulationWorker::threadMain, this);
+    DEBUG_LOG("SimulationWorker", "Started simulation worker thread");
+}
+
+// Stop the worker thread
+SimulationWorker::~SimulationWorker() {
+    stopThread();
+}
+
+// Stop and join the worker thread
+void SimulationWorker::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        m_stopRequested = true;
+    }
+    m_commandCondition.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+        DEBUG_LOG("SimulationWorker", "Stopped simulation worker thread");
+    }
+}
+
+// Start or pause continuous stepping
+void SimulationWorker::setRunning(bool running) {
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        m_running.store(running, std::memory_order_relaxed);
+    }
+    m_commandCondition.notify_all();
+}
+
+// Set the batch size used while running
+void SimulationWorker::setStepsPerFrame(int steps) {
+    m_stepsPerFrame.store(std::max(1, steps), std::memory_order_relaxed);
+}
+
+// Limit the stepping rate while running
+void SimulationWorker::setTargetStepRate(double stepsPerSecond) {
+    m_targetStepRate.store(std::max(0.0, stepsPerSecond), std::memory_order_relaxed);
+}
+
+// Choose what later frames carry
+void SimulationWorker::setFrameContent(FrameContent content) {
+    if (m_frameContent.exchange(content, std::memory_order_relaxed) != content) {
+        // Republish so a paused simulation shows the new content too
+        post([this]() { publishFrame(); });
+    }
+}
+
+// Choose the grid region and resolution of later frames
+void SimulationWorker::setViewport(const DensityViewport& view) {
+    post([this, view]() {
+        m_viewport = view;
+        publishFrame(false);
+    });
+}
+
+// Worker thread main loop
+void SimulationWorker::threadMain() {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(m_commandMutex);
+    while (!m_stopRequested) {
+        // Commands from the consumer go first, one at a time
+        if (!m_commands.empty()) {
+            std::function<void()> command = std::move(m_commands.front());
+            m_commands.pop_front();
+            m_busy = true;
+            lock.unlock();
+
+            try {
+                command();
+            } catch (...) {
+                recordError(std::current_exception());
+            }
+
+            lock.lock();
+            m_busy = false;
+            m_commandCondition.notify_all();
+            continue;
+        }
+
+        if (!m_running.load(std::memory_order_relaxed)) {
+            m_commandCondition.wait(lock, [this]() {
+                return m_stopRequested || !m_commands.empty() || m_running.load(std::memory_order_relaxed);
+            });
+            continue;
+        }
+
+        // Run one batch and hand the result to the render loop
+        const int steps = m_stepsPerFrame.load(std::memory_order_relaxed);
+        const double rate = m_targetStepRate.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        m_busy = true;
+        lock.unlock();
+
+        try {
+            m_engine->advance(steps);
+            publishFrame();
+        } catch (...) {
+            recordError(std::current_exception());
+        }
+
+        lock.lock();
+        m_busy = false;
+        m_commandCondition.notify_all();
+
+        // When throttled, wait out the rest of the batch's time slot but
+        // stay responsive to commands
+        if (rate > 0.0) {
+            const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(steps / rate));
+            m_commandCondition.wait_until(lock, deadline, [this]() {
+                return m_stopRequested || !m_commands.empty() || !m_running.load(std::memory_order_relaxed);
+            });
+        }
+    }
+}
+
+// Fill and publish a frame from the engine's current state
+void SimulationWorker::publishFrame(bool engineChanged) {
+    TRACE_SCOPE("Publish frame", "worker");
+    DensityFrame& frame = m_frames.writeBuffer();
+    const DensityViewport view = DensityPyramid::resolve(m_viewport, m_nx, m_ny);
+    const bool full = DensityPyramid::isFullResolution(view, m_nx, m_ny);
+    int width = 0;
+    int height = 0;
+    DensityPyramid::outputSize(view, width, height);
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (engineChanged) {
+        m_pyramidCurrent = false;
+    }
+
+    // Frame buffers are reused, so after the first frames this never allocates
+    if (m_frameContent.load(std::memory_order_relaxed) == FrameContent::Wavefunction) {
+        frame.density.clear();
+        frame.field.resize(2 * count);
+        if (full) {
+            m_engine->writeWavefunctionField(frame.field.data());
+        } else {
+            resizeGrid(m_fieldScratch, 2 * static_cast<size_t>(m_nx) * static_cast<size_t>(m_ny));
+            m_engine->writeWavefunctionField(m_fieldScratch.data());
+            DensityPyramid::sampleField(m_fieldScratch.data(), m_nx, m_ny, view, frame.field.data());
+        }
+    } else {
+        frame.field.clear();
+        frame.density.resize(count);
+        if (full) {
+            m_engine->writeProbabilityDensity(frame.density.data());
+        } else {
+            if (!m_pyramidCurrent) {
+                m_engine->writeProbabilityDensity(m_pyramid.resize(m_nx, m_ny));
+                m_pyramid.build();
+                m_pyramidCurrent = true;
+            }
+            m_pyramid.sample(view, frame.density.data());
+        }
+    }
+    frame.width = width;
+    frame.height = height;
+    frame.view = view;
+    frame.nx = m_nx;
+    frame.ny = m_ny;
+    frame.time = m_engine->getCurrentTime();
+    frame.totalProbability = m_engine->getTotalProbability();
+    frame.frameIndex = ++m_frameCounter;
+    m_frames.publish();
+}
+
+// Move the newest published frame to the consumer side
+void SimulationWorker::refreshFrame() const {
+    if (m_frames.update()) {
+        m_unseenFrame = true;
+    }
+}
+
+// Take the newest frame if it has not been reported yet
+bool SimulationWorker::acquireFrame() {
+    refreshFrame();
+    bool changed = m_unseenFrame;
+    m_unseenFrame = false;
+    return changed;
+}
+
+// Re-publish engine events on the application event bus
+void SimulationWorker::dispatchEvents() {
+    TRACE_SCOPE("Dispatch events", "events");
+    METRICS_SCOPE(MetricStage::EventDispatch, 0);
+    if (m_eventQueue && m_eventBus) {
+        m_eventQueue->dispatch(*m_eventBus);
+    }
+
+    if (m_completedBatches.exchange(0, std::memory_order_relaxed) > 0 && m_stepCompletionCallback) {
+        m_stepCompletionCallback();
+    }
+}
+
+// Wait until the command queue is drained
+void SimulationWorker::waitIdle() {
+    std::unique_lock<std::mutex> lock(m_commandMutex);
+    m_commandCondition.wait(lock, [this]() {
+        return m_stopRequested || (m_commands.empty() && !m_busy);
+    });
+}
+
+// Keep the first failure of asynchronous work and stop running
+void SimulationWorker::recordError(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        ERROR_LOG("SimulationWorker", std::string("Simulation stopped: ") + e.what());
+    } catch (...) {
+        ERROR_LOG("SimulationWorker", "Simulation stopped by an unknown exception");
+    }
+
+    std::lock_guard<std::mutex> lock(m_commandMutex);
+    if (!m_error) {
+        m_error = error;
+    }
+    m_running.store(false, std::memory_order_relaxed);
+}
+
+// Queue a command for the worker thread
+void SimulationWorker::post(std::function<void()> command) {
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        if (!m_stopRequested) {
+            m_commands.push_back(std::move(command));
+            command = nullptr;
+        }
+    }
+
+    // Once the worker has stopped, the caller owns the engine
+    if (command) {
+        command();
+        return;
+    }
+    m_commandCondition.notify_all();
+}
+
+// Run a command on the worker thread and wait for it
+void SimulationWorker::runSync(std::function<void()> command) const {
+    if (std::this_thread::get_id() == m_thread.get_id()) {
+        command();
+        return;
+    }
+
+    auto task = std::make_shared<std::packaged_task<void()>>(std::move(command));
+    std::future<void> done = task->get_future();
+    const_cast<SimulationWorker*>(this)->post([task]() { (*task)(); });
+    done.get();
+
+    // Report a failure of earlier asynchronous work once
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        std::swap(error, m_error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Queue a single step
+void SimulationWorker::step() {
+    advance(1);
+}
+
+// Queue a batch of steps
+void SimulationWorker::advance(int nSteps) {
+    post([this, nSteps]() {
+        m_engine->advance(nSteps);
+        publishFrame();
+    });
+}
+
+// Reset the engine on the worker thread
+void SimulationWorker::reset() {
+    runSync([this]() {
+        m_engine->reset();
+        publishFrame();
+    });
+}
+
+// Reconfigure the engine on the worker thread
+void SimulationWorker::updateConfig(const PhysicsConfig& config, bool keepState) {
+    runSync([this, &config, keepState]() {
+        m_engine->updateConfig(config, keepState);
+        m_nx = config.nx;
+        m_ny = config.ny;
+        publishFrame();
+    });
+}
+
+// Replace the potential on the worker thread
+void SimulationWorker::setPotential(std::unique_ptr<Potential> potential) {
+    // std::function needs a copyable callable, so share ownership until the move
+    auto holder = std::make_shared<std::unique_ptr<Potential>>(std::move(potential));
+    runSync([this, holder]() {
+        m_engine->setPotential(std::move(*holder));
+        publishFrame();
+    });
+}
+
+// Copy the wavefunction between batches
+const Wavefunction& SimulationWorker::getWavefunction() const {
+    runSync([this]() {
+        m_wavefunctionCopy = std::make_unique<Wavefunction>(m_engine->getWavefunction());
+    });
+    return *m_wavefunctionCopy;
+}
+
+// Compute observables between batches
+ObservableSample SimulationWorker::computeObservables() const {
+    ObservableSample sample;
+    runSync([this, &sample]() { sample = m_engine->computeObservables(); });
+    return sample;
+}
+
+// Capture a checkpoint between batches
+CheckpointState SimulationWorker::captureCheckpoint() const {
+    CheckpointState state;
+    runSync([this, &state]() { state = m_engine->captureCheckpoint(); });
+    return state;
+}
+
+// Restore a checkpoint on the worker thread
+void SimulationWorker::restoreCheckpoint(const CheckpointState& state) {
+    runSync([this, &state]() {
+        m_engine->restoreCheckpoint(state);
+        publishFrame();
+    });
+}
+
+// Time of the latest frame
+double SimulationWorker::getCurrentTime() const {
+    refreshFrame();
+    return currentFrame().time;
+}
+
+// Norm of the latest frame
+double SimulationWorker::getTotalProbability() const {
+    refreshFrame();
+    return currentFrame().totalProbability;
+}
+
+// Density of the latest frame
+std::vector<float> SimulationWorker::getProbabilityDensity() const {
+    refreshFrame();
+    const DensityFrame& frame = currentFrame();
+    if (frame.field.empty() && isFullResolution(frame)) {
+        return frame.density;
+    }
+    std::vector<float> density(static_cast<size_t>(frame.nx) * static_cast<size_t>(frame.ny));
+    writeProbabilityDensity(density.data());
+    return density;
+}
+
+// Copy the density of the latest frame
+void SimulationWorker::writeProbabilityDensity(float* dst) const {
+    refreshFrame();
+    const DensityFrame& frame = currentFrame();
+    if (!isFullResolution(frame)) {
+        // The frame only holds a reduced view; take the density between batches
+        runSync([this, dst]() { m_engine->writeProbabilityDensity(dst); });
+        return;
+    }
+    if (frame.field.empty()) {
+        std::copy(frame.density.begin(), frame.density.end(), dst);
+        return;
+    }
+    const size_t count = frame.field.size() / 2;
+    for (size_t n = 0; n < count; ++n) {
+        const float re = frame.field[2 * n];
+        const float im = frame.field[2 * n + 1];
+        dst[n] = re * re + im * im;
+    }
+}
+
+// Copy ψ from the latest frame
+void SimulationWorker::writeWavefunctionField(float* dst) const {
+    refreshFrame();
+    const DensityFrame& frame = currentFrame();
+    if (frame.field.empty() || !isFullResolution(frame)) {
+        // The frame carries no phase or only a reduced view; ask the engine between batches
+        runSync([this, dst]() { m_engine->writeWavefunctionField(dst); });
+        return;
+    }
+    std::copy(frame.field.begin(), frame.field.end(), dst);
+}
+
+// Set the callback invoked by dispatchEvents()
+void SimulationWorker::setStepCompletionCallback(StepCompletionCallback callback) {
+    m_stepCompletionCallback = std::move(callback);
+}
+
+// Shut down the engine and stop the worker thread
+void SimulationWorker::shutdown() {
+    setRunning(false);
+    runSync([this]() { m_engine->shutdown(); });
+    stopThread();
+    dispatchEvents();
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ISimulationEngine.h"
+#include "Checkpoint.h"
+#include "Observables.h"
+#include "DensityPyramid.h"
+#include "../core/EventBus.h"
+#include "../core/AsyncEventQueue.h"
+#include "../core/Wavefunction.h"
+#include "../core/GridPool.h"
+#include "../core/TripleBuffer.h"
+
+/**
+ * @struct DensityFrame
+ * @brief One published snapshot of the simulation for display
+ */
+struct DensityFrame {
+    std::vector<float> density;    ///< |ψ|² over the viewport (x fastest); empty for FrameContent::Wavefunction
+    std::vector<float> field;      ///< ψ as re/im pairs over the viewport; only for FrameContent::Wavefunction
+    int width = 0;                 ///< Samples per row of density/field
+    int height = 0;                ///< Rows of density/field
+    DensityViewport view;          ///< Resolved grid region the samples cover
+    int nx = 0;                    ///< Grid points in x direction
+    int ny = 0;                    ///< Grid points in y direction
+    double time = 0.0;             ///< Simulation time of the frame
+    double totalProbability = 0.0; ///< Norm of the wavefunction at that time
+    uint64_t frameIndex = 0;       ///< Sequence number, increasing by one per frame
+};
+
+/**
+ * @enum FrameContent
+ * @brief What the worker computes into each published frame
+ */
+enum class FrameContent {
+    Density,      ///< |ψ|² computed on the CPU
+    Wavefunction  ///< ψ itself, for displays that derive |ψ|² and phase on the GPU
+};
+
+/**
+ * @class SimulationWorker
+ * @brief Runs a simulation engine on its own thread
+ *
+ * The worker owns an engine and steps it on a background thread, so that
+ * a slow step never stalls the render loop and vsync does not cap the step
+ * rate. While running it advances the engine in batches of stepsPerFrame
+ * steps (using the fused ISimulationEngine::advance()) and publishes a
+ * DensityFrame after each batch through a lock-free TripleBuffer.
+ *
+ * The worker is itself an ISimulationEngine, so existing callers keep
+ * working across the thread boundary:
+ * - step()/advance() are queued and run asynchronously on the worker.
+ * - reset(), updateConfig(), setPotential(), getWavefunction(),
+ *   computeObservables(), captureCheckpoint(), restoreCheckpoint() and
+ *   shutdown() are queued and waited for; exceptions are rethrown to the
+ *   caller.
+ * - An exception from a queued step()/advance() or a running batch stops
+ *   the worker (isRunning() turns false) and is rethrown by the next of
+ *   the waited-for calls above, after that call's own work has run.
+ * - getCurrentTime(), getTotalProbability(), getProbabilityDensity(),
+ *   writeProbabilityDensity() and writeWavefunctionField() answer from the
+ *   latest published frame without touching the engine, unless a viewport
+ *   reduced the frame; then the full-resolution data comes from the engine.
+ *
+ * Frames cover a DensityViewport (setViewport()): the whole grid at full
+ * resolution by default, or a region max-pooled down to display size
+ * through a DensityPyramid, so only display-sized data is copied to the
+ * consumer however large the grid is.
+ *
+ * Events published by the engine are posted to an AsyncEventQueue and
+ * published on the application's event bus by dispatchEvents(), which the
+ * render loop calls once per frame; event handlers therefore still run on
+ * the GUI thread, and step events arrive at most once per frame however
+ * fast the worker steps. The step completion callback is invoked there too,
+ * once per dispatch that saw new steps.
+ *
+ * Frame and query methods must be called from a single consumer thread.
+ */
+class SimulationWorker : public ISimulationEngine {
+public:
+    /**
+     * @brief Create the engine and start the worker thread (paused)
+     * @param config The physics configuration; config.precision selects the engine
+     * @param eventBus Application event bus that dispatchEvents() publishes to
+     */
+    SimulationWorker(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus = nullptr);
+
+    /**
+     * @brief Stop the worker thread
+     */
+    ~SimulationWorker() override;
+
+    SimulationWorker(const SimulationWorker&) = delete;
+    SimulationWorker& operator=(const SimulationWorker&) = delete;
+
+    /**
+     * @brief Start or pause continuous stepping
+     * @param running True to step continuously, false to pause after the current batch
+     */
+    void setRunning(bool running);
+
+    /**
+     * @brief Check whether the worker is stepping continuously
+     * @return True if running
+     */
+    bool isRunning() const { return m_running.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Set the number of steps taken between published frames
+     * @param steps Steps per batch (at least 1)
+     */
+    void setStepsPerFrame(int steps);
+
+    /**
+     * @brief Limit the stepping rate while running
+     * @param stepsPerSecond Maximum steps per second (0 = as fast as possible)
+     */
+    void setTargetStepRate(double stepsPerSecond);
+
+    /**
+     * @brief Choose what later frames carry
+     * @param content Density (default) or the wavefunction itself
+     */
+    void setFrameContent(FrameContent content);
+
+    /**
+     * @brief Get what later frames carry
+     * @return The frame content
+     */
+    FrameContent getFrameContent() const { return m_frameContent.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Choose the grid region and resolution of later frames
+     *
+     * The current state is republished for the new viewport without
+     * recomputing the density when nothing has stepped since.
+     *
+     * @param view Region and maximum output size (defaults: whole grid, full resolution)
+     */
+    void setViewport(const DensityViewport& view);
+
+    /**
+     * @brief Take the newest published frame, if a new one is available
+     * @return True if currentFrame() changed
+     */
+    bool acquireFrame();
+
+    /**
+     * @brief Get the frame taken by the last successful acquireFrame()
+     * @return The current frame
+     */
+    const DensityFrame& currentFrame() const { return m_frames.readBuffer(); }
+
+    /**
+     * @brief Re-publish queued engine events on the application event bus
+     *
+     * Call once per frame from the thread that owns the event handlers.
+     */
+    void dispatchEvents();
+
+    /**
+     * @brief Wait until all queued commands and steps have been executed
+     */
+    void waitIdle();
+
+    // ISimulationEngine implementation
+    void step() override;
+    void advance(int nSteps) override;
+    void reset() override;
+    void updateConfig(const PhysicsConfig& config, bool keepState = false) override;
+    void setPotential(std::unique_ptr<Potential> potential) override;
+    const Wavefunction& getWavefunction() const override;
+    double getCurrentTime() const override;
+    double getTotalProbability() const override;
+    ObservableSample computeObservables() const override;
+    std::vector<float> getProbabilityDensity() const override;
+    void writeProbabilityDensity(float* dst) const override;
+
+    /**
+     * @brief Copy ψ from the latest frame
+     *
+     * If the frame carries no full-resolution field, ψ is taken from the
+     * engine between batches instead.
+     *
+     * @param dst Destination for 2 * nx * ny floats
+     */
+    void writeWavefunctionField(float* dst) const override;
+    void setStepCompletionCallback(StepCompletionCallback callback) override;
+    CheckpointState captureCheckpoint() const override;
+    void restoreCheckpoint(const CheckpointState& state) override;
+    void shutdown() override;
+
+private:
+    /**
+     * @brief Stop and join the worker thread, leaving the engine to the caller
+     */
+    void stopThread();
+
+    /**
+     * @brief Queue a command for the worker thread
+     * @param command Work to run on the worker thread
+     */
+    void post(std::function<void()> command);
+
+    /**
+     * @brief Run a command on the worker thread and wait for it
+     * @param command Work to run on the worker thread
+     * @throws Any exception thrown by command, or else the first exception
+     *         of asynchronous work since the last runSync()
+     */
+    void runSync(std::function<void()> command) const;
+
+    /**
+     * @brief Keep the first exception of asynchronous work and stop running
+     * @param error The exception
+     */
+    void recordError(std::exception_ptr error);
+
+    /**
+     * @brief Worker thread main loop
+     */
+    void threadMain();
+
+    /**
+     * @brief Fill and publish a frame from the engine's current state
+     * @param engineChanged False to reuse the density pyramid of the last frame
+     */
+    void publishFrame(bool engineChanged = true);
+
+    /**
+     * @brief Move the newest published frame to the consumer side
+     */
+    void refreshFrame() const;
+
+    /**
+     * @brief Check whether a frame holds the whole grid at full resolution
+     * @param frame Published frame
+     * @return True if the frame's samples are the grid points
+     */
+    static bool isFullResolution(const DensityFrame& frame) {
+        return frame.width == frame.nx && frame.height == frame.ny;
+    }
+
+    std::shared_ptr<EventBus> m_eventBus;       ///< Application event bus
+    std::shared_ptr<AsyncEventQueue> m_eventQueue;  ///< Engine events waiting for dispatchEvents()
+    std::shared_ptr<ISimulationEngine> m_engine;  ///< Engine owned by the worker thread
+
+    mutable std::mutex m_commandMutex;                   ///< Guards m_commands, m_busy and m_error
+    mutable std::condition_variable m_commandCondition;  ///< Signals new commands and state changes
+    mutable std::deque<std::function<void()>> m_commands;  ///< Pending work for the worker
+    bool m_busy = false;                                 ///< Worker is executing commands or a batch
+    bool m_stopRequested = false;                        ///< Worker thread should exit
+    mutable std::exception_ptr m_error;                  ///< Failure of asynchronous work, rethrown by runSync()
+
+    std::atomic<bool> m_running{false};       ///< Step continuously
+    std::atomic<int> m_stepsPerFrame{1};      ///< Steps per batch while running
+    std::atomic<double> m_targetStepRate{0.0};  ///< Step rate limit (0 = unlimited)
+    std::atomic<FrameContent> m_frameContent{FrameContent::Density};  ///< What publishFrame() computes
+    std::atomic<int> m_completedBatches{0};   ///< Batches finished since the last dispatch
+
+    mutable TripleBuffer<DensityFrame> m_frames;  ///< Frame handoff to the consumer
+    mutable bool m_unseenFrame = false;           ///< Consumer took a frame acquireFrame() has not reported
+    uint64_t m_frameCounter = 0;                  ///< Worker-side frame sequence number
+    int m_nx;                                     ///< Grid size of the engine (worker side)
+    int m_ny;                                     ///< Grid size of the engine (worker side)
+    DensityViewport m_viewport;                   ///< Requested frame viewport (worker side)
+    DensityPyramid m_pyramid;                     ///< Max-pooled density levels for reduced frames
+    bool m_pyramidCurrent = false;                ///< Pyramid matches the engine state
+    GridVector<float> m_fieldScratch;             ///< Full-resolution ψ for reduced field frames
+    mutable std::unique_ptr<Wavefunction> m_wavefunctionCopy;  ///< Snapshot returned by getWavefunction()
+    StepCompletionCallback m_stepCompletionCallback;     ///< Invoked by dispatchEvents()
+
+    std::thread m_thread;  ///< The worker thread
+};
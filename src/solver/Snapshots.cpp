@@ -0,0 +1,706 @@
+#include "Snapshots.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "ISimulationEngine.h"
+#include "../core/DebugUtils.h"
+#include "../core/Trace.h"
+#include "../core/Wavefunction.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Round a byte count up to the frame alignment
+uint64_t alignFrame(uint64_t bytes) {
+    const uint64_t alignment = SnapshotFormat::kFrameAlignment;
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+void appendVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+uint32_t readVarint(const unsigned char*& in, const unsigned char* end) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (in == end) {
+            break;
+        }
+        const unsigned char byte = *in++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupt snapshot frame: truncated varint");
+}
+
+// Code current against previous as zigzag varint differences with zero runs
+void encodeDelta(const uint16_t* current, const uint16_t* previous, size_t count,
+                 std::vector<unsigned char>& out) {
+    out.clear();
+    size_t n = 0;
+    while (n < count) {
+        if (current[n] == previous[n]) {
+            size_t run = 1;
+            while (n + run < count && current[n + run] == previous[n + run]) {
+                ++run;
+            }
+            out.push_back(0);
+            appendVarint(out, static_cast<uint32_t>(run - 1));
+            n += run;
+            continue;
+        }
+        const int32_t difference = static_cast<int32_t>(current[n]) - static_cast<int32_t>(previous[n]);
+        appendVarint(out, (static_cast<uint32_t>(difference) << 1) ^ static_cast<uint32_t>(difference >> 31));
+        ++n;
+    }
+}
+
+// Apply the differences of one frame to values in place
+void decodeDelta(const unsigned char* in, size_t bytes, uint16_t* values, size_t count) {
+    const unsigned char* end = in + bytes;
+    size_t n = 0;
+    while (n < count) {
+        if (in == end) {
+            throw std::runtime_error("Corrupt snapshot frame: payload ends early");
+        }
+        if (*in == 0) {
+            ++in;
+            const size_t run = static_cast<size_t>(readVarint(in, end)) + 1;
+            if (run > count - n) {
+                throw std::runtime_error("Corrupt snapshot frame: run past the grid");
+            }
+            n += run;
+            continue;
+        }
+        const uint32_t zigzag = readVarint(in, end);
+        const int32_t difference = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+        values[n] = static_cast<uint16_t>(static_cast<int32_t>(values[n]) + difference);
+        ++n;
+    }
+}
+
+}  // namespace
+
+// Parse an encoding name
+SnapshotFormat::Encoding SnapshotFormat::parseEncoding(const std::string& name) {
+    if (name == "complex128") {
+        return Encoding::Complex128;
+    }
+    if (name == "complex64") {
+        return Encoding::Complex64;
+    }
+    if (name == "float32") {
+        return Encoding::Density32;
+    }
+    if (name == "float16") {
+        return Encoding::Density16;
+    }
+    if (name == "delta16") {
+        return Encoding::DensityDelta16;
+    }
+    throw std::invalid_argument("Unknown snapshot encoding: " + name +
+                                " (expected complex128, complex64, float32, float16 or delta16)");
+}
+
+// Get the name of an encoding
+const char* SnapshotFormat::encodingName(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Complex128: return "complex128";
+        case Encoding::Complex64: return "complex64";
+        case Encoding::Density32: return "float32";
+        case Encoding::Density16: return "float16";
+        case Encoding::DensityDelta16: return "delta16";
+    }
+    return "unknown";
+}
+
+// Check whether an encoding stores the wavefunction itself
+bool SnapshotFormat::storesField(Encoding encoding) {
+    return encoding == Encoding::Complex128 || encoding == Encoding::Complex64;
+}
+
+// Get the payload size of a fixed-size encoding
+size_t SnapshotFormat::payloadBytes(Encoding encoding, size_t points) {
+    switch (encoding) {
+        case Encoding::Complex128: return points * 2 * sizeof(double);
+        case Encoding::Complex64: return points * 2 * sizeof(float);
+        case Encoding::Density32: return points * sizeof(float);
+        case Encoding::Density16: return points * sizeof(uint16_t);
+        case Encoding::DensityDelta16: return 0;
+    }
+    return 0;
+}
+
+// Convert to IEEE binary16 with round to nearest even
+uint16_t SnapshotFormat::toHalf(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xff) {
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));  // Inf or NaN
+    }
+    const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 0x1f) {
+        return static_cast<uint16_t>(sign | 0x7c00u);  // Overflow to infinity
+    }
+    if (halfExponent <= 0) {
+        // Subnormal half (or zero): the implicit bit joins the shifted mantissa
+        if (halfExponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        const int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    // A carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+// Convert from IEEE binary16
+float SnapshotFormat::fromHalf(uint16_t bits) {
+    const uint32_t sign = static_cast<uint32_t>(bits & 0x8000u) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1fu;
+    const uint32_t mantissa = bits & 0x3ffu;
+    if (exponent == 0) {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    const uint32_t result = exponent == 0x1f ? (sign | 0x7f800000u | (mantissa << 13))
+                                             : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float value = 0.0f;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+// Create the file and start the writer thread
+SnapshotWriter::SnapshotWriter(const std::string& path, SnapshotFormat::Encoding encoding, int nx, int ny,
+                               double lx, double ly, double dt, int keyframeInterval)
+    : m_path(path),
+      m_encoding(encoding),
+      m_header{},
+      m_fileEnd(SnapshotFormat::kHeaderBytes)
+{
+    if (nx <= 0 || ny <= 0) {
+        throw std::invalid_argument("Snapshot streams need a non-empty grid");
+    }
+    if (keyframeInterval < 1) {
+        throw std::invalid_argument("The snapshot keyframe interval must be at least 1");
+    }
+    const size_t points = static_cast<size_t>(nx) * static_cast<size_t>(ny);
+    std::memcpy(m_header.magic, SnapshotFormat::kMagic, sizeof(m_header.magic));
+    m_header.version = SnapshotFormat::kVersion;
+    m_header.encoding = static_cast<uint32_t>(encoding);
+    m_header.nx = nx;
+    m_header.ny = ny;
+    m_header.lx = lx;
+    m_header.ly = ly;
+    m_header.dt = dt;
+    const size_t payload = SnapshotFormat::payloadBytes(encoding, points);
+    m_header.frameStride = payload > 0 ? alignFrame(SnapshotFormat::kFrameHeaderBytes + payload) : 0;
+    m_header.keyframeInterval = encoding == SnapshotFormat::Encoding::DensityDelta16
+                                    ? static_cast<uint32_t>(keyframeInterval) : 1u;
+
+    m_file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        ERROR_LOG("SnapshotWriter", "Cannot create " + path);
+        throw std::runtime_error("Cannot create snapshot stream " + path);
+    }
+    writeHeader();
+
+    m_free = { &m_frames[0], &m_frames[1] };
+    m_thread = std::thread(&SnapshotWriter::threadMain, this);
+}
+
+// Write the remaining frames and stop the writer thread
+SnapshotWriter::~SnapshotWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        ERROR_LOG("SnapshotWriter", std::string("Snapshot stream not finished: ") + e.what());
+    }
+}
+
+// Copy the engine state into a free buffer and queue it
+bool SnapshotWriter::capture(const ISimulationEngine& engine, int64_t step) {
+    TRACE_SCOPE("Capture snapshot", "io");
+    Frame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_error) {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+        if (m_stopRequested) {
+            throw std::logic_error("Snapshot stream is closed");
+        }
+        if (!m_free.empty()) {
+            frame = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    if (!frame) {
+        fill(engine, m_discard);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_dropped;
+        return false;
+    }
+
+    frame->step = step;
+    frame->time = engine.getCurrentTime();
+    fill(engine, *frame);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(frame);
+    }
+    m_condition.notify_all();
+    return true;
+}
+
+// Read the engine state the way the encoding needs it
+void SnapshotWriter::fill(const ISimulationEngine& engine, Frame& frame) const {
+    const size_t points = static_cast<size_t>(m_header.nx) * static_cast<size_t>(m_header.ny);
+    switch (m_encoding) {
+        case SnapshotFormat::Encoding::Complex128: {
+            const Wavefunction& psi = engine.getWavefunction();
+            if (psi.size() != points) {
+                throw std::invalid_argument("Engine grid does not match the snapshot stream");
+            }
+            frame.psi.assign(psi.begin(), psi.end());
+            break;
+        }
+        case SnapshotFormat::Encoding::Complex64:
+            frame.values.resize(2 * points);
+            engine.writeWavefunctionField(frame.values.data());
+            break;
+        default:
+            frame.values.resize(points);
+            engine.writeProbabilityDensity(frame.values.data());
+            break;
+    }
+}
+
+// Make the collective read of a capture on a rank that does not write
+void SnapshotWriter::participate(const ISimulationEngine& engine, SnapshotFormat::Encoding encoding) {
+    switch (encoding) {
+        case SnapshotFormat::Encoding::Complex128:
+            engine.getWavefunction();
+            break;
+        case SnapshotFormat::Encoding::Complex64:
+            engine.writeWavefunctionField(nullptr);
+            break;
+        default:
+            engine.writeProbabilityDensity(nullptr);
+            break;
+    }
+}
+
+// Write the remaining frames and finish the file
+void SnapshotWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return;
+        }
+        m_stopRequested = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // The writer thread has exited, so the file is ours
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    if (!m_error) {
+        try {
+            finish();
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+    }
+    m_file.close();
+    rethrowError();
+}
+
+// Get the number of frames written so far
+size_t SnapshotWriter::getWrittenCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+// Get the number of dropped frames
+size_t SnapshotWriter::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+// Encode and append one frame
+void SnapshotWriter::writeFrame(const Frame& frame) {
+    TRACE_SCOPE("Write snapshot", "io");
+    const size_t points = static_cast<size_t>(m_header.nx) * static_cast<size_t>(m_header.ny);
+    SnapshotFrameHeader record{};
+    record.step = frame.step;
+    record.time = frame.time;
+    record.keyframe = 1;
+    const void* payload = nullptr;
+
+    switch (m_encoding) {
+        case SnapshotFormat::Encoding::Complex128:
+            payload = frame.psi.data();
+            record.payloadBytes = points * 2 * sizeof(double);
+            break;
+        case SnapshotFormat::Encoding::Complex64:
+        case SnapshotFormat::Encoding::Density32:
+            payload = frame.values.data();
+            record.payloadBytes = frame.values.size() * sizeof(float);
+            break;
+        case SnapshotFormat::Encoding::Density16:
+        case SnapshotFormat::Encoding::DensityDelta16: {
+            m_halves.resize(points);
+            for (size_t n = 0; n < points; ++n) {
+                m_halves[n] = SnapshotFormat::toHalf(frame.values[n]);
+            }
+            if (m_encoding == SnapshotFormat::Encoding::Density16) {
+                payload = m_halves.data();
+                record.payloadBytes = points * sizeof(uint16_t);
+                break;
+            }
+            // Keyframes are coded against zeros, the rest against the previous frame
+            const bool keyframe = m_header.frameCount % m_header.keyframeInterval == 0;
+            if (keyframe) {
+                m_previous.assign(points, 0);
+            }
+            encodeDelta(m_halves.data(), m_previous.data(), points, m_payload);
+            m_previous.swap(m_halves);
+            payload = m_payload.data();
+            record.payloadBytes = m_payload.size();
+            record.keyframe = keyframe ? 1 : 0;
+            break;
+        }
+    }
+
+    const uint64_t recordBytes = alignFrame(SnapshotFormat::kFrameHeaderBytes + record.payloadBytes);
+    static const char padding[SnapshotFormat::kFrameAlignment] = {};
+    m_file.seekp(static_cast<std::streamoff>(m_fileEnd));
+    m_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_file.write(static_cast<const char*>(payload), static_cast<std::streamsize>(record.payloadBytes));
+    m_file.write(padding, static_cast<std::streamsize>(recordBytes - SnapshotFormat::kFrameHeaderBytes -
+                                                       record.payloadBytes));
+
+    // Count the frame only once it is complete, so readers never see a partial one
+    m_index.push_back(m_fileEnd);
+    m_fileEnd += recordBytes;
+    ++m_header.frameCount;
+    writeHeader();
+}
+
+// Write the frame index of variable-size frames and the final header
+void SnapshotWriter::finish() {
+    if (m_header.frameStride == 0 && !m_index.empty()) {
+        m_file.seekp(static_cast<std::streamoff>(m_fileEnd));
+        m_file.write(reinterpret_cast<const char*>(m_index.data()),
+                     static_cast<std::streamsize>(m_index.size() * sizeof(uint64_t)));
+        m_header.indexOffset = m_fileEnd;
+        writeHeader();
+    }
+}
+
+// Rewrite the header at the start of the file
+void SnapshotWriter::writeHeader() {
+    std::vector<char> block(SnapshotFormat::kHeaderBytes, 0);
+    std::memcpy(block.data(), &m_header, sizeof(m_header));
+    m_file.seekp(0);
+    m_file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    m_file.flush();
+    if (!m_file) {
+        throw std::runtime_error("Cannot write snapshot stream " + m_path);
+    }
+}
+
+// Writer thread main loop
+void SnapshotWriter::threadMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this]() { return m_stopRequested || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;  // Stop requested and everything written
+        }
+        Frame* frame = m_queue.front();
+        m_queue.pop_front();
+        m_writing = true;
+        const bool failed = static_cast<bool>(m_error);
+        lock.unlock();
+
+        // After a failure the queue is only drained, so capture() can report it
+        std::exception_ptr error;
+        if (!failed) {
+            try {
+                writeFrame(*frame);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        m_writing = false;
+        m_free.push_back(frame);
+        if (error) {
+            m_error = error;
+        } else if (!failed) {
+            ++m_written;
+        }
+        m_condition.notify_all();
+    }
+}
+
+// Rethrow a stored write error
+void SnapshotWriter::rethrowError() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        error = m_error;
+        m_error = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Map a stream file and find its complete frames
+SnapshotReader::SnapshotReader(const std::string& path) {
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open snapshot stream " + path);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(SnapshotFormat::kHeaderBytes)) {
+        ::close(fd);
+        throw std::runtime_error("Not a snapshot stream: " + path);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map snapshot stream " + path);
+    }
+    m_data = static_cast<const unsigned char*>(mapping);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open snapshot stream " + path);
+    }
+    m_copy.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_copy.data()), static_cast<std::streamsize>(m_copy.size()));
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+#endif
+
+    try {
+        if (m_size < SnapshotFormat::kHeaderBytes) {
+            throw std::runtime_error("Not a snapshot stream: " + path);
+        }
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+        if (std::memcmp(m_header.magic, SnapshotFormat::kMagic, sizeof(m_header.magic)) != 0) {
+            throw std::runtime_error("Not a snapshot stream: " + path);
+        }
+        if (m_header.version != SnapshotFormat::kVersion) {
+            throw std::runtime_error("Unsupported snapshot stream version " + std::to_string(m_header.version) +
+                                     " in " + path);
+        }
+        if (m_header.encoding > static_cast<uint32_t>(SnapshotFormat::Encoding::DensityDelta16) ||
+            m_header.nx <= 0 || m_header.ny <= 0 || m_header.keyframeInterval == 0) {
+            throw std::runtime_error("Corrupt snapshot stream header in " + path);
+        }
+
+        const uint64_t available = m_size - SnapshotFormat::kHeaderBytes;
+        if (m_header.frameStride > 0) {
+            // Fixed-size frames: frame n is at a known offset
+            const uint64_t frames = std::min<uint64_t>(m_header.frameCount, available / m_header.frameStride);
+            m_offsets.resize(frames);
+            for (uint64_t n = 0; n < frames; ++n) {
+                m_offsets[n] = SnapshotFormat::kHeaderBytes + n * m_header.frameStride;
+            }
+        } else if (m_header.indexOffset > 0 &&
+                   m_header.indexOffset + m_header.frameCount * sizeof(uint64_t) <= m_size) {
+            m_offsets.resize(m_header.frameCount);
+            std::memcpy(m_offsets.data(), m_data + m_header.indexOffset, m_offsets.size() * sizeof(uint64_t));
+        } else {
+            // No index yet (stream still open or cut short): walk the frame headers
+            uint64_t offset = SnapshotFormat::kHeaderBytes;
+            for (uint64_t n = 0; n < m_header.frameCount; ++n) {
+                if (offset + SnapshotFormat::kFrameHeaderBytes > m_size) {
+                    break;
+                }
+                const auto* record = reinterpret_cast<const SnapshotFrameHeader*>(m_data + offset);
+                const uint64_t end = offset + SnapshotFormat::kFrameHeaderBytes + record->payloadBytes;
+                if (end > m_size) {
+                    break;
+                }
+                m_offsets.push_back(offset);
+                offset = alignFrame(end);
+            }
+        }
+        for (uint64_t offset : m_offsets) {
+            const auto* record = reinterpret_cast<const SnapshotFrameHeader*>(m_data + offset);
+            if (offset + SnapshotFormat::kFrameHeaderBytes + record->payloadBytes > m_size) {
+                throw std::runtime_error("Corrupt snapshot stream index in " + path);
+            }
+        }
+    } catch (...) {
+#ifndef _WIN32
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+        throw;
+    }
+}
+
+// Unmap the file
+SnapshotReader::~SnapshotReader() {
+#ifndef _WIN32
+    if (m_data) {
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
+
+// Get the header of a frame
+const SnapshotFrameHeader& SnapshotReader::getFrameHeader(size_t frame) const {
+    if (frame >= m_offsets.size()) {
+        throw std::out_of_range("Snapshot frame " + std::to_string(frame) + " is past the end of the stream");
+    }
+    return *reinterpret_cast<const SnapshotFrameHeader*>(m_data + m_offsets[frame]);
+}
+
+// Get the raw payload of a frame
+const void* SnapshotReader::getPayload(size_t frame) const {
+    getFrameHeader(frame);
+    return m_data + m_offsets[frame] + SnapshotFormat::kFrameHeaderBytes;
+}
+
+// Decode the probability density of a frame
+void SnapshotReader::readDensity(size_t frame, float* dst) const {
+    const SnapshotFrameHeader& record = getFrameHeader(frame);
+    const size_t points = static_cast<size_t>(m_header.nx) * static_cast<size_t>(m_header.ny);
+    const SnapshotFormat::Encoding encoding = getEncoding();
+    if (encoding != SnapshotFormat::Encoding::DensityDelta16 &&
+        record.payloadBytes != SnapshotFormat::payloadBytes(encoding, points)) {
+        throw std::runtime_error("Corrupt snapshot frame: unexpected payload size");
+    }
+    const void* payload = getPayload(frame);
+
+    switch (encoding) {
+        case SnapshotFormat::Encoding::Complex128: {
+            const double* psi = static_cast<const double*>(payload);
+            for (size_t n = 0; n < points; ++n) {
+                dst[n] = static_cast<float>(psi[2 * n] * psi[2 * n] + psi[2 * n + 1] * psi[2 * n + 1]);
+            }
+            break;
+        }
+        case SnapshotFormat::Encoding::Complex64: {
+            const float* psi = static_cast<const float*>(payload);
+            for (size_t n = 0; n < points; ++n) {
+                dst[n] = psi[2 * n] * psi[2 * n] + psi[2 * n + 1] * psi[2 * n + 1];
+            }
+            break;
+        }
+        case SnapshotFormat::Encoding::Density32:
+            std::memcpy(dst, payload, points * sizeof(float));
+            break;
+        case SnapshotFormat::Encoding::Density16: {
+            const uint16_t* halves = static_cast<const uint16_t*>(payload);
+            for (size_t n = 0; n < points; ++n) {
+                dst[n] = SnapshotFormat::fromHalf(halves[n]);
+            }
+            break;
+        }
+        case SnapshotFormat::Encoding::DensityDelta16:
+            decodeHalves(frame);
+            for (size_t n = 0; n < points; ++n) {
+                dst[n] = SnapshotFormat::fromHalf(m_decoded[n]);
+            }
+            break;
+    }
+}
+
+// Decode the wavefunction of a frame
+void SnapshotReader::readField(size_t frame, std::complex<double>* dst) const {
+    const SnapshotFormat::Encoding encoding = getEncoding();
+    if (!SnapshotFormat::storesField(encoding)) {
+        throw std::logic_error(std::string("Snapshot stream stores ") + SnapshotFormat::encodingName(encoding) +
+                               " densities, not the wavefunction");
+    }
+    const size_t points = static_cast<size_t>(m_header.nx) * static_cast<size_t>(m_header.ny);
+    if (getFrameHeader(frame).payloadBytes != SnapshotFormat::payloadBytes(encoding, points)) {
+        throw std::runtime_error("Corrupt snapshot frame: unexpected payload size");
+    }
+    const void* payload = getPayload(frame);
+    if (encoding == SnapshotFormat::Encoding::Complex128) {
+        std::memcpy(static_cast<void*>(dst), payload, points * sizeof(std::complex<double>));
+        return;
+    }
+    const float* psi = static_cast<const float*>(payload);
+    for (size_t n = 0; n < points; ++n) {
+        dst[n] = std::complex<double>(psi[2 * n], psi[2 * n + 1]);
+    }
+}
+
+// Decode a delta-coded frame from its keyframe, or from the cached frame
+void SnapshotReader::decodeHalves(size_t frame) const {
+    if (m_decodedFrame == frame) {
+        return;
+    }
+    const size_t points = static_cast<size_t>(m_header.nx) * static_cast<size_t>(m_header.ny);
+    size_t keyframe = frame;
+    while (!getFrameHeader(keyframe).keyframe) {
+        if (keyframe == 0) {
+            throw std::runtime_error("Corrupt snapshot stream: no keyframe before frame " + std::to_string(frame));
+        }
+        --keyframe;
+    }
+
+    size_t first = keyframe;
+    if (m_decodedFrame != static_cast<size_t>(-1) && m_decodedFrame >= keyframe && m_decodedFrame < frame) {
+        first = m_decodedFrame + 1;
+    } else {
+        m_decoded.assign(points, 0);
+    }
+    m_decodedFrame = static_cast<size_t>(-1);  // Invalid until the decode completes
+    for (size_t n = first; n <= frame; ++n) {
+        decodeDelta(static_cast<const unsigned char*>(getPayload(n)), getFrameHeader(n).payloadBytes,
+                    m_decoded.data(), points);
+    }
+    m_decodedFrame = frame;
+}
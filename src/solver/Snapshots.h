@@ -0,0 +1,390 @@
+#pragma once
+
+#include <complex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ISimulationEngine;
+
+/**
+ * @struct SnapshotFormat
+ * @brief Constants and codecs of snapshot stream files
+ *
+ * A stream is one file of ψ (or |ψ|²) frames that analysis tools can mmap
+ * and index directly. All values are little-endian.
+ *
+ * File layout (format version 1):
+ * - bytes [0, kHeaderBytes): SnapshotFileHeader, zero padded
+ * - frames, each a SnapshotFrameHeader (kFrameHeaderBytes) followed by
+ *   its payload, padded to a multiple of kFrameAlignment bytes
+ * - for variable-size encodings, an index of frameCount uint64 frame
+ *   offsets at indexOffset, written when the stream is closed
+ *
+ * With a fixed-size encoding frame n starts at kHeaderBytes + n * frameStride
+ * and its payload is the raw array, so it can be used in place. frameCount
+ * is updated after every frame, so a stream that is still being written,
+ * or whose writer was killed, can be read up to its last complete frame.
+ *
+ * Payloads (x fastest, nx * ny points):
+ * - Complex128: ψ as float64 re/im pairs
+ * - Complex64: ψ as float32 re/im pairs
+ * - Density32: |ψ|² as float32
+ * - Density16: |ψ|² as IEEE binary16 (about 3 significant digits;
+ *   values below 6e-8 become 0)
+ * - DensityDelta16: the Density16 bit patterns as differences from the
+ *   previous frame, zigzag varint coded, with runs of unchanged values
+ *   stored as a 0 byte plus a varint run length. Every keyframeInterval-th
+ *   frame is coded against zeros, so decoding frame n starts at the
+ *   keyframe before it.
+ */
+struct SnapshotFormat {
+    /**
+     * @enum Encoding
+     * @brief What a frame stores and how
+     */
+    enum class Encoding : uint32_t {
+        Complex128 = 0,
+        Complex64 = 1,
+        Density32 = 2,
+        Density16 = 3,
+        DensityDelta16 = 4
+    };
+
+    static constexpr char kMagic[8] = {'Q', 'M', 'S', 'N', 'A', 'P', '0', '1'};  ///< File signature
+    static constexpr uint32_t kVersion = 1;             ///< Format version
+    static constexpr size_t kHeaderBytes = 4096;        ///< Bytes before the first frame
+    static constexpr size_t kFrameHeaderBytes = 64;     ///< Bytes before each payload
+    static constexpr size_t kFrameAlignment = 64;       ///< Frames start on multiples of this
+
+    /**
+     * @brief Parse an encoding name
+     * @param name "complex128", "complex64", "float32", "float16" or "delta16"
+     * @return The matching encoding
+     * @throws std::invalid_argument if name is not recognized
+     */
+    static Encoding parseEncoding(const std::string& name);
+
+    /**
+     * @brief Get the name of an encoding, as accepted by parseEncoding()
+     * @param encoding Frame encoding
+     * @return The encoding name
+     */
+    static const char* encodingName(Encoding encoding);
+
+    /**
+     * @brief Check whether an encoding stores ψ rather than |ψ|²
+     * @param encoding Frame encoding
+     * @return True for Complex128 and Complex64
+     */
+    static bool storesField(Encoding encoding);
+
+    /**
+     * @brief Get the payload size of a fixed-size encoding
+     * @param encoding Frame encoding
+     * @param points Grid points per frame
+     * @return Payload bytes, or 0 for DensityDelta16, whose frames vary in size
+     */
+    static size_t payloadBytes(Encoding encoding, size_t points);
+
+    /**
+     * @brief Convert to IEEE binary16, rounding to nearest even
+     * @param value Value to convert
+     * @return Bit pattern of the half-precision value
+     */
+    static uint16_t toHalf(float value);
+
+    /**
+     * @brief Convert from IEEE binary16
+     * @param bits Bit pattern of a half-precision value
+     * @return The value
+     */
+    static float fromHalf(uint16_t bits);
+};
+
+/**
+ * @struct SnapshotFileHeader
+ * @brief Fixed header at the start of a snapshot stream
+ */
+struct SnapshotFileHeader {
+    char magic[8];              ///< SnapshotFormat::kMagic
+    uint32_t version;           ///< SnapshotFormat::kVersion
+    uint32_t encoding;          ///< SnapshotFormat::Encoding of every frame
+    int32_t nx;                 ///< Grid points in x direction
+    int32_t ny;                 ///< Grid points in y direction
+    double lx;                  ///< Physical length of the domain in x direction
+    double ly;                  ///< Physical length of the domain in y direction
+    double dt;                  ///< Time step of the run
+    uint64_t frameStride;       ///< Bytes per frame including its header (0 = variable)
+    uint64_t frameCount;        ///< Complete frames in the file
+    uint64_t indexOffset;       ///< File offset of the frame index (0 = none yet)
+    uint32_t keyframeInterval;  ///< Frames per DensityDelta16 keyframe (1 for other encodings)
+    uint32_t reserved;          ///< Zero
+};
+
+/**
+ * @struct SnapshotFrameHeader
+ * @brief Header in front of every frame payload
+ */
+struct SnapshotFrameHeader {
+    int64_t step;           ///< Step number of the frame
+    double time;            ///< Simulation time of the frame
+    uint64_t payloadBytes;  ///< Payload size in bytes
+    uint32_t keyframe;      ///< 1 if the payload does not depend on earlier frames
+    uint32_t reserved[9];   ///< Zero
+};
+
+static_assert(std::is_trivially_copyable<SnapshotFileHeader>::value && sizeof(SnapshotFileHeader) == 80,
+              "SnapshotFileHeader must match the documented layout");
+static_assert(sizeof(SnapshotFrameHeader) == SnapshotFormat::kFrameHeaderBytes,
+              "SnapshotFrameHeader must fill kFrameHeaderBytes");
+
+/**
+ * @class SnapshotWriter
+ * @brief Streams snapshots of an engine to a file from a background thread
+ *
+ * capture() copies the engine state into one of two frame buffers and
+ * returns; encoding and file I/O happen on the writer thread, so stepping
+ * only pays for the copy. While the writer is still busy with both buffers
+ * further frames are dropped and counted instead of blocking the caller;
+ * every frame records its step, so gaps are visible to readers.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Create the file and start the writer thread
+     * @param path Output file; an existing file is replaced
+     * @param encoding Frame encoding
+     * @param nx Grid points in x direction
+     * @param ny Grid points in y direction
+     * @param lx Physical length of the domain in x direction
+     * @param ly Physical length of the domain in y direction
+     * @param dt Time step of the run
+     * @param keyframeInterval Frames per keyframe for DensityDelta16 (at least 1)
+     * @throws std::runtime_error if the file cannot be created
+     * @throws std::invalid_argument if the grid is empty or keyframeInterval < 1
+     */
+    SnapshotWriter(const std::string& path, SnapshotFormat::Encoding encoding, int nx, int ny,
+                   double lx, double ly, double dt, int keyframeInterval = 32);
+
+    /**
+     * @brief Write the remaining frames and stop the writer thread
+     */
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    /**
+     * @brief Queue a snapshot of the engine's current state
+     *
+     * The state is read even when the frame is dropped, because that read
+     * is collective for a distributed engine.
+     *
+     * @param engine Engine to read; its grid must match the stream
+     * @param step Step number recorded with the frame
+     * @return False if both buffers were busy and the frame was dropped
+     * @throws std::runtime_error if an earlier write failed
+     */
+    bool capture(const ISimulationEngine& engine, int64_t step);
+
+    /**
+     * @brief Take part in a capture on a rank that does not write
+     *
+     * Performs the collective read capture() makes, without keeping it.
+     *
+     * @param engine The distributed engine
+     * @param encoding Encoding of the stream written by the output rank
+     */
+    static void participate(const ISimulationEngine& engine, SnapshotFormat::Encoding encoding);
+
+    /**
+     * @brief Write the remaining frames, finish the file and stop the thread
+     * @throws std::runtime_error if writing failed
+     */
+    void close();
+
+    /**
+     * @brief Get the number of frames written so far
+     * @return Completed frames
+     */
+    size_t getWrittenCount() const;
+
+    /**
+     * @brief Get the number of frames dropped because the writer fell behind
+     * @return Dropped frame count
+     */
+    size_t getDroppedCount() const;
+
+private:
+    /**
+     * @struct Frame
+     * @brief One captured state waiting to be written
+     */
+    struct Frame {
+        int64_t step = 0;                        ///< Step number
+        double time = 0.0;                       ///< Simulation time
+        std::vector<float> values;               ///< |ψ|² or float re/im pairs
+        std::vector<std::complex<double>> psi;   ///< ψ for Complex128
+    };
+
+    /**
+     * @brief Read the engine state into a frame buffer
+     * @param engine Engine to read
+     * @param frame Destination
+     */
+    void fill(const ISimulationEngine& engine, Frame& frame) const;
+
+    /**
+     * @brief Encode and append one frame, then update the header
+     * @param frame Frame to write
+     */
+    void writeFrame(const Frame& frame);
+
+    /**
+     * @brief Write the frame index and the final header
+     */
+    void finish();
+
+    /**
+     * @brief Write the file header at the start of the file
+     */
+    void writeHeader();
+
+    /**
+     * @brief Writer thread main loop
+     */
+    void threadMain();
+
+    /**
+     * @brief Rethrow a stored write error, clearing it
+     */
+    void rethrowError();
+
+    std::string m_path;                  ///< Output file
+    SnapshotFormat::Encoding m_encoding; ///< Frame encoding
+    SnapshotFileHeader m_header;         ///< Current header (writer thread after construction)
+    std::fstream m_file;                 ///< Output stream (writer thread only)
+    uint64_t m_fileEnd;                  ///< Offset of the next frame
+    std::vector<uint64_t> m_index;       ///< Offset of every written frame
+    std::vector<uint16_t> m_halves;      ///< Half-precision values of the current frame
+    std::vector<uint16_t> m_previous;    ///< Half-precision values of the previous frame (delta coding)
+    std::vector<unsigned char> m_payload;  ///< Encoded payload of the current frame
+    Frame m_discard;                     ///< Destination of dropped captures
+
+    Frame m_frames[2];                   ///< The double buffer
+    mutable std::mutex m_mutex;          ///< Guards the members below
+    std::condition_variable m_condition; ///< Signals queued frames, free buffers and stop
+    std::vector<Frame*> m_free;          ///< Buffers available to capture()
+    std::deque<Frame*> m_queue;          ///< Captured frames in order
+    bool m_writing = false;              ///< The writer thread holds a frame
+    bool m_stopRequested = false;        ///< Writer thread should drain and exit
+    bool m_closed = false;               ///< close() has finished
+    size_t m_written = 0;                ///< Completed frames
+    size_t m_dropped = 0;                ///< Frames dropped because both buffers were busy
+    std::exception_ptr m_error;          ///< First write failure not yet reported
+
+    std::thread m_thread;  ///< The writer thread
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Memory-maps a snapshot stream for random access to its frames
+ *
+ * Frames of fixed-size encodings are served straight from the mapping.
+ * DensityDelta16 frames are decoded from their keyframe; the last decoded
+ * frame is cached, so reading forward costs one delta per frame. A reader
+ * is not safe for concurrent use; open one per thread instead.
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief Map a stream file
+     * @param path Stream written by SnapshotWriter (complete or still being written)
+     * @throws std::runtime_error if the file cannot be mapped or is not a snapshot stream
+     */
+    explicit SnapshotReader(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * @brief Get the file header
+     * @return Header as stored in the file
+     */
+    const SnapshotFileHeader& getHeader() const { return m_header; }
+
+    /**
+     * @brief Get the frame encoding
+     * @return Encoding of every frame
+     */
+    SnapshotFormat::Encoding getEncoding() const { return static_cast<SnapshotFormat::Encoding>(m_header.encoding); }
+
+    /**
+     * @brief Get the number of complete frames in the mapping
+     * @return Frame count
+     */
+    size_t getFrameCount() const { return m_offsets.size(); }
+
+    /**
+     * @brief Get the header of a frame
+     * @param frame Frame index
+     * @return The frame header
+     * @throws std::out_of_range if frame is not below getFrameCount()
+     */
+    const SnapshotFrameHeader& getFrameHeader(size_t frame) const;
+
+    /**
+     * @brief Get the raw payload of a frame inside the mapping
+     * @param frame Frame index
+     * @return Pointer to payloadBytes of the frame's payload, 64-byte aligned
+     * @throws std::out_of_range if frame is not below getFrameCount()
+     */
+    const void* getPayload(size_t frame) const;
+
+    /**
+     * @brief Decode |ψ|² of a frame
+     * @param frame Frame index
+     * @param dst Destination for nx * ny floats in storage order
+     * @throws std::out_of_range if frame is not below getFrameCount()
+     * @throws std::runtime_error if the payload is corrupt
+     */
+    void readDensity(size_t frame, float* dst) const;
+
+    /**
+     * @brief Decode ψ of a frame
+     * @param frame Frame index
+     * @param dst Destination for nx * ny values in storage order
+     * @throws std::out_of_range if frame is not below getFrameCount()
+     * @throws std::logic_error if the stream stores only densities
+     */
+    void readField(size_t frame, std::complex<double>* dst) const;
+
+private:
+    /**
+     * @brief Decode the DensityDelta16 half values of a frame into m_decoded
+     * @param frame Frame index
+     */
+    void decodeHalves(size_t frame) const;
+
+    const unsigned char* m_data = nullptr;  ///< Start of the mapping
+    size_t m_size = 0;                      ///< Mapped bytes
+    std::vector<unsigned char> m_copy;      ///< File contents where mmap is unavailable
+    SnapshotFileHeader m_header{};          ///< Copy of the file header
+    std::vector<uint64_t> m_offsets;        ///< Offset of every complete frame
+    mutable std::vector<uint16_t> m_decoded;  ///< Half values of the cached DensityDelta16 frame
+    mutable size_t m_decodedFrame = static_cast<size_t>(-1);  ///< Frame held in m_decoded (-1 = none)
+};
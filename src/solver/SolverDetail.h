@@ -0,0 +1,312 @@
+#pragma once
+
+// Helpers shared by the engine implementations (SimulationEngine.cpp,
+// EnsembleEngine.cpp, DistributedSimulationEngine.cpp); not part of the
+// solver's public interface.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fftw3.h>
+#include "FFTWWisdom.h"
+#include "SplittingScheme.h"
+#include "../core/GridPool.h"
+#include "../core/PhysicsConfig.h"
+#include "../core/Potential.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace solver_detail {
+
+// Resolve a requested thread count (0 = OpenMP default) to the number actually used
+inline int resolveThreadCount(int requested) {
+#ifdef _OPENMP
+    return requested > 0 ? requested : omp_get_max_threads();
+#else
+    (void)requested;
+    return 1;
+#endif
+}
+
+// Index of the calling thread in its OpenMP team
+inline int threadIndex() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Pointwise passes are split into blocks of this many complex values
+// (64 KiB of wavefunction data) that are handed to the SIMD kernels in parallel
+constexpr std::ptrdiff_t kKernelBlock = 4096;
+
+// Run kernel(begin, count) over [0, size) in parallel blocks
+template <typename Kernel>
+void forEachBlock(std::ptrdiff_t size, int numThreads, Kernel kernel) {
+    const std::ptrdiff_t blocks = (size + kKernelBlock - 1) / kKernelBlock;
+    
+    #pragma omp parallel for num_threads(numThreads)
+    for (std::ptrdiff_t b = 0; b < blocks; ++b) {
+        std::ptrdiff_t begin = b * kKernelBlock;
+        kernel(begin, static_cast<size_t>(std::min(kKernelBlock, size - begin)));
+    }
+}
+
+// Sample every row of a potential in parallel, handing each to
+// consume(j, values). Exceptions must not leave an OpenMP region, so the
+// first one a row throws is rethrown here once the loop has finished
+template <typename Consume>
+void sampleRows(const Potential& potential, const GridGeometry& grid, int numThreads, Consume consume) {
+    std::exception_ptr error;
+    
+    #pragma omp parallel num_threads(numThreads)
+    {
+        std::vector<double> row(static_cast<size_t>(grid.nx));
+        
+        #pragma omp for
+        for (int j = 0; j < grid.ny; ++j) {
+            try {
+                potential.sampleRow(grid, j, row.data());
+                consume(j, row.data());
+            } catch (...) {
+                #pragma omp critical(qmsim_sample_rows)
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Thin wrappers selecting FFTW's double (fftw_) or float (fftwf_) interface
+template <typename Real> struct FFTW;
+
+template <> struct FFTW<double> {
+    using Plan = fftw_plan;
+    static constexpr FFTWWisdom::Precision precision = FFTWWisdom::Precision::Double;
+    static fftw_plan planDft2d(int n0, int n1, std::complex<double>* data, int sign, unsigned flags) {
+        fftw_complex* inout = reinterpret_cast<fftw_complex*>(data);
+        return fftw_plan_dft_2d(n0, n1, inout, inout, sign, flags);
+    }
+    // howmany contiguous n0 x n1 transforms, distance n0*n1 apart
+    static fftw_plan planMany2d(int n0, int n1, int howmany, std::complex<double>* data, int sign, unsigned flags) {
+        const int n[2] = {n0, n1};
+        fftw_complex* inout = reinterpret_cast<fftw_complex*>(data);
+        return fftw_plan_many_dft(2, n, howmany, inout, nullptr, 1, n0 * n1, inout, nullptr, 1, n0 * n1, sign, flags);
+    }
+    static void execute(fftw_plan plan) { fftw_execute(plan); }
+    static void destroy(fftw_plan plan) { fftw_destroy_plan(plan); }
+#ifdef QMSIM_FFTW_THREADS
+    static bool initThreads() { return fftw_init_threads() != 0; }
+    static void planWithThreads(int numThreads) { fftw_plan_with_nthreads(numThreads); }
+#endif
+};
+
+template <> struct FFTW<float> {
+    using Plan = fftwf_plan;
+    static constexpr FFTWWisdom::Precision precision = FFTWWisdom::Precision::Float;
+    static fftwf_plan planDft2d(int n0, int n1, std::complex<float>* data, int sign, unsigned flags) {
+        fftwf_complex* inout = reinterpret_cast<fftwf_complex*>(data);
+        return fftwf_plan_dft_2d(n0, n1, inout, inout, sign, flags);
+    }
+    // howmany contiguous n0 x n1 transforms, distance n0*n1 apart
+    static fftwf_plan planMany2d(int n0, int n1, int howmany, std::complex<float>* data, int sign, unsigned flags) {
+        const int n[2] = {n0, n1};
+        fftwf_complex* inout = reinterpret_cast<fftwf_complex*>(data);
+        return fftwf_plan_many_dft(2, n, howmany, inout, nullptr, 1, n0 * n1, inout, nullptr, 1, n0 * n1, sign, flags);
+    }
+    static void execute(fftwf_plan plan) { fftwf_execute(plan); }
+    static void destroy(fftwf_plan plan) { fftwf_destroy_plan(plan); }
+#ifdef QMSIM_FFTW_THREADS
+    static bool initThreads() { return fftwf_init_threads() != 0; }
+    static void planWithThreads(int numThreads) { fftwf_plan_with_nthreads(numThreads); }
+#endif
+};
+
+// Prepare FFTW to plan with numThreads threads; returns the thread count the
+// plans will use. Call with FFTWWisdom::plannerMutex() held.
+template <typename Real>
+int preparePlannerThreads(int numThreads) {
+#ifdef QMSIM_FFTW_THREADS
+    // Initialize FFTW's thread support once per process and precision
+    static const bool fftwThreadsReady = FFTW<Real>::initThreads();
+    if (fftwThreadsReady) {
+        FFTW<Real>::planWithThreads(numThreads);
+        return numThreads;
+    }
+#endif
+    (void)numThreads;
+    return 1;
+}
+
+// Fill mask with the damping exp(-W*dt/2) of an absorbing layer on an
+// nx x ny grid centred on the origin, for rows [firstRow, firstRow + rows)
+// (rows < 0 = all); leaves it empty when the layer is off. Mask is a
+// std::vector<double> or a GridVector<double>
+template <typename Mask>
+void buildAbsorberMask(const AbsorbingBoundary& absorber, int nx, int ny, double lx, double ly,
+                       double dt, int numThreads, Mask& mask, int firstRow = 0, int rows = -1) {
+    const double width = std::min({absorber.width, lx / 2, ly / 2});
+    if (!(width > 0.0) || !(absorber.strength > 0.0)) {
+        mask.clear();
+        return;
+    }
+    const int count = rows < 0 ? ny : rows;
+    // Take a block of exactly the new size, like resizeGrid()
+    const size_t size = static_cast<size_t>(nx) * count;
+    if (mask.size() != size) {
+        Mask().swap(mask);
+        mask.resize(size);
+    }
+    const double dx = lx / nx;
+    const double dy = ly / ny;
+    
+    // Depth into the layer from the nearest edge, measured from the inner boundary
+    auto depth = [width](double position, double half) { return std::max(0.0, std::abs(position) - (half - width)); };
+    
+    #pragma omp parallel for num_threads(numThreads)
+    for (int r = 0; r < count; ++r) {
+        const double depthY = depth(-ly/2 + (firstRow + r) * dy, ly/2);
+        double* row = mask.data() + static_cast<size_t>(r) * nx;
+        for (int i = 0; i < nx; ++i) {
+            // The corner regions take the deeper of the two layers
+            const double d = std::max(depth(-lx/2 + i * dx, lx/2), depthY) / width;
+            row[i] = std::exp(-absorber.strength * d * d * dt / 2.0);
+        }
+    }
+}
+
+// Data of a stage table: host tables are GridVectors, device tables raw pointers
+template <typename T>
+const T* stageData(const GridVector<T>& phase) { return phase.data(); }
+template <typename T>
+const T* stageData(T* phase) { return phase; }
+
+// Find the table of a stage weight in an engine's list of {weight, phase}
+// tables; returns null if there is none for the weight
+template <typename Stage>
+auto findStage(const std::vector<Stage>& stages, double weight) -> decltype(stageData(stages.front().phase)) {
+    for (const Stage& stage : stages) {
+        if (stage.weight == weight) {
+            return stageData(stage.phase);
+        }
+    }
+    return nullptr;
+}
+
+// Potential stage weights of a splitting: every a plus the merged
+// last-and-first stage of consecutive steps
+inline std::vector<double> potentialStageWeights(const SplittingScheme& scheme) {
+    std::vector<double> weights = scheme.a;
+    weights.push_back(scheme.a.back() + scheme.a.front());
+    return weights;
+}
+
+// Append a table for each weight that has none yet; make(weight) returns
+// the filled phase table
+template <typename Stage, typename Make>
+void buildStageTables(std::vector<Stage>& stages, const std::vector<double>& weights, Make make) {
+    for (double weight : weights) {
+        if (!findStage(stages, weight)) {
+            stages.push_back(Stage{weight, make(weight)});
+        }
+    }
+}
+
+// A time-dependent driven potential whose V0 and V1 can be tabulated once,
+// leaving only the drive amplitude to follow the time; null otherwise
+inline const DrivenPotential* tabulatedDrive(const Potential& potential) {
+    const auto* driven = dynamic_cast<const DrivenPotential*>(&potential);
+    if (driven && !driven->getBase().isTimeDependent() && !driven->getCoupling().isTimeDependent()) {
+        return driven;
+    }
+    return nullptr;
+}
+
+// A moving potential whose shape can be tabulated once and shifted; null otherwise
+inline const MovingPotential* tabulatedShape(const Potential& potential) {
+    const auto* moving = dynamic_cast<const MovingPotential*>(&potential);
+    if (moving && !moving->getShape().isTimeDependent()) {
+        return moving;
+    }
+    return nullptr;
+}
+
+// Signed frequency of FFT bin i of n, in the k-grid order of the engines
+// (0, 1, ..., n/2, -(n-1)/2 ... -1 with the Nyquist bin counted as positive)
+inline int binFrequency(int i, int n) {
+    return i <= n / 2 ? i : i - n;
+}
+
+// Resample a periodic field from an nx x ny grid onto newNx x newNy grid
+// points over the same domain by zero-padding or truncating its Fourier
+// coefficients. Both arrays are row-major with x fastest. Band-limited
+// fields are reproduced exactly, and the norm sum |ψ|² dx dy is kept up
+// to the truncated modes. Uses one-off FFTW_ESTIMATE plans, which neither
+// measure nor touch the arrays while planning.
+template <typename Real>
+void resampleSpectral(const std::complex<Real>* src, int nx, int ny, std::complex<Real>* dst,
+                      int newNx, int newNy, int numThreads) {
+    using Complex = std::complex<Real>;
+    GridPool::FirstTouchScope firstTouch(numThreads);
+    GridVector<Complex> spectrum(src, src + static_cast<size_t>(nx) * ny);
+    const size_t size = static_cast<size_t>(newNx) * newNy;
+    std::fill(dst, dst + size, Complex(0, 0));
+    
+    typename FFTW<Real>::Plan forward = nullptr;
+    typename FFTW<Real>::Plan backward = nullptr;
+    {
+        std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+        preparePlannerThreads<Real>(numThreads);
+        forward = FFTW<Real>::planDft2d(ny, nx, spectrum.data(), FFTW_FORWARD, FFTW_ESTIMATE);
+        backward = FFTW<Real>::planDft2d(newNy, newNx, dst, FFTW_BACKWARD, FFTW_ESTIMATE);
+        if (!forward || !backward) {
+            if (forward) {
+                FFTW<Real>::destroy(forward);
+            }
+            if (backward) {
+                FFTW<Real>::destroy(backward);
+            }
+            throw std::runtime_error("Failed to create FFTW plans for resampling");
+        }
+    }
+    FFTW<Real>::execute(forward);
+    
+    // Copy every mode the new grid can represent; the old grid's 1/(nx*ny)
+    // normalization makes the backward transform interpolate ψ itself
+    const Real scale = static_cast<Real>(1.0 / (static_cast<double>(nx) * ny));
+    for (int j = 0; j < ny; ++j) {
+        const int fy = binFrequency(j, ny);
+        const int row = fy >= 0 ? fy : fy + newNy;
+        if (row < 0 || row >= newNy || binFrequency(row, newNy) != fy) {
+            continue;
+        }
+        for (int i = 0; i < nx; ++i) {
+            const int fx = binFrequency(i, nx);
+            const int column = fx >= 0 ? fx : fx + newNx;
+            if (column < 0 || column >= newNx || binFrequency(column, newNx) != fx) {
+                continue;
+            }
+            dst[static_cast<size_t>(row) * newNx + column] = spectrum[static_cast<size_t>(j) * nx + i] * scale;
+        }
+    }
+    
+    FFTW<Real>::execute(backward);
+    std::lock_guard<std::mutex> plannerLock(FFTWWisdom::plannerMutex());
+    FFTW<Real>::destroy(forward);
+    FFTW<Real>::destroy(backward);
+}
+
+}  // namespace solver_detail
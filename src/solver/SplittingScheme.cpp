@@ -0,0 +1,57 @@
+#include "SplittingScheme.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// V/2 K V/2
+SplittingScheme makeStrang() {
+    return {"strang", 2, {0.5, 0.5}, {1.0}};
+}
+
+// Three Strang steps of w1*dt, w0*dt and w1*dt with w0 + 2*w1 = 1
+SplittingScheme makeYoshida4() {
+    const double cbrt2 = std::cbrt(2.0);
+    const double w1 = 1.0 / (2.0 - cbrt2);
+    const double w0 = 1.0 - 2.0 * w1;
+    return {"yoshida4", 4, {w1 / 2, (w0 + w1) / 2, (w0 + w1) / 2, w1 / 2}, {w1, w0, w1}};
+}
+
+// S. Blanes and P. C. Moan, J. Comput. Appl. Math. 142, 313 (2002), S6
+SplittingScheme makeBlanesMoan4() {
+    const double a1 = 0.0792036964311957;
+    const double a2 = 0.353172906049774;
+    const double a3 = -0.0420650803577195;
+    const double a4 = 1.0 - 2.0 * (a1 + a2 + a3);
+    const double b1 = 0.209515106613362;
+    const double b2 = -0.143851773179818;
+    const double b3 = 0.5 - b1 - b2;
+    return {"blanes-moan4", 4, {a1, a2, a3, a4, a3, a2, a1}, {b1, b2, b3, b3, b2, b1}};
+}
+
+}  // namespace
+
+// Look up a scheme by name
+const SplittingScheme& SplittingScheme::fromName(const std::string& name) {
+    static const SplittingScheme yoshida4 = makeYoshida4();
+    static const SplittingScheme blanesMoan4 = makeBlanesMoan4();
+    if (name == "strang") return strang();
+    if (name == "yoshida4") return yoshida4;
+    if (name == "blanes-moan4") return blanesMoan4;
+    throw std::invalid_argument("Unknown integrator: " + name);
+}
+
+// Get the Strang splitting
+const SplittingScheme& SplittingScheme::strang() {
+    static const SplittingScheme scheme = makeStrang();
+    return scheme;
+}
+
+// Time of a potential stage relative to the step start
+double SplittingScheme::stageTime(size_t stage) const {
+    double time = 0.0;
+    for (size_t j = 0; j < stage && j < b.size(); ++j) {
+        time += b[j];
+    }
+    return time;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct SplittingScheme
+ * @brief Symmetric operator splitting V(a0) K(b0) V(a1) ... K(b[s-1]) V(a[s])
+ *
+ * One step of size dt applies exp(-i*a[j]*V*dt) and exp(-i*b[j]*K*dt) in
+ * turn, so the scheme costs one FFT pair per kinetic stage. The potential
+ * stage j acts at t + (b[0] + ... + b[j-1])*dt, which keeps the order for
+ * time-dependent potentials. Both coefficient lists are palindromes; a[s]
+ * and a[0] of consecutive steps merge into one stage.
+ *
+ * Schemes:
+ * - "strang": second order, one FFT pair per step
+ * - "yoshida4": fourth-order triple jump of Strang steps (Yoshida,
+ *   Forest-Ruth), three FFT pairs per step
+ * - "blanes-moan4": fourth-order optimized splitting (Blanes and Moan's
+ *   S6), six FFT pairs per step; for the same number of FFTs it is about
+ *   fifty times more accurate than yoshida4 on a harmonic trap
+ */
+struct SplittingScheme {
+    std::string name;       ///< Name accepted by fromName()
+    int order = 2;          ///< Global order of accuracy
+    std::vector<double> a;  ///< Potential stage weights, s + 1 values
+    std::vector<double> b;  ///< Kinetic stage weights, s values
+
+    /**
+     * @brief Look up a scheme by name
+     * @param name "strang", "yoshida4" or "blanes-moan4"
+     * @return The scheme's coefficients
+     * @throws std::invalid_argument if name is not recognized
+     */
+    static const SplittingScheme& fromName(const std::string& name);
+
+    /**
+     * @brief Get the second-order Strang splitting V/2 K V/2
+     * @return The scheme's coefficients
+     */
+    static const SplittingScheme& strang();
+
+    /**
+     * @brief Check whether this is the Strang splitting
+     * @return True for V/2 K V/2
+     */
+    bool isStrang() const { return b.size() == 1; }
+
+    /**
+     * @brief Get the time of a potential stage relative to the step start
+     * @param stage Potential stage index, 0 to s
+     * @return b[0] + ... + b[stage-1], in units of dt
+     */
+    double stageTime(size_t stage) const;
+};
@@ -4,40 +4,37 @@
 #include <imgui_impl_opengl3.h>
 #include <iostream>
 #include <algorithm>
+#include <cfloat>
+#include <cstdio>
 #include <GLFW/glfw3.h>
 #include "../solver/ISimulationEngine.h"
 #include "../core/DebugUtils.h"
+#include "../core/Trace.h"
 #include "../core/Events.h"
 
-UIManager::UIManager(std::shared_ptr<EventBus> eventBus)
-    : m_eventBus(eventBus) {
+UIManager::UIManager(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus)
+    : m_config(config), m_eventBus(eventBus) {
     DEBUG_LOG("UIManager", "Constructing UIManager");
-    // Initialize default config values
-    m_config.nx = 512;
-    m_config.ny = 512;
-    m_config.dt = 0.001;
-    m_config.omega = 1.0;
-    
-    // Default potential (Free Space)
-    m_config.potential.type = "FreeSpace";
-    m_config.potential.parameters = {};
-    
-    // Default wavepacket
-    m_config.wavepacket.x0 = 0.0;
-    m_config.wavepacket.y0 = 0.0;
-    m_config.wavepacket.sigmaX = 0.1;
-    m_config.wavepacket.sigmaY = 0.1;
-    m_config.wavepacket.kx = 5.0;
-    m_config.wavepacket.ky = 0.0;
-    
-    // Default output
-    m_config.output.checkpointInterval = 1.0;
-    m_config.output.exportObservables = false;
-    
-    // Copy config to UI state
+    // Start from the engine's configuration, so applying the widgets only
+    // changes the fields they edit and keeps the grid, threads and planner
     m_uiState.dt = static_cast<float>(m_config.dt);
-    m_uiState.potentialType = 0; // Free Space
-    m_uiState.harmonicOmega = static_cast<float>(m_config.omega);
+    const std::vector<double>& parameters = m_config.potential.parameters;
+    if (m_config.potential.type == "SquareBarrier" && parameters.size() >= 4) {
+        m_uiState.potentialType = 1;
+        m_uiState.barrierHeight = static_cast<float>(parameters[0]);
+        m_uiState.barrierWidth = static_cast<float>(parameters[1]);
+        m_uiState.barrierX = static_cast<float>(parameters[2]);
+        m_uiState.barrierY = static_cast<float>(parameters[3]);
+    }
+    else if (m_config.potential.type == "HarmonicOscillator") {
+        m_uiState.potentialType = 2;
+        if (!parameters.empty()) {
+            m_uiState.harmonicOmega = static_cast<float>(parameters[0]);
+        }
+    }
+    else {
+        m_uiState.potentialType = 0; // Free Space
+    }
     m_uiState.waveX0 = static_cast<float>(m_config.wavepacket.x0);
     m_uiState.waveY0 = static_cast<float>(m_config.wavepacket.y0);
     m_uiState.waveSigmaX = static_cast<float>(m_config.wavepacket.sigmaX);
@@ -183,6 +180,7 @@ void UIManager::processInput() {
 }
 
 void UIManager::render() {
+    TRACE_SCOPE("UI", "render");
     if (!m_initialized) return;
     
     // Start the ImGui frame
@@ -207,6 +205,7 @@ void UIManager::render() {
     renderPotentialSettings();
     renderWavepacketSettings();
     renderDiagnostics();
+    renderDisplaySettings();
     renderEventMonitor();
     
     ImGui::End();
@@ -301,12 +300,8 @@ void UIManager::renderPotentialSettings() {
             updateConfig(updatedConfig);
             
             try {
-                // Update the engine with the new configuration
-                m_engine->updateConfig(updatedConfig);
-                
-                // Uncommented the previously commented-out method call
-                // and use a safer approach by using the interface method
-                m_engine->setPotential(createPotentialFromConfig(updatedConfig.potential));
+                // Only the changed tables are rebuilt and the running state carries over
+                m_engine->updateConfig(updatedConfig, true);
             }
             catch (const std::exception& e) {
                 std::cerr << "Error updating potential: " << e.what() << std::endl;
@@ -317,12 +312,6 @@ void UIManager::renderPotentialSettings() {
     ImGui::Separator();
 }
 
-// Helper method to create a potential object from configuration
-std::unique_ptr<Potential> UIManager::createPotentialFromConfig(const PotentialConfig& config) {
-    // Use the static factory method from Potential class
-    return Potential::create(config.type, config.parameters);
-}
-
 void UIManager::renderWavepacketSettings() {
     ImGui::Text("Initial Wavepacket");
     
@@ -343,14 +332,13 @@ void UIManager::renderWavepacketSettings() {
                 m_engine->reset();
                 
                 // Log the update
-                std::cout << "Updated wavepacket configuration: "
-                          << "x0=" << updatedConfig.wavepacket.x0 
-                          << ", y0=" << updatedConfig.wavepacket.y0
-                          << ", sigmaX=" << updatedConfig.wavepacket.sigmaX
-                          << ", sigmaY=" << updatedConfig.wavepacket.sigmaY
-                          << ", kx=" << updatedConfig.wavepacket.kx
-                          << ", ky=" << updatedConfig.wavepacket.ky
-                          << std::endl;
+                DEBUG_LOG("UIManager", "Updated wavepacket configuration: x0=" +
+                          std::to_string(updatedConfig.wavepacket.x0) +
+                          ", y0=" + std::to_string(updatedConfig.wavepacket.y0) +
+                          ", sigmaX=" + std::to_string(updatedConfig.wavepacket.sigmaX) +
+                          ", sigmaY=" + std::to_string(updatedConfig.wavepacket.sigmaY) +
+                          ", kx=" + std::to_string(updatedConfig.wavepacket.kx) +
+                          ", ky=" + std::to_string(updatedConfig.wavepacket.ky));
             }
             catch (const std::exception& e) {
                 std::cerr << "Error updating wavepacket configuration: " << e.what() << std::endl;
@@ -391,6 +379,96 @@ void UIManager::renderDiagnostics() {
             "Warning: Probability not conserved (%.6f)", totalProbability);
     }
     
+    renderPerformance();
+    
+    ImGui::Separator();
+}
+
+void UIManager::renderPerformance() {
+    // Sample a few times a second whatever the frame rate; the solver runs on its own thread
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - m_lastMetricsSample).count() >= METRICS_SAMPLE_SECONDS) {
+        m_metricsHistory.sample(MetricsRegistry::getInstance().snapshot());
+        m_lastMetricsSample = now;
+    }
+    
+    if (!ImGui::CollapsingHeader("Performance")) {
+        return;
+    }
+    
+    const MetricsHistory::Interval& latest = m_metricsHistory.getLatest();
+    const MetricsSnapshot& totals = m_metricsHistory.getSnapshot();
+    const double megabyte = 1024.0 * 1024.0;
+    ImGui::Text("Steps/s: %.1f | Bandwidth: %.2f GB/s", latest.stepsPerSecond, latest.gigabytesPerSecond);
+    ImGui::Text("Memory: %.1f MB grids, %.1f MB cached, %.1f MB resident",
+                totals.gridBytes / megabyte, totals.cachedGridBytes / megabyte, totals.residentBytes / megabyte);
+    
+    // Series are ring buffers; the offset points ImGui at the oldest value
+    const int offset = static_cast<int>(m_metricsHistory.getOffset());
+    const std::vector<float>& steps = m_metricsHistory.getStepsPerSecond();
+    if (!steps.empty()) {
+        ImGui::PlotLines("##stepsPerSecond", steps.data(), static_cast<int>(steps.size()), offset,
+                         "steps/s", 0.0f, FLT_MAX, ImVec2(0, 40));
+    }
+    
+    // One histogram of the mean pass duration per stage; stages that never ran are left out
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const MetricStage stage = static_cast<MetricStage>(s);
+        const std::vector<float>& series = m_metricsHistory.getStageMilliseconds(stage);
+        if (series.empty() || totals.stages[s].count == 0) {
+            continue;
+        }
+        char overlay[96];
+        if (latest.stageGigabytesPerSecond[s] > 0.0) {
+            std::snprintf(overlay, sizeof(overlay), "%s: %.3f ms, %.0f/s, %.1f GB/s", MetricsRegistry::stageTitle(stage),
+                          latest.milliseconds[s], latest.callsPerSecond[s], latest.stageGigabytesPerSecond[s]);
+        } else {
+            std::snprintf(overlay, sizeof(overlay), "%s: %.3f ms, %.0f/s", MetricsRegistry::stageTitle(stage),
+                          latest.milliseconds[s], latest.callsPerSecond[s]);
+        }
+        ImGui::PushID(static_cast<int>(s));
+        ImGui::PlotHistogram("##stage", series.data(), static_cast<int>(series.size()), offset, overlay,
+                             0.0f, FLT_MAX, ImVec2(0, 36));
+        ImGui::PopID();
+    }
+}
+
+void UIManager::renderDisplaySettings() {
+    ImGui::Text("Display");
+    
+    // The visualization engine picks these up from ConfigurationUpdated events
+    auto publish = [this](const std::string& param, const std::string& value) {
+        if (m_eventBus) {
+            m_eventBus->publish(makeEvent<ConfigurationUpdatedEvent>(param, value));
+        }
+    };
+    
+    if (ImGui::Combo("View", &m_uiState.renderMode, RENDER_MODES, 3)) {
+        publish("renderMode", std::to_string(m_uiState.renderMode));
+    }
+    if (m_uiState.renderMode != 2 && ImGui::Combo("Colormap", &m_uiState.colormap, COLORMAPS, 3)) {
+        publish("colormap", std::to_string(m_uiState.colormap));
+    }
+    if (ImGui::SliderFloat("Brightness", &m_uiState.displayScale, 0.1f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic)) {
+        publish("scale", std::to_string(m_uiState.displayScale));
+    }
+    if (ImGui::Checkbox("Auto-scale to maximum", &m_uiState.autoScale)) {
+        publish("autoScale", m_uiState.autoScale ? "1" : "0");
+    }
+    
+    // Zoomed views are fetched from the solver at up to full grid resolution
+    if (ImGui::SliderFloat("Zoom", &m_uiState.zoom, 1.0f, 64.0f, "%.1fx", ImGuiSliderFlags_Logarithmic)) {
+        publish("zoom", std::to_string(m_uiState.zoom));
+    }
+    if (m_uiState.zoom > 1.0f) {
+        if (ImGui::SliderFloat("View X", &m_uiState.viewX, 0.0f, 1.0f, "%.3f")) {
+            publish("viewX", std::to_string(m_uiState.viewX));
+        }
+        if (ImGui::SliderFloat("View Y", &m_uiState.viewY, 0.0f, 1.0f, "%.3f")) {
+            publish("viewY", std::to_string(m_uiState.viewY));
+        }
+    }
+    
     ImGui::Separator();
 }
 
@@ -435,13 +513,12 @@ bool UIManager::handleEvent(const EventPtr& event) {
             return true;
             
         case EventType::SimulationStepped: {
-            auto steppedEvent = std::dynamic_pointer_cast<SimulationSteppedEvent>(event);
-            if (steppedEvent) {
-                m_currentTime = steppedEvent->getTime();
-                // Update the displayed total probability
-                DEBUG_LOG("UIManager", "Received SimulationStepped event - Time: " 
-                        + std::to_string(steppedEvent->getTime()));
-            }
+            // The type tag identifies the class, so no dynamic cast is needed
+            const auto& steppedEvent = static_cast<const SimulationSteppedEvent&>(*event);
+            m_currentTime = steppedEvent.getTime();
+            // Update the displayed total probability
+            TRACE_LOG("UIManager", "Received SimulationStepped event - Time: " 
+                    + std::to_string(steppedEvent.getTime()));
             return true;
         }
             
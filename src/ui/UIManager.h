@@ -1,6 +1,7 @@
 #pragma once
 
 #include <imgui.h>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -11,6 +12,7 @@
 #include "../core/Potential.h" // Added for Potential class
 #include "../core/EventBus.h"
 #include "../core/IEventHandler.h"
+#include "../core/Metrics.h"
 
 // Forward declaration for GLFW
 struct GLFWwindow;
@@ -22,7 +24,8 @@ class UIManager : public IUIManager,
                   public IEventHandler,
                   public std::enable_shared_from_this<UIManager> {
 public:
-    UIManager(std::shared_ptr<EventBus> eventBus = nullptr);
+    // Seeded with the engine's configuration, which the settings widgets edit
+    explicit UIManager(const PhysicsConfig& config, std::shared_ptr<EventBus> eventBus = nullptr);
     ~UIManager() override;
     
     // Initialize the UI components
@@ -97,11 +100,10 @@ private:
     void renderPotentialSettings();
     void renderWavepacketSettings();
     void renderDiagnostics();
+    void renderPerformance();
+    void renderDisplaySettings();
     void renderEventMonitor();
     
-    // Helper method to create potential objects
-    std::unique_ptr<Potential> createPotentialFromConfig(const PotentialConfig& config);
-    
     // ImGui state
     bool m_initialized = false;
     
@@ -125,12 +127,24 @@ private:
         float waveSigmaY = 0.1f;
         float waveKx = 5.0f;
         float waveKy = 0.0f;
+        
+        int renderMode = 0;
+        int colormap = 0;
+        float displayScale = 1.0f;
+        bool autoScale = true;
+        float zoom = 1.0f;
+        float viewX = 0.5f;
+        float viewY = 0.5f;
     } m_uiState;
     
     // Display stats
     double m_currentTime = 0.0;
     double m_fps = 0.0;
     
+    // Rolling stage timings for the performance section, sampled from the MetricsRegistry
+    MetricsHistory m_metricsHistory;
+    std::chrono::steady_clock::time_point m_lastMetricsSample;
+    
     // Event callbacks
     std::function<void()> m_startCallback;
     std::function<void()> m_stopCallback;
@@ -146,5 +160,8 @@ private:
     
     // Constants
     const char* POTENTIAL_TYPES[3] = { "Free Space", "Square Barrier/Well", "Harmonic Oscillator" };
+    const char* RENDER_MODES[3] = { "Density", "Density (GPU)", "Phase" };
+    const char* COLORMAPS[3] = { "Viridis", "Grayscale", "Hot" };
     const size_t MAX_RECENT_EVENTS = 100;
+    const double METRICS_SAMPLE_SECONDS = 0.25;
 };
\ No newline at end of file
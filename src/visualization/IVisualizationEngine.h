@@ -5,6 +5,16 @@
 // Forward declarations
 class GLFWwindow;
 
+/**
+ * @enum RenderMode
+ * @brief What the visualization shows and which data it expects
+ */
+enum class RenderMode {
+    Density = 0,  ///< Colormapped |ψ|², uploaded as density (beginDensityUpload)
+    Field = 1,    ///< Colormapped |ψ|², computed on the GPU from an uploaded ψ (beginFieldUpload)
+    Phase = 2     ///< Hue from arg ψ and brightness from |ψ|², from an uploaded ψ
+};
+
 /**
  * @interface IVisualizationEngine
  * @brief Interface for visualization engines
@@ -33,6 +43,72 @@ public:
      */
     virtual void render(const std::vector<float>& probabilityDensity) = 0;
     
+    /**
+     * @brief Begin writing the next density upload
+     * 
+     * Returns a pointer to width * height floats of staging memory that the
+     * caller fills with |ψ|² in row-major order and then hands to the GPU
+     * with endDensityUpload(). The pointer is only valid until then. The
+     * image is stretched over the view, so it may be any size up to the
+     * texture size; grids larger than that are reduced before the upload.
+     * 
+     * @param width Samples per row, at most getWidth()
+     * @param height Rows, at most getHeight()
+     * @return Staging buffer, or nullptr if nothing can be uploaded
+     */
+    virtual float* beginDensityUpload(int width, int height) = 0;
+    
+    /**
+     * @brief Finish the upload started by beginDensityUpload()
+     * 
+     * The copy into the density texture is queued and runs asynchronously.
+     */
+    virtual void endDensityUpload() = 0;
+    
+    /**
+     * @brief Begin writing the next wavefunction upload
+     * 
+     * Like beginDensityUpload(), but for 2 * width * height floats holding
+     * ψ as (re, im) pairs; |ψ|² and the phase are computed on the GPU.
+     * 
+     * @param width Samples per row, at most getWidth()
+     * @param height Rows, at most getHeight()
+     * @return Staging buffer, or nullptr if nothing can be uploaded
+     */
+    virtual float* beginFieldUpload(int width, int height) = 0;
+    
+    /**
+     * @brief Finish the upload started by beginFieldUpload()
+     */
+    virtual void endFieldUpload() = 0;
+    
+    /**
+     * @brief Render the most recently uploaded density or wavefunction
+     */
+    virtual void renderCurrent() = 0;
+    
+    /**
+     * @brief Select what is shown
+     * 
+     * Field and Phase need wavefunction uploads; a density upload is shown
+     * as density whatever the mode.
+     * 
+     * @param mode The render mode
+     */
+    virtual void setRenderMode(RenderMode mode) = 0;
+    
+    /**
+     * @brief Get the selected render mode
+     * @return The render mode
+     */
+    virtual RenderMode getRenderMode() const = 0;
+    
+    /**
+     * @brief Normalize the display by the maximum of |ψ|²
+     * @param enabled True to divide by the maximum found on the GPU, false to show raw values
+     */
+    virtual void setAutoScale(bool enabled) = 0;
+    
     /**
      * @brief Clean up resources used by the visualization engine
      */
@@ -46,13 +122,13 @@ public:
     
     /**
      * @brief Get the width of the visualization area
-     * @return Width in pixels
+     * @return Width of the display texture in texels (independent of the grid)
      */
     virtual int getWidth() const = 0;
     
     /**
      * @brief Get the height of the visualization area
-     * @return Height in pixels
+     * @return Height of the display texture in texels (independent of the grid)
      */
     virtual int getHeight() const = 0;
     
@@ -1,9 +1,12 @@
 #include "VisualizationEngine.h"
 #include "../core/Events.h"
 #include "../core/DebugUtils.h"
+#include "../core/Metrics.h"
+#include "../core/Trace.h"
 #define GLFW_INCLUDE_NONE  // do not include OpenGL headers in GLFW
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <cstring>
 #include <iostream>
 
 // Vertex and fragment shader source code as string constants
@@ -22,13 +25,17 @@ const std::string VisualizationEngine::s_fragmentShaderSource = R"glsl(
 #version 330 core
 out vec4 FragColor;
 in vec2 TexCoord;
-uniform sampler2D densityTexture;
-uniform int colormapType;
+uniform sampler2D densityTexture;  // |ψ|² uploaded by the CPU
+uniform sampler2D fieldTexture;    // ψ as (re, im)
+uniform sampler2D maxTexture;      // 1x1 maximum of |ψ|² from the reduction
+uniform int u_mode;                // 0 = density, 1 = |ψ|² of the field, 2 = phase of the field
+uniform int u_colormap;            // 0 = viridis, 1 = grayscale, 2 = hot
+uniform float u_scale;             // Brightness multiplier
+uniform int u_autoScale;           // Divide by the maximum density
+uniform vec2 u_imageScale;         // Part of the textures the current frame fills
 
 // Viridis-inspired colormap function
-vec3 applyColormap(float value) {
-    value = clamp(value, 0.0, 1.0);
-    
+vec3 viridis(float value) {
     // Viridis-inspired colormap (simplified)
     vec3 c0 = vec3(0.267004, 0.004874, 0.329415);
     vec3 c1 = vec3(0.253935, 0.265254, 0.529983);
@@ -60,10 +67,79 @@ vec3 applyColormap(float value) {
     return color;
 }
 
+// Black-red-yellow-white ramp
+vec3 hot(float value) {
+    return clamp(vec3(3.0 * value, 3.0 * value - 1.0, 3.0 * value - 2.0), 0.0, 1.0);
+}
+
+vec3 applyColormap(float value) {
+    value = clamp(value, 0.0, 1.0);
+    if (u_colormap == 1) {
+        return vec3(value);
+    }
+    if (u_colormap == 2) {
+        return hot(value);
+    }
+    return viridis(value);
+}
+
+vec3 hsvToRgb(vec3 c) {
+    vec3 p = abs(fract(c.xxx + vec3(0.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0);
+    return c.z * mix(vec3(1.0), clamp(p - 1.0, 0.0, 1.0), c.y);
+}
+
 void main() {
-    float density = texture(densityTexture, TexCoord).r;
-    vec3 color = applyColormap(density);
-    FragColor = vec4(color, 1.0);
+    // Stay half a texel inside the image so filtering never reads stale texels
+    vec2 halfTexel = 0.5 / vec2(textureSize(densityTexture, 0));
+    vec2 uv = clamp(TexCoord * u_imageScale, halfTexel, u_imageScale - halfTexel);
+    
+    vec2 psi = vec2(0.0);
+    float density;
+    if (u_mode == 0) {
+        density = texture(densityTexture, uv).r;
+    } else {
+        psi = texture(fieldTexture, uv).rg;
+        density = dot(psi, psi);
+    }
+    
+    float maxDensity = 1.0;
+    if (u_autoScale != 0) {
+        maxDensity = max(texelFetch(maxTexture, ivec2(0, 0), 0).r, 1e-30);
+    }
+    float value = density * u_scale / maxDensity;
+    
+    if (u_mode == 2) {
+        // Hue encodes arg ψ in [-π, π], brightness the scaled density
+        float hue = atan(psi.y, psi.x) / 6.28318530718 + 0.5;
+        FragColor = vec4(hsvToRgb(vec3(hue, 1.0, clamp(value, 0.0, 1.0))), 1.0);
+    } else {
+        FragColor = vec4(applyColormap(value), 1.0);
+    }
+}
+)glsl";
+
+// One reduction pass: each output texel is the maximum |ψ|² of a 4x4 source block
+const std::string VisualizationEngine::s_maxFragmentShaderSource = R"glsl(
+#version 330 core
+layout (location = 0) out float maxValue;
+uniform sampler2D sourceTexture;
+uniform ivec2 sourceSize;
+uniform int sourceIsField;  // Source holds ψ as (re, im) rather than a density
+
+float densityAt(ivec2 texel) {
+    vec2 value = texelFetch(sourceTexture, min(texel, sourceSize - 1), 0).rg;
+    return sourceIsField != 0 ? dot(value, value) : value.r;
+}
+
+void main() {
+    ivec2 base = ivec2(gl_FragCoord.xy) * 4;
+    float result = 0.0;
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            result = max(result, densityAt(base + ivec2(i, j)));
+        }
+    }
+    maxValue = result;
 }
 )glsl";
 
@@ -137,10 +213,22 @@ bool VisualizationEngine::initialize(GLFWwindow* window) {
     // Allocate memory for the texture - we'll update this with actual data later
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_width, m_height, 0, GL_RED, GL_FLOAT, nullptr);
     
+    // Create texture for the complex wavefunction (re, im)
+    glGenTextures(1, &m_fieldTexture);
+    glBindTexture(GL_TEXTURE_2D, m_fieldTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, m_width, m_height, 0, GL_RG, GL_FLOAT, nullptr);
+    
     // Unbind
     glBindTexture(GL_TEXTURE_2D, 0);
     glBindVertexArray(0);
     
+    createUploadBuffers();
+    createMaxReduction();
+    
     // Subscribe to events now that the object is fully constructed
     if (m_eventBus) {
         m_eventBus->subscribe(EventType::WavefunctionUpdated, shared_from_this());
@@ -166,18 +254,17 @@ bool VisualizationEngine::handleEvent(const EventPtr& event) {
         case EventType::WavefunctionUpdated: {
             // We would normally trigger a re-render here, but in our current architecture
             // rendering is done in the main loop, so we'll just log this event
-            DEBUG_LOG("VisualizationEngine", "Received WavefunctionUpdated event");
+            TRACE_LOG("VisualizationEngine", "Received WavefunctionUpdated event");
             return true;
         }
         
         case EventType::SimulationStepped: {
-            auto steppedEvent = std::dynamic_pointer_cast<SimulationSteppedEvent>(event);
-            if (steppedEvent) {
-                DEBUG_LOG("VisualizationEngine", "Received SimulationStepped event - Time: " 
-                        + std::to_string(steppedEvent->getTime())
-                        + ", Total Probability: " 
-                        + std::to_string(steppedEvent->getTotalProbability()));
-            }
+            // The type tag identifies the class, so no dynamic cast is needed
+            const auto& steppedEvent = static_cast<const SimulationSteppedEvent&>(*event);
+            TRACE_LOG("VisualizationEngine", "Received SimulationStepped event - Time: " 
+                    + std::to_string(steppedEvent.getTime())
+                    + ", Total Probability: " 
+                    + std::to_string(steppedEvent.getTotalProbability()));
             return true;
         }
         
@@ -198,6 +285,17 @@ bool VisualizationEngine::handleEvent(const EventPtr& event) {
                     } catch (const std::exception& e) {
                         DEBUG_LOG("VisualizationEngine", "Error parsing colormap value: " + value);
                     }
+                } else if (param == "renderMode") {
+                    try {
+                        int mode = std::stoi(value);
+                        if (mode >= 0 && mode <= static_cast<int>(RenderMode::Phase)) {
+                            setRenderMode(static_cast<RenderMode>(mode));
+                        }
+                    } catch (const std::exception& e) {
+                        DEBUG_LOG("VisualizationEngine", "Error parsing render mode value: " + value);
+                    }
+                } else if (param == "autoScale") {
+                    setAutoScale(value == "1" || value == "true");
                 } else if (param == "scale") {
                     try {
                         float scale = std::stof(value);
@@ -220,7 +318,7 @@ void VisualizationEngine::render(const std::vector<float>& probabilityDensity) {
         return;
     }
     
-    // Ensure we have the right amount of data
+    // Ensure we have the right amount of data; other sizes go through beginDensityUpload()
     if (static_cast<int>(probabilityDensity.size()) != m_width * m_height) {
         std::cerr << "Error: Probability density data size mismatch. Expected " 
                   << (m_width * m_height) << " but got " 
@@ -228,17 +326,304 @@ void VisualizationEngine::render(const std::vector<float>& probabilityDensity) {
         return;
     }
     
-    // Update the texture with the new probability density data
-    glBindTexture(GL_TEXTURE_2D, m_densityTexture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RED, GL_FLOAT, probabilityDensity.data());
+    // Update the texture through the pixel buffers
+    if (float* staging = beginDensityUpload(m_width, m_height)) {
+        std::memcpy(staging, probabilityDensity.data(), probabilityDensity.size() * sizeof(float));
+        endDensityUpload();
+    }
+    
+    renderCurrent();
+}
+
+// Create the pixel unpack buffers used to stream the density and field textures
+void VisualizationEngine::createUploadBuffers() {
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(m_width) * m_height * kMaxUploadComponents * sizeof(float);
+    
+    // Persistent, coherent mappings avoid a map/unmap per frame; they need
+    // GL 4.4 or ARB_buffer_storage, so a 3.3 context orphans and remaps instead
+    m_persistentMapping = glBufferStorage != nullptr;
+    
+    glGenBuffers(kUploadBufferCount, m_uploadBuffers);
+    for (int i = 0; i < kUploadBufferCount; ++i) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffers[i]);
+        if (m_persistentMapping) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+            m_mappedBuffers[i] = static_cast<float*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags));
+            if (!m_mappedBuffers[i]) {
+                m_persistentMapping = false;
+            }
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    if (!m_persistentMapping && glBufferStorage != nullptr) {
+        // Mapping failed; immutable storage cannot be orphaned, so start over
+        deleteUploadBuffers();
+        glGenBuffers(kUploadBufferCount, m_uploadBuffers);
+        for (int i = 0; i < kUploadBufferCount; ++i) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffers[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    
+    DEBUG_LOG("VisualizationEngine", std::string("Texture uploads use ")
+            + (m_persistentMapping ? "persistently mapped" : "orphaned") + " pixel buffers");
+}
+
+// Delete the pixel unpack buffers and their fences
+void VisualizationEngine::deleteUploadBuffers() {
+    for (int i = 0; i < kUploadBufferCount; ++i) {
+        if (m_uploadFences[i]) {
+            glDeleteSync(m_uploadFences[i]);
+            m_uploadFences[i] = nullptr;
+        }
+        if (m_mappedBuffers[i]) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffers[i]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            m_mappedBuffers[i] = nullptr;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(kUploadBufferCount, m_uploadBuffers);
+    for (GLuint& buffer : m_uploadBuffers) {
+        buffer = 0;
+    }
+    m_uploadIndex = 0;
+    m_uploadPending = false;
+}
+
+// Begin writing the next density upload
+float* VisualizationEngine::beginDensityUpload(int width, int height) {
+    return beginUpload(width, height, 1);
+}
+
+// Queue the copy of the filled pixel buffer into the density texture
+void VisualizationEngine::endDensityUpload() {
+    if (m_uploadPending) {
+        endUpload(m_densityTexture, GL_RED);
+        m_lastUploadWasField = false;
+        if (m_autoScale) {
+            reduceMax(m_densityTexture, false);
+        }
+    }
+}
+
+// Begin writing the next wavefunction upload
+float* VisualizationEngine::beginFieldUpload(int width, int height) {
+    return beginUpload(width, height, 2);
+}
+
+// Queue the copy of the filled pixel buffer into the field texture
+void VisualizationEngine::endFieldUpload() {
+    if (m_uploadPending) {
+        endUpload(m_fieldTexture, GL_RG);
+        m_lastUploadWasField = true;
+        if (m_autoScale) {
+            reduceMax(m_fieldTexture, true);
+        }
+    }
+}
+
+// Map the next pixel buffer for an upload of components floats per texel
+float* VisualizationEngine::beginUpload(int width, int height, int components) {
+    TRACE_SCOPE("Map upload buffer", "render");
+    if (!m_initialized || m_uploadPending) {
+        return nullptr;
+    }
+    if (width <= 0 || height <= 0 || width > m_width || height > m_height) {
+        std::cerr << "Error: Upload of " << width << "x" << height
+                  << " does not fit the " << m_width << "x" << m_height << " texture" << std::endl;
+        return nullptr;
+    }
+    
+    const int index = m_uploadIndex;
+    float* staging = nullptr;
+    if (m_persistentMapping) {
+        // The GPU may still be reading this buffer from two uploads ago
+        if (m_uploadFences[index]) {
+            glClientWaitSync(m_uploadFences[index], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(m_uploadFences[index]);
+            m_uploadFences[index] = nullptr;
+        }
+        staging = m_mappedBuffers[index];
+    } else {
+        // Orphan the old storage so mapping never waits for the GPU
+        const GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * components * sizeof(float);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffers[index]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        staging = static_cast<float*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    
+    m_uploadPending = staging != nullptr;
+    m_uploadWidth = width;
+    m_uploadHeight = height;
+    return staging;
+}
+
+// Queue the copy from the filled pixel buffer into a texture
+void VisualizationEngine::endUpload(GLuint texture, unsigned int format) {
+    TRACE_SCOPE("Texture upload", "render");
+    const int index = m_uploadIndex;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffers[index]);
+    if (!m_persistentMapping) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    
+    // With an unpack buffer bound the data argument is an offset into it
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_uploadWidth, m_uploadHeight, format, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    if (m_persistentMapping) {
+        m_uploadFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    m_uploadIndex = (index + 1) % kUploadBufferCount;
+    m_uploadPending = false;
+    m_imageWidth = m_uploadWidth;
+    m_imageHeight = m_uploadHeight;
+}
+
+// Create the textures and framebuffer of the max reduction
+void VisualizationEngine::createMaxReduction() {
+    m_maxProgram = createShaderProgram(s_vertexShaderSource, s_maxFragmentShaderSource);
+    if (m_maxProgram == 0) {
+        std::cerr << "Failed to create max reduction program; auto-scaling disabled" << std::endl;
+        m_autoScale = false;
+        return;
+    }
+    
+    // Levels shrink 4x per axis (matching the shader's block size) down to 1x1
+    int width = m_width;
+    int height = m_height;
+    do {
+        width = (width + 3) / 4;
+        height = (height + 3) / 4;
+        m_maxSizes.emplace_back(width, height);
+    } while (width > 1 || height > 1);
+    
+    m_maxTextures.resize(m_maxSizes.size());
+    glGenTextures(static_cast<GLsizei>(m_maxTextures.size()), m_maxTextures.data());
+    for (size_t level = 0; level < m_maxTextures.size(); ++level) {
+        glBindTexture(GL_TEXTURE_2D, m_maxTextures[level]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_maxSizes[level].first, m_maxSizes[level].second,
+                     0, GL_RED, GL_FLOAT, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glGenFramebuffers(1, &m_maxFramebuffer);
+}
+
+// Delete the max reduction objects
+void VisualizationEngine::deleteMaxReduction() {
+    if (!m_maxTextures.empty()) {
+        glDeleteTextures(static_cast<GLsizei>(m_maxTextures.size()), m_maxTextures.data());
+    }
+    m_maxTextures.clear();
+    m_maxSizes.clear();
+    if (m_maxFramebuffer) {
+        glDeleteFramebuffers(1, &m_maxFramebuffer);
+        m_maxFramebuffer = 0;
+    }
+    if (m_maxProgram) {
+        glDeleteProgram(m_maxProgram);
+        m_maxProgram = 0;
+    }
+}
+
+// Reduce |ψ|² of a texture to its maximum in the last (1x1) level, on the GPU
+void VisualizationEngine::reduceMax(GLuint source, bool sourceIsField) {
+    TRACE_SCOPE("Max reduction", "render");
+    if (m_maxProgram == 0) {
+        return;
+    }
+    
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, m_maxFramebuffer);
+    glUseProgram(m_maxProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(m_maxProgram, "sourceTexture"), 0);
+    const GLint sizeLocation = glGetUniformLocation(m_maxProgram, "sourceSize");
+    const GLint fieldLocation = glGetUniformLocation(m_maxProgram, "sourceIsField");
+    glBindVertexArray(m_vao);
+    
+    // Each pass reads the previous level; the data never leaves the GPU
+    GLuint input = source;
+    int inputWidth = m_imageWidth;
+    int inputHeight = m_imageHeight;
+    for (size_t level = 0; level < m_maxTextures.size(); ++level) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_maxTextures[level], 0);
+        glViewport(0, 0, m_maxSizes[level].first, m_maxSizes[level].second);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glUniform2i(sizeLocation, inputWidth, inputHeight);
+        glUniform1i(fieldLocation, level == 0 && sourceIsField ? 1 : 0);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        
+        input = m_maxTextures[level];
+        inputWidth = m_maxSizes[level].first;
+        inputHeight = m_maxSizes[level].second;
+    }
+    
+    // Restore the default framebuffer
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// Select what is shown
+void VisualizationEngine::setRenderMode(RenderMode mode) {
+    m_renderMode = mode;
+    DEBUG_LOG("VisualizationEngine", "Render mode set to " + std::to_string(static_cast<int>(mode)));
+}
+
+// Render the most recently uploaded density or wavefunction
+void VisualizationEngine::renderCurrent() {
+    TRACE_SCOPE("Render", "render");
+    METRICS_SCOPE(MetricStage::Render, 0);
+    if (!m_initialized) {
+        return;
+    }
     
     // Draw the quad with our shader and texture
     glUseProgram(m_shaderProgram);
     
-    // Bind the density texture
+    // A density upload carries no phase, so it is always shown as density
+    int shaderMode = 0;
+    if (m_lastUploadWasField) {
+        shaderMode = m_renderMode == RenderMode::Phase ? 2 : 1;
+    }
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "u_mode"), shaderMode);
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "u_colormap"), m_colormapType);
+    glUniform1f(glGetUniformLocation(m_shaderProgram, "u_scale"), m_scale);
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "u_autoScale"),
+                m_autoScale && !m_maxTextures.empty() ? 1 : 0);
+    glUniform2f(glGetUniformLocation(m_shaderProgram, "u_imageScale"),
+                m_imageWidth > 0 ? static_cast<float>(m_imageWidth) / m_width : 1.0f,
+                m_imageHeight > 0 ? static_cast<float>(m_imageHeight) / m_height : 1.0f);
+    
+    // Bind the density, field and maximum textures
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_densityTexture);
     glUniform1i(glGetUniformLocation(m_shaderProgram, "densityTexture"), 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_fieldTexture);
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "fieldTexture"), 1);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, m_maxTextures.empty() ? 0 : m_maxTextures.back());
+    glUniform1i(glGetUniformLocation(m_shaderProgram, "maxTexture"), 2);
+    glActiveTexture(GL_TEXTURE0);
     
     // Draw
     glBindVertexArray(m_vao);
@@ -252,11 +637,14 @@ void VisualizationEngine::render(const std::vector<float>& probabilityDensity) {
 void VisualizationEngine::cleanup() {
     if (m_initialized) {
         // Delete OpenGL objects
+        deleteUploadBuffers();
+        deleteMaxReduction();
         glDeleteProgram(m_shaderProgram);
         glDeleteVertexArrays(1, &m_vao);
         glDeleteBuffers(1, &m_vbo);
         glDeleteBuffers(1, &m_ebo);
         glDeleteTextures(1, &m_densityTexture);
+        glDeleteTextures(1, &m_fieldTexture);
         
         m_initialized = false;
     }
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
 #include "IVisualizationEngine.h"
 #include "../core/EventBus.h"
 #include "../core/IEventHandler.h"
@@ -10,6 +11,7 @@
 // Forward declarations to avoid including headers
 class GLFWwindow;
 typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
 
 class VisualizationEngine : public IVisualizationEngine, 
                             public IEventHandler,
@@ -20,6 +22,14 @@ public:
 
     bool initialize(GLFWwindow* window) override;
     void render(const std::vector<float>& probabilityDensity) override;
+    float* beginDensityUpload(int width, int height) override;
+    void endDensityUpload() override;
+    float* beginFieldUpload(int width, int height) override;
+    void endFieldUpload() override;
+    void renderCurrent() override;
+    void setRenderMode(RenderMode mode) override;
+    RenderMode getRenderMode() const override { return m_renderMode; }
+    void setAutoScale(bool enabled) override { m_autoScale = enabled; }
     void cleanup() override;
     void shutdown() override;
     
@@ -27,7 +37,7 @@ public:
     int getWidth() const override { return m_width; }
     int getHeight() const override { return m_height; }
     
-    // Interface implementation
+    // Interface implementation; colormaps are 0 = viridis, 1 = grayscale, 2 = hot
     void setColormap(int colormapType) override;
     void setScale(float scale) override;
     
@@ -39,9 +49,21 @@ private:
     GLuint compileShader(const std::string& source, unsigned int shaderType);
     GLuint createShaderProgram(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
     
+    // Pixel buffer methods
+    void createUploadBuffers();
+    void deleteUploadBuffers();
+    float* beginUpload(int width, int height, int components);
+    void endUpload(GLuint texture, unsigned int format);
+    
+    // GPU max reduction of |ψ|² for auto-scaling
+    void createMaxReduction();
+    void deleteMaxReduction();
+    void reduceMax(GLuint source, bool sourceIsField);
+    
     // GLSL shader sources - defined as static const variables in the cpp file
     static const std::string s_vertexShaderSource;
     static const std::string s_fragmentShaderSource;
+    static const std::string s_maxFragmentShaderSource;
     
     // OpenGL objects
     GLuint m_shaderProgram = 0;
@@ -49,6 +71,29 @@ private:
     GLuint m_vbo = 0;          // Vertex Buffer Object
     GLuint m_ebo = 0;          // Element Buffer Object
     GLuint m_densityTexture = 0;
+    GLuint m_fieldTexture = 0;     // ψ as RG32F (re, im)
+    
+    // Max reduction: each pass shrinks the previous level 4x per axis down to 1x1
+    GLuint m_maxProgram = 0;
+    GLuint m_maxFramebuffer = 0;
+    std::vector<GLuint> m_maxTextures;             // R32F levels, last one is 1x1
+    std::vector<std::pair<int, int>> m_maxSizes;   // Size of each level
+    
+    // Double-buffered pixel unpack buffers: the CPU fills one while the GPU
+    // copies the other into the texture
+    static constexpr int kUploadBufferCount = 2;
+    static constexpr int kMaxUploadComponents = 2;      // Buffers are sized for RG32F
+    GLuint m_uploadBuffers[kUploadBufferCount] = {};
+    GLsync m_uploadFences[kUploadBufferCount] = {};     // Set after each persistent upload
+    float* m_mappedBuffers[kUploadBufferCount] = {};    // Persistent mappings
+    int m_uploadIndex = 0;                              // Buffer the next upload writes
+    bool m_persistentMapping = false;                   // GL 4.4 / ARB_buffer_storage
+    bool m_uploadPending = false;                       // Between a begin and end upload call
+    bool m_lastUploadWasField = false;                  // Which texture holds the current frame
+    int m_uploadWidth = 0;                              // Size of the pending upload
+    int m_uploadHeight = 0;
+    int m_imageWidth = 0;                               // Part of the textures holding the current frame
+    int m_imageHeight = 0;
     
     // Dimensions
     int m_width;
@@ -58,6 +103,8 @@ private:
     bool m_initialized = false;
     int m_colormapType = 0;
     float m_scale = 1.0f;
+    RenderMode m_renderMode = RenderMode::Density;
+    bool m_autoScale = true;
     
     // Event system
     std::shared_ptr<EventBus> m_eventBus;
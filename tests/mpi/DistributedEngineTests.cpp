@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include <mpi.h>
+#include <unistd.h>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../../src/batch/BatchRunner.h"
+#include "../../src/solver/Checkpoint.h"
+#include "../../src/solver/DistributedSimulationEngine.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/PhysicsConfig.h"
+
+namespace {
+
+int worldRank() {
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+
+// An odd grid height, so the slabs of the ranks differ in size
+PhysicsConfig makeConfig() {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 27;
+    config.dt = 0.005;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = { 1.5 };
+    config.absorber.width = 2.0;
+    config.wavepacket = {-1.0, 0.5, 0.8, 1.0, 3.0, -1.0};
+    config.numThreads = 1;
+    return config;
+}
+
+// Largest |ψ_distributed - ψ_serial|; the gathered state is only on rank 0
+double maxDifference(const DistributedSimulationEngine& distributed, const SimulationEngine& serial) {
+    const Wavefunction& gathered = distributed.getWavefunction();
+    if (worldRank() != 0) {
+        return 0.0;
+    }
+    const Wavefunction& expected = serial.getWavefunction();
+    if (gathered.size() != expected.size()) {
+        return INFINITY;
+    }
+    double difference = 0.0;
+    for (size_t n = 0; n < expected.size(); ++n) {
+        difference = std::max(difference, std::abs(gathered.data()[n] - expected.data()[n]));
+    }
+    return difference;
+}
+
+// Directory shared by all ranks, created by rank 0 and removed on destruction
+class SharedTempDir {
+public:
+    explicit SharedTempDir(const std::string& name) {
+        long id = static_cast<long>(getpid());
+        MPI_Bcast(&id, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+        m_path = std::filesystem::temp_directory_path() / (name + "_" + std::to_string(id));
+        if (worldRank() == 0) {
+            std::filesystem::remove_all(m_path);
+            std::filesystem::create_directories(m_path);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    ~SharedTempDir() {
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (worldRank() == 0) {
+            std::filesystem::remove_all(m_path);
+        }
+    }
+    std::string file(const std::string& name) const { return (m_path / name).string(); }
+    const std::filesystem::path& path() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+};
+
+}  // namespace
+
+// Test that the slabs cover the grid without overlap
+TEST(DistributedEngineTest, SlabsCoverGrid) {
+    DistributedSimulationEngine engine(makeConfig());
+    int rows = engine.getLocalRows();
+    MPI_Allreduce(MPI_IN_PLACE, &rows, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    EXPECT_EQ(rows, makeConfig().ny);
+    EXPECT_EQ(engine.isOutputRank(), worldRank() == 0);
+    EXPECT_THROW({
+        PhysicsConfig config = makeConfig();
+        config.precision = "float";
+        DistributedSimulationEngine single(config);
+    }, std::invalid_argument);
+}
+
+// Test that the distributed steps match the serial engine
+TEST(DistributedEngineTest, MatchesSerialEngine) {
+    for (const char* scheme : {"strang", "yoshida4"}) {
+        PhysicsConfig config = makeConfig();
+        config.integration.scheme = scheme;
+        DistributedSimulationEngine distributed(config);
+        SimulationEngine serial(config);
+        EXPECT_LT(maxDifference(distributed, serial), 1e-12) << scheme;
+
+        distributed.advance(9);
+        distributed.step();
+        serial.advance(9);
+        serial.step();
+        EXPECT_NEAR(distributed.getCurrentTime(), serial.getCurrentTime(), 1e-12);
+        EXPECT_LT(maxDifference(distributed, serial), 1e-10) << scheme;
+        EXPECT_NEAR(distributed.getTotalProbability(), serial.getTotalProbability(), 1e-12) << scheme;
+    }
+}
+
+// Test a time-dependent potential, resampled on each rank's rows
+TEST(DistributedEngineTest, TimeDependentPotential) {
+    PhysicsConfig config = makeConfig();
+    PotentialConfig trap;
+    trap.type = "HarmonicOscillator";
+    trap.parameters = { 1.0 };
+    PotentialConfig drive;
+    drive.type = "HarmonicOscillator";
+    drive.parameters = { 0.5 };
+    config.potential = PotentialConfig();
+    config.potential.type = "Driven";
+    config.potential.parameters = { 1.0, 5.0 };
+    config.potential.components = { trap, drive };
+
+    DistributedSimulationEngine distributed(config);
+    SimulationEngine serial(config);
+    distributed.advance(15);
+    serial.advance(15);
+    EXPECT_LT(maxDifference(distributed, serial), 1e-9);
+}
+
+// Test that carrying ψ over to a new grid and slab layout matches the serial engine
+TEST(DistributedEngineTest, UpdateConfigKeepsState) {
+    DistributedSimulationEngine distributed(makeConfig());
+    SimulationEngine serial(makeConfig());
+    distributed.advance(10);
+    serial.advance(10);
+
+    PhysicsConfig finer = makeConfig();
+    finer.nx = 40;
+    finer.ny = 35;
+    finer.dt = 0.004;
+    distributed.updateConfig(finer, true);
+    serial.updateConfig(finer, true);
+    EXPECT_NEAR(distributed.getCurrentTime(), serial.getCurrentTime(), 1e-12);
+    EXPECT_LT(maxDifference(distributed, serial), 1e-12);
+
+    distributed.advance(10);
+    serial.advance(10);
+    EXPECT_LT(maxDifference(distributed, serial), 1e-10);
+    EXPECT_NEAR(distributed.getTotalProbability(), serial.getTotalProbability(), 1e-12);
+}
+
+// Test that the reduced observables equal the serial ones on every rank
+TEST(DistributedEngineTest, ObservablesMatchSerialEngine) {
+    PhysicsConfig config = makeConfig();
+    config.output.regions = { {"left", -5.0, 0.0, -5.0, 5.0}, {"top", -5.0, 5.0, 1.0, 5.0} };
+    DistributedSimulationEngine distributed(config);
+    SimulationEngine serial(config);
+    distributed.advance(20);
+    serial.advance(20);
+
+    const ObservableSample actual = distributed.computeObservables();
+    const ObservableSample expected = serial.computeObservables();
+    EXPECT_NEAR(actual.totalProbability, expected.totalProbability, 1e-12);
+    EXPECT_NEAR(actual.absorbedProbability, expected.absorbedProbability, 1e-12);
+    EXPECT_NEAR(actual.x, expected.x, 1e-10);
+    EXPECT_NEAR(actual.y, expected.y, 1e-10);
+    EXPECT_NEAR(actual.px, expected.px, 1e-10);
+    EXPECT_NEAR(actual.py, expected.py, 1e-10);
+    EXPECT_NEAR(actual.kineticEnergy, expected.kineticEnergy, 1e-10);
+    EXPECT_NEAR(actual.potentialEnergy, expected.potentialEnergy, 1e-10);
+    ASSERT_EQ(actual.regions.size(), 2u);
+    EXPECT_NEAR(actual.regions[0], expected.regions[0], 1e-12);
+    EXPECT_NEAR(actual.regions[1], expected.regions[1], 1e-12);
+
+    // The gathered density matches the serial one on rank 0
+    const std::vector<float> density = distributed.getProbabilityDensity();
+    if (worldRank() == 0) {
+        const std::vector<float> reference = serial.getProbabilityDensity();
+        ASSERT_EQ(density.size(), reference.size());
+        for (size_t n = 0; n < density.size(); ++n) {
+            EXPECT_NEAR(density[n], reference[n], 1e-6);
+        }
+    }
+    else {
+        EXPECT_TRUE(density.empty());
+    }
+}
+
+// Test a parallel checkpoint round trip, and that serial code can read it
+TEST(DistributedEngineTest, ParallelCheckpointRoundTrip) {
+    SharedTempDir directory("qmsim_distributed_checkpoint");
+    const std::string path = directory.file("checkpoint.h5");
+    PhysicsConfig config = makeConfig();
+    DistributedSimulationEngine original(config);
+    original.advance(12);
+    ASSERT_TRUE(original.writeCheckpointFile(path, 12, 0));
+    const CheckpointState captured = original.captureCheckpoint();
+
+    DistributedSimulationEngine restored(config);
+    ASSERT_TRUE(restored.restoreCheckpointFile(path));
+    EXPECT_DOUBLE_EQ(restored.getCurrentTime(), original.getCurrentTime());
+    EXPECT_NEAR(restored.computeObservables().absorbedProbability,
+                original.computeObservables().absorbedProbability, 1e-14);
+    original.advance(5);
+    restored.advance(5);
+    const Wavefunction& expected = original.getWavefunction();
+    const Wavefunction& actual = restored.getWavefunction();
+    if (worldRank() == 0) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t n = 0; n < actual.size(); ++n) {
+            EXPECT_EQ(actual.data()[n], expected.data()[n]);
+        }
+
+        // The file has the serial layout
+        const CheckpointState state = Checkpoint::read(path);
+        EXPECT_EQ(state.step, 12);
+        ASSERT_EQ(state.psi.size(), captured.psi.size());
+        for (size_t n = 0; n < state.psi.size(); ++n) {
+            EXPECT_EQ(state.psi[n], captured.psi[n]);
+        }
+    }
+
+    // A serial checkpoint restores into the distributed engine
+    MPI_Barrier(MPI_COMM_WORLD);
+    SimulationEngine serial(config);
+    serial.advance(12);
+    CheckpointState state = serial.captureCheckpoint();
+    DistributedSimulationEngine resumed(config);
+    resumed.restoreCheckpoint(state);
+    resumed.advance(5);
+    serial.advance(5);
+    EXPECT_LT(maxDifference(resumed, serial), 1e-10);
+}
+
+// Test that BatchRunner drives the engine unchanged and writes output on rank 0 only
+TEST(DistributedEngineTest, BatchRunnerWritesOnRankZero) {
+    SharedTempDir directory("qmsim_distributed_batch");
+    PhysicsConfig config = makeConfig();
+    config.output.checkpointInterval = 10 * config.dt;
+
+    BatchOptions options;
+    options.steps = 30;
+    options.observableInterval = 10;
+    options.snapshotInterval = 15;
+    options.outputDir = directory.path().string();
+    options.quiet = true;
+    BatchRunner runner(std::make_shared<DistributedSimulationEngine>(config), config, options);
+    const BatchResult result = runner.run();
+    EXPECT_EQ(result.steps, 30);
+    EXPECT_EQ(result.checkpoints, 3);
+    EXPECT_EQ(result.snapshots, 2);
+
+    SimulationEngine serial(config);
+    serial.advance(30);
+    EXPECT_NEAR(result.totalProbability, serial.getTotalProbability(), 1e-12);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (worldRank() == 0) {
+        EXPECT_TRUE(std::filesystem::exists(directory.file("observables.csv")));
+        EXPECT_TRUE(std::filesystem::exists(directory.file("density_30.f32")));
+        EXPECT_EQ(Checkpoint::read(directory.file("checkpoint.h5"), false).step, 30);
+    }
+
+    // Resuming goes through the engine's own reader
+    options.resumeFrom = directory.file("checkpoint.h5");
+    options.steps = 40;
+    MPI_Barrier(MPI_COMM_WORLD);
+    BatchRunner resumed(std::make_shared<DistributedSimulationEngine>(config), config, options);
+    EXPECT_EQ(resumed.getStartStep(), 30);
+    const BatchResult more = resumed.run();
+    EXPECT_EQ(more.steps, 10);
+    serial.advance(10);
+    EXPECT_NEAR(more.totalProbability, serial.getTotalProbability(), 1e-12);
+}
+
+// Runs the tests on every rank; only rank 0 prints results
+int main(int argc, char** argv) {
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    ::testing::InitGoogleTest(&argc, argv);
+    if (worldRank() != 0) {
+        ::testing::TestEventListeners& listeners = ::testing::UnitTest::GetInstance()->listeners();
+        delete listeners.Release(listeners.default_result_printer());
+    }
+
+    int failed = RUN_ALL_TESTS();
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return failed;
+}
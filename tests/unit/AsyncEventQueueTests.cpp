@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/core/AsyncEventQueue.h"
+#include "../../src/core/EventPool.h"
+#include "../../src/core/EventBus.h"
+#include "../../src/core/IEventHandler.h"
+
+namespace {
+
+// Records every event it handles
+class EventRecorder : public IEventHandler {
+public:
+    bool handleEvent(const EventPtr& event) override {
+        events.push_back(event);
+        return true;
+    }
+
+    std::vector<EventPtr> events;
+};
+
+std::shared_ptr<EventRecorder> subscribeRecorder(EventBus& bus, const std::vector<EventType>& types) {
+    auto recorder = std::make_shared<EventRecorder>();
+    for (EventType type : types) {
+        bus.subscribe(type, recorder);
+    }
+    return recorder;
+}
+
+std::string parameterOf(const EventPtr& event) {
+    return static_cast<const ConfigurationUpdatedEvent&>(*event).getParameter();
+}
+
+}  // namespace
+
+// Test that events are delivered at dispatch, in posting order
+TEST(AsyncEventQueueTest, DeliversInOrderOnDispatch) {
+    EventBus bus;
+    auto recorder = subscribeRecorder(bus, {EventType::ConfigurationUpdated, EventType::SimulationStarted});
+    AsyncEventQueue queue(4);
+
+    queue.post(makeEvent<SimulationStartedEvent>());
+    for (int i = 0; i < 10; ++i) {
+        queue.post(makeEvent<ConfigurationUpdatedEvent>(std::to_string(i), ""));
+    }
+    EXPECT_TRUE(recorder->events.empty());
+    EXPECT_GT(queue.getOverflowCount(), 0u);  // Ten events do not fit four slots
+
+    EXPECT_EQ(queue.dispatch(bus), 11u);
+    ASSERT_EQ(recorder->events.size(), 11u);
+    EXPECT_EQ(recorder->events[0]->getType(), EventType::SimulationStarted);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(parameterOf(recorder->events[i + 1]), std::to_string(i));
+    }
+    EXPECT_EQ(queue.dispatch(bus), 0u);
+}
+
+// Test that only the latest coalesced event survives until dispatch
+TEST(AsyncEventQueueTest, CoalescesSteppedEvents) {
+    EventBus bus;
+    auto recorder = subscribeRecorder(bus, {EventType::SimulationStepped, EventType::SimulationReset});
+    AsyncEventQueue queue;
+
+    queue.post(makeEvent<SimulationResetEvent>());
+    for (int i = 1; i <= 100; ++i) {
+        queue.post(makeEvent<SimulationSteppedEvent>(0.01 * i, 0.01, 1.0));
+    }
+
+    EXPECT_EQ(queue.dispatch(bus), 2u);
+    ASSERT_EQ(recorder->events.size(), 2u);
+    EXPECT_EQ(recorder->events[0]->getType(), EventType::SimulationReset);
+    EXPECT_DOUBLE_EQ(static_cast<const SimulationSteppedEvent&>(*recorder->events[1]).getTime(), 1.0);
+    EXPECT_EQ(queue.getCoalescedCount(), 99u);
+
+    // With coalescing off every event is delivered
+    recorder->events.clear();
+    queue.setCoalesced({});
+    for (int i = 0; i < 5; ++i) {
+        queue.post(makeEvent<SimulationSteppedEvent>(0.0, 0.01, 1.0));
+    }
+    EXPECT_EQ(queue.dispatch(bus), 5u);
+}
+
+// Test that concurrent producers lose no events and keep their own order
+TEST(AsyncEventQueueTest, MultipleProducers) {
+    EventBus bus;
+    auto recorder = subscribeRecorder(bus, {EventType::ConfigurationUpdated});
+    AsyncEventQueue queue(64);
+
+    const int kProducers = 4;
+    const int kEvents = 2000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kEvents; ++i) {
+                queue.post(makeEvent<ConfigurationUpdatedEvent>(std::to_string(p), std::to_string(i)));
+            }
+        });
+    }
+
+    size_t delivered = 0;
+    while (delivered < static_cast<size_t>(kProducers * kEvents)) {
+        delivered += queue.dispatch(bus);
+        std::this_thread::yield();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(queue.dispatch(bus), 0u);
+
+    std::vector<int> next(kProducers, 0);
+    for (const EventPtr& event : recorder->events) {
+        const auto& update = static_cast<const ConfigurationUpdatedEvent&>(*event);
+        const int p = std::stoi(update.getParameter());
+        EXPECT_EQ(std::stoi(update.getValue()), next[p]);
+        ++next[p];
+    }
+    for (int p = 0; p < kProducers; ++p) {
+        EXPECT_EQ(next[p], kEvents);
+    }
+}
+
+// Test the optional history ring
+TEST(AsyncEventQueueTest, History) {
+    EventBus bus;
+    AsyncEventQueue queue;
+    queue.post(makeEvent<ConfigurationUpdatedEvent>("a", ""));
+    queue.dispatch(bus);
+    EXPECT_TRUE(queue.getHistory().empty());
+
+    queue.setHistoryCapacity(3);
+    for (const char* name : {"b", "c", "d", "e"}) {
+        queue.post(makeEvent<ConfigurationUpdatedEvent>(name, ""));
+    }
+    queue.dispatch(bus);
+
+    std::vector<EventPtr> history = queue.getHistory();
+    ASSERT_EQ(history.size(), 3u);
+    EXPECT_EQ(parameterOf(history[0]), "c");
+    EXPECT_EQ(parameterOf(history[2]), "e");
+
+    queue.setHistoryCapacity(1);
+    history = queue.getHistory();
+    ASSERT_EQ(history.size(), 1u);
+    EXPECT_EQ(parameterOf(history[0]), "e");
+}
+
+// Test that pooled events reuse their blocks once released
+TEST(EventPoolTest, ReusesBlocks) {
+    auto pool = std::make_shared<EventPool>(4);
+    EventBus bus;
+    bus.setMaxHistorySize(0);  // The bus history would keep the events alive
+    AsyncEventQueue queue;
+
+    for (int i = 0; i < 1000; ++i) {
+        queue.post(makePooledEvent<SimulationSteppedEvent>(pool, 0.01 * i, 0.01, 1.0));
+        queue.post(makePooledEvent<WavefunctionUpdatedEvent>(pool));
+        if (i % 10 == 0) {
+            queue.dispatch(bus);
+        }
+    }
+    queue.dispatch(bus);
+    EXPECT_EQ(pool->getHeapAllocationCount(), 0u);
+
+    // An exhausted pool falls back to the heap
+    std::vector<EventPtr> held;
+    for (int i = 0; i < 5; ++i) {
+        held.push_back(makePooledEvent<WavefunctionUpdatedEvent>(pool));
+    }
+    EXPECT_EQ(pool->getHeapAllocationCount(), 1u);
+    EXPECT_EQ(held.back()->getType(), EventType::WavefunctionUpdated);
+
+    // Without a pool it is makeEvent()
+    EXPECT_NE(makePooledEvent<WavefunctionUpdatedEvent>(nullptr), nullptr);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../../src/batch/BatchRunner.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "../../src/solver/Observables.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    return test_utils::makeConfig(32, 16, 0.01, "FreeSpace", {}, {0.0, 0.0, 1.0, 1.0, 1.0, 0.0});
+}
+
+using test_utils::readLines;
+
+// Fresh output directory under the system temp path, removed after each test
+class BatchRunnerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() /
+                ("qmsim_batch_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+    }
+    void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+    std::filesystem::path m_dir;
+};
+
+}  // namespace
+
+// Test a step-count run with periodic observables and snapshots
+TEST_F(BatchRunnerTest, WritesObservablesAndSnapshots) {
+    PhysicsConfig config = makeConfig();
+    BatchOptions options;
+    options.steps = 25;
+    options.observableInterval = 10;
+    options.snapshotInterval = 20;
+    options.outputDir = m_dir.string();
+    options.quiet = true;
+
+    BatchRunner runner(config, options);
+    BatchResult result = runner.run();
+
+    EXPECT_EQ(result.steps, 25);
+    EXPECT_NEAR(result.simulatedTime, 0.25, 1e-12);
+    EXPECT_NEAR(result.totalProbability, 1.0, 1e-10);
+    EXPECT_EQ(result.snapshots, 2);
+
+    // Header plus rows for steps 0, 10, 20 and 25
+    auto lines = readLines(m_dir / "observables.csv");
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(lines[0].rfind("step,time,total_probability,", 0), 0u);
+    EXPECT_EQ(lines[1].rfind("0,", 0), 0u);
+    EXPECT_EQ(lines[2].rfind("10,", 0), 0u);
+    EXPECT_EQ(lines[4].rfind("25,", 0), 0u);
+
+    // One float per grid point in each snapshot
+    const auto expectedSize = static_cast<std::uintmax_t>(config.nx * config.ny * sizeof(float));
+    EXPECT_EQ(std::filesystem::file_size(m_dir / "density_20.f32"), expectedSize);
+    EXPECT_EQ(std::filesystem::file_size(m_dir / "density_25.f32"), expectedSize);
+}
+
+// Test that a simulated duration is converted to whole steps
+TEST_F(BatchRunnerTest, DurationSetsStepCount) {
+    PhysicsConfig config = makeConfig();
+    config.precision = "float";
+    BatchOptions options;
+    options.duration = 0.105;
+    options.outputDir = m_dir.string();
+    options.quiet = true;
+
+    BatchRunner runner(config, options);
+    EXPECT_EQ(runner.getTotalSteps(), 11);
+
+    BatchResult result = runner.run();
+    EXPECT_EQ(result.steps, 11);
+    EXPECT_GE(result.simulatedTime, options.duration);
+    EXPECT_EQ(result.snapshots, 1);
+    EXPECT_EQ(readLines(m_dir / "observables.csv").size(), 3u);
+}
+
+// Test that an adaptive run takes its own steps between outputs at multiples of dt
+TEST_F(BatchRunnerTest, AdaptiveRunKeepsOutputTimes) {
+    PhysicsConfig config = makeConfig();
+    config.dt = 0.001;
+    config.integration.scheme = "blanes-moan4";
+    config.integration.adaptive = true;
+    config.integration.tolerance = 1e-6;
+    BatchOptions options;
+    options.duration = 0.5;
+    options.observableInterval = 100;
+    options.outputDir = m_dir.string();
+    options.quiet = true;
+
+    BatchRunner runner(config, options);
+    BatchResult result = runner.run();
+    EXPECT_NEAR(result.simulatedTime, 0.5, 1e-12);
+    EXPECT_LT(result.steps, 100);
+    EXPECT_NEAR(result.totalProbability, 1.0, 1e-10);
+
+    // Rows at steps 0, 100, ..., 500 of the configured dt
+    auto lines = readLines(m_dir / "observables.csv");
+    ASSERT_EQ(lines.size(), 7u);
+    EXPECT_EQ(lines[2].rfind("100,0.1,", 0), 0u);
+    EXPECT_EQ(lines[6].rfind("500,0.5,", 0), 0u);
+
+    // Strang gives no error estimate, so the run is refused
+    config.integration.scheme = "strang";
+    BatchRunner strang(config, options);
+    EXPECT_THROW(strang.run(), std::invalid_argument);
+}
+
+// Test that an imaginaryTime block makes the run start from the ground state
+TEST_F(BatchRunnerTest, RelaxesToGroundStateFirst) {
+    PhysicsConfig config = makeConfig();
+    config.nx = 32;
+    config.ny = 32;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = {1.0};
+    config.imaginaryTime.enabled = true;
+    BatchOptions options;
+    options.steps = 20;
+    options.outputDir = m_dir.string();
+    options.quiet = true;
+
+    BatchRunner runner(config, options);
+    BatchResult result = runner.run();
+    ASSERT_EQ(result.eigenstates.size(), 1u);
+    EXPECT_TRUE(result.eigenstates[0].converged);
+    EXPECT_NEAR(result.eigenstates[0].energy, 1.0, 1e-3);
+    EXPECT_NEAR(result.simulatedTime, 0.2, 1e-12);
+
+    // The wavepacket moving with ⟨p_x⟩ = 1 was replaced by the stationary
+    // ground state, E = ω
+    const ObservableSample sample = runner.getEngine()->computeObservables();
+    EXPECT_NEAR(sample.energy, 1.0, 1e-3);
+    EXPECT_NEAR(sample.px, 0.0, 1e-3);
+}
+
+// Test that a run resumed from a checkpoint ends in the same state as a full run
+TEST_F(BatchRunnerTest, ResumeFromCheckpoint) {
+    PhysicsConfig config = makeConfig();
+    config.output.checkpointInterval = 0.1;
+
+    // Reference run straight to step 20
+    BatchOptions full;
+    full.steps = 20;
+    full.observableInterval = 5;
+    full.outputDir = (m_dir / "full").string();
+    full.quiet = true;
+    BatchResult reference = BatchRunner(config, full).run();
+    EXPECT_GE(reference.checkpoints, 1);
+
+    // Interrupted run: only the first 10 steps, leaving a checkpoint at step 10
+    BatchOptions partial = full;
+    partial.steps = 10;
+    partial.outputDir = (m_dir / "resumed").string();
+    BatchRunner(config, partial).run();
+
+    BatchOptions resume = full;
+    resume.outputDir = partial.outputDir;
+    resume.resumeFrom = (m_dir / "resumed" / "checkpoint.h5").string();
+    BatchRunner runner(config, resume);
+    EXPECT_EQ(runner.getStartStep(), 10);
+
+    BatchResult result = runner.run();
+    EXPECT_EQ(result.firstStep, 10);
+    EXPECT_EQ(result.steps, 10);
+    EXPECT_DOUBLE_EQ(result.simulatedTime, reference.simulatedTime);
+    EXPECT_NEAR(result.totalProbability, reference.totalProbability, 1e-12);
+
+    // Observable rows for steps 0, 5, 10, 15 and 20, without duplicates
+    auto lines = readLines(m_dir / "resumed" / "observables.csv");
+    ASSERT_EQ(lines.size(), 6u);
+    EXPECT_EQ(lines[3].rfind("10,", 0), 0u);
+    EXPECT_EQ(lines[5].rfind("20,", 0), 0u);
+}
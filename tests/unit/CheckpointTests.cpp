@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <complex>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include "../../src/solver/Checkpoint.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    return test_utils::makeConfig(32, 16, 0.01, "HarmonicOscillator", {1.5}, {1.0, 0.0, 1.0, 1.0, 2.0, 0.0});
+}
+
+// Checkpoint file path under the system temp directory, removed after each test
+class CheckpointTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_path = (std::filesystem::temp_directory_path() /
+                  ("qmsim_checkpoint_" +
+                   std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".h5"))
+                     .string();
+        std::filesystem::remove(m_path);
+    }
+    void TearDown() override { std::filesystem::remove(m_path); }
+
+    std::string m_path;
+};
+
+}  // namespace
+
+// Test that every field survives a write/read round trip
+TEST_F(CheckpointTest, RoundTrip) {
+    SimulationEngine engine(makeConfig());
+    engine.advance(5);
+    CheckpointState saved = engine.captureCheckpoint();
+    saved.step = 5;
+
+    Checkpoint::write(m_path, saved, 4);
+    CheckpointState loaded = Checkpoint::read(m_path);
+
+    EXPECT_EQ(loaded.nx, 32);
+    EXPECT_EQ(loaded.ny, 16);
+    EXPECT_DOUBLE_EQ(loaded.lx, saved.lx);
+    EXPECT_DOUBLE_EQ(loaded.dt, 0.01);
+    EXPECT_DOUBLE_EQ(loaded.time, engine.getCurrentTime());
+    EXPECT_EQ(loaded.step, 5);
+    EXPECT_EQ(loaded.precision, "double");
+    EXPECT_EQ(loaded.potential.type, "HarmonicOscillator");
+    ASSERT_EQ(loaded.potential.parameters.size(), 1u);
+    EXPECT_DOUBLE_EQ(loaded.potential.parameters[0], 1.5);
+    ASSERT_EQ(loaded.psi.size(), saved.psi.size());
+    for (size_t i = 0; i < saved.psi.size(); ++i) {
+        EXPECT_EQ(loaded.psi[i], saved.psi[i]);
+    }
+
+    // The header can be read without the wavefunction
+    CheckpointState header = Checkpoint::read(m_path, false);
+    EXPECT_EQ(header.nx, 32);
+    EXPECT_TRUE(header.psi.empty());
+}
+
+// Test that nested potential components survive a round trip
+TEST_F(CheckpointTest, PotentialComponentsRoundTrip) {
+    PotentialConfig oscillator;
+    oscillator.type = "HarmonicOscillator";
+    oscillator.parameters = {1.5};
+
+    PotentialConfig composite;
+    composite.type = "Composite";
+    composite.components = {oscillator};
+
+    PotentialConfig moving;
+    moving.type = "Moving";
+    moving.parameters = {0.1, 0.0};
+    moving.components = {oscillator};
+    moving.components[0].parameters = {2.0};
+
+    PhysicsConfig config = makeConfig();
+    config.potential.type = "Driven";
+    config.potential.parameters = {0.5, 2.0};
+    config.potential.components = {composite, moving};
+
+    SimulationEngine engine(config);
+    Checkpoint::write(m_path, engine.captureCheckpoint());
+    CheckpointState loaded = Checkpoint::read(m_path, false);
+
+    ASSERT_EQ(loaded.potential.components.size(), 2u);
+    ASSERT_EQ(loaded.potential.components[0].components.size(), 1u);
+    EXPECT_EQ(loaded.potential.components[0].components[0].type, "HarmonicOscillator");
+    EXPECT_EQ(loaded.potential, config.potential);
+}
+
+// Test that a restored engine continues exactly like an uninterrupted one
+TEST_F(CheckpointTest, RestoreContinuesRun) {
+    PhysicsConfig config = makeConfig();
+    SimulationEngine reference(config);
+    reference.advance(20);
+
+    SimulationEngine first(config);
+    first.advance(10);
+    Checkpoint::write(m_path, first.captureCheckpoint());
+
+    // Start from a different potential and time step; the checkpoint wins
+    PhysicsConfig other = config;
+    other.dt = 0.02;
+    other.potential.type = "FreeSpace";
+    other.potential.parameters.clear();
+    SimulationEngine resumed(other);
+    resumed.restoreCheckpoint(Checkpoint::read(m_path));
+    resumed.advance(10);
+
+    EXPECT_DOUBLE_EQ(resumed.getCurrentTime(), reference.getCurrentTime());
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = resumed.getWavefunction();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(std::abs(actual.data()[i] - expected.data()[i]), 0.0, 1e-12);
+    }
+}
+
+// Test single precision files and restoring them into either engine
+TEST_F(CheckpointTest, SinglePrecision) {
+    PhysicsConfig config = makeConfig();
+    config.precision = "float";
+    SimulationEngineF engine(config);
+    engine.advance(3);
+    Checkpoint::write(m_path, engine.captureCheckpoint());
+
+    CheckpointState loaded = Checkpoint::read(m_path);
+    EXPECT_EQ(loaded.precision, "float");
+
+    SimulationEngineF restored(config);
+    restored.restoreCheckpoint(loaded);
+    const auto& expected = engine.getNativeWavefunction();
+    const auto& actual = restored.getNativeWavefunction();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(actual.data()[i], expected.data()[i]);
+    }
+
+    SimulationEngine promoted(makeConfig());
+    EXPECT_NO_THROW(promoted.restoreCheckpoint(loaded));
+    EXPECT_DOUBLE_EQ(promoted.getCurrentTime(), engine.getCurrentTime());
+}
+
+// Test that mismatched grids and missing files are rejected
+TEST_F(CheckpointTest, RejectsMismatch) {
+    SimulationEngine engine(makeConfig());
+    CheckpointState state = engine.captureCheckpoint();
+
+    PhysicsConfig larger = makeConfig();
+    larger.nx = 64;
+    SimulationEngine other(larger);
+    EXPECT_THROW(other.restoreCheckpoint(state), std::invalid_argument);
+
+    EXPECT_THROW(Checkpoint::read(m_path), std::runtime_error);
+}
+
+// Test the background writer and the interval conversion
+TEST_F(CheckpointTest, BackgroundWriter) {
+    SimulationEngine engine(makeConfig());
+    {
+        CheckpointWriter writer(1);
+        for (int i = 1; i <= 3; ++i) {
+            engine.advance(2);
+            CheckpointState state = engine.captureCheckpoint();
+            state.step = 2 * i;
+            writer.submit(m_path, std::move(state));
+        }
+        writer.flush();
+        EXPECT_GE(writer.getWrittenCount(), 1);
+    }
+
+    // Older queued states may be dropped, but the newest always lands
+    EXPECT_EQ(Checkpoint::read(m_path, false).step, 6);
+    EXPECT_FALSE(std::filesystem::exists(m_path + ".tmp"));
+
+    EXPECT_EQ(Checkpoint::intervalSteps(0.1, 0.01), 10);
+    EXPECT_EQ(Checkpoint::intervalSteps(0.001, 0.01), 1);
+    EXPECT_EQ(Checkpoint::intervalSteps(0.0, 0.01), 0);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <complex>
+#include <random>
+#include <vector>
+#include "../../src/solver/ComplexKernels.h"
+
+namespace {
+
+// Every instruction set the kernels can be compiled for
+const kernels::Isa ALL_ISAS[] = {
+    kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512, kernels::Isa::NEON
+};
+
+template <typename T = double>
+std::vector<std::complex<T>> randomBuffer(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<T> dist(-2, 2);
+    std::vector<std::complex<T>> buffer(count);
+    for (auto& value : buffer) {
+        value = std::complex<T>(dist(rng), dist(rng));
+    }
+    return buffer;
+}
+
+// Restores the default instruction set after each test
+class ComplexKernelsTest : public ::testing::Test {
+protected:
+    void SetUp() override { m_defaultIsa = kernels::activeIsa(); }
+    void TearDown() override { kernels::setIsa(m_defaultIsa); }
+
+private:
+    kernels::Isa m_defaultIsa = kernels::Isa::Scalar;
+};
+
+}  // namespace
+
+// Test that the dispatcher picks a supported instruction set
+TEST_F(ComplexKernelsTest, Dispatch) {
+    EXPECT_TRUE(kernels::isSupported(kernels::Isa::Scalar));
+    EXPECT_TRUE(kernels::isSupported(kernels::activeIsa()));
+    EXPECT_TRUE(kernels::setIsa(kernels::Isa::Scalar));
+    EXPECT_EQ(kernels::activeIsa(), kernels::Isa::Scalar);
+    EXPECT_STREQ(kernels::isaName(kernels::Isa::AVX2), "AVX2");
+}
+
+// Test the complex multiply kernels against std::complex on every available path
+TEST_F(ComplexKernelsTest, MultiplyMatchesStdComplex) {
+    for (kernels::Isa isa : ALL_ISAS) {
+        if (!kernels::setIsa(isa)) continue;
+        SCOPED_TRACE(kernels::isaName(isa));
+
+        // Odd sizes exercise the scalar tails of the vector loops
+        for (size_t count : { 0u, 1u, 3u, 8u, 37u }) {
+            auto psi = randomBuffer(count, 1);
+            auto table = randomBuffer(count, 2);
+            auto squared = psi;
+
+            kernels::multiply(psi.data(), table.data(), count);
+            kernels::multiplySquared(squared.data(), table.data(), count);
+
+            auto original = randomBuffer(count, 1);
+            for (size_t n = 0; n < count; ++n) {
+                std::complex<double> expected = original[n] * table[n];
+                EXPECT_NEAR(psi[n].real(), expected.real(), 1e-14);
+                EXPECT_NEAR(psi[n].imag(), expected.imag(), 1e-14);
+
+                expected = original[n] * table[n] * table[n];
+                EXPECT_NEAR(squared[n].real(), expected.real(), 1e-13);
+                EXPECT_NEAR(squared[n].imag(), expected.imag(), 1e-13);
+            }
+        }
+    }
+}
+
+// Test the scale, density and norm kernels on every available path
+TEST_F(ComplexKernelsTest, ScaleAndNorms) {
+    for (kernels::Isa isa : ALL_ISAS) {
+        if (!kernels::setIsa(isa)) continue;
+        SCOPED_TRACE(kernels::isaName(isa));
+
+        const size_t count = 45;
+        auto original = randomBuffer(count, 3);
+
+        auto scaled = original;
+        kernels::scale(scaled.data(), 0.25, count);
+
+        std::vector<float> density(count);
+        kernels::normToFloat(original.data(), density.data(), count);
+
+        double expectedSum = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+            EXPECT_DOUBLE_EQ(scaled[n].real(), original[n].real() * 0.25);
+            EXPECT_DOUBLE_EQ(scaled[n].imag(), original[n].imag() * 0.25);
+            EXPECT_FLOAT_EQ(density[n], static_cast<float>(std::norm(original[n])));
+            expectedSum += std::norm(original[n]);
+        }
+        EXPECT_NEAR(kernels::sumNorm(original.data(), count), expectedSum, 1e-12);
+    }
+}
+
+// Test the single-precision kernels against std::complex<float> on every available path
+TEST_F(ComplexKernelsTest, SinglePrecisionKernels) {
+    for (kernels::Isa isa : ALL_ISAS) {
+        if (!kernels::setIsa(isa)) continue;
+        SCOPED_TRACE(kernels::isaName(isa));
+        
+        // Odd sizes exercise the scalar tails of the vector loops
+        for (size_t count : { 0u, 1u, 3u, 8u, 16u, 37u }) {
+            const auto original = randomBuffer<float>(count, 4);
+            const auto table = randomBuffer<float>(count, 5);
+            
+            auto psi = original;
+            auto squared = original;
+            auto scaled = original;
+            kernels::multiply(psi.data(), table.data(), count);
+            kernels::multiplySquared(squared.data(), table.data(), count);
+            kernels::scale(scaled.data(), 0.5f, count);
+            
+            std::vector<float> density(count);
+            kernels::normToFloat(original.data(), density.data(), count);
+            
+            double expectedSum = 0.0;
+            for (size_t n = 0; n < count; ++n) {
+                std::complex<float> expected = original[n] * table[n];
+                EXPECT_NEAR(psi[n].real(), expected.real(), 1e-5);
+                EXPECT_NEAR(psi[n].imag(), expected.imag(), 1e-5);
+                
+                expected = original[n] * table[n] * table[n];
+                EXPECT_NEAR(squared[n].real(), expected.real(), 1e-4);
+                EXPECT_NEAR(squared[n].imag(), expected.imag(), 1e-4);
+                
+                EXPECT_FLOAT_EQ(scaled[n].real(), original[n].real() * 0.5f);
+                EXPECT_FLOAT_EQ(scaled[n].imag(), original[n].imag() * 0.5f);
+                EXPECT_NEAR(density[n], std::norm(original[n]), 1e-5);
+                expectedSum += std::norm(std::complex<double>(original[n]));
+            }
+            EXPECT_NEAR(kernels::sumNorm(original.data(), count), expectedSum, 1e-9);
+        }
+    }
+}
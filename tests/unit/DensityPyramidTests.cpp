@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../../src/solver/DensityPyramid.h"
+
+namespace {
+
+std::vector<float> randomDensity(int nx, int ny, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<float> density(static_cast<size_t>(nx) * ny);
+    for (float& value : density) {
+        value = distribution(generator);
+    }
+    return density;
+}
+
+DensityPyramid makePyramid(const std::vector<float>& density, int nx, int ny, int numThreads = 1) {
+    DensityPyramid pyramid(numThreads);
+    std::copy(density.begin(), density.end(), pyramid.resize(nx, ny));
+    pyramid.build();
+    return pyramid;
+}
+
+// Maximum over the exact grid span of every output sample
+std::vector<float> bruteForceMax(const std::vector<float>& density, int nx, const DensityViewport& view) {
+    int width = 0;
+    int height = 0;
+    DensityPyramid::outputSize(view, width, height);
+    std::vector<float> result(static_cast<size_t>(width) * height, 0.0f);
+    for (int v = 0; v < height; ++v) {
+        for (int u = 0; u < width; ++u) {
+            const int64_t i0 = view.x0 + static_cast<int64_t>(u) * view.width / width;
+            const int64_t i1 = view.x0 + static_cast<int64_t>(u + 1) * view.width / width;
+            const int64_t j0 = view.y0 + static_cast<int64_t>(v) * view.height / height;
+            const int64_t j1 = view.y0 + static_cast<int64_t>(v + 1) * view.height / height;
+            float value = 0.0f;
+            for (int64_t j = j0; j < j1; ++j) {
+                for (int64_t i = i0; i < i1; ++i) {
+                    value = std::max(value, density[j * nx + i]);
+                }
+            }
+            result[static_cast<size_t>(v) * width + u] = value;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+// Test level sizes and 2x2 max pooling with odd edges
+TEST(DensityPyramidTest, BuildsMaxPooledLevels) {
+    const int nx = 5;
+    const int ny = 3;
+    std::vector<float> density = randomDensity(nx, ny, 1);
+    DensityPyramid pyramid = makePyramid(density, nx, ny);
+
+    ASSERT_EQ(pyramid.getLevelCount(), 4);
+    EXPECT_EQ(pyramid.getLevelWidth(1), 3);
+    EXPECT_EQ(pyramid.getLevelHeight(1), 2);
+    EXPECT_EQ(pyramid.getLevelWidth(3), 1);
+    EXPECT_EQ(pyramid.getLevelHeight(3), 1);
+
+    // The odd last column and row only pool themselves
+    EXPECT_EQ(pyramid.getLevel(1)[0], std::max({density[0], density[1], density[5], density[6]}));
+    EXPECT_EQ(pyramid.getLevel(1)[2], std::max(density[4], density[9]));
+    EXPECT_EQ(pyramid.getLevel(1)[3], std::max(density[10], density[11]));
+    EXPECT_EQ(pyramid.getLevel(3)[0], *std::max_element(density.begin(), density.end()));
+}
+
+// Test that aligned reductions match a brute-force max pool exactly
+TEST(DensityPyramidTest, SampleMatchesBruteForce) {
+    const int nx = 128;
+    const int ny = 64;
+    std::vector<float> density = randomDensity(nx, ny, 2);
+    DensityPyramid pyramid = makePyramid(density, nx, ny, 4);
+
+    DensityViewport request;
+    request.maxWidth = 16;
+    request.maxHeight = 16;
+    DensityViewport view = DensityPyramid::resolve(request, nx, ny);
+    std::vector<float> sampled(16 * 16);
+    pyramid.sample(view, sampled.data());
+    EXPECT_EQ(sampled, bruteForceMax(density, nx, view));
+
+    // Unaligned: never below the exact span maximum, and peaks survive
+    request = DensityViewport{7, 3, 101, 57, 33, 20};
+    view = DensityPyramid::resolve(request, nx, ny);
+    int width = 0;
+    int height = 0;
+    DensityPyramid::outputSize(view, width, height);
+    ASSERT_EQ(width, 33);
+    ASSERT_EQ(height, 20);
+    sampled.assign(static_cast<size_t>(width) * height, 0.0f);
+    pyramid.sample(view, sampled.data());
+    std::vector<float> exact = bruteForceMax(density, nx, view);
+    for (size_t n = 0; n < exact.size(); ++n) {
+        EXPECT_GE(sampled[n], exact[n]);
+    }
+    EXPECT_EQ(*std::max_element(sampled.begin(), sampled.end()),
+              *std::max_element(exact.begin(), exact.end()));
+}
+
+// Test that regions smaller than the output come back at full resolution
+TEST(DensityPyramidTest, ZoomedRegionIsFullResolution) {
+    const int nx = 64;
+    const int ny = 64;
+    std::vector<float> density = randomDensity(nx, ny, 3);
+    DensityPyramid pyramid = makePyramid(density, nx, ny);
+
+    DensityViewport view = DensityPyramid::resolve(DensityViewport{20, 30, 10, 8, 32, 32}, nx, ny);
+    int width = 0;
+    int height = 0;
+    DensityPyramid::outputSize(view, width, height);
+    ASSERT_EQ(width, 10);
+    ASSERT_EQ(height, 8);
+
+    std::vector<float> tile(static_cast<size_t>(width) * height);
+    pyramid.sample(view, tile.data());
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            EXPECT_EQ(tile[j * width + i], density[(30 + j) * nx + 20 + i]);
+        }
+    }
+}
+
+// Test viewport resolution and field point sampling
+TEST(DensityPyramidTest, ResolveAndSampleField) {
+    DensityViewport view = DensityPyramid::resolve(DensityViewport{}, 40, 30);
+    EXPECT_TRUE(DensityPyramid::isFullResolution(view, 40, 30));
+
+    view = DensityPyramid::resolve(DensityViewport{35, -5, 20, 0, 0, 0}, 40, 30);
+    EXPECT_EQ(view.x0, 35);
+    EXPECT_EQ(view.y0, 0);
+    EXPECT_EQ(view.width, 5);
+    EXPECT_EQ(view.height, 30);
+    EXPECT_FALSE(DensityPyramid::isFullResolution(view, 40, 30));
+
+    // Field value at (i, j) encodes its position
+    const int nx = 8;
+    const int ny = 4;
+    std::vector<float> field(2 * nx * ny);
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            field[2 * (j * nx + i)] = static_cast<float>(i);
+            field[2 * (j * nx + i) + 1] = static_cast<float>(j);
+        }
+    }
+    view = DensityPyramid::resolve(DensityViewport{0, 0, 0, 0, 4, 2}, nx, ny);
+    std::vector<float> sampled(2 * 4 * 2);
+    DensityPyramid::sampleField(field.data(), nx, ny, view, sampled.data(), 1);
+    EXPECT_EQ(sampled[0], 0.0f);   // Cells {0, 1} x {0, 1} pick (0, 0)
+    EXPECT_EQ(sampled[2], 2.0f);   // Next cell starts at column 2
+    EXPECT_EQ(sampled[2 * 4 + 1], 2.0f);  // Second output row starts at grid row 2
+}
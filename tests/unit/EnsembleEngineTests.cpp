@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "../../src/solver/EnsembleEngine.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    PhysicsConfig config =
+        test_utils::makeConfig(32, 32, 0.005, "HarmonicOscillator", {1.5}, {0.0, 0.0, 1.0, 1.0, 0.0, 0.0});
+    config.absorber.width = 2.0;
+    return config;
+}
+
+std::vector<Wavepacket> makeWavepackets() {
+    return {
+        {0.0, 0.0, 0.8, 0.8, 2.0, 0.0},
+        {-1.0, 0.5, 0.6, 1.0, 0.0, -1.5},
+        {2.0, -1.0, 1.2, 0.7, 4.0, 3.0},
+    };
+}
+
+// Largest |ψ_member - ψ_engine| over the grid
+template <typename Real>
+double maxDifference(const BasicEnsembleEngine<Real>& ensemble, size_t member, const BasicSimulationEngine<Real>& engine) {
+    const BasicWavefunction<Real> actual = ensemble.getMember(member);
+    const Wavefunction& expected = engine.getWavefunction();
+    double difference = 0.0;
+    for (size_t n = 0; n < actual.size(); ++n) {
+        difference = std::max(difference, std::abs(std::complex<double>(actual.data()[n]) - expected.data()[n]));
+    }
+    return difference;
+}
+
+}  // namespace
+
+// Test that every member evolves like an independent engine
+TEST(EnsembleEngineTest, MatchesIndependentEngines) {
+    PhysicsConfig config = makeConfig();
+    const std::vector<Wavepacket> wavepackets = makeWavepackets();
+    EnsembleEngine ensemble(config, wavepackets);
+    ASSERT_EQ(ensemble.getMemberCount(), wavepackets.size());
+
+    ensemble.advance(7);
+    ensemble.step();
+    ensemble.advance(12);
+    EXPECT_NEAR(ensemble.getCurrentTime(), 20 * config.dt, 1e-12);
+
+    for (size_t k = 0; k < wavepackets.size(); ++k) {
+        config.wavepacket = wavepackets[k];
+        SimulationEngine engine(config);
+        engine.advance(7);
+        engine.step();
+        engine.advance(12);
+        EXPECT_LT(maxDifference(ensemble, k, engine), 1e-10) << "member " << k;
+        EXPECT_NEAR(ensemble.getTotalProbability(k), engine.getTotalProbability(), 1e-12);
+    }
+
+    // reset() returns every member to its wavepacket
+    ensemble.reset();
+    EXPECT_DOUBLE_EQ(ensemble.getCurrentTime(), 0.0);
+    config.wavepacket = wavepackets[2];
+    SimulationEngine fresh(config);
+    EXPECT_LT(maxDifference(ensemble, 2, fresh), 1e-14);
+}
+
+// Test a fourth-order scheme with a time-dependent potential shared by the members
+TEST(EnsembleEngineTest, TimeDependentPotentialAndScheme) {
+    PhysicsConfig config = makeConfig();
+    config.integration.scheme = "yoshida4";
+    PotentialConfig trap;
+    trap.type = "HarmonicOscillator";
+    trap.parameters = { 1.0 };
+    PotentialConfig drive;
+    drive.type = "HarmonicOscillator";
+    drive.parameters = { 0.5 };
+    config.potential = PotentialConfig();
+    config.potential.type = "Driven";
+    config.potential.parameters = { 1.0, 5.0 };
+    config.potential.components = { trap, drive };
+
+    const std::vector<Wavepacket> wavepackets = makeWavepackets();
+    EnsembleEngine ensemble(config, wavepackets);
+    ensemble.advance(15);
+
+    for (size_t k = 0; k < wavepackets.size(); ++k) {
+        config.wavepacket = wavepackets[k];
+        SimulationEngine engine(config);
+        engine.advance(15);
+        EXPECT_LT(maxDifference(ensemble, k, engine), 1e-9) << "member " << k;
+    }
+}
+
+// Test the single-precision ensemble against the single-precision engine
+TEST(EnsembleEngineTest, SinglePrecision) {
+    PhysicsConfig config = makeConfig();
+    config.precision = "float";
+    const std::vector<Wavepacket> wavepackets = makeWavepackets();
+    EnsembleEngineF ensemble(config, wavepackets);
+    ensemble.advance(10);
+
+    std::vector<float> density(static_cast<size_t>(config.nx) * config.ny);
+    for (size_t k = 0; k < wavepackets.size(); ++k) {
+        config.wavepacket = wavepackets[k];
+        SimulationEngineF engine(config);
+        engine.advance(10);
+        EXPECT_LT(maxDifference(ensemble, k, engine), 1e-5) << "member " << k;
+
+        ensemble.writeProbabilityDensity(k, density.data());
+        double sum = 0.0;
+        for (float value : density) {
+            sum += value;
+        }
+        EXPECT_NEAR(sum * (config.lx / config.nx) * (config.ly / config.ny), ensemble.getTotalProbability(k), 1e-5);
+    }
+}
+
+// Test that an empty ensemble is rejected
+TEST(EnsembleEngineTest, RequiresMembers) {
+    EXPECT_THROW(EnsembleEngine(makeConfig(), {}), std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <stdexcept>
+#include <fftw3.h>
+#include "../../src/solver/FFTWWisdom.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig(const std::string& wisdomDir) {
+    PhysicsConfig config = test_utils::makeConfig(32, 16, 0.01, "FreeSpace", {}, {0.0, 0.0, 0.8, 0.8, 2.0, 0.0});
+    config.fftw.wisdomDir = wisdomDir;
+    return config;
+}
+
+// Fresh wisdom directory under the system temp path, removed after each test
+class FFTWWisdomTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() /
+                ("qmsim_wisdom_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+    }
+    void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+    std::filesystem::path m_dir;
+};
+
+}  // namespace
+
+// Test planner names and flags
+TEST_F(FFTWWisdomTest, PlannerFlags) {
+    EXPECT_EQ(FFTWWisdom::plannerFlags("estimate"), static_cast<unsigned>(FFTW_ESTIMATE));
+    EXPECT_EQ(FFTWWisdom::plannerFlags("measure"), static_cast<unsigned>(FFTW_MEASURE));
+    EXPECT_EQ(FFTWWisdom::plannerFlags("patient"), static_cast<unsigned>(FFTW_PATIENT));
+    EXPECT_THROW(FFTWWisdom::plannerFlags("fast"), std::invalid_argument);
+
+    for (const char* name : { "estimate", "measure", "patient", "exhaustive" }) {
+        EXPECT_STREQ(FFTWWisdom::plannerName(FFTWWisdom::plannerFlags(name)), name);
+    }
+    EXPECT_FALSE(FFTWWisdom::usesWisdom(FFTW_ESTIMATE));
+    EXPECT_TRUE(FFTWWisdom::usesWisdom(FFTW_MEASURE));
+}
+
+// Test that the file name covers every part of the key
+TEST_F(FFTWWisdomTest, FileNameEncodesKey) {
+    FFTWWisdom::Key key{ 256, 128, FFTWWisdom::Precision::Float, 4, FFTW_PATIENT };
+    EXPECT_EQ(FFTWWisdom::fileName(key), "fftw-float-256x128-t4-patient.wisdom");
+
+    key.precision = FFTWWisdom::Precision::Double;
+    key.flags = FFTW_MEASURE;
+    EXPECT_EQ(FFTWWisdom::fileName(key), "fftw-double-256x128-t4-measure.wisdom");
+
+    key.howmany = 8;
+    EXPECT_EQ(FFTWWisdom::fileName(key), "fftw-double-256x128-t4-measure-k8.wisdom");
+}
+
+// Test that an engine saves wisdom once and loads it afterwards
+TEST_F(FFTWWisdomTest, EngineSavesAndReusesWisdom) {
+    PhysicsConfig config = makeConfig(m_dir.string());
+    FFTWWisdom::Key key{ config.nx, config.ny, FFTWWisdom::Precision::Double, 1, FFTW_MEASURE };
+    EXPECT_FALSE(FFTWWisdom::load(m_dir.string(), key));
+
+    {
+        SimulationEngine engine(config);
+    }
+    const std::filesystem::path file = m_dir / FFTWWisdom::fileName(key);
+    ASSERT_TRUE(std::filesystem::exists(file));
+    EXPECT_TRUE(FFTWWisdom::load(m_dir.string(), key));
+
+    // A second engine with the same key plans from the store and leaves it untouched
+    auto written = std::filesystem::last_write_time(file);
+    SimulationEngine engine(config);
+    EXPECT_EQ(std::filesystem::last_write_time(file), written);
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-12);
+
+    // A different precision gets its own entry
+    config.precision = "float";
+    SimulationEngineF floatEngine(config);
+    key.precision = FFTWWisdom::Precision::Float;
+    EXPECT_TRUE(std::filesystem::exists(m_dir / FFTWWisdom::fileName(key)));
+}
+
+// Test that estimate plans skip the store and invalid planners are rejected
+TEST_F(FFTWWisdomTest, EngineHonorsPlannerSetting) {
+    PhysicsConfig config = makeConfig(m_dir.string());
+    config.fftw.planner = "estimate";
+    SimulationEngine estimated(config);
+    EXPECT_FALSE(std::filesystem::exists(m_dir));
+
+    config.fftw.planner = "measure";
+    SimulationEngine measured(config);
+    estimated.advance(20);
+    measured.advance(20);
+    const Wavefunction& a = estimated.getWavefunction();
+    const Wavefunction& b = measured.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(a(i, j) - b(i, j)), 0.0, 1e-12);
+        }
+    }
+
+    // A bad planner is rejected before the running engine is modified
+    config.fftw.planner = "fast";
+    EXPECT_THROW(SimulationEngine bad(config), std::invalid_argument);
+    EXPECT_THROW(measured.updateConfig(config), std::invalid_argument);
+    measured.step();
+    EXPECT_NEAR(measured.getTotalProbability(), 1.0, 1e-12);
+}
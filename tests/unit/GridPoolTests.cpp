@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../../src/core/GridPool.h"
+#include "../../src/core/Wavefunction.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "TestUtils.h"
+
+namespace {
+
+bool isAligned(const void* pointer) {
+    return reinterpret_cast<uintptr_t>(pointer) % GridPool::kAlignment == 0;
+}
+
+PhysicsConfig makeConfig(int nx, int ny) {
+    PhysicsConfig config =
+        test_utils::makeConfig(nx, ny, 0.005, "HarmonicOscillator", {1.0}, {0.0, 0.0, 1.0, 1.0, 1.0, 0.0});
+    config.integration.scheme = "yoshida4";
+    config.numThreads = 2;
+    return config;
+}
+
+}  // namespace
+
+// Test that small and large blocks are aligned and large ones are recycled by size
+TEST(GridPoolTest, ReusesBlocksOfTheSameSize) {
+    GridPool pool;
+    const size_t bytes = 4 * GridPool::kMinPooledBytes;
+    void* small = pool.allocate(100);
+    void* large = pool.allocate(bytes);
+    EXPECT_TRUE(isAligned(small));
+    EXPECT_TRUE(isAligned(large));
+    EXPECT_EQ(pool.getFreshAllocationCount(), 2u);
+
+    // Small blocks go straight back to the system allocator
+    pool.deallocate(small, 100);
+    pool.deallocate(large, bytes);
+    EXPECT_EQ(pool.getCachedBytes(), bytes);
+
+    // Only a request of exactly the released size gets the block back
+    void* other = pool.allocate(bytes + 64);
+    EXPECT_EQ(pool.getReuseCount(), 0u);
+    void* again = pool.allocate(bytes);
+    EXPECT_EQ(again, large);
+    EXPECT_EQ(pool.getReuseCount(), 1u);
+    EXPECT_EQ(pool.getCachedBytes(), 0u);
+
+    pool.deallocate(other, bytes + 64);
+    pool.deallocate(again, bytes);
+    pool.trim();
+    EXPECT_EQ(pool.getCachedBytes(), 0u);
+}
+
+// Test that the cache limit frees the oldest blocks first
+TEST(GridPoolTest, CacheLimitEvictsOldestBlocks) {
+    const size_t bytes = GridPool::kMinPooledBytes;
+    GridPool pool(2 * bytes);
+    void* first = pool.allocate(bytes);
+    void* second = pool.allocate(bytes);
+    void* third = pool.allocate(bytes);
+    pool.deallocate(first, bytes);
+    pool.deallocate(second, bytes);
+    pool.deallocate(third, bytes);
+    EXPECT_EQ(pool.getCachedBytes(), 2 * bytes);
+
+    // The newest release is handed out first; the oldest was freed
+    EXPECT_EQ(pool.allocate(bytes), third);
+    EXPECT_EQ(pool.allocate(bytes), second);
+    EXPECT_EQ(pool.getCachedBytes(), 0u);
+    pool.deallocate(second, bytes);
+    pool.deallocate(third, bytes);
+
+    // Blocks above the limit are never cached
+    pool.setCacheLimit(bytes / 2);
+    EXPECT_EQ(pool.getCachedBytes(), 0u);
+    void* block = pool.allocate(bytes);
+    pool.deallocate(block, bytes);
+    EXPECT_EQ(pool.getCachedBytes(), 0u);
+}
+
+// Test that resizeGrid keeps equal sizes and recycles the block of a changed size
+TEST(GridPoolTest, ResizeGridRecyclesBlocks) {
+    GridVector<double> buffer(20000, 1.5);
+    EXPECT_TRUE(isAligned(buffer.data()));
+    const double* original = buffer.data();
+
+    resizeGrid(buffer, buffer.size());
+    EXPECT_EQ(buffer.data(), original);
+    EXPECT_EQ(buffer[0], 1.5);
+
+    // Growing takes exactly the new size, shrinking back reuses the first block
+    const size_t reused = GridPool::shared().getReuseCount();
+    resizeGrid(buffer, 30000);
+    EXPECT_EQ(buffer.capacity(), 30000u);
+    EXPECT_EQ(buffer[0], 0.0);
+    resizeGrid(buffer, 20000);
+    EXPECT_EQ(buffer.data(), original);
+    EXPECT_GT(GridPool::shared().getReuseCount(), reused);
+}
+
+// Test that a wavefunction resizes in place and keeps aligned storage
+TEST(GridPoolTest, WavefunctionResize) {
+    Wavefunction psi(64, 32);
+    EXPECT_TRUE(isAligned(psi.data()));
+    psi(3, 4) = {1.0, 2.0};
+    const auto* original = psi.data();
+
+    psi.resize(32, 64);
+    EXPECT_EQ(psi.getNx(), 32);
+    EXPECT_EQ(psi.getNy(), 64);
+    EXPECT_EQ(psi.data(), original);
+
+    psi.resize(48, 48);
+    EXPECT_EQ(psi.size(), 48u * 48u);
+    EXPECT_TRUE(isAligned(psi.data()));
+    EXPECT_EQ(psi(3, 4), Wavefunction::value_type(0.0, 0.0));
+}
+
+// Test that engines reuse their buffers across updateConfig and plan on aligned memory
+TEST(GridPoolTest, EngineReusesBuffersAcrossUpdateConfig) {
+    SimulationEngine engine(makeConfig(64, 64));
+    const auto* psi = engine.getNativeWavefunction().data();
+    EXPECT_TRUE(isAligned(psi));
+
+    // Same grid: ψ stays where the plans expect it
+    PhysicsConfig config = makeConfig(64, 64);
+    config.dt = 0.002;
+    engine.updateConfig(config);
+    EXPECT_EQ(engine.getNativeWavefunction().data(), psi);
+
+    // A round trip through another size is served from the pool
+    engine.updateConfig(makeConfig(128, 64));
+    const size_t reused = GridPool::shared().getReuseCount();
+    engine.updateConfig(makeConfig(64, 64));
+    EXPECT_GT(GridPool::shared().getReuseCount(), reused);
+    EXPECT_TRUE(isAligned(engine.getNativeWavefunction().data()));
+
+    // The recycled buffers give the same evolution as a fresh engine
+    SimulationEngine fresh(makeConfig(64, 64));
+    engine.advance(10);
+    fresh.advance(10);
+    const Wavefunction& a = engine.getWavefunction();
+    const Wavefunction& b = fresh.getWavefunction();
+    for (size_t n = 0; n < a.size(); ++n) {
+        ASSERT_NEAR(std::abs(a.data()[n] - b.data()[n]), 0.0, 1e-12) << n;
+    }
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "../../src/core/GridPool.h"
+#include "../../src/core/Metrics.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "TestUtils.h"
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+const MetricsSnapshot::Stage& stageOf(const MetricsSnapshot& snapshot, MetricStage stage) {
+    return snapshot.stages[static_cast<size_t>(stage)];
+}
+
+PhysicsConfig makeConfig() {
+    PhysicsConfig config =
+        test_utils::makeConfig(64, 64, 0.005, "HarmonicOscillator", {1.0}, {0.0, 0.0, 1.0, 1.0, 1.0, 0.0});
+    config.numThreads = 2;
+    return config;
+}
+
+// Metrics file under the system temp directory, removed after each test
+class MetricsFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        m_prom = (std::filesystem::temp_directory_path() / ("qmsim_metrics_" + name + ".prom")).string();
+        m_json = (std::filesystem::temp_directory_path() / ("qmsim_metrics_" + name + ".json")).string();
+    }
+    void TearDown() override {
+        std::filesystem::remove(m_prom);
+        std::filesystem::remove(m_json);
+    }
+
+    std::string m_prom;
+    std::string m_json;
+};
+
+}  // namespace
+
+// Test that a recorded pass lands in the first bucket that holds its duration
+TEST(MetricsTest, RecordStageFillsLogBuckets) {
+    MetricsRegistry& registry = MetricsRegistry::getInstance();
+    const MetricsSnapshot before = registry.snapshot();
+
+    registry.recordStage(MetricStage::Render, 500, 64);        // 0.5 µs: bucket 0
+    registry.recordStage(MetricStage::Render, 3000, 64);       // 3 µs: bucket 2 (≤ 4 µs)
+    registry.recordStage(MetricStage::Render, 1000000000000);  // far beyond the last bound
+    const MetricsSnapshot after = registry.snapshot();
+
+    const auto& a = stageOf(before, MetricStage::Render);
+    const auto& b = stageOf(after, MetricStage::Render);
+    EXPECT_EQ(b.count - a.count, 3u);
+    EXPECT_EQ(b.nanoseconds - a.nanoseconds, 1000000003500u);
+    EXPECT_EQ(b.bytes - a.bytes, 128u);
+    EXPECT_EQ(b.buckets[0] - a.buckets[0], 1u);
+    EXPECT_EQ(b.buckets[1] - a.buckets[1], 0u);
+    EXPECT_EQ(b.buckets[2] - a.buckets[2], 1u);
+    EXPECT_EQ(b.buckets.back() - a.buckets.back(), 1u);
+
+    EXPECT_DOUBLE_EQ(MetricsRegistry::bucketBound(0), 1e-6);
+    EXPECT_DOUBLE_EQ(MetricsRegistry::bucketBound(10), 1024e-6);
+    EXPECT_TRUE(std::isinf(MetricsRegistry::bucketBound(MetricsSnapshot::kBuckets - 1)));
+}
+
+// Test that the Prometheus text has cumulative buckets ending in +Inf
+TEST(MetricsTest, PrometheusHistogramIsCumulative) {
+    MetricsSnapshot snapshot;
+    snapshot.steps = 42;
+    snapshot.gridBytes = 4096;
+    auto& stage = snapshot.stages[static_cast<size_t>(MetricStage::Kinetic)];
+    stage.count = 3;
+    stage.nanoseconds = 2500000000;
+    stage.bytes = 300;
+    stage.buckets[0] = 1;
+    stage.buckets[2] = 2;
+
+    const std::string text = MetricsRegistry::formatPrometheus(snapshot);
+    EXPECT_NE(text.find("# TYPE qmsim_stage_seconds histogram"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_bucket{stage=\"kinetic\",le=\"1e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_bucket{stage=\"kinetic\",le=\"2e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_bucket{stage=\"kinetic\",le=\"4e-06\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_bucket{stage=\"kinetic\",le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_sum{stage=\"kinetic\"} 2.5\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_seconds_count{stage=\"kinetic\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_stage_bytes_total{stage=\"kinetic\"} 300\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_steps_total 42\n"), std::string::npos);
+    EXPECT_NE(text.find("qmsim_grid_bytes 4096\n"), std::string::npos);
+
+    const std::string json = MetricsRegistry::formatJson(snapshot);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.find_last_not_of('\n'), json.rfind('}'));
+    EXPECT_NE(json.find("\"steps\":42"), std::string::npos);
+    EXPECT_NE(json.find("\"kinetic\":{\"count\":3"), std::string::npos);
+}
+
+// Test that advancing an engine counts its steps and times its stages
+TEST(MetricsTest, EngineAdvanceRecordsStages) {
+#if !QMSIM_ENABLE_METRICS
+    GTEST_SKIP() << "metrics compiled out";
+#endif
+    SimulationEngine engine(makeConfig());
+    const MetricsSnapshot before = MetricsRegistry::getInstance().snapshot();
+    engine.advance(5);
+    engine.computeObservables();
+    const MetricsSnapshot after = MetricsRegistry::getInstance().snapshot();
+
+    EXPECT_EQ(after.steps - before.steps, 5u);
+    for (MetricStage stage : {MetricStage::Potential, MetricStage::FFTForward, MetricStage::FFTBackward,
+                              MetricStage::Kinetic, MetricStage::Observables}) {
+        const auto& a = stageOf(before, stage);
+        const auto& b = stageOf(after, stage);
+        EXPECT_GT(b.count, a.count) << MetricsRegistry::stageName(stage);
+        EXPECT_GT(b.bytes, a.bytes) << MetricsRegistry::stageName(stage);
+    }
+    // One forward and one backward transform per kinetic pass
+    EXPECT_EQ(stageOf(after, MetricStage::FFTForward).count - stageOf(before, MetricStage::FFTForward).count,
+              stageOf(after, MetricStage::Kinetic).count - stageOf(before, MetricStage::Kinetic).count);
+    EXPECT_GT(after.gridBytes, 0u);
+}
+
+// Test that only accepted real-time steps count: not the embedded estimate
+// or rejected attempts of adaptive steps, nor imaginary-time relaxation
+TEST(MetricsTest, EngineCountsOnlyAcceptedSteps) {
+#if !QMSIM_ENABLE_METRICS
+    GTEST_SKIP() << "metrics compiled out";
+#endif
+    PhysicsConfig config = makeConfig();
+    config.dt = 0.4;
+    config.integration.scheme = "blanes-moan4";
+    config.integration.adaptive = true;
+    config.integration.tolerance = 1e-5;
+    config.integration.maxDt = 0.2;
+    SimulationEngine engine(config);
+
+    const MetricsSnapshot before = MetricsRegistry::getInstance().snapshot();
+    const int steps = engine.advanceFor(0.8);
+    ImaginaryTime options;
+    options.maxSteps = 50;
+    engine.relaxEigenstates(options);
+    const MetricsSnapshot after = MetricsRegistry::getInstance().snapshot();
+
+    EXPECT_EQ(after.steps - before.steps, static_cast<uint64_t>(steps));
+}
+
+// Test that the history turns snapshots into rates and wraps its ring
+TEST(MetricsTest, HistoryComputesIntervalRates) {
+    MetricsHistory history(3);
+    MetricsSnapshot snapshot;
+    history.sample(snapshot);
+    EXPECT_TRUE(history.getStepsPerSecond().empty());
+
+    for (int n = 1; n <= 4; ++n) {
+        snapshot.uptimeSeconds += 0.5;
+        snapshot.steps += 100;
+        auto& stage = snapshot.stages[static_cast<size_t>(MetricStage::Potential)];
+        stage.count += 10;
+        stage.nanoseconds += 20000000;
+        stage.bytes += 40000000;
+        history.sample(snapshot);
+    }
+
+    const MetricsHistory::Interval& latest = history.getLatest();
+    EXPECT_DOUBLE_EQ(latest.seconds, 0.5);
+    EXPECT_DOUBLE_EQ(latest.stepsPerSecond, 200.0);
+    EXPECT_DOUBLE_EQ(latest.gigabytesPerSecond, 2.0);
+    const size_t potential = static_cast<size_t>(MetricStage::Potential);
+    EXPECT_DOUBLE_EQ(latest.milliseconds[potential], 2.0);
+    EXPECT_DOUBLE_EQ(latest.callsPerSecond[potential], 20.0);
+    EXPECT_DOUBLE_EQ(latest.stageGigabytesPerSecond[potential], 2.0);
+
+    // Four intervals in a ring of three: the oldest slot is the second one
+    EXPECT_EQ(history.getStepsPerSecond().size(), 3u);
+    EXPECT_EQ(history.getStageMilliseconds(MetricStage::Potential).size(), 3u);
+    EXPECT_EQ(history.getOffset(), 1u);
+    EXPECT_EQ(history.getSnapshot().steps, 400u);
+}
+
+// Test that writeFile picks the format from the extension
+TEST_F(MetricsFileTest, WriteFileChoosesFormat) {
+    MetricsRegistry::getInstance().writeFile(m_prom);
+    MetricsRegistry::getInstance().writeFile(m_json);
+    EXPECT_NE(readFile(m_prom).find("qmsim_steps_total"), std::string::npos);
+    EXPECT_EQ(readFile(m_json).front(), '{');
+    EXPECT_FALSE(std::filesystem::exists(m_prom + ".tmp"));
+
+    EXPECT_THROW(MetricsRegistry::getInstance().writeFile("/nonexistent/dir/metrics.prom"), std::runtime_error);
+}
+
+// Test that an exporter without an interval writes once when stopped
+TEST_F(MetricsFileTest, ExporterWritesOnStop) {
+    MetricsExporter exporter(m_prom, 0.0);
+    EXPECT_EQ(exporter.getWriteCount(), 0u);
+    exporter.stop();
+    exporter.stop();
+    EXPECT_EQ(exporter.getWriteCount(), 1u);
+    EXPECT_NE(readFile(m_prom).find("qmsim_stage_seconds_count{stage=\"potential\"}"), std::string::npos);
+}
+
+// Test that the pool reports the bytes of the blocks handed out
+TEST(MetricsTest, GridPoolTracksLiveBytes) {
+    GridPool pool;
+    const size_t bytes = 4 * GridPool::kMinPooledBytes;
+    void* block = pool.allocate(bytes);
+    EXPECT_EQ(pool.getLiveBytes(), bytes);
+    pool.deallocate(block, bytes);
+    EXPECT_EQ(pool.getLiveBytes(), 0u);
+
+    // A reused block counts again
+    block = pool.allocate(bytes);
+    EXPECT_EQ(pool.getReuseCount(), 1u);
+    EXPECT_EQ(pool.getLiveBytes(), bytes);
+    pool.deallocate(block, bytes);
+    pool.trim();
+}
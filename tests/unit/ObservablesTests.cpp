@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../src/solver/Observables.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    return test_utils::makeConfig(64, 64, 0.005, "FreeSpace", {}, {1.0, -0.5, 1.0, 1.0, 2.0, 0.0});
+}
+
+using test_utils::readLines;
+
+ObservableSample makeSample(int64_t step, size_t regions) {
+    ObservableSample sample;
+    sample.step = step;
+    sample.time = 0.1 * step;
+    sample.totalProbability = 1.0;
+    sample.regions.assign(regions, 0.5);
+    return sample;
+}
+
+// Output file under the system temp directory, removed after each test
+class ObservableWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_path = (std::filesystem::temp_directory_path() /
+                  ("qmsim_observables_" +
+                   std::string(::testing::UnitTest::GetInstance()->current_test_info()->name())))
+                     .string();
+        std::filesystem::remove(m_path);
+    }
+    void TearDown() override { std::filesystem::remove(m_path); }
+
+    std::string m_path;
+};
+
+}  // namespace
+
+// Test the expectation values of a Gaussian wavepacket against the analytic ones
+TEST(ObservablesTest, GaussianWavepacket) {
+    SimulationEngine engine(makeConfig());
+    ObservableSample sample = engine.computeObservables();
+
+    // |ψ|² has variance σ²/2 per axis, so ⟨p²⟩ = k0² + 1/(2σ²)
+    EXPECT_NEAR(sample.totalProbability, 1.0, 1e-10);
+    EXPECT_NEAR(sample.x, 1.0, 1e-6);
+    EXPECT_NEAR(sample.y, -0.5, 1e-6);
+    EXPECT_NEAR(sample.px, 2.0, 1e-6);
+    EXPECT_NEAR(sample.py, 0.0, 1e-6);
+    EXPECT_NEAR(sample.kineticEnergy, (4.0 + 0.5 + 0.5) / 2.0, 1e-6);
+    EXPECT_DOUBLE_EQ(sample.potentialEnergy, 0.0);
+    EXPECT_DOUBLE_EQ(sample.energy, sample.kineticEnergy);
+
+    // Free motion: ⟨x⟩ moves with ⟨p⟩ and the energy is conserved
+    engine.advance(100);
+    ObservableSample later = engine.computeObservables();
+    EXPECT_NEAR(later.x, 1.0 + 2.0 * 0.5, 1e-4);
+    EXPECT_NEAR(later.px, 2.0, 1e-6);
+    EXPECT_NEAR(later.energy, sample.energy, 1e-8);
+}
+
+// Test region probabilities and the potential energy term
+TEST(ObservablesTest, RegionsAndPotential) {
+    PhysicsConfig config = makeConfig();
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = {1.0};
+    config.wavepacket.kx = 0.0;
+    config.wavepacket.x0 = 0.0;
+    config.wavepacket.y0 = 0.0;
+    config.output.regions = {
+        {"left", -10.0, -1e-9, -10.0, 10.0},
+        {"right", 0.0, 10.0, -10.0, 10.0}
+    };
+    SimulationEngine engine(config);
+    ObservableSample sample = engine.computeObservables();
+
+    ASSERT_EQ(sample.regions.size(), 2u);
+    EXPECT_NEAR(sample.regions[0] + sample.regions[1], sample.totalProbability, 1e-12);
+    EXPECT_GT(sample.regions[1], sample.regions[0]);  // x = 0 belongs to the right half
+
+    // V = (x² + y²)/2 and ⟨x²⟩ = ⟨y²⟩ = σ²/2
+    EXPECT_NEAR(sample.potentialEnergy, 0.5, 1e-6);
+    EXPECT_NEAR(sample.energy, 1.0, 1e-6);
+}
+
+// Test that the result does not depend on the thread count
+TEST(ObservablesTest, IndependentOfThreadCount) {
+    PhysicsConfig config = makeConfig();
+    SimulationEngine serial(config);
+    config.numThreads = 4;
+    SimulationEngine parallel(config);
+
+    ObservableSample a = serial.computeObservables();
+    ObservableSample b = parallel.computeObservables();
+    EXPECT_EQ(a.x, b.x);
+    EXPECT_EQ(a.y, b.y);
+    EXPECT_EQ(a.px, b.px);
+    EXPECT_EQ(a.energy, b.energy);
+}
+
+// Test CSV output and keeping rows when resuming
+TEST_F(ObservableWriterTest, CsvResume) {
+    std::vector<ObservableRegion> regions = {{"barrier", 0.0, 1.0, -1.0, 1.0}};
+    {
+        ObservableWriter writer(m_path, ObservableWriter::Format::Csv, regions);
+        for (int step = 0; step <= 30; step += 10) {
+            EXPECT_TRUE(writer.push(makeSample(step, 1)));
+        }
+    }
+
+    auto lines = readLines(m_path);
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(lines[0], "step,time,total_probability,x_mean,y_mean,px_mean,py_mean,"
+                        "kinetic_energy,potential_energy,energy,wall_seconds,absorbed_probability,region_barrier");
+    EXPECT_EQ(lines[2].rfind("10,1,1,", 0), 0u);
+
+    {
+        ObservableWriter writer(m_path, ObservableWriter::Format::Csv, regions, 16, 15);
+        EXPECT_EQ(writer.getLastKeptStep(), 10);
+        writer.push(makeSample(20, 1));
+        writer.close();
+    }
+
+    lines = readLines(m_path);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[3].rfind("20,", 0), 0u);
+}
+
+// Test the binary layout
+TEST_F(ObservableWriterTest, Binary) {
+    {
+        ObservableWriter writer(m_path, ObservableWriter::Format::Binary, {});
+        writer.push(makeSample(0, 0));
+        writer.push(makeSample(5, 0));
+    }
+
+    std::ifstream in(m_path, std::ios::binary);
+    char magic[8];
+    uint32_t columns = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&columns), sizeof(columns));
+    EXPECT_EQ(std::string(magic, 8), "QMOBS001");
+    ASSERT_EQ(columns, 12u);
+
+    for (uint32_t c = 0; c < columns; ++c) {
+        uint32_t length = 0;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        in.seekg(length, std::ios::cur);
+    }
+    std::vector<double> records(2 * columns);
+    in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(double)));
+    ASSERT_TRUE(in);
+    EXPECT_DOUBLE_EQ(records[columns], 5.0);
+    EXPECT_DOUBLE_EQ(records[columns + 1], 0.5);
+}
+
+// Test that a full queue drops samples instead of blocking
+TEST_F(ObservableWriterTest, DropsWhenFull) {
+    size_t accepted = 0;
+    size_t dropped = 0;
+    {
+        ObservableWriter writer(m_path, ObservableWriter::Format::Csv, {}, 1);
+        for (int step = 0; step < 2000; ++step) {
+            accepted += writer.push(makeSample(step, 0)) ? 1 : 0;
+        }
+        writer.close();
+        dropped = writer.getDroppedCount();
+    }
+
+    EXPECT_EQ(accepted + dropped, 2000u);
+    EXPECT_EQ(readLines(m_path).size(), accepted + 1);
+    EXPECT_THROW(ObservableWriter::parseFormat("xml"), std::invalid_argument);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
 #include "../../src/core/Potential.h"
 
 // Test the FreeSpacePotential class
@@ -117,4 +121,178 @@ TEST(PotentialTest, Factory) {
     EXPECT_EQ(pot6->getType(), "HarmonicOscillator");
     // Should use default omega
     EXPECT_NE(pot6->getValue(1.0, 1.0), 0.0); // Non-zero away from origin
-}
\ No newline at end of file
+}
+
+// Test that batched evaluation matches point evaluation for every potential
+TEST(PotentialTest, BatchMatchesPointwise) {
+    GridGeometry grid;
+    grid.nx = 8;
+    grid.ny = 8;
+    grid.x0 = -2.0;
+    grid.y0 = -2.0;
+    grid.dx = 0.5;
+    grid.dy = 0.5;
+    std::vector<double> table(64);
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i] = 0.1 * static_cast<double>(i);
+    }
+
+    std::vector<std::unique_ptr<Potential>> potentials;
+    potentials.push_back(Potential::create("FreeSpace", {}));
+    potentials.push_back(Potential::create("SquareBarrier", {2.0, 1.5, 0.3, -0.2}));
+    potentials.push_back(Potential::create("HarmonicOscillator", {1.5}));
+    potentials.push_back(Potential::create("Rectangle", {3.0, -1.0, 0.2, -0.5, 2.0}));
+    potentials.push_back(std::make_unique<GridPotential>(grid, table));
+
+    const std::vector<double> x = {-3.0, -1.7, -0.5, 0.0, 0.25, 0.9, 1.3, 2.6};
+    const std::vector<double> y = {0.4, -2.2, 1.1, 0.0, -0.3, 0.7, 1.9, -0.1};
+    std::vector<double> out(x.size());
+    for (const auto& potential : potentials) {
+        potential->evaluate(x.data(), y.data(), out.data(), x.size());
+        for (size_t i = 0; i < x.size(); ++i) {
+            EXPECT_DOUBLE_EQ(out[i], potential->getValue(x[i], y[i])) << potential->getType() << " point " << i;
+        }
+
+        GridGeometry row = grid;
+        row.nx = 5;
+        row.x0 = -1.9;
+        std::vector<double> sampled(static_cast<size_t>(row.nx));
+        potential->sampleRow(row, 3, sampled.data());
+        for (int i = 0; i < row.nx; ++i) {
+            EXPECT_DOUBLE_EQ(sampled[i], potential->getValue(row.x0 + i * row.dx, row.y0 + 3 * row.dy))
+                << potential->getType() << " sample " << i;
+        }
+    }
+}
+
+// Test the rectangle edges and the factory defaults
+TEST(PotentialTest, Rectangle) {
+    RectanglePotential wall(4.0, -0.1, 0.1, -5.0, 5.0);
+    EXPECT_EQ(wall.getType(), "Rectangle");
+    EXPECT_DOUBLE_EQ(wall.getValue(0.0, 4.9), 4.0);
+    EXPECT_DOUBLE_EQ(wall.getValue(0.1, -5.0), 4.0);
+    EXPECT_DOUBLE_EQ(wall.getValue(0.11, 0.0), 0.0);
+    EXPECT_DOUBLE_EQ(wall.getValue(0.0, 5.1), 0.0);
+
+    auto unit = Potential::create("Rectangle", {});
+    EXPECT_DOUBLE_EQ(unit->getValue(0.0, 0.0), 1.0);
+    EXPECT_DOUBLE_EQ(unit->getValue(0.6, 0.0), 0.0);
+}
+
+// Test interpolation, clamping and the copy path of tabulated potentials
+TEST(PotentialTest, GridPotential) {
+    GridGeometry grid;
+    grid.nx = 3;
+    grid.ny = 2;
+    grid.x0 = 0.0;
+    grid.y0 = 0.0;
+    grid.dx = 1.0;
+    grid.dy = 2.0;
+    GridPotential pot(grid, {0.0, 1.0, 2.0,
+                             10.0, 11.0, 12.0});
+    EXPECT_EQ(pot.getType(), "Grid");
+
+    EXPECT_DOUBLE_EQ(pot.getValue(1.0, 0.0), 1.0);
+    EXPECT_DOUBLE_EQ(pot.getValue(2.0, 2.0), 12.0);
+    EXPECT_DOUBLE_EQ(pot.getValue(0.5, 0.0), 0.5);
+    EXPECT_DOUBLE_EQ(pot.getValue(1.5, 1.0), 6.5);
+    EXPECT_DOUBLE_EQ(pot.getValue(-1.0, -1.0), 0.0);
+    EXPECT_DOUBLE_EQ(pot.getValue(5.0, 5.0), 12.0);
+
+    std::vector<double> row(3);
+    pot.sampleRow(grid, 1, row.data());
+    EXPECT_EQ(row, (std::vector<double>{10.0, 11.0, 12.0}));
+
+    EXPECT_THROW(GridPotential(grid, {1.0, 2.0}), std::invalid_argument);
+}
+
+// Test loading a potential from a PGM image
+TEST(PotentialTest, GridPotentialFromImage) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "qmsim_potential_test.pgm").string();
+    {
+        std::ofstream image(path, std::ios::binary);
+        image << "P5\n# wall with a slit\n3 2\n255\n";
+        const unsigned char pixels[] = {255, 0, 255, 0, 51, 0};
+        image.write(reinterpret_cast<const char*>(pixels), sizeof(pixels));
+    }
+
+    auto pot = GridPotential::load(path, 10.0, -3.0, 3.0, -2.0, 2.0);
+    std::filesystem::remove(path);
+
+    // The first image row is the top of the area
+    EXPECT_EQ(pot->getGrid().nx, 3);
+    EXPECT_EQ(pot->getGrid().ny, 2);
+    EXPECT_DOUBLE_EQ(pot->getGrid().dx, 2.0);
+    EXPECT_DOUBLE_EQ(pot->getGrid().dy, 2.0);
+    EXPECT_EQ(pot->getValues(), (std::vector<double>{0.0, 2.0, 0.0, 10.0, 0.0, 10.0}));
+
+    PotentialConfig config;
+    config.type = "Grid";
+    config.file = path;
+    EXPECT_THROW(Potential::create(config), std::runtime_error);
+}
+
+// Test that composite potentials sum their components
+TEST(PotentialTest, Composite) {
+    PotentialConfig config;
+    config.type = "Composite";
+    config.components.resize(2);
+    config.components[0].type = "HarmonicOscillator";
+    config.components[0].parameters = {1.0};
+    config.components[1].type = "SquareBarrier";
+    config.components[1].parameters = {5.0, 1.0, 0.0, 0.0};
+
+    auto pot = Potential::create(config);
+    EXPECT_EQ(pot->getType(), "Composite");
+    EXPECT_DOUBLE_EQ(pot->getValue(0.2, 0.0), 0.5 * 0.04 + 5.0);
+    EXPECT_DOUBLE_EQ(pot->getValue(2.0, 0.0), 2.0);
+
+    CompositePotential empty;
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_DOUBLE_EQ(empty.getValue(1.0, 1.0), 0.0);
+}
+
+// Test that driven and moving potentials follow setTime()
+TEST(PotentialTest, TimeDependent) {
+    DrivenPotential driven(std::make_unique<HarmonicOscillatorPotential>(1.0),
+                           std::make_unique<SquareBarrierPotential>(2.0, 1.0, 0.0, 0.0),
+                           DrivenPotential::sineDrive(3.0, 2.0, 0.0, 1.0));
+    EXPECT_TRUE(driven.isTimeDependent());
+    EXPECT_EQ(driven.getType(), "Driven");
+    EXPECT_DOUBLE_EQ(driven.getValue(0.0, 0.0), 2.0);
+    driven.setTime(0.25);
+    EXPECT_DOUBLE_EQ(driven.getDrive(0.25), 1.0 + 3.0 * std::sin(0.5));
+    EXPECT_DOUBLE_EQ(driven.getValue(0.0, 0.0), 2.0 * driven.getDrive(0.25));
+    EXPECT_DOUBLE_EQ(driven.getValue(2.0, 0.0), 2.0);
+
+    // The pulse envelope vanishes far from its centre
+    auto pulse = DrivenPotential::sineDrive(1.0, 5.0, 0.3, 0.0, 2.0, 0.1);
+    EXPECT_NEAR(pulse(0.0), 0.0, 1e-12);
+    EXPECT_DOUBLE_EQ(pulse(2.0), std::sin(10.3));
+
+    MovingPotential moving(std::make_unique<SquareBarrierPotential>(4.0, 1.0, 0.0, 0.0),
+                           MovingPotential::linearPath(2.0, -1.0));
+    moving.setTime(1.5);
+    EXPECT_DOUBLE_EQ(moving.getValue(3.0, -1.5), 4.0);
+    EXPECT_DOUBLE_EQ(moving.getValue(0.0, 0.0), 0.0);
+    double x = 0.0, y = 0.0;
+    moving.getOffset(1.5, x, y);
+    EXPECT_DOUBLE_EQ(x, 3.0);
+    EXPECT_DOUBLE_EQ(y, -1.5);
+
+    // Composites are time-dependent if a component is
+    PotentialConfig config;
+    config.type = "Composite";
+    config.components.resize(2);
+    config.components[0].type = "HarmonicOscillator";
+    config.components[1].type = "Moving";
+    config.components[1].parameters = {1.0, 0.0};
+    config.components[1].components.resize(1);
+    config.components[1].components[0].type = "SquareBarrier";
+    auto composite = Potential::create(config);
+    EXPECT_TRUE(composite->isTimeDependent());
+    composite->setTime(2.0);
+    EXPECT_DOUBLE_EQ(composite->getValue(2.0, 0.0), 0.5 * 4.0 + 1.0);
+    EXPECT_FALSE(Potential::create(config.components[0])->isTimeDependent());
+}
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include "../../src/solver/SimulationEngine.h"
 #include "../../src/core/PhysicsConfig.h"
@@ -58,8 +60,8 @@ TEST(SimulationEngineTest, FreeSpaceStep) {
         engine.step();
     }
     
-    // TODO: Once getTotalProbability() is implemented, add:
-    // EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-6);
+    // The unitary phase tables must preserve total probability
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-6);
 }
 
 // Test stepping with square barrier potential
@@ -358,4 +360,918 @@ TEST(SimulationEngineTest, EnergyConservation) {
     // TODO: Verify energy is conserved
     // double finalEnergy = engine.getTotalEnergy();
     // EXPECT_NEAR(finalEnergy, initialEnergy, 0.01 * std::abs(initialEnergy));  // Within 1%
-}
\ No newline at end of file
+}
+
+// Test that cached potential phases are rebuilt when the potential changes
+TEST(SimulationEngineTest, PhaseTablesFollowSetPotential) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.dt = 0.001;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = { 2.0 };
+    config.wavepacket.x0 = 0.5;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 0.0;
+    config.wavepacket.ky = 0.0;
+    
+    // Reference engine built directly with the harmonic potential
+    SimulationEngine reference(config);
+    
+    // Second engine starts in free space and switches potential afterwards
+    PhysicsConfig freeConfig = config;
+    freeConfig.potential.type = "FreeSpace";
+    freeConfig.potential.parameters.clear();
+    SimulationEngine engine(freeConfig);
+    engine.setPotential(Potential::create("HarmonicOscillator", { 2.0 }));
+    
+    for (int i = 0; i < 20; ++i) {
+        reference.step();
+        engine.step();
+    }
+    
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = engine.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-12);
+        }
+    }
+}
+
+// Test that cached phase tables are rebuilt when dt changes via updateConfig
+TEST(SimulationEngineTest, PhaseTablesFollowUpdateConfig) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 32;
+    config.dt = 0.002;
+    config.potential.type = "SquareBarrier";
+    config.potential.parameters = { 5.0, 1.0, 0.0, 0.0 };
+    config.wavepacket.x0 = -1.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 3.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine reference(config);
+    
+    PhysicsConfig initialConfig = config;
+    initialConfig.dt = 0.01;
+    SimulationEngine engine(initialConfig);
+    engine.updateConfig(config);
+    
+    for (int i = 0; i < 20; ++i) {
+        reference.step();
+        engine.step();
+    }
+    
+    EXPECT_NEAR(engine.getCurrentTime(), reference.getCurrentTime(), 1e-12);
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = engine.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-12);
+        }
+    }
+}
+
+// Test that a fused batch matches the same number of individual steps
+TEST(SimulationEngineTest, AdvanceMatchesRepeatedSteps) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.dt = 0.001;
+    config.potential.type = "SquareBarrier";
+    config.potential.parameters = { 10.0, 0.5, 0.0, 0.0 };
+    config.wavepacket.x0 = -2.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 5.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine reference(config);
+    for (int i = 0; i < 50; ++i) {
+        reference.step();
+    }
+    
+    SimulationEngine engine(config);
+    engine.advance(50);
+    
+    EXPECT_NEAR(engine.getCurrentTime(), reference.getCurrentTime(), 1e-12);
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-6);
+    
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = engine.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-10);
+        }
+    }
+}
+
+// Test that advance() only notifies at the observable interval and batch end
+TEST(SimulationEngineTest, AdvanceObservableInterval) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 32;
+    config.dt = 0.001;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = 0.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 1.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine engine(config);
+    
+    int notifications = 0;
+    engine.setStepCompletionCallback([&notifications]() { ++notifications; });
+    
+    // Without an interval only the end of the batch is reported
+    engine.advance(35);
+    EXPECT_EQ(notifications, 1);
+    
+    // With an interval of 10 steps, 35 steps report at 10, 20, 30 and 35
+    notifications = 0;
+    engine.setObservableInterval(10);
+    engine.advance(35);
+    EXPECT_EQ(notifications, 4);
+    EXPECT_NEAR(engine.getCurrentTime(), 70 * config.dt, 1e-12);
+}
+
+// Test that the solver thread count does not change the evolution
+TEST(SimulationEngineTest, ThreadCountIndependence) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.dt = 0.001;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = { 1.0 };
+    config.wavepacket.x0 = 0.5;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 2.0;
+    config.wavepacket.ky = 0.0;
+    
+    config.numThreads = 1;
+    SimulationEngine serial(config);
+    EXPECT_EQ(serial.getNumThreads(), 1);
+    
+    config.numThreads = 4;
+    SimulationEngine parallel(config);
+    EXPECT_GE(parallel.getNumThreads(), 1);
+    
+    serial.advance(25);
+    parallel.advance(25);
+    
+    EXPECT_NEAR(parallel.getTotalProbability(), serial.getTotalProbability(), 1e-12);
+    const Wavefunction& expected = serial.getWavefunction();
+    const Wavefunction& actual = parallel.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-12);
+        }
+    }
+}
+
+// Test free propagation on a non-square grid, which requires the FFT
+// layout to match the (i, j) accessor layout
+TEST(SimulationEngineTest, NonSquareGridPropagation) {
+    PhysicsConfig config;
+    config.nx = 128;
+    config.ny = 32;
+    config.dt = 0.001;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = -2.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 1.0;
+    config.wavepacket.kx = 4.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine engine(config);
+    engine.advance(250);
+    
+    // The domain is fixed at 20 x 20 with the origin at the centre
+    const double lx = 20.0, ly = 20.0;
+    const double dx = lx / config.nx, dy = ly / config.ny;
+    const Wavefunction& wf = engine.getWavefunction();
+    double meanX = 0.0, meanY = 0.0;
+    for (int j = 0; j < config.ny; ++j) {
+        const std::complex<double>* psiRow = wf.row(j);
+        for (int i = 0; i < config.nx; ++i) {
+            double p = std::norm(psiRow[i]) * dx * dy;
+            meanX += p * (-lx / 2 + i * dx);
+            meanY += p * (-ly / 2 + j * dy);
+        }
+    }
+    
+    // Free motion: <x>(t) = x0 + kx * t (ħ = m = 1), <y> stays at y0
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-6);
+    EXPECT_NEAR(meanX, config.wavepacket.x0 + config.wavepacket.kx * engine.getCurrentTime(), 0.05);
+    EXPECT_NEAR(meanY, config.wavepacket.y0, 0.05);
+}
+
+// Test that the single-precision engine tracks the double-precision engine
+TEST(SimulationEngineTest, SinglePrecisionMatchesDouble) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.dt = 0.005;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = { 1.0 };
+    config.wavepacket.x0 = -1.0;
+    config.wavepacket.y0 = 0.5;
+    config.wavepacket.sigmaX = 0.7;
+    config.wavepacket.sigmaY = 0.7;
+    config.wavepacket.kx = 2.0;
+    config.wavepacket.ky = -1.0;
+    
+    SimulationEngine reference(config);
+    SimulationEngineF engine(config);
+    
+    reference.advance(100);
+    engine.advance(100);
+    
+    // FFT rounding makes the float norm drift by roughly 1e-7 per step
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-4);
+    
+    const Wavefunction& expected = reference.getWavefunction();
+    const WavefunctionF& actual = engine.getNativeWavefunction();
+    const Wavefunction& converted = engine.getWavefunction();
+    double maxError = 0.0;
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            maxError = std::max(maxError, std::abs(std::complex<double>(actual(i, j)) - expected(i, j)));
+            EXPECT_EQ(converted(i, j), std::complex<double>(actual(i, j)));
+        }
+    }
+    EXPECT_LT(maxError, 1e-4);
+    
+    std::vector<float> expectedDensity = reference.getProbabilityDensity();
+    std::vector<float> density = engine.getProbabilityDensity();
+    ASSERT_EQ(density.size(), expectedDensity.size());
+    for (size_t n = 0; n < density.size(); ++n) {
+        EXPECT_NEAR(density[n], expectedDensity[n], 1e-4);
+    }
+}
+
+// Test that filling a caller buffer matches the allocating density getter
+TEST(SimulationEngineTest, WriteProbabilityDensity) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 16;
+    config.dt = 0.01;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = 0.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 1.0;
+    config.wavepacket.sigmaY = 1.0;
+    config.wavepacket.kx = 1.0;
+    config.wavepacket.ky = 0.5;
+    config.numThreads = 3;
+    
+    SimulationEngine engine(config);
+    config.precision = "float";
+    SimulationEngineF engineF(config);
+    engine.advance(5);
+    engineF.advance(5);
+    
+    std::vector<float> expected = engine.getProbabilityDensity();
+    std::vector<float> buffer(expected.size(), -1.0f);
+    engine.writeProbabilityDensity(buffer.data());
+    EXPECT_EQ(buffer, expected);
+    
+    std::vector<float> expectedF = engineF.getProbabilityDensity();
+    engineF.writeProbabilityDensity(buffer.data());
+    EXPECT_EQ(buffer, expectedF);
+    
+    std::vector<float> fromWavefunction(expected.size(), -1.0f);
+    engine.getWavefunction().writeProbabilityDensity(fromWavefunction.data());
+    EXPECT_EQ(fromWavefunction, expected);
+    
+    // The complex field carries the same values as re/im pairs
+    std::vector<float> field(2 * expected.size());
+    engine.writeWavefunctionField(field.data());
+    const Wavefunction& psi = engine.getWavefunction();
+    for (size_t n = 0; n < psi.size(); ++n) {
+        EXPECT_EQ(field[2 * n], static_cast<float>(psi.data()[n].real()));
+        EXPECT_EQ(field[2 * n + 1], static_cast<float>(psi.data()[n].imag()));
+    }
+    engineF.writeWavefunctionField(field.data());
+    const WavefunctionF& psiF = engineF.getNativeWavefunction();
+    for (size_t n = 0; n < psiF.size(); ++n) {
+        EXPECT_EQ(field[2 * n], psiF.data()[n].real());
+        EXPECT_EQ(field[2 * n + 1], psiF.data()[n].imag());
+    }
+}
+
+// Test that the factory selects the engine precision from the configuration
+TEST(SimulationEngineTest, FactorySelectsPrecision) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 32;
+    config.dt = 0.01;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = 0.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 1.0;
+    config.wavepacket.ky = 0.0;
+    
+    auto doubleEngine = createSimulationEngine(config);
+    EXPECT_NE(dynamic_cast<SimulationEngine*>(doubleEngine.get()), nullptr);
+    
+    config.precision = "float";
+    auto floatEngine = createSimulationEngine(config);
+    EXPECT_NE(dynamic_cast<SimulationEngineF*>(floatEngine.get()), nullptr);
+    floatEngine->step();
+    EXPECT_NEAR(floatEngine->getTotalProbability(), 1.0, 1e-5);
+    
+    config.precision = "half";
+    EXPECT_THROW(createSimulationEngine(config), std::invalid_argument);
+}
+
+// Test that a potential tabulated on the solver grid propagates like the analytic one
+TEST(SimulationEngineTest, GridPotentialMatchesAnalytic) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 32;
+    config.dt = 0.002;
+    config.potential.type = "Composite";
+    config.potential.components.resize(2);
+    config.potential.components[0].type = "HarmonicOscillator";
+    config.potential.components[0].parameters = { 1.5 };
+    config.potential.components[1].type = "Rectangle";
+    config.potential.components[1].parameters = { 8.0, 1.0, 1.5, -10.0, 10.0 };
+    config.wavepacket.x0 = -1.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.5;
+    config.wavepacket.sigmaY = 0.5;
+    config.wavepacket.kx = 3.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine reference(config);
+    
+    // Tabulate the same potential on the engine's 20 x 20 grid
+    GridGeometry grid;
+    grid.nx = config.nx;
+    grid.ny = config.ny;
+    grid.x0 = -10.0;
+    grid.y0 = -10.0;
+    grid.dx = 20.0 / config.nx;
+    grid.dy = 20.0 / config.ny;
+    auto analytic = Potential::create(config.potential);
+    std::vector<double> values(static_cast<size_t>(grid.nx) * grid.ny);
+    for (int j = 0; j < grid.ny; ++j) {
+        analytic->sampleRow(grid, j, values.data() + static_cast<size_t>(j) * grid.nx);
+    }
+    
+    PhysicsConfig freeConfig = config;
+    freeConfig.potential = PotentialConfig();
+    freeConfig.potential.type = "FreeSpace";
+    SimulationEngine engine(freeConfig);
+    engine.setPotential(std::make_unique<GridPotential>(grid, values));
+    
+    reference.advance(20);
+    engine.advance(20);
+    
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = engine.getWavefunction();
+    for (int j = 0; j < config.ny; ++j) {
+        for (int i = 0; i < config.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-12);
+        }
+    }
+}
+
+namespace {
+
+// Wraps a potential and counts the batches (grid rows) evaluated from it
+class CountingPotential : public Potential {
+public:
+    CountingPotential(std::unique_ptr<Potential> inner, std::shared_ptr<std::atomic<int>> rows)
+        : m_inner(std::move(inner)), m_rows(std::move(rows)) {}
+    double getValue(double x, double y) const override { return m_inner->getValue(x, y); }
+    std::string getType() const override { return m_inner->getType(); }
+    void evaluate(const double* x, const double* y, double* out, size_t count) const override {
+        ++*m_rows;
+        m_inner->evaluate(x, y, out, count);
+    }
+    void sampleRow(const GridGeometry& grid, int row, double* out) const override {
+        ++*m_rows;
+        m_inner->sampleRow(grid, row, out);
+    }
+
+private:
+    std::unique_ptr<Potential> m_inner;
+    std::shared_ptr<std::atomic<int>> m_rows;
+};
+
+PhysicsConfig timeDependentConfig() {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 32;
+    config.dt = 0.005;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = -1.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.7;
+    config.wavepacket.sigmaY = 0.7;
+    config.wavepacket.kx = 2.0;
+    config.wavepacket.ky = 0.0;
+    return config;
+}
+
+void expectSameWavefunction(const SimulationEngine& actual, const SimulationEngine& expected, double tolerance) {
+    const Wavefunction& a = actual.getWavefunction();
+    const Wavefunction& b = expected.getWavefunction();
+    double maxDifference = 0.0;
+    for (int j = 0; j < b.getNy(); ++j) {
+        for (int i = 0; i < b.getNx(); ++i) {
+            maxDifference = std::max(maxDifference, std::abs(a(i, j) - b(i, j)));
+        }
+    }
+    EXPECT_LT(maxDifference, tolerance);
+}
+
+}  // namespace
+
+// Test that the fused V0 + f(t)V1 update matches re-sampling V at every time,
+// and that it never evaluates V0 again
+TEST(SimulationEngineTest, DrivenPotentialMatchesResampling) {
+    const PhysicsConfig config = timeDependentConfig();
+    auto makeDriven = [](std::shared_ptr<std::atomic<int>> rows) {
+        return std::make_unique<DrivenPotential>(
+            std::make_unique<CountingPotential>(std::make_unique<HarmonicOscillatorPotential>(1.0), rows),
+            std::make_unique<RectanglePotential>(1.0, -10.0, 10.0, -10.0, 10.0),
+            DrivenPotential::sineDrive(4.0, 6.0, 0.2));
+    };
+    auto fusedRows = std::make_shared<std::atomic<int>>(0);
+    auto sampledRows = std::make_shared<std::atomic<int>>(0);
+    
+    SimulationEngine fused(config);
+    fused.setPotential(makeDriven(fusedRows));
+    EXPECT_EQ(fusedRows->load(), config.ny);
+    
+    // Inside a composite the driven potential is re-tabulated at every time
+    SimulationEngine sampled(config);
+    auto composite = std::make_unique<CompositePotential>();
+    composite->add(makeDriven(sampledRows));
+    sampled.setPotential(std::move(composite));
+    
+    for (int i = 0; i < 5; ++i) {
+        fused.step();
+        sampled.step();
+    }
+    fused.advance(10);
+    sampled.advance(10);
+    
+    EXPECT_EQ(fusedRows->load(), config.ny);
+    // One tabulation per distinct time, not one per half step
+    EXPECT_EQ(sampledRows->load(), (1 + 15) * config.ny);
+    
+    expectSameWavefunction(fused, sampled, 1e-10);
+    EXPECT_NEAR(fused.computeObservables().potentialEnergy, sampled.computeObservables().potentialEnergy, 1e-10);
+}
+
+// Test that a trap moving by whole cells is shifted rather than re-evaluated,
+// and that fractional offsets stay close to re-sampling
+TEST(SimulationEngineTest, MovingPotentialShift) {
+    const PhysicsConfig config = timeDependentConfig();
+    const double dx = 20.0 / config.nx;
+    
+    auto run = [&](double velocity, double tolerance) {
+        auto shiftedRows = std::make_shared<std::atomic<int>>(0);
+        auto sampledRows = std::make_shared<std::atomic<int>>(0);
+        auto makeMoving = [&](std::shared_ptr<std::atomic<int>> rows) {
+            // Edges between grid points, so rounding cannot move them across one
+            auto shape = std::make_unique<SquareBarrierPotential>(6.0, 1.3 * dx + 0.01, 1.0 + 0.5 * dx, 0.0);
+            return std::make_unique<MovingPotential>(
+                std::make_unique<CountingPotential>(std::move(shape), rows),
+                MovingPotential::linearPath(velocity, 0.0));
+        };
+        
+        SimulationEngine shifted(config);
+        shifted.setPotential(makeMoving(shiftedRows));
+        
+        SimulationEngine sampled(config);
+        auto composite = std::make_unique<CompositePotential>();
+        composite->add(makeMoving(sampledRows));
+        sampled.setPotential(std::move(composite));
+        
+        for (int i = 0; i < 4; ++i) {
+            shifted.step();
+            sampled.step();
+        }
+        shifted.advance(12);
+        sampled.advance(12);
+        
+        EXPECT_EQ(shiftedRows->load(), config.ny);
+        EXPECT_GT(sampledRows->load(), config.ny);
+        expectSameWavefunction(shifted, sampled, tolerance);
+        EXPECT_NEAR(shifted.getTotalProbability(), 1.0, 1e-8);
+    };
+    
+    // One cell per step, keeping the barrier inside the domain
+    run(dx / config.dt, 1e-12);
+    
+    // A third of a cell per step interpolates the barrier across one cell
+    run(dx / config.dt / 3.0, 0.05);
+}
+
+// Test that an absorbing layer removes an outgoing packet on a small domain
+// instead of letting it wrap around, and that the loss is reported
+TEST(SimulationEngineTest, AbsorbingBoundary) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.lx = 10.0;
+    config.ly = 10.0;
+    config.dt = 0.005;
+    config.potential.type = "FreeSpace";
+    config.wavepacket.x0 = 1.0;
+    config.wavepacket.y0 = 0.0;
+    config.wavepacket.sigmaX = 0.6;
+    config.wavepacket.sigmaY = 0.6;
+    config.wavepacket.kx = 8.0;
+    config.wavepacket.ky = 0.0;
+    const std::vector<ObservableRegion> wrapped = {{"wrapped", -3.0, 0.0, -3.0, 3.0}};
+    
+    SimulationEngine periodic(config);
+    periodic.setObservableRegions(wrapped);
+    
+    config.absorber.width = 2.0;
+    config.absorber.strength = 40.0;
+    SimulationEngine absorbing(config);
+    absorbing.setObservableRegions(wrapped);
+    
+    // The packet crosses the right edge before t = 0.75
+    periodic.advance(150);
+    absorbing.advance(150);
+    
+    const ObservableSample open = periodic.computeObservables();
+    const ObservableSample absorbed = absorbing.computeObservables();
+    EXPECT_NEAR(open.totalProbability, 1.0, 1e-6);
+    EXPECT_NEAR(open.absorbedProbability, 0.0, 1e-6);
+    EXPECT_GT(open.regions[0], 0.3);
+    
+    EXPECT_LT(absorbed.totalProbability, 0.05);
+    EXPECT_NEAR(absorbed.absorbedProbability, 1.0 - absorbed.totalProbability, 1e-6);
+    EXPECT_LT(absorbed.regions[0], 0.01);
+    
+    // The absorbed probability survives a checkpoint round trip
+    SimulationEngine restored(config);
+    restored.restoreCheckpoint(absorbing.captureCheckpoint());
+    EXPECT_NEAR(restored.getAbsorbedProbability(), absorbed.absorbedProbability, 1e-9);
+    
+    config.lx = 0.0;
+    EXPECT_THROW(SimulationEngine invalid(config), std::invalid_argument);
+}
+
+// Test that imaginary-time relaxation finds the harmonic oscillator levels
+// E = ω(nx + ny + 1) and leaves the engine ready for real-time steps
+TEST(SimulationEngineTest, ImaginaryTimeEigenstates) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 64;
+    config.dt = 0.005;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = {1.0};
+    config.wavepacket.x0 = 0.5;
+    config.wavepacket.y0 = -0.3;
+    config.wavepacket.sigmaX = 1.5;
+    config.wavepacket.sigmaY = 0.8;
+    config.wavepacket.kx = 1.0;
+    config.wavepacket.ky = 0.0;
+    
+    SimulationEngine engine(config);
+    ImaginaryTime options;
+    options.states = 3;
+    const std::vector<EigenstateResult> results = engine.relaxEigenstates(options);
+    
+    ASSERT_EQ(results.size(), 3u);
+    const double expected[] = {1.0, 2.0, 2.0};
+    for (size_t k = 0; k < results.size(); ++k) {
+        EXPECT_TRUE(results[k].converged);
+        EXPECT_NEAR(results[k].dt, options.minDt, 1e-15);
+        EXPECT_NEAR(results[k].energy, expected[k], 1e-4);
+    }
+    
+    // The states are orthonormal
+    const auto& states = engine.getEigenstates();
+    const double cell = (20.0 / config.nx) * (20.0 / config.ny);
+    for (size_t a = 0; a < states.size(); ++a) {
+        for (size_t b = 0; b <= a; ++b) {
+            std::complex<double> overlap = 0.0;
+            for (size_t n = 0; n < states[a].size(); ++n) {
+                overlap += std::conj(states[a].data()[n]) * states[b].data()[n];
+            }
+            EXPECT_NEAR(std::abs(overlap) * cell, a == b ? 1.0 : 0.0, 1e-6);
+        }
+    }
+    
+    // The ground state is left in ψ and is stationary in real time
+    EXPECT_EQ(engine.getCurrentTime(), 0.0);
+    engine.advance(100);
+    const ObservableSample sample = engine.computeObservables();
+    EXPECT_NEAR(sample.totalProbability, 1.0, 1e-9);
+    EXPECT_NEAR(sample.energy, results[0].energy, 1e-6);
+    // The energy converges quadratically in the residual excited components
+    EXPECT_NEAR(sample.x, 0.0, 1e-3);
+    
+    options.minDt = 0.0;
+    EXPECT_THROW(engine.relaxEigenstates(options), std::invalid_argument);
+}
+
+namespace {
+
+PhysicsConfig integratorConfig(const std::string& scheme, double dt) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 32;
+    config.dt = dt;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = {1.0};
+    config.wavepacket.x0 = -1.0;
+    config.wavepacket.y0 = 0.5;
+    config.wavepacket.sigmaX = 0.8;
+    config.wavepacket.sigmaY = 1.0;
+    config.wavepacket.kx = 2.0;
+    config.wavepacket.ky = 0.0;
+    config.integration.scheme = scheme;
+    return config;
+}
+
+double wavefunctionDistance(const SimulationEngine& a, const SimulationEngine& b) {
+    const Wavefunction& psiA = a.getWavefunction();
+    const Wavefunction& psiB = b.getWavefunction();
+    double sum = 0.0;
+    for (size_t n = 0; n < psiA.size(); ++n) {
+        sum += std::norm(psiA.data()[n] - psiB.data()[n]);
+    }
+    return std::sqrt(sum * (20.0 / psiA.getNx()) * (20.0 / psiA.getNy()));
+}
+
+}  // namespace
+
+// Test the convergence order of each splitting and that the
+// higher-order ones need fewer FFTs for the same error
+TEST(SimulationEngineTest, IntegratorOrder) {
+    const double duration = 0.8;
+    SimulationEngine reference(integratorConfig("blanes-moan4", duration / 320));
+    reference.advance(320);
+    
+    auto error = [&](const std::string& scheme, int steps) {
+        SimulationEngine engine(integratorConfig(scheme, duration / steps));
+        engine.advance(steps);
+        EXPECT_NEAR(engine.getCurrentTime(), duration, 1e-12);
+        return wavefunctionDistance(engine, reference);
+    };
+    
+    const double strang = error("strang", 20) / error("strang", 40);
+    const double yoshida = error("yoshida4", 20) / error("yoshida4", 40);
+    const double blanesMoan = error("blanes-moan4", 10) / error("blanes-moan4", 20);
+    EXPECT_NEAR(strang, 4.0, 0.2);
+    EXPECT_NEAR(yoshida, 16.0, 1.0);
+    EXPECT_NEAR(blanesMoan, 16.0, 1.0);
+    
+    // 120 FFT pairs each
+    const double strangError = error("strang", 120);
+    const double yoshidaError = error("yoshida4", 40);
+    const double blanesMoanError = error("blanes-moan4", 20);
+    EXPECT_LT(yoshidaError, strangError / 100.0);
+    EXPECT_LT(blanesMoanError, yoshidaError / 10.0);
+    
+    // A single step() matches an advance() of one step
+    SimulationEngine stepped(integratorConfig("yoshida4", 0.02));
+    SimulationEngine advanced(integratorConfig("yoshida4", 0.02));
+    stepped.step();
+    advanced.advance(1);
+    EXPECT_LT(wavefunctionDistance(stepped, advanced), 1e-14);
+    
+    EXPECT_THROW(SimulationEngine(integratorConfig("euler", 0.01)), std::invalid_argument);
+}
+
+// Test that the adaptive controller grows dt from a small start, recovers
+// from a step that is too large, and lands exactly on the requested time
+TEST(SimulationEngineTest, AdaptiveTimeStep) {
+    const double duration = 0.8;
+    SimulationEngine reference(integratorConfig("blanes-moan4", duration / 320));
+    reference.advance(320);
+    
+    for (double initialDt : {0.001, 0.4}) {
+        PhysicsConfig config = integratorConfig("blanes-moan4", initialDt);
+        config.integration.adaptive = true;
+        config.integration.tolerance = 1e-5;
+        config.integration.maxDt = 0.2;
+        SimulationEngine engine(config);
+        
+        const int steps = engine.advanceFor(duration / 2) + engine.advanceFor(duration / 2);
+        EXPECT_DOUBLE_EQ(engine.getCurrentTime(), duration);
+        // Fixed steps of the initial dt would take 800
+        EXPECT_LT(steps, 60);
+        EXPECT_GT(engine.getTimeStep(), 0.01);
+        EXPECT_LE(engine.getTimeStep(), config.integration.maxDt);
+        // The tolerance bounds the Strang estimate; the kept result is far better
+        EXPECT_LT(wavefunctionDistance(engine, reference), 1e-8);
+        EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-10);
+    }
+    
+    // Without adaptive stepping the duration is split into steps of dt
+    SimulationEngine fixed(integratorConfig("strang", 0.01));
+    EXPECT_EQ(fixed.advanceFor(0.5), 50);
+    EXPECT_NEAR(fixed.getCurrentTime(), 0.5, 1e-12);
+    
+    // Strang has no lower-order partner to estimate its error with
+    PhysicsConfig strang = integratorConfig("strang", 0.01);
+    strang.integration.adaptive = true;
+    SimulationEngine unestimated(strang);
+    EXPECT_THROW(unestimated.advanceFor(0.5), std::invalid_argument);
+    EXPECT_DOUBLE_EQ(unestimated.getCurrentTime(), 0.0);
+}
+
+// Test that steps at the minimum dt are kept when the tolerance is out of
+// reach, also when spreading the duration leaves dt a rounding above minDt
+TEST(SimulationEngineTest, AdaptiveTimeStepAtMinimum) {
+    PhysicsConfig config = integratorConfig("blanes-moan4", 0.01);
+    config.integration.adaptive = true;
+    config.integration.tolerance = 1e-30;
+    config.integration.minDt = 0.01;
+    config.integration.maxDt = 0.2;
+    SimulationEngine engine(config);
+    
+    // 5 + 2e-10 steps of minDt round to 5 steps just longer than minDt
+    const double duration = 0.05 + 2e-12;
+    EXPECT_EQ(engine.advanceFor(duration), 5);
+    EXPECT_DOUBLE_EQ(engine.getCurrentTime(), duration);
+    
+    // 5.3 steps of minDt become 6 shorter ones
+    EXPECT_EQ(engine.advanceFor(0.053), 6);
+    EXPECT_DOUBLE_EQ(engine.getCurrentTime(), duration + 0.053);
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-10);
+}
+
+// Test that higher-order splittings keep their order with a driven potential,
+// whose stages are applied from the values at each stage time
+TEST(SimulationEngineTest, IntegratorOrderTimeDependent) {
+    auto run = [](const std::string& scheme, int steps) {
+        PhysicsConfig config = integratorConfig(scheme, 0.8 / steps);
+        auto engine = std::make_unique<SimulationEngine>(config);
+        engine->setPotential(std::make_unique<DrivenPotential>(
+            std::make_unique<HarmonicOscillatorPotential>(1.0),
+            std::make_unique<RectanglePotential>(1.0, 0.0, 10.0, -10.0, 10.0),
+            DrivenPotential::sineDrive(3.0, 4.0)));
+        engine->advance(steps);
+        return engine;
+    };
+    auto reference = run("blanes-moan4", 320);
+    const double coarse = wavefunctionDistance(*run("yoshida4", 40), *reference);
+    const double fine = wavefunctionDistance(*run("yoshida4", 80), *reference);
+    EXPECT_NEAR(coarse / fine, 16.0, 1.5);
+}
+
+// Test that updateConfig on the same grid keeps the ψ buffer and plans and matches a fresh engine
+TEST(SimulationEngineTest, UpdateConfigReusesPlans) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 32;
+    config.dt = 0.005;
+    config.potential.type = "HarmonicOscillator";
+    config.potential.parameters = { 1.0 };
+    config.wavepacket = {0.0, 0.0, 0.7, 0.7, 0.0, 0.0};
+    config.numThreads = 1;
+    
+    SimulationEngine engine(config);
+    engine.advance(10);
+    const auto* buffer = &engine.getWavefunction()(0, 0);
+    
+    // A sweep-style update: same grid, new physics
+    PhysicsConfig next = config;
+    next.dt = 0.004;
+    next.wavepacket.kx = 2.0;
+    next.potential.parameters = { 3.0 };
+    engine.updateConfig(next);
+    EXPECT_EQ(&engine.getWavefunction()(0, 0), buffer);
+    EXPECT_DOUBLE_EQ(engine.getCurrentTime(), 0.0);
+    
+    SimulationEngine reference(next);
+    engine.advance(25);
+    reference.advance(25);
+    const Wavefunction& expected = reference.getWavefunction();
+    const Wavefunction& actual = engine.getWavefunction();
+    for (int j = 0; j < next.ny; ++j) {
+        for (int i = 0; i < next.nx; ++i) {
+            EXPECT_NEAR(std::abs(actual(i, j) - expected(i, j)), 0.0, 1e-12);
+        }
+    }
+    
+    // A new grid still replans
+    next.nx = 64;
+    engine.updateConfig(next);
+    engine.advance(5);
+    EXPECT_EQ(engine.getWavefunction().getNx(), 64);
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-10);
+}
+
+// Test that keepState carries ψ over parameter updates and matches a fresh engine with the new tables
+TEST(SimulationEngineTest, UpdateConfigKeepsStateAcrossParameters) {
+    PhysicsConfig config;
+    config.nx = 64;
+    config.ny = 32;
+    config.dt = 0.004;
+    config.potential.type = "SquareBarrier";
+    config.potential.parameters = { 4.0, 1.0, 1.0, 0.0 };
+    config.absorber.width = 2.0;
+    config.wavepacket = {-2.0, 0.0, 0.8, 0.8, 3.0, 0.0};
+    config.integration.scheme = "yoshida4";
+    config.numThreads = 1;
+    
+    SimulationEngine engine(config);
+    engine.advance(20);
+    const double time = engine.getCurrentTime();
+    const double absorbed = engine.getAbsorbedProbability();
+    
+    // Each update is compared with a fresh engine of the new settings resumed from the same state
+    auto expectMatchesResumed = [&](const PhysicsConfig& next) {
+        CheckpointState state = engine.captureCheckpoint();
+        const Wavefunction before = engine.getWavefunction();
+        engine.updateConfig(next, true);
+        EXPECT_DOUBLE_EQ(engine.getCurrentTime(), state.time);
+        EXPECT_NEAR(engine.getAbsorbedProbability(), state.absorbed, 1e-14);
+        for (size_t n = 0; n < before.size(); ++n) {
+            ASSERT_EQ(engine.getWavefunction().data()[n], before.data()[n]) << n;
+        }
+        
+        state.dt = next.dt;
+        state.potential = next.potential;
+        SimulationEngine reference(next);
+        reference.restoreCheckpoint(state);
+        engine.advance(15);
+        reference.advance(15);
+        EXPECT_LT(wavefunctionDistance(engine, reference), 1e-12);
+    };
+    
+    // A new dt and absorber only rephase the tabulated V
+    PhysicsConfig next = config;
+    next.dt = 0.003;
+    next.absorber.strength = 20.0;
+    expectMatchesResumed(next);
+    
+    // A new potential is sampled again, the plans stay
+    next.potential.parameters = { 6.0, 0.5, 1.0, 0.0 };
+    next.integration.scheme = "strang";
+    expectMatchesResumed(next);
+    EXPECT_GT(engine.getCurrentTime(), time);
+    EXPECT_GT(engine.getAbsorbedProbability(), absorbed);
+    
+    // Carrying ψ over needs the same domain
+    next.lx = 30.0;
+    EXPECT_THROW(engine.updateConfig(next, true), std::invalid_argument);
+    EXPECT_EQ(engine.getWavefunction().getNx(), 64);
+}
+
+// Test that keepState resamples ψ spectrally onto a new grid
+TEST(SimulationEngineTest, UpdateConfigResamplesOnNewGrid) {
+    PhysicsConfig config;
+    config.nx = 48;
+    config.ny = 48;
+    config.dt = 0.01;
+    config.potential.type = "FreeSpace";
+    config.wavepacket = {0.3, -0.2, 1.4, 1.4, 1.0, -0.5};
+    config.numThreads = 1;
+    
+    // The Gaussian is band-limited on the coarse grid, so its spectral
+    // interpolation is the Gaussian sampled on the fine grid
+    SimulationEngine engine(config);
+    PhysicsConfig fine = config;
+    fine.nx = 96;
+    fine.ny = 64;
+    const SimulationEngine sampled(fine);
+    engine.updateConfig(fine, true);
+    ASSERT_EQ(engine.getWavefunction().getNx(), 96);
+    ASSERT_EQ(engine.getWavefunction().getNy(), 64);
+    EXPECT_LT(wavefunctionDistance(engine, sampled), 1e-8);
+    EXPECT_NEAR(engine.getTotalProbability(), 1.0, 1e-10);
+    
+    // Back to the first grid drops only the zero padding again
+    const SimulationEngine original(config);
+    engine.updateConfig(config, true);
+    EXPECT_LT(wavefunctionDistance(engine, original), 1e-12);
+    
+    // The carried state keeps evolving like the one that never moved
+    SimulationEngine moved(config);
+    moved.advance(10);
+    engine.updateConfig(fine, true);
+    engine.updateConfig(config, true);
+    engine.advance(10);
+    EXPECT_LT(wavefunctionDistance(engine, moved), 1e-9);
+    EXPECT_DOUBLE_EQ(engine.getCurrentTime(), moved.getCurrentTime());
+}
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/solver/SimulationWorker.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/core/TripleBuffer.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "../../src/core/Potential.h"
+#include "../../src/core/EventBus.h"
+#include "../../src/core/IEventHandler.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    return test_utils::makeConfig(32, 32, 0.01, "FreeSpace", {}, {0.0, 0.0, 1.0, 1.0, 2.0, 0.0});
+}
+
+// Records the thread each stepped event was handled on
+class SteppedRecorder : public IEventHandler {
+public:
+    bool handleEvent(const EventPtr& event) override {
+        threads.push_back(std::this_thread::get_id());
+        return true;
+    }
+
+    std::vector<std::thread::id> threads;
+};
+
+// Time-dependent potential that fails to sample after t = 0
+class ThrowingPotential : public Potential {
+public:
+    double getValue(double, double) const override { return 0.0; }
+    std::string getType() const override { return "Throwing"; }
+    void sampleRow(const GridGeometry& grid, int, double* out) const override {
+        if (m_time > 0.0) {
+            throw std::runtime_error("Potential cannot be sampled");
+        }
+        std::fill(out, out + grid.nx, 0.0);
+    }
+    bool isTimeDependent() const override { return true; }
+    void setTime(double time) override { m_time = time; }
+
+private:
+    double m_time = 0.0;
+};
+
+}  // namespace
+
+// Test that the consumer sees only the newest published value
+TEST(TripleBufferTest, KeepsLatestValue) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.writeBuffer() = 1;
+    buffer.publish();
+    buffer.writeBuffer() = 2;
+    buffer.publish();
+
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.readBuffer(), 2);
+    EXPECT_FALSE(buffer.update());
+
+    buffer.writeBuffer() = 3;
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.readBuffer(), 3);
+}
+
+// Test that steps queued on the worker match a direct engine
+TEST(SimulationWorkerTest, AdvanceMatchesEngine) {
+    PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    SimulationWorker worker(config);
+
+    ASSERT_TRUE(worker.acquireFrame());
+    EXPECT_EQ(worker.currentFrame().nx, config.nx);
+    EXPECT_DOUBLE_EQ(worker.currentFrame().time, 0.0);
+
+    engine.advance(10);
+    worker.advance(5);
+    worker.step();
+    worker.advance(4);
+    worker.waitIdle();
+
+    ASSERT_TRUE(worker.acquireFrame());
+    const DensityFrame& frame = worker.currentFrame();
+    EXPECT_NEAR(frame.time, engine.getCurrentTime(), 1e-12);
+    EXPECT_NEAR(frame.totalProbability, engine.getTotalProbability(), 1e-12);
+
+    std::vector<float> expected = engine.getProbabilityDensity();
+    ASSERT_EQ(frame.density.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_FLOAT_EQ(frame.density[i], expected[i]);
+    }
+    std::vector<float> copied(expected.size());
+    worker.writeProbabilityDensity(copied.data());
+    EXPECT_EQ(copied, frame.density);
+    EXPECT_FALSE(worker.acquireFrame());
+}
+
+// Test that frames carry ψ instead of |ψ|² when asked to
+TEST(SimulationWorkerTest, WavefunctionFrames) {
+    PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    SimulationWorker worker(config);
+    engine.advance(3);
+    worker.setFrameContent(FrameContent::Wavefunction);
+    worker.advance(3);
+    worker.waitIdle();
+
+    ASSERT_TRUE(worker.acquireFrame());
+    const DensityFrame& frame = worker.currentFrame();
+    EXPECT_TRUE(frame.density.empty());
+    std::vector<float> expected(2 * static_cast<size_t>(config.nx * config.ny));
+    engine.writeWavefunctionField(expected.data());
+    EXPECT_EQ(frame.field, expected);
+
+    // Density queries are still answered from the field
+    std::vector<float> density = worker.getProbabilityDensity();
+    std::vector<float> expectedDensity = engine.getProbabilityDensity();
+    ASSERT_EQ(density.size(), expectedDensity.size());
+    for (size_t i = 0; i < density.size(); ++i) {
+        EXPECT_NEAR(density[i], expectedDensity[i], 1e-6f * (1.0f + expectedDensity[i]));
+    }
+
+    // Switching back republishes a density frame even while paused
+    worker.setFrameContent(FrameContent::Density);
+    worker.waitIdle();
+    ASSERT_TRUE(worker.acquireFrame());
+    EXPECT_TRUE(worker.currentFrame().field.empty());
+    EXPECT_EQ(worker.currentFrame().density.size(), expectedDensity.size());
+}
+
+// Test that a viewport shrinks frames while full-resolution queries still work
+TEST(SimulationWorkerTest, ViewportFrames) {
+    PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    SimulationWorker worker(config);
+
+    DensityViewport view;
+    view.maxWidth = 8;
+    view.maxHeight = 8;
+    worker.setViewport(view);
+    worker.waitIdle();
+    ASSERT_TRUE(worker.acquireFrame());
+    const DensityFrame& frame = worker.currentFrame();
+    EXPECT_EQ(frame.width, 8);
+    EXPECT_EQ(frame.height, 8);
+    ASSERT_EQ(frame.density.size(), 64u);
+
+    // Max pooling keeps the peak of the wavepacket
+    std::vector<float> expected = engine.getProbabilityDensity();
+    EXPECT_EQ(*std::max_element(frame.density.begin(), frame.density.end()),
+              *std::max_element(expected.begin(), expected.end()));
+    EXPECT_EQ(worker.getProbabilityDensity(), expected);
+
+    // A small region arrives at full resolution
+    view = DensityViewport{4, 8, 6, 5, 8, 8};
+    worker.setViewport(view);
+    worker.waitIdle();
+    ASSERT_TRUE(worker.acquireFrame());
+    const DensityFrame& tile = worker.currentFrame();
+    ASSERT_EQ(tile.width, 6);
+    ASSERT_EQ(tile.height, 5);
+    for (int j = 0; j < 5; ++j) {
+        for (int i = 0; i < 6; ++i) {
+            EXPECT_EQ(tile.density[j * 6 + i], expected[(8 + j) * config.nx + 4 + i]);
+        }
+    }
+}
+
+// Test continuous stepping, pausing and reset across the thread boundary
+TEST(SimulationWorkerTest, RunPauseReset) {
+    SimulationWorker worker(makeConfig());
+    worker.setStepsPerFrame(4);
+    worker.setRunning(true);
+
+    // Wait for the worker to publish a few batches
+    for (int i = 0; i < 1000 && worker.getCurrentTime() < 0.2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    worker.setRunning(false);
+    worker.waitIdle();
+    EXPECT_GE(worker.getCurrentTime(), 0.2);
+    EXPECT_NEAR(worker.getTotalProbability(), 1.0, 1e-10);
+
+    // Paused: the time no longer advances
+    double pausedTime = worker.getCurrentTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_DOUBLE_EQ(worker.getCurrentTime(), pausedTime);
+
+    worker.reset();
+    EXPECT_DOUBLE_EQ(worker.getCurrentTime(), 0.0);
+    EXPECT_EQ(worker.getWavefunction().getNx(), 32);
+}
+
+// Test that configuration errors reach the caller and resizes reach the frame
+TEST(SimulationWorkerTest, UpdateConfig) {
+    SimulationWorker worker(makeConfig());
+
+    PhysicsConfig invalid = makeConfig();
+    invalid.fftw.planner = "bogus";
+    EXPECT_THROW(worker.updateConfig(invalid), std::invalid_argument);
+
+    PhysicsConfig larger = makeConfig();
+    larger.nx = 64;
+    worker.updateConfig(larger);
+    worker.acquireFrame();
+    EXPECT_EQ(worker.currentFrame().nx, 64);
+    EXPECT_EQ(worker.currentFrame().density.size(), static_cast<size_t>(64 * 32));
+}
+
+// Test that engine failures on the worker thread stop it and reach the next waited-for call
+TEST(SimulationWorkerTest, EngineErrorsStopTheWorker) {
+    SimulationWorker worker(makeConfig());
+    worker.setPotential(std::make_unique<ThrowingPotential>());
+
+    // A queued batch fails without taking the process down, and is reported once
+    worker.advance(2);
+    worker.waitIdle();
+    EXPECT_THROW(worker.computeObservables(), std::runtime_error);
+    EXPECT_NO_THROW(worker.computeObservables());
+
+    // A running worker pauses on the failure
+    worker.setRunning(true);
+    for (int i = 0; i < 1000 && worker.isRunning(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(worker.isRunning());
+
+    // The call that reports the failure still does its own work
+    EXPECT_THROW(worker.reset(), std::runtime_error);
+    EXPECT_DOUBLE_EQ(worker.getCurrentTime(), 0.0);
+    EXPECT_NO_THROW(worker.reset());
+}
+
+// Test that engine events are delivered on the dispatching thread
+TEST(SimulationWorkerTest, EventsDispatchedOnConsumerThread) {
+    auto eventBus = std::make_shared<EventBus>();
+    auto recorder = std::make_shared<SteppedRecorder>();
+    eventBus->subscribe(EventType::SimulationStepped, recorder);
+
+    SimulationWorker worker(makeConfig(), eventBus);
+    int callbacks = 0;
+    worker.setStepCompletionCallback([&callbacks]() { ++callbacks; });
+
+    worker.advance(3);
+    worker.advance(3);
+    worker.waitIdle();
+    EXPECT_TRUE(recorder->threads.empty());
+    EXPECT_EQ(callbacks, 0);
+
+    // Both batches' stepped events are coalesced into one
+    worker.dispatchEvents();
+    ASSERT_EQ(recorder->threads.size(), 1u);
+    for (const auto& id : recorder->threads) {
+        EXPECT_EQ(id, std::this_thread::get_id());
+    }
+    EXPECT_EQ(callbacks, 1);
+
+    worker.shutdown();
+}
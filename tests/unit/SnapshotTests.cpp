@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/batch/BatchRunner.h"
+#include "../../src/solver/SimulationEngine.h"
+#include "../../src/solver/Snapshots.h"
+#include "TestUtils.h"
+
+namespace {
+
+PhysicsConfig makeConfig() {
+    return test_utils::makeConfig(64, 32, 0.01, "HarmonicOscillator", {0.5}, {1.0, 0.0, 1.0, 1.0, 2.0, 0.0});
+}
+
+size_t points(const PhysicsConfig& config) {
+    return static_cast<size_t>(config.nx) * static_cast<size_t>(config.ny);
+}
+
+// Wait until the writer thread has finished count frames
+void waitForWrites(const SnapshotWriter& writer, size_t count) {
+    while (writer.getWrittenCount() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Fresh stream file under the system temp path, removed after each test
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() /
+                ("qmsim_snapshots_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+        std::filesystem::create_directories(m_dir);
+    }
+    void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+    std::string path(const std::string& name) const { return (m_dir / name).string(); }
+
+    std::filesystem::path m_dir;
+};
+
+}  // namespace
+
+// Test the half-precision conversion at exact values, ties, subnormals and overflow
+TEST(SnapshotFormatTest, HalfConversion) {
+    EXPECT_EQ(SnapshotFormat::toHalf(1.0f), 0x3c00);
+    EXPECT_EQ(SnapshotFormat::toHalf(-2.0f), 0xc000);
+    EXPECT_EQ(SnapshotFormat::toHalf(65504.0f), 0x7bff);
+    EXPECT_EQ(SnapshotFormat::toHalf(1e6f), 0x7c00);
+    EXPECT_EQ(SnapshotFormat::toHalf(std::ldexp(1.0f, -24)), 0x0001);
+    EXPECT_EQ(SnapshotFormat::toHalf(std::ldexp(1.0f, -26)), 0x0000);
+    // 1 + 2^-11 lies halfway between 1 and the next half; ties go to even
+    EXPECT_EQ(SnapshotFormat::toHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    EXPECT_EQ(SnapshotFormat::toHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)), 0x3c02);
+
+    for (uint32_t bits = 0; bits < 0x7c00; ++bits) {
+        const uint16_t half = static_cast<uint16_t>(bits);
+        ASSERT_EQ(SnapshotFormat::toHalf(SnapshotFormat::fromHalf(half)), half) << bits;
+    }
+    EXPECT_TRUE(std::isinf(SnapshotFormat::fromHalf(0x7c00)));
+    EXPECT_TRUE(std::isnan(SnapshotFormat::fromHalf(SnapshotFormat::toHalf(NAN))));
+}
+
+// Test that every fixed-size encoding reads back what the engine produced
+TEST_F(SnapshotTest, FixedEncodingsRoundTrip) {
+    const PhysicsConfig config = makeConfig();
+    const SnapshotFormat::Encoding encodings[] = {
+        SnapshotFormat::Encoding::Complex128, SnapshotFormat::Encoding::Complex64,
+        SnapshotFormat::Encoding::Density32, SnapshotFormat::Encoding::Density16
+    };
+    for (SnapshotFormat::Encoding encoding : encodings) {
+        SCOPED_TRACE(SnapshotFormat::encodingName(encoding));
+        const std::string file = path(std::string(SnapshotFormat::encodingName(encoding)) + ".qms");
+        SimulationEngine engine(config);
+        std::vector<std::vector<float>> densities;
+        std::vector<std::vector<std::complex<double>>> fields;
+        {
+            SnapshotWriter writer(file, encoding, config.nx, config.ny, config.lx, config.ly, config.dt);
+            for (int frame = 0; frame < 3; ++frame) {
+                engine.advance(5);
+                std::vector<float> density(points(config));
+                engine.writeProbabilityDensity(density.data());
+                densities.push_back(density);
+                const Wavefunction& psi = engine.getWavefunction();
+                fields.emplace_back(psi.begin(), psi.end());
+                ASSERT_TRUE(writer.capture(engine, (frame + 1) * 5));
+                waitForWrites(writer, static_cast<size_t>(frame + 1));
+            }
+            writer.close();
+            EXPECT_EQ(writer.getDroppedCount(), 0u);
+        }
+
+        SnapshotReader reader(file);
+        ASSERT_EQ(reader.getFrameCount(), 3u);
+        EXPECT_EQ(reader.getHeader().nx, config.nx);
+        EXPECT_EQ(reader.getHeader().ny, config.ny);
+        EXPECT_EQ(reader.getEncoding(), encoding);
+        const uint64_t stride = reader.getHeader().frameStride;
+        EXPECT_EQ(stride % SnapshotFormat::kFrameAlignment, 0u);
+        EXPECT_EQ(std::filesystem::file_size(file), SnapshotFormat::kHeaderBytes + 3 * stride);
+
+        std::vector<float> density(points(config));
+        std::vector<std::complex<double>> field(points(config));
+        for (size_t frame = 0; frame < 3; ++frame) {
+            EXPECT_EQ(reader.getFrameHeader(frame).step, static_cast<int64_t>(frame + 1) * 5);
+            EXPECT_NEAR(reader.getFrameHeader(frame).time, (frame + 1) * 5 * config.dt, 1e-12);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(reader.getPayload(frame)) % SnapshotFormat::kFrameAlignment, 0u);
+
+            reader.readDensity(frame, density.data());
+            for (size_t n = 0; n < density.size(); ++n) {
+                const float expected = densities[frame][n];
+                const float tolerance = encoding == SnapshotFormat::Encoding::Density16
+                                            ? std::max(expected * 1e-3f, 6e-8f) : expected * 1e-5f + 1e-30f;
+                ASSERT_NEAR(density[n], expected, tolerance) << n;
+            }
+            if (SnapshotFormat::storesField(encoding)) {
+                reader.readField(frame, field.data());
+                const double tolerance = encoding == SnapshotFormat::Encoding::Complex128 ? 0.0 : 1e-6;
+                for (size_t n = 0; n < field.size(); ++n) {
+                    ASSERT_LE(std::abs(field[n] - fields[frame][n]), tolerance) << n;
+                }
+            } else {
+                EXPECT_THROW(reader.readField(frame, field.data()), std::logic_error);
+            }
+        }
+        if (encoding == SnapshotFormat::Encoding::Density32) {
+            // Raw frames are the engine's density, usable in place
+            EXPECT_EQ(std::memcmp(reader.getPayload(1), densities[1].data(), densities[1].size() * sizeof(float)), 0);
+        }
+    }
+}
+
+// Test that delta frames decode to the float16 frames in any order and take less space
+TEST_F(SnapshotTest, DeltaFramesMatchFloat16) {
+    const PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    const int frames = 10;
+    {
+        SnapshotWriter half(path("half.qms"), SnapshotFormat::Encoding::Density16,
+                            config.nx, config.ny, config.lx, config.ly, config.dt);
+        SnapshotWriter delta(path("delta.qms"), SnapshotFormat::Encoding::DensityDelta16,
+                             config.nx, config.ny, config.lx, config.ly, config.dt, 4);
+        for (int frame = 0; frame < frames; ++frame) {
+            engine.advance(frame % 3 == 0 ? 0 : 3);  // Some frames repeat the previous one
+            ASSERT_TRUE(half.capture(engine, frame));
+            ASSERT_TRUE(delta.capture(engine, frame));
+            waitForWrites(half, static_cast<size_t>(frame + 1));
+            waitForWrites(delta, static_cast<size_t>(frame + 1));
+        }
+    }
+
+    SnapshotReader half(path("half.qms"));
+    SnapshotReader delta(path("delta.qms"));
+    ASSERT_EQ(delta.getFrameCount(), static_cast<size_t>(frames));
+    EXPECT_EQ(delta.getHeader().frameStride, 0u);
+    EXPECT_NE(delta.getHeader().indexOffset, 0u);
+    EXPECT_LT(std::filesystem::file_size(path("delta.qms")), std::filesystem::file_size(path("half.qms")));
+
+    std::vector<float> expected(points(config));
+    std::vector<float> decoded(points(config));
+    for (size_t frame : {7, 2, 3, 9, 0, 8, 1, 5, 4, 6}) {
+        EXPECT_EQ(delta.getFrameHeader(frame).keyframe != 0, frame % 4 == 0) << frame;
+        half.readDensity(frame, expected.data());
+        delta.readDensity(frame, decoded.data());
+        ASSERT_EQ(std::memcmp(expected.data(), decoded.data(), expected.size() * sizeof(float)), 0) << frame;
+    }
+}
+
+// Test that a stream still being written, or cut short, reads up to its last complete frame
+TEST_F(SnapshotTest, PartialStreamIsReadable) {
+    const PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    for (SnapshotFormat::Encoding encoding : {SnapshotFormat::Encoding::Density32,
+                                              SnapshotFormat::Encoding::DensityDelta16}) {
+        SCOPED_TRACE(SnapshotFormat::encodingName(encoding));
+        const std::string file = path("partial.qms");
+        SnapshotWriter writer(file, encoding, config.nx, config.ny, config.lx, config.ly, config.dt);
+        for (int frame = 0; frame < 3; ++frame) {
+            engine.advance(2);
+            ASSERT_TRUE(writer.capture(engine, frame));
+            waitForWrites(writer, static_cast<size_t>(frame + 1));
+        }
+        {
+            SnapshotReader reader(file);
+            EXPECT_EQ(reader.getFrameCount(), 3u);
+            std::vector<float> density(points(config));
+            reader.readDensity(2, density.data());
+        }
+        writer.close();
+
+        // Chop the last frame in half
+        const std::string cut = path("cut.qms");
+        std::filesystem::copy_file(file, cut, std::filesystem::copy_options::overwrite_existing);
+        SnapshotReader complete(file);
+        const uint64_t lastFrame = reinterpret_cast<const unsigned char*>(complete.getPayload(2)) -
+                                   reinterpret_cast<const unsigned char*>(complete.getPayload(0));
+        std::filesystem::resize_file(cut, SnapshotFormat::kHeaderBytes + lastFrame + 100);
+        SnapshotReader reader(cut);
+        EXPECT_EQ(reader.getFrameCount(), 2u);
+        EXPECT_EQ(reader.getFrameHeader(1).step, 1);
+        EXPECT_THROW(reader.getFrameHeader(2), std::out_of_range);
+    }
+}
+
+// Test that bad encodings, grids and files are rejected
+TEST_F(SnapshotTest, RejectsInvalidInput) {
+    EXPECT_EQ(SnapshotFormat::parseEncoding("delta16"), SnapshotFormat::Encoding::DensityDelta16);
+    EXPECT_THROW(SnapshotFormat::parseEncoding("float8"), std::invalid_argument);
+    EXPECT_THROW(SnapshotWriter(path("a.qms"), SnapshotFormat::Encoding::Density32, 0, 4, 1.0, 1.0, 0.1),
+                 std::invalid_argument);
+    EXPECT_THROW(SnapshotWriter(path("missing/a.qms"), SnapshotFormat::Encoding::Density32, 4, 4, 1.0, 1.0, 0.1),
+                 std::runtime_error);
+
+    PhysicsConfig config = makeConfig();
+    SimulationEngine engine(config);
+    {
+        SnapshotWriter writer(path("b.qms"), SnapshotFormat::Encoding::Complex128, 16, 16, 1.0, 1.0, 0.1);
+        EXPECT_THROW(writer.capture(engine, 0), std::invalid_argument);
+    }
+
+    std::ofstream(path("c.qms"), std::ios::binary) << std::string(8192, 'x');
+    EXPECT_THROW(SnapshotReader(path("c.qms")), std::runtime_error);
+    EXPECT_THROW(SnapshotReader(path("none.qms")), std::runtime_error);
+}
+
+// Test that the batch runner writes its snapshots into one stream
+TEST_F(SnapshotTest, BatchRunnerWritesStream) {
+    PhysicsConfig config = makeConfig();
+    config.output.snapshotStream = "float16";
+    BatchOptions options;
+    options.steps = 20;
+    options.snapshotInterval = 5;
+    options.outputDir = m_dir.string();
+    options.quiet = true;
+
+    BatchResult result = BatchRunner(config, options).run();
+    EXPECT_EQ(result.snapshots + result.droppedSnapshots, 4);
+    EXPECT_FALSE(std::filesystem::exists(m_dir / "density_20.f32"));
+
+    SnapshotReader reader((m_dir / "snapshots.qms").string());
+    EXPECT_EQ(reader.getEncoding(), SnapshotFormat::Encoding::Density16);
+    ASSERT_EQ(reader.getFrameCount(), static_cast<size_t>(result.snapshots));
+    for (size_t frame = 0; frame < reader.getFrameCount(); ++frame) {
+        EXPECT_EQ(reader.getFrameHeader(frame).step % 5, 0);
+    }
+    EXPECT_NEAR(reader.getHeader().dt, config.dt, 0.0);
+}
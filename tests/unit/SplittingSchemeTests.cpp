@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <stdexcept>
+#include "../../src/solver/SplittingScheme.h"
+
+// Test that every scheme is a consistent symmetric splitting
+TEST(SplittingSchemeTest, Consistency) {
+    for (const char* name : {"strang", "yoshida4", "blanes-moan4"}) {
+        const SplittingScheme& scheme = SplittingScheme::fromName(name);
+        EXPECT_EQ(scheme.name, name);
+        ASSERT_EQ(scheme.a.size(), scheme.b.size() + 1);
+        
+        // The weights of each operator add up to one full step
+        EXPECT_NEAR(std::accumulate(scheme.a.begin(), scheme.a.end(), 0.0), 1.0, 1e-14) << name;
+        EXPECT_NEAR(std::accumulate(scheme.b.begin(), scheme.b.end(), 0.0), 1.0, 1e-14) << name;
+        
+        // Palindromic weights make the step time-symmetric
+        for (size_t j = 0; j < scheme.a.size(); ++j) {
+            EXPECT_DOUBLE_EQ(scheme.a[j], scheme.a[scheme.a.size() - 1 - j]) << name;
+        }
+        for (size_t j = 0; j < scheme.b.size(); ++j) {
+            EXPECT_DOUBLE_EQ(scheme.b[j], scheme.b[scheme.b.size() - 1 - j]) << name;
+        }
+        EXPECT_DOUBLE_EQ(scheme.stageTime(0), 0.0);
+        EXPECT_NEAR(scheme.stageTime(scheme.b.size()), 1.0, 1e-14);
+    }
+    
+    EXPECT_TRUE(SplittingScheme::strang().isStrang());
+    EXPECT_EQ(SplittingScheme::fromName("yoshida4").order, 4);
+    EXPECT_THROW(SplittingScheme::fromName("euler"), std::invalid_argument);
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/batch/SweepRunner.h"
+#include "../../src/batch/WorkStealingPool.h"
+#include "../../src/config/ConfigLoader.h"
+#include "TestUtils.h"
+
+namespace {
+
+// Small free-space configuration followed by a sweep block
+std::string sweepJson(const std::string& sweep) {
+    return R"({
+  "grid": {"nx": 32, "ny": 16},
+  "dt": 0.01,
+  "potential": {"type": "HarmonicOscillator", "parameters": [1.0]},
+  "wavepacket": {"x0": 0.0, "y0": 0.0, "sigmaX": 1.0, "sigmaY": 1.0, "kx": 0.0, "ky": 0.0},
+  "omega": 1.0,
+  "threads": 1,
+  "precision": "double",
+  "fftw": {"planner": "estimate", "wisdomDir": ""},
+  "output": {"checkpointInterval": 0, "checkpointCompression": 0, "exportObservables": true, "observablesFormat": "csv", "regions": []},
+  "sweep": )" + sweep + "\n}\n";
+}
+
+using test_utils::readLines;
+
+std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    for (std::string field; std::getline(stream, field, ',');) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// Fresh directory under the system temp path, removed after each test
+class SweepRunnerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() /
+                ("qmsim_sweep_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+        std::filesystem::create_directories(m_dir);
+    }
+    void TearDown() override { std::filesystem::remove_all(m_dir); }
+
+    std::string writeSweep(const std::string& sweep) {
+        const std::filesystem::path path = m_dir / "sweep.json";
+        std::ofstream(path) << sweepJson(sweep);
+        return path.string();
+    }
+
+    std::filesystem::path m_dir;
+};
+
+}  // namespace
+
+// Test that every task runs once and idle workers steal from a busy one
+TEST(WorkStealingPoolTest, RunsEveryTaskAndSteals) {
+    WorkStealingPool pool(2);
+    ASSERT_EQ(pool.getWorkerCount(), 2);
+
+    std::vector<std::atomic<int>> runs(8);
+    std::vector<WorkStealingPool::Task> tasks;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        tasks.push_back([&runs, i](int) {
+            if (i == 0) {
+                // Hold worker 0 on its first task so worker 1 takes the rest of its chunk
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+            ++runs[i];
+        });
+    }
+    pool.run(tasks);
+
+    for (const std::atomic<int>& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+    EXPECT_GT(pool.getStolenCount(), 0u);
+}
+
+// Test that a failing task's exception reaches the caller
+TEST(WorkStealingPoolTest, RethrowsTaskException) {
+    WorkStealingPool pool(3);
+    std::vector<WorkStealingPool::Task> tasks(6, [](int) {});
+    tasks[4] = [](int) { throw std::runtime_error("task failed"); };
+    EXPECT_THROW(pool.run(tasks), std::runtime_error);
+}
+
+// Test the product and zip expansions of a sweep block
+TEST_F(SweepRunnerTest, ExpandsSweep) {
+    config::SweepSpec spec = config::ConfigLoader::loadSweep(writeSweep(R"({
+        "steps": 10,
+        "parameters": {
+            "/wavepacket/kx": [0.5, 1.0],
+            "/potential/parameters/0": {"from": 1.0, "to": 3.0, "count": 3}
+        }
+    })"));
+
+    ASSERT_EQ(spec.jobs.size(), 6u);
+    EXPECT_EQ(spec.steps, 10);
+    ASSERT_EQ(spec.parameters.size(), 2u);
+    EXPECT_EQ(spec.parameters[0], "/potential/parameters/0");  // Key order
+    EXPECT_EQ(spec.parameters[1], "/wavepacket/kx");
+
+    // The last parameter varies fastest
+    const config::SweepJob& job = spec.jobs[3];
+    EXPECT_EQ(job.index, 3);
+    ASSERT_EQ(job.values.size(), 2u);
+    EXPECT_DOUBLE_EQ(job.values[0], 2.0);
+    EXPECT_DOUBLE_EQ(job.values[1], 1.0);
+    EXPECT_DOUBLE_EQ(job.config.wavepacket.kx, 1.0);
+    ASSERT_EQ(job.config.potential.parameters.size(), 1u);
+    EXPECT_DOUBLE_EQ(job.config.potential.parameters[0], 2.0);
+    EXPECT_EQ(job.config.nx, 32);
+
+    config::SweepSpec zipped = config::ConfigLoader::loadSweep(writeSweep(R"({
+        "steps": 10, "combine": "zip",
+        "parameters": {"/wavepacket/kx": [0.5, 1.0], "/dt": [0.01, 0.02]}
+    })"));
+    ASSERT_EQ(zipped.jobs.size(), 2u);
+    EXPECT_DOUBLE_EQ(zipped.jobs[1].config.dt, 0.02);
+    EXPECT_DOUBLE_EQ(zipped.jobs[1].config.wavepacket.kx, 1.0);
+
+    EXPECT_THROW(config::ConfigLoader::loadSweep(writeSweep(R"({
+        "steps": 10, "combine": "zip",
+        "parameters": {"/wavepacket/kx": [0.5, 1.0], "/dt": [0.01]}
+    })")), std::invalid_argument);
+}
+
+// Test that all runs land in one observables file with run and parameter columns
+TEST_F(SweepRunnerTest, AggregatesObservables) {
+    config::SweepSpec spec = config::ConfigLoader::loadSweep(writeSweep(R"({
+        "steps": 10,
+        "observeEvery": 5,
+        "parameters": {
+            "/wavepacket/kx": [0.0, 1.0],
+            "/grid/nx": [16, 32]
+        }
+    })"));
+
+    SweepOptions options;
+    options.outputDir = (m_dir / "out").string();
+    options.workers = 3;
+    options.quiet = true;
+    SweepRunner runner(spec, options);
+    SweepResult result = runner.run();
+
+    EXPECT_EQ(result.runs, 4);
+    EXPECT_EQ(result.failed, 0);
+    EXPECT_EQ(result.droppedSamples, 0);
+    EXPECT_GT(result.runsPerHour, 0.0);
+
+    const std::vector<std::string> lines = readLines(m_dir / "out" / "sweep.csv");
+    ASSERT_EQ(lines.size(), 1u + 4u * 3u);
+    const std::vector<std::string> header = splitCsv(lines[0]);
+    ASSERT_EQ(header.size(), 15u);
+    EXPECT_EQ(header[12], "run");
+    EXPECT_EQ(header[13], "grid.nx");
+    EXPECT_EQ(header[14], "wavepacket.kx");
+
+    // Each run writes steps 0, 5 and 10 under its own labels
+    std::set<std::string> rows;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        const std::vector<std::string> fields = splitCsv(lines[i]);
+        ASSERT_EQ(fields.size(), header.size());
+        rows.insert(fields[12] + "/" + fields[0]);
+        const int run = std::stoi(fields[12]);
+        EXPECT_EQ(std::stod(fields[13]), run < 2 ? 16.0 : 32.0);
+        EXPECT_EQ(std::stod(fields[14]), run % 2 == 0 ? 0.0 : 1.0);
+        EXPECT_NEAR(std::stod(fields[2]), 1.0, 1e-9);
+    }
+    EXPECT_EQ(rows.size(), 12u);
+}
+
+// Test that a run with an invalid configuration fails alone
+TEST_F(SweepRunnerTest, FailedRunDoesNotStopSweep) {
+    config::SweepSpec spec = config::ConfigLoader::loadSweep(writeSweep(R"({
+        "steps": 4,
+        "parameters": {"/integration/scheme": ["strang", "no-such-scheme", "yoshida4"]}
+    })"));
+
+    SweepOptions options;
+    options.outputDir = (m_dir / "out").string();
+    options.workers = 1;
+    options.quiet = true;
+    SweepResult result = SweepRunner(spec, options).run();
+
+    EXPECT_EQ(result.runs, 2);
+    EXPECT_EQ(result.failed, 1);
+    EXPECT_EQ(readLines(m_dir / "out" / "sweep.csv").size(), 1u + 2u * 2u);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../src/core/PhysicsConfig.h"
+
+// Helpers shared by the unit test suites
+namespace test_utils {
+
+// Single-threaded solver configuration; suites adjust the remaining fields
+inline PhysicsConfig makeConfig(int nx, int ny, double dt, const std::string& potentialType,
+                                const std::vector<double>& potentialParameters, const Wavepacket& wavepacket) {
+    PhysicsConfig config;
+    config.nx = nx;
+    config.ny = ny;
+    config.dt = dt;
+    config.potential.type = potentialType;
+    config.potential.parameters = potentialParameters;
+    config.wavepacket = wavepacket;
+    config.numThreads = 1;
+    return config;
+}
+
+// Lines of a text file, without their line breaks
+inline std::vector<std::string> readLines(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+}  // namespace test_utils
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../../src/core/DebugUtils.h"
+#include "../../src/core/Trace.h"
+#include "../../src/core/PhysicsConfig.h"
+#include "../../src/solver/SimulationEngine.h"
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+size_t countOccurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+// Trace file under the system temp directory, removed after each test
+class TracerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_path = (std::filesystem::temp_directory_path() /
+                  ("qmsim_trace_" +
+                   std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".json"))
+                     .string();
+    }
+    void TearDown() override { std::filesystem::remove(m_path); }
+
+    std::string m_path;
+};
+
+}  // namespace
+
+// Test that disabled log statements do not evaluate their message
+TEST(LoggingTest, DisabledMessagesAreNotEvaluated) {
+    DebugUtils& logger = DebugUtils::getInstance();
+    const LogLevel previous = logger.getLogLevel();
+    int evaluated = 0;
+    auto message = [&evaluated]() {
+        ++evaluated;
+        return std::string("message");
+    };
+
+    logger.setDebugEnabled(false);
+    DEBUG_LOG("LoggingTest", message());
+    TRACE_LOG("LoggingTest", message());
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_FALSE(logger.isDebugEnabled());
+
+    logger.setLogLevel(LogLevel::Trace);
+    DEBUG_LOG("LoggingTest", message());
+    EXPECT_EQ(evaluated, 1);
+
+    // Below the compiled-in minimum nothing is evaluated whatever the runtime level
+    TRACE_LOG("LoggingTest", message());
+    EXPECT_EQ(evaluated, QMSIM_MIN_LOG_LEVEL > 0 ? 1 : 2);
+    evaluated = 1;
+
+    logger.setLogLevel(LogLevel::Off);
+    ERROR_LOG("LoggingTest", message());
+    EXPECT_EQ(evaluated, 1);
+
+    logger.setLogLevel(previous);
+}
+
+// Test the Chrome trace output of nested scopes on several threads
+TEST_F(TracerTest, WritesChromeTrace) {
+    {
+        TRACE_SCOPE("before start", "test");
+    }
+
+    Tracer::getInstance().start(m_path);
+    {
+        TRACE_SCOPE("outer", "test");
+        TRACE_SCOPE("inner \"quoted\"", "test");
+    }
+    std::thread worker([]() { TRACE_SCOPE("worker", "test"); });
+    worker.join();
+    EXPECT_EQ(Tracer::getInstance().stop(), 3u);
+
+    {
+        TRACE_SCOPE("after stop", "test");
+    }
+
+    const std::string trace = readFile(m_path);
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(countOccurrences(trace, "\"ph\":\"X\""), 3u);
+    EXPECT_NE(trace.find("\"name\":\"outer\",\"cat\":\"test\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"inner \\\"quoted\\\"\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"worker\""), std::string::npos);
+    EXPECT_EQ(trace.find("before start"), std::string::npos);
+    EXPECT_EQ(trace.find("after stop"), std::string::npos);
+}
+
+// Test the per-thread event limit and the solver scopes
+TEST_F(TracerTest, SolverScopesAndLimit) {
+    PhysicsConfig config;
+    config.nx = 32;
+    config.ny = 32;
+    config.dt = 0.01;
+    config.potential.type = "FreeSpace";
+    config.numThreads = 1;
+    SimulationEngine engine(config);
+
+    Tracer::getInstance().start(m_path);
+    engine.advance(3);
+    engine.computeObservables();
+    Tracer::getInstance().stop();
+
+    // V/2 K V K V K V/2 inside one Advance, with both FFTs of each K
+    const std::string trace = readFile(m_path);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"Advance\""), 1u);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"K\""), 3u);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"FFT forward\""), 3u);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"V/2\""), 2u);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"V\""), 2u);
+    EXPECT_EQ(countOccurrences(trace, "\"name\":\"Observables\""), 1u);
+
+    Tracer::getInstance().start(m_path, 2);
+    engine.advance(1);
+    EXPECT_EQ(Tracer::getInstance().stop(), 2u);
+    EXPECT_GT(Tracer::getInstance().getDroppedCount(), 0u);
+}
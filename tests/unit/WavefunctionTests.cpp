@@ -176,3 +176,56 @@ TEST(WavefunctionTest, TotalProbability) {
     // Should be very close to 1.0 for a properly normalized wavefunction
     EXPECT_NEAR(total_prob, 1.0, 1e-6);
 }
+
+// Test contiguous row and flat iteration primitives
+TEST(WavefunctionTest, RowAndFlatAccess) {
+    int nx = 5, ny = 3;
+    Wavefunction wf(nx, ny);
+    EXPECT_EQ(wf.size(), static_cast<size_t>(nx * ny));
+    
+    // Rows are contiguous runs of nx elements in x
+    for (int j = 0; j < ny; ++j) {
+        std::complex<double>* psiRow = wf.row(j);
+        EXPECT_EQ(psiRow, wf.data() + j * nx);
+        for (int i = 0; i < nx; ++i) {
+            psiRow[i] = std::complex<double>(i, j);
+        }
+    }
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            EXPECT_EQ(wf(i, j), std::complex<double>(i, j));
+        }
+    }
+    
+    // Flat iteration visits every element once in storage order
+    size_t n = 0;
+    for (const auto& value : wf) {
+        EXPECT_EQ(value, std::complex<double>(static_cast<double>(n % nx), static_cast<double>(n / nx)));
+        ++n;
+    }
+    EXPECT_EQ(n, wf.size());
+}
+
+// Test the single-precision wavefunction against the double-precision one
+TEST(WavefunctionTest, SinglePrecision) {
+    int nx = 64, ny = 48;
+    double lx = 20.0, ly = 20.0;
+    
+    Wavefunction reference(nx, ny);
+    WavefunctionF wf(nx, ny);
+    reference.initializeGaussian(1.0, -0.5, 1.2, 0.8, 3.0, 1.0, lx, ly);
+    wf.initializeGaussian(1.0, -0.5, 1.2, 0.8, 3.0, 1.0, lx, ly);
+    
+    EXPECT_NEAR(wf.getTotalProbability(lx, ly), 1.0, 1e-6);
+    
+    // Converting back to double reproduces the float values exactly
+    Wavefunction converted(wf);
+    EXPECT_EQ(converted.getNx(), nx);
+    EXPECT_EQ(converted.getNy(), ny);
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            EXPECT_EQ(converted(i, j), std::complex<double>(wf(i, j)));
+            EXPECT_NEAR(std::abs(converted(i, j) - reference(i, j)), 0.0, 1e-6);
+        }
+    }
+}